@@ -0,0 +1,112 @@
+/**
+ *
+ *  @file      Bench.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Defines a minimal registry and timer for throughput benchmarks
+ */
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <format>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace brilliant {
+  namespace wp {
+    namespace bench {
+
+      /**
+       * @brief A registered benchmark
+       */
+      struct Benchmark {
+        //! The name printed before the results
+        std::string name;
+
+        //! The function running the benchmark
+        std::function<void()> run;
+      };
+
+      /**
+       * @brief Get every registered benchmark
+       * @return The benchmark registry
+       */
+      inline std::vector<Benchmark>& registry() {
+        static std::vector<Benchmark> benchmarks;
+        return benchmarks;
+      }
+
+      /**
+       * @brief Registers a benchmark during static initialization
+       */
+      struct Registrar {
+        /**
+         * @brief Add a benchmark to the registry
+         * @param name The name of the benchmark
+         * @param run The function running the benchmark
+         */
+        Registrar(std::string name, std::function<void()> run) {
+          registry().push_back({std::move(name), std::move(run)});
+        }
+      };
+
+      /**
+       * @brief Time a function and print its throughput
+       * @tparam F The function type
+       * @param label The label printed with the results
+       * @param bytes The number of bytes processed by one call of f
+       * @param pixels The number of pixels processed by one call of f
+       * @param f The function to time
+       *
+       * f is called once to warm up, then repeatedly for at least half a
+       * second. The fastest call is reported to reduce noise from other
+       * processes.
+       */
+      template <class F>
+      void measure(std::string_view label, std::uint64_t bytes,
+                   std::uint64_t pixels, F&& f) {
+        using clock = std::chrono::steady_clock;
+        f();
+
+        auto best = clock::duration::max();
+        const auto end = clock::now() + std::chrono::milliseconds(500);
+        std::size_t iterations = 0;
+        do {
+          const auto start = clock::now();
+          f();
+          best = std::min(best, clock::now() - start);
+          ++iterations;
+        } while (clock::now() < end || iterations < 3);
+
+        const auto seconds = std::chrono::duration<double>(best).count();
+        std::cout << std::format(
+            "  {:<32} {:>10.1f} MB/s {:>10.1f} Mpx/s\n", label,
+            static_cast<double>(bytes) / seconds / 1e6,
+            static_cast<double>(pixels) / seconds / 1e6);
+      }
+
+    }  // namespace bench
+  }  // namespace wp
+}  // namespace brilliant
+
+//! Concatenate two tokens after expanding them
+#define BRILLIANT_BENCH_CONCAT_IMPL(a, b) a##b
+
+//! Concatenate two tokens after expanding them
+#define BRILLIANT_BENCH_CONCAT(a, b) BRILLIANT_BENCH_CONCAT_IMPL(a, b)
+
+/**
+ * @brief Define and register a benchmark function
+ * @param name The name of the benchmark
+ */
+#define BRILLIANT_BENCH(name)                                           \
+  static void BRILLIANT_BENCH_CONCAT(bench_, name)();                   \
+  static const ::brilliant::wp::bench::Registrar BRILLIANT_BENCH_CONCAT( \
+      registrar_, name)(#name, &BRILLIANT_BENCH_CONCAT(bench_, name));   \
+  static void BRILLIANT_BENCH_CONCAT(bench_, name)()
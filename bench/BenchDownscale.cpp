@@ -0,0 +1,150 @@
+/**
+ *
+ *  @file      BenchDownscale.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Speed and quality benchmarks for scaling decoded images to tile sizes
+ */
+
+#include <boost/gil.hpp>
+#include <boost/gil/extension/numeric/resample.hpp>
+#include <boost/gil/extension/numeric/sampler.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "Bench.hpp"
+#include "Downscale.hpp"
+
+namespace {
+  //! Width of the source image, a 24 megapixel photo
+  constexpr std::uint32_t width = 6000;
+
+  //! Height of the source image, a 24 megapixel photo
+  constexpr std::uint32_t height = 4000;
+
+  /**
+   * @brief Make a source with detail at every frequency
+   * @return A zone plate over smooth gradients with a little noise
+   */
+  boost::gil::rgb8_image_t makeSource() {
+    boost::gil::rgb8_image_t src(width, height);
+    auto view = boost::gil::view(src);
+    std::mt19937 mt(0);
+    std::uniform_int_distribution<int> noise(-8, 8);
+    for (std::uint32_t y = 0; y < height; ++y) {
+      for (std::uint32_t x = 0; x < width; ++x) {
+        const double dx = x - width / 2.0;
+        const double dy = y - height / 2.0;
+        const double plate =
+            127.5 + 127.5 * std::cos((dx * dx + dy * dy) * 3.14159 / width);
+        const auto clamp = [](double value) {
+          return static_cast<std::uint8_t>(std::clamp(value, 0.0, 255.0));
+        };
+        view(x, y) = boost::gil::rgb8_pixel_t(
+            clamp(plate), clamp(255.0 * x / width + noise(mt)),
+            clamp(0.5 * plate + 127.0 * y / height));
+      }
+    }
+    return src;
+  }
+
+  /**
+   * @brief Scale down by averaging the exact area under each pixel
+   * @param src The source
+   * @param w The width to scale to
+   * @param h The height to scale to
+   * @return Each channel of each pixel, unrounded
+   *
+   * Slow, but the closest to an ideal reduction, so the reference for
+   * PSNR.
+   */
+  std::vector<double> reference(const boost::gil::rgb8c_view_t& src,
+                                std::uint32_t w, std::uint32_t h) {
+    const double rx = static_cast<double>(src.width()) / w;
+    const double ry = static_cast<double>(src.height()) / h;
+    // horizontal then vertical, each weighted by overlap
+    std::vector<double> rows(std::size_t{w} * src.height() * 3);
+    for (std::ptrdiff_t y = 0; y < src.height(); ++y) {
+      for (std::uint32_t x = 0; x < w; ++x) {
+        const double begin = x * rx;
+        // rounding can take the last end just past the edge
+        const double end = std::min<double>(begin + rx, src.width());
+        for (auto s = static_cast<std::ptrdiff_t>(begin); s < end; ++s) {
+          const double overlap = std::min<double>(s + 1, end) -
+                                 std::max<double>(s, begin);
+          for (int c = 0; c < 3; ++c) {
+            rows[(y * w + x) * 3 + c] += src(s, y)[c] * overlap / rx;
+          }
+        }
+      }
+    }
+    std::vector<double> out(std::size_t{w} * h * 3);
+    for (std::uint32_t y = 0; y < h; ++y) {
+      const double begin = y * ry;
+      const double end = std::min<double>(begin + ry, src.height());
+      for (auto s = static_cast<std::ptrdiff_t>(begin); s < end; ++s) {
+        const double overlap =
+            std::min<double>(s + 1, end) - std::max<double>(s, begin);
+        for (std::size_t i = 0; i < std::size_t{w} * 3; ++i) {
+          out[y * w * 3 + i] += rows[s * w * 3 + i] * overlap / ry;
+        }
+      }
+    }
+    return out;
+  }
+
+  /**
+   * @brief Measure how close an image is to a reference
+   * @param image The image
+   * @param expected The reference channels
+   * @return The peak signal to noise ratio in dB, higher is closer
+   */
+  double psnr(const boost::gil::rgb8c_view_t& image,
+              const std::vector<double>& expected) {
+    double squares = 0.0;
+    std::size_t i = 0;
+    for (const auto& pixel : image) {
+      for (int c = 0; c < 3; ++c, ++i) {
+        const double error = pixel[c] - expected[i];
+        squares += error * error;
+      }
+    }
+    return 10.0 * std::log10(255.0 * 255.0 / (squares / expected.size()));
+  }
+}  // namespace
+
+BRILLIANT_BENCH(Downscale) {
+  const auto src = makeSource();
+  const auto view = boost::gil::const_view(src);
+  const std::uint64_t pixels = std::uint64_t{width} * height;
+
+  // 1440p, 1080p and 720p tiles, and a reduction of under 2x
+  for (const std::uint32_t tileHeight : {2600u, 1440u, 1080u, 720u}) {
+    const auto tileWidth = width * tileHeight / height;
+    boost::gil::rgb8_image_t bilinear(tileWidth, tileHeight);
+    boost::gil::rgb8_image_t pyramid(tileWidth, tileHeight);
+    const auto label = std::format("{}x{}", tileWidth, tileHeight);
+
+    brilliant::wp::bench::measure(label + " bilinear", pixels * 3, pixels,
+                                  [&] {
+                                    boost::gil::resize_view(
+                                        view, boost::gil::view(bilinear),
+                                        boost::gil::bilinear_sampler());
+                                  });
+    brilliant::wp::bench::measure(label + " pyramid", pixels * 3, pixels, [&] {
+      brilliant::wp::resample(view, boost::gil::view(pyramid));
+    });
+
+    const auto expected = reference(view, tileWidth, tileHeight);
+    std::cout << std::format(
+        "  {:<32} {:>10.2f} dB bilinear {:>10.2f} dB pyramid\n",
+        label + " PSNR", psnr(boost::gil::const_view(bilinear), expected),
+        psnr(boost::gil::const_view(pyramid), expected));
+  }
+}
@@ -0,0 +1,81 @@
+/**
+ *
+ *  @file      BenchJpegEncode.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Throughput benchmarks for encoding wallpapers as jpeg
+ */
+
+#include <boost/asio/thread_pool.hpp>
+#include <boost/gil.hpp>
+#include <boost/gil/extension/io/jpeg.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <random>
+#include <thread>
+
+#include "Bench.hpp"
+#include "ParallelJpeg.hpp"
+
+namespace {
+  //! Width of the benchmark image, two 4k monitors side by side
+  constexpr std::uint32_t width = 7680;
+
+  //! Height of the benchmark image, two 4k monitors side by side
+  constexpr std::uint32_t height = 2160;
+
+  /**
+   * @brief Make an image with gradients and some noise, closer to a photo
+   * than either flat colour or pure noise
+   * @return The image
+   */
+  boost::gil::rgb8_image_t makeImage() {
+    boost::gil::rgb8_image_t img(width, height);
+    std::mt19937 mt(0);
+    const auto view = boost::gil::view(img);
+    for (std::ptrdiff_t y = 0; y < view.height(); ++y) {
+      auto it = view.row_begin(y);
+      for (std::ptrdiff_t x = 0; x < view.width(); ++x, ++it) {
+        const auto noise = static_cast<std::uint8_t>(mt() % 24);
+        *it = boost::gil::rgb8_pixel_t(
+            static_cast<std::uint8_t>(x / 32 + noise),
+            static_cast<std::uint8_t>(y / 9 + noise),
+            static_cast<std::uint8_t>((x + y) / 40 + noise));
+      }
+    }
+    return img;
+  }
+}  // namespace
+
+BRILLIANT_BENCH(JpegEncode) {
+  const auto img = makeImage();
+  const auto view = boost::gil::const_view(img);
+  const std::uint64_t pixels = std::uint64_t{width} * height;
+  const auto bytes = pixels * 3;
+  const auto path =
+      std::filesystem::temp_directory_path() / "brilliant_wp_bench.jpg";
+
+  brilliant::wp::bench::measure("gil write_view", bytes, pixels, [&] {
+    boost::gil::write_view(
+        path.string(), view,
+        boost::gil::image_write_info<boost::gil::jpeg_tag>());
+  });
+
+  const auto cores = std::max(1u, std::thread::hardware_concurrency());
+  for (std::uint32_t threads = 1; threads <= cores; threads *= 2) {
+    // the caller encodes as well, so the pool only needs the helpers
+    boost::asio::thread_pool pool(std::max(1u, threads - 1));
+    brilliant::wp::bench::measure(
+        std::format("writeJpegParallel {} thread(s)", threads), bytes, pixels,
+        [&] {
+          brilliant::wp::writeJpegParallel(path, view, pool.get_executor(),
+                                           threads);
+        });
+    pool.join();
+  }
+
+  std::filesystem::remove(path);
+}
@@ -0,0 +1,67 @@
+/**
+ *
+ *  @file      BenchPixelConversion.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Throughput benchmarks for the pixel conversion kernels
+ */
+
+#include <boost/gil.hpp>
+#include <cstdint>
+#include <random>
+#include <string>
+
+#include "Bench.hpp"
+#include "PixelConversion.hpp"
+
+namespace {
+  //! Width of the benchmark images, a 4k monitor
+  constexpr std::uint32_t width = 3840;
+
+  //! Height of the benchmark images, a 4k monitor
+  constexpr std::uint32_t height = 2160;
+
+  /**
+   * @brief Compare convertToRgb8 against boost::gil's generic conversion
+   * @tparam Image The source image type
+   * @param name The name of the source type
+   */
+  template <class Image>
+  void compare(const std::string& name) {
+    Image src(width, height);
+    std::mt19937 mt(0);
+    auto bytes = reinterpret_cast<std::uint8_t*>(
+        &*boost::gil::view(src).row_begin(0));
+    const auto size = boost::gil::view(src).size() *
+                      sizeof(typename Image::value_type);
+    for (std::size_t i = 0; i < size; ++i) {
+      bytes[i] = static_cast<std::uint8_t>(mt());
+    }
+
+    boost::gil::rgb8_image_t dst(width, height);
+    const std::uint64_t pixels = std::uint64_t{width} * height;
+    const brilliant::wp::ImageType::const_view_t any(
+        boost::gil::const_view(src));
+
+    brilliant::wp::bench::measure(name + " convertToRgb8", size, pixels, [&] {
+      brilliant::wp::convertToRgb8(any, boost::gil::view(dst),
+                                   boost::gil::rgb8_pixel_t(0, 0, 0));
+    });
+    brilliant::wp::bench::measure(name + " copy_and_convert", size, pixels,
+                                  [&] {
+                                    boost::gil::copy_and_convert_pixels(
+                                        any, boost::gil::view(dst));
+                                  });
+  }
+}  // namespace
+
+BRILLIANT_BENCH(PixelConversion) {
+  compare<boost::gil::rgb8_image_t>("rgb8");
+  compare<boost::gil::rgba8_image_t>("rgba8");
+  compare<boost::gil::rgba16_image_t>("rgba16");
+  compare<boost::gil::gray8_image_t>("gray8");
+  compare<boost::gil::gray16_image_t>("gray16");
+  compare<boost::gil::gray_alpha8_image_t>("gray_alpha8");
+  compare<boost::gil::gray_alpha16_image_t>("gray_alpha16");
+}
@@ -0,0 +1,32 @@
+/**
+ *
+ *  @file      main.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Runs the registered benchmarks
+ */
+
+#include <iostream>
+#include <string_view>
+
+#include "Bench.hpp"
+
+/**
+ * @brief Run every benchmark, or only those whose name contains the first
+ * argument
+ * @param argc The number of arguments from the command line
+ * @param argv Arguments from the command line
+ * @return 0
+ */
+int main(int argc, const char* argv[]) {
+  const std::string_view filter = argc > 1 ? argv[1] : "";
+  for (const auto& benchmark : brilliant::wp::bench::registry()) {
+    if (benchmark.name.find(filter) == std::string::npos) {
+      continue;
+    }
+    std::cout << benchmark.name << '\n';
+    benchmark.run();
+  }
+  return 0;
+}
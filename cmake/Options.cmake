@@ -6,6 +6,7 @@ option(BRILLIANT_CMAKE_BUILD_HEADER_ONLY
        "Build project as a header only library" OFF
 )
 option(BRILLIANT_CMAKE_CODE_COVERAGE "Build project with code coverage" OFF)
+option(BRILLIANT_CMAKE_BUILD_BENCHMARKS "Build the throughput benchmarks" OFF)
 
 set(BRILLIANT_CMAKE_SANITIZER
     ""
@@ -9,16 +9,38 @@
 #include "App.hpp"
 
 #include <boost/asio.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/use_awaitable.hpp>
 #include <boost/gil.hpp>
-#include <boost/gil/extension/numeric/resample.hpp>
-#include <boost/gil/extension/numeric/sampler.hpp>
+#include <algorithm>
+#include <cmath>
 #include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <latch>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
 #include <ranges>
+#include <span>
 #include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_set>
 
+#include "Downscale.hpp"
+#include "GutterFill.hpp"
 #include "GetInstallPath.hpp"
+#include "ImageDecoder.hpp"
 #include "Log.hpp"
+#include "JpegWriter.hpp"
+#include "ParallelJpeg.hpp"
+#include "SourceArchive.hpp"
+#include "ThreadPriority.hpp"
 #include "TomlConfigBuilder.hpp"
+#include "TransitionLoop.hpp"
 
 namespace brilliant {
   namespace wp {
@@ -27,215 +49,1452 @@ namespace brilliant {
 
     namespace asio = boost::asio;
 
+    //! Prefix shared by all generated wallpaper file names
+    constexpr auto fileNamePrefix = "brilliant_wallpaper_"sv;
+
     //! Format for generated wallpaper file names
-    constexpr auto fileNameFormat =
-        "brilliant_wallpaper_m{}_{:%Y%m%d-%H%M%S}.jpg"sv;
-
-    App::App(int argc, const char* argv[])
-        : mt(rd()),
-          tempDirectory(std::filesystem::temp_directory_path() /
-                        "brilliant_wp") {
-      // TODO: parse args
-      //  - seed - seed the random number gen
-      //  - configfile path - alternative path to the config file
-      //  - tmp dir - alternative path to tmp directory
-      //  - debug level
+    constexpr auto fileNameFormat = "{}m{}_{:%Y%m%d-%H%M%S}_{}.jpg"sv;
+
+    //! Format for monitor snapshot file names
+    constexpr auto snapshotFileFormat = "{}m{}.state"sv;
+
+    //! How many spares are tried before a failed tile is left empty
+    constexpr std::size_t maxRefillAttempts = 3;
+
+    //! How long a monitor waits after a wallpaper fails to render
+    constexpr auto renderRetryDelay = std::chrono::seconds(5);
+
+    //! How often a deferred render checks whether the machine is idle
+    constexpr auto loadPollInterval = std::chrono::seconds(5);
+
+    //! How much of the blurred colour is kept in the gaps between tiles, so
+    //! the tiles stand out from it
+    constexpr float gutterBrightness = 0.5f;
+
+    //! How many shown wallpapers each monitor keeps to show again
+    constexpr std::size_t recentWallpapers = 4;
+
+    //! How many sources are probed per background catalog task
+    constexpr std::size_t catalogBatchSize = 32;
+
+    //! How much of a deflated archive member is inflated to probe it. Enough
+    //! for the header of any but the most heavily annotated image
+    constexpr std::uint64_t probeBytes = 256 << 10;
+
+    //! How many sources are picked for each wallpaper. More than fit on a
+    //! wallpaper, the rest are spares for failed tiles
+    constexpr std::size_t sampleSize = 64;
+
+    //! How many sources are tried from the gap index before the end of a
+    //! row is left as it is
+    constexpr std::size_t maxGapFillAttempts = 16;
+
+    //! Format for batch rendered wallpaper file names
+    constexpr auto renderFileNameFormat = "wallpaper_{:04}.jpg"sv;
+
+    namespace {
+      /**
+       * @brief Call a function for each index on a pool and wait for every
+       * call to finish
+       * @tparam F The function type
+       * @param pool The pool to run the calls on
+       * @param count The number of calls
+       * @param f Called once with each index from 0 to count
+       *
+       * The first exception thrown by f is rethrown once every call is done.
+       */
+      template <class F>
+      void parallelFor(asio::thread_pool& pool, std::size_t count, F f) {
+        std::latch done(static_cast<std::ptrdiff_t>(count));
+        std::mutex mutex;
+        std::exception_ptr error;
+        for (std::size_t i = 0; i < count; ++i) {
+          asio::post(pool, [&, i] {
+            try {
+              f(i);
+            } catch (...) {
+              std::lock_guard lock(mutex);
+              if (!error) {
+                error = std::current_exception();
+              }
+            }
+            done.count_down();
+          });
+        }
+        done.wait();
+        if (error) {
+          std::rethrow_exception(error);
+        }
+      }
+
+      /**
+       * @brief Call a function once on every thread of a pool
+       * @tparam F The function type
+       * @param pool The pool
+       * @param threads The number of threads in the pool
+       * @param f Called once on each thread
+       *
+       * Each call waits for the others to start, so no thread can take a
+       * second one.
+       */
+      template <class F>
+      void onEachThread(asio::thread_pool& pool, std::size_t threads, F f) {
+        std::latch started(static_cast<std::ptrdiff_t>(threads));
+        parallelFor(pool, threads, [&](std::size_t) {
+          started.arrive_and_wait();
+          f();
+        });
+      }
+
+      /**
+       * @brief Unpack a config colour into a pixel
+       * @param colour The colour as 0xRRGGBB
+       * @return The colour as an rgb8 pixel
+       */
+      boost::gil::rgb8_pixel_t toPixel(std::uint32_t colour) {
+        return {static_cast<std::uint8_t>(colour >> 16),
+                static_cast<std::uint8_t>(colour >> 8),
+                static_cast<std::uint8_t>(colour)};
+      }
+    }  // namespace
+
+    App::App(const CommandLine& options)
+        : stopped(false),
+          seed(options.seed ? *options.seed : rd()),
+          mt(seed),
+          tempDirectory(options.tempDirectory.value_or(
+              std::filesystem::temp_directory_path() / "brilliant_wp")),
+          quarantine(tempDirectory / "quarantine.txt") {
+      // logged so a run can be repeated with --seed
+      log(severity_level::info, "Random seed: {}", seed);
+
       installDirectory = getInstallPath() / "brilliant_wp";
       log(severity_level::debug, "Install directory: {}",
           installDirectory.string());
 
+      const auto configStart = std::chrono::steady_clock::now();
       TomlConfigBuilder builder;
-      config = builder.build(installDirectory / "config.toml");
+      config = builder.build(
+          options.configFile.value_or(installDirectory / "config.toml"));
+      std::size_t configSources = 0;
+      for (const auto& monitor : config.monitors | std::views::values) {
+        configSources += monitor.backgroundPaths.size();
+      }
+      // dominated by walking the configured folders
+      log(severity_level::info, "Loaded config with {} sources in {}",
+          configSources,
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::steady_clock::now() - configStart));
+
+      startWorkers();
+      memoryBudget.emplace(config.memoryBudget);
 
       if (!std::filesystem::exists(tempDirectory)) {
-        std::filesystem::create_directory(tempDirectory);
+        std::filesystem::create_directories(tempDirectory);
         log(severity_level::debug, "Created temp directory: {}",
             tempDirectory.string());
       }
     }
 
-    void App::run() {
-      asio::thread_pool pool;
-      timers.reserve(config.monitors.size());
-
-      for (auto& [i, monitor] : config.monitors) {
-        for (auto iter = monitor.backgroundPaths.begin();
-             iter != monitor.backgroundPaths.end();) {
-          if (auto tags = getImageType(*iter)) {
-            fileInfoCache.emplace(*iter, ImageInfo{*iter, *tags});
-            ++iter;
-          } else {
-            log(severity_level::warning,
-                "The file type of {} could not be determined and so will not "
-                "be included in source images",
-                iter->string());
-            iter = monitor.backgroundPaths.erase(iter);
+    void App::startWorkers() {
+      ioWorkers.emplace(config.ioThreads);
+      workerThreads = config.cpuThreads
+                          ? config.cpuThreads
+                          : std::max(1u, std::thread::hardware_concurrency());
+      workers.emplace(workerThreads);
+      log(severity_level::debug, "Started {} I/O and {} worker threads",
+          config.ioThreads, workerThreads);
+      if (!config.lowPriority && config.cpuAffinity.empty()) {
+        return;
+      }
+
+      // a thread which cannot be moved still does its share of the work
+      onEachThread(*workers, workerThreads, [this] {
+        try {
+          if (config.lowPriority) {
+            lowerThreadPriority();
           }
+          setThreadAffinity(config.cpuAffinity);
+        } catch (const std::system_error& e) {
+          log(severity_level::warning,
+              "Failed to schedule a worker thread: {}", e.what());
+        }
+      });
+    }
+
+    bool App::isUsableSource(ImageId id) {
+      std::filesystem::path path;
+      std::optional<std::pair<std::filesystem::path, MemberLocation>> member;
+      {
+        std::shared_lock lock(catalogMutex);
+        if (const auto status = catalog.status(id);
+            status != Catalog::Status::unknown) {
+          return status == Catalog::Status::usable;
         }
+        path = catalog.path(id);
+        member = catalog.archiveMember(id);
       }
+      // any failure below leaves the source unusable for the rest of the run
+      const auto unusable = [this, id] {
+        std::lock_guard lock(catalogMutex);
+        catalog.setUnusable(id);
+        return false;
+      };
 
-      for (auto i : config.monitors | std::views::keys) {
-        auto& timer = timers.emplace_back(pool);
-        asio::post(pool, [this, &timer, i] {
+      if (quarantine.contains(path)) {
+        log(severity_level::debug, "Skipping quarantined file {}",
+            path.string());
+        return unusable();
+      }
+
+      try {
+        if (const auto size = member ? member->second.size
+                                     : std::filesystem::file_size(path);
+            size > config.maxFileSize) {
+          log(severity_level::warning,
+              "{} is {} bytes, over the limit of {}, so it will not be "
+              "included in source images",
+              path.string(), size, config.maxFileSize);
+          return unusable();
+        }
+
+        // map once and use the same pages for the type check and probe. A
+        // deflated member is only inflated as far as its header
+        const auto file =
+            member ? SourceFile(member->first, member->second,
+                                AccessHint::normal, probeBytes)
+                   : SourceFile(path, AccessHint::normal);
+        const auto tags = getImageType(file.data());
+        if (!tags) {
+          log(severity_level::warning,
+              "The file type of {} could not be determined and so will not "
+              "be included in source images",
+              path.string());
+          return unusable();
+        }
+
+        const auto info = [&] {
           try {
-            // immediately make the first one
-            auto wallpaper = makeNextWallpaper(i);
-            const auto name = std::format(fileNameFormat, i,
-                                          std::chrono::system_clock::now());
-            const auto outPath = tempDirectory / name;
-            boost::gil::write_view(
-                outPath, boost::gil::const_view(wallpaper),
-                boost::gil::image_write_info<boost::gil::jpeg_tag>());
-            setter.setWallpaper(i, outPath);
-
-            // prep the next
-            wallpaper = makeNextWallpaper(i);
-            const auto nextName = std::format(fileNameFormat, i,
-                                              std::chrono::system_clock::now());
-            boost::gil::write_view(
-                tempDirectory / nextName, boost::gil::const_view(wallpaper),
-                boost::gil::image_write_info<boost::gil::jpeg_tag>());
-
-            const auto delay = config.monitors[i].transitionDelay
-                                   ? *config.monitors[i].transitionDelay
-                                   : config.globalTransitionDelay;
-
-            log(severity_level::debug,
-                "Next wallpaper for monitor {} saved to {}", i,
-                (tempDirectory / nextName).string());
-            log(severity_level::debug, "Next wallpaper will be set in {}",
-                delay);
-
-            // set async timer
-            timer.expires_after(delay);
-            timer.async_wait([this, &timer, nextName, i](const auto& ec) {
-              onTimerExpiry(timer, i, nextName, ec);
-            });
-          } catch (const std::exception& e) {
-            if (!eptr) {
-              eptr = std::make_exception_ptr(e);
-              stop();
+            return probeImage(file.data(), *tags);
+          } catch (const DecodeError&) {
+            if (!file.partial()) {
+              throw;
             }
+            // the header runs past what was read
+            return probeImage(SourceFile(member->first, member->second,
+                                         AccessHint::normal)
+                                  .data(),
+                              *tags);
           }
-        });
+        }();
+        if (!chooseDecodeScale(info, 1, 1, config.maxDecodePixels)) {
+          log(severity_level::warning,
+              "{} is {}x{} and cannot be decoded within {} pixels so it will "
+              "not be included in source images",
+              path.string(), info.width(), info.height(),
+              config.maxDecodePixels);
+          return unusable();
+        }
+        // another thread may have probed the same source meanwhile, only
+        // the first to settle it counts it
+        std::lock_guard lock(catalogMutex);
+        if (catalog.setUsable(id, info)) {
+          ++usableCount;
+          return true;
+        }
+        return catalog.status(id) == Catalog::Status::usable;
+      } catch (const DecodeError& e) {
+        quarantine.add(path, e.what());
+      } catch (const std::exception& e) {
+        log(severity_level::warning,
+            "Could not read {} so it will not be included in source images: "
+            "{}",
+            path.string(), e.what());
       }
+      return unusable();
+    }
 
-      pool.join();
+    void App::run() {
+      // all state is created up front so the monitor coroutines never race on
+      // insertion
+      for (auto i : config.monitors | std::views::keys) {
+        monitorStates.try_emplace(
+            i, MonitorState{
+                   asio::steady_timer(timerContext),
+                   asio::steady_timer(timerContext),
+                   AsyncQueue<std::filesystem::path>(
+                       timerContext.get_executor(), config.prefetch),
+                   std::mt19937(mt())});
+      }
+
+      for (auto i : config.monitors | std::views::keys) {
+        internSources(i);
+      }
+
+      shareTileCaches();
+
+      // wallpapers a monitor carries on with are kept by the clean up below
+      std::unordered_set<std::filesystem::path> keep;
+      for (auto i : config.monitors | std::views::keys) {
+        auto& state = monitorStates.at(i);
+        state.savedMt = state.mt;
+        keep.insert(snapshotPath(i));
+        if (restoreSnapshot(i)) {
+          // the restored wallpapers take the rounds they would have been
+          // made in, keeping the monitor in step with the others
+          for (std::size_t n = 0; n <= state.queue.contents().size(); ++n) {
+            finishRound(i);
+          }
+          keep.insert(state.current);
+          keep.insert(state.queue.contents().begin(),
+                      state.queue.contents().end());
+          for (const auto& recent : state.recent) {
+            keep.insert(recent.path);
+          }
+        }
+      }
+
+      // monitors which did not carry on skip to the round the others are up
+      // to rather than making rounds nobody else will
+      std::map<const TileGroup*, std::uint64_t> latestRounds;
+      for (const auto& state : monitorStates | std::views::values) {
+        if (state.tileGroup) {
+          auto& latest = latestRounds[state.tileGroup.get()];
+          latest = std::max(latest, state.round);
+        }
+      }
+      for (auto& [i, state] : monitorStates) {
+        while (state.tileGroup &&
+               state.round < latestRounds.at(state.tileGroup.get())) {
+          finishRound(i);
+        }
+      }
+
+      // Remove wallpapers left over from a previous run
+      for (const auto& entry :
+           std::filesystem::directory_iterator(tempDirectory)) {
+        if (entry.path().filename().string().starts_with(fileNamePrefix) &&
+            !keep.contains(entry.path())) {
+          log(severity_level::debug, "Removing item: {}",
+              entry.path().string());
+          std::filesystem::remove_all(entry);
+        }
+      }
+
+      for (auto i : config.monitors | std::views::keys) {
+        spawn(runMonitor(i));
+      }
+
+      timerContext.run();
+      ioWorkers->join();
+      workers->join();
+
+      for (const auto& [i, state] : monitorStates) {
+        log(severity_level::info, "Monitor {}: {}", i, state.stats.summary());
+      }
 
       if (eptr) {
         std::rethrow_exception(eptr);
       }
     }
 
-    ImageType App::makeNextWallpaper(unsigned monitorIndex) {
-      auto& monitor = config.monitors[monitorIndex];
+    void App::render(const RenderOptions& options) {
+      using seconds = std::chrono::duration<double>;
+      std::filesystem::create_directories(options.outputDirectory);
+
+      // sorted so a seed picks the same sources whatever order the folders
+      // were listed in
+      std::vector<std::pair<std::filesystem::path, float>> paths;
+      for (auto& monitor : config.monitors | std::views::values) {
+        internArchiveMembers(monitor);
+        for (auto&& [path, weight] :
+             std::views::zip(monitor.backgroundPaths, monitor.weights)) {
+          paths.emplace_back(std::move(path), weight);
+        }
+        monitor.backgroundPaths = {};
+        monitor.weights = {};
+      }
+      std::ranges::sort(paths);
+      std::vector<ImageId> sources;
+      std::vector<float> weights;
+      sources.reserve(paths.size());
+      {
+        std::lock_guard lock(catalogMutex);
+        for (const auto& [path, weight] : paths) {
+          // a source listed by several monitors keeps its largest weight,
+          // which sorts last
+          const auto id = catalog.intern(path);
+          if (!sources.empty() && sources.back() == id) {
+            weights.back() = weight;
+          } else {
+            sources.push_back(id);
+            weights.push_back(weight);
+          }
+        }
+      }
+      paths = {};
 
-      std::ranges::shuffle(monitor.backgroundPaths, mt);
-      auto info = monitor.backgroundPaths |
-                  std::views::transform([this](const auto& path) {
-                    return fileInfoCache.at(path);
+      const auto catalogStart = std::chrono::steady_clock::now();
+      std::vector<char> usable(sources.size());
+      parallelFor(*ioWorkers,
+                  (sources.size() + catalogBatchSize - 1) / catalogBatchSize,
+                  [&](std::size_t batch) {
+                    const auto end = std::min(sources.size(),
+                                              (batch + 1) * catalogBatchSize);
+                    for (auto i = batch * catalogBatchSize; i < end; ++i) {
+                      usable[i] = isUsableSource(sources[i]);
+                    }
                   });
+      std::vector<ImageId> usableSources;
+      WeightedSampler sampler;
+      for (std::size_t i = 0; i < sources.size(); ++i) {
+        if (usable[i]) {
+          usableSources.push_back(sources[i]);
+          sampler.push(weights[i]);
+        }
+      }
+      std::cout << std::format(
+          "Cataloged {} usable of {} sources in {:.3f}s\n",
+          usableSources.size(), sources.size(),
+          seconds(std::chrono::steady_clock::now() - catalogStart).count());
+      if (usableSources.empty()) {
+        throw ConfigError("None of the configured sources can be used");
+      }
 
-      const auto res = setter.getResolution(monitorIndex);
-      boost::gil::rgb8_image_t combined(res.first, res.second);
-      const auto rois = determineRoisFromImageInfo(combined, info);
+      const auto gaps = indexSources(usableSources, sampler, options.height);
 
-      for (const auto& [path, roi] :
-           std::views::zip(monitor.backgroundPaths, rois)) {
-        const auto resizedWidth = roi.second.x - roi.first.x;
-        const auto resizedHeight = roi.second.y - roi.first.y;
+      std::mutex printMutex;
+      TileStats total;
+      const auto start = std::chrono::steady_clock::now();
+      parallelFor(*workers, options.count, [&](std::size_t index) {
+        const auto wallpaperStart = std::chrono::steady_clock::now();
+        std::seed_seq seq{seed, static_cast<std::uint32_t>(index)};
+        std::mt19937 rng(seq);
+        const auto acceptAll = [](std::size_t) { return true; };
+        auto picks = pickDistinct(sampler, sampleSize, rng, acceptAll);
+        fillGap(picks, usableSources, gaps, options.width, rng, acceptAll);
+        std::vector<ImageId> sample;
+        for (const auto picked : picks) {
+          sample.push_back(usableSources[picked]);
+        }
 
-        ImageType rawImg;
-        std::visit(
-            [&](const auto& type) {
-              boost::gil::read_image(path, rawImg, type);
+        TileStats tiles;
+        const auto canvas = memoryBudget->hold(
+            std::uint64_t{options.width} * options.height * 3);
+        tiles.peakBytes = memoryBudget->used();
+        boost::gil::rgb8_image_t wallpaper(options.width, options.height,
+                                           toPixel(config.background));
+        const auto rois =
+            layoutSources(sample, options.width, options.height);
+        drawTiles(
+            boost::gil::view(wallpaper), sample, rois,
+            [this, &tiles](ImageId id, auto width, auto height) {
+              return std::make_shared<const boost::gil::rgb8_image_t>(
+                  makeTile(id, width, height, tiles));
             },
-            fileInfoCache.at(path).getType());
-
-        if (rawImg.height() != resizedHeight ||
-            rawImg.width() != resizedWidth) {
-          boost::gil::rgb8_image_t resized(resizedWidth, resizedHeight);
-          boost::gil::resize_view(boost::gil::const_view(rawImg),
-                                  boost::gil::view(resized),
-                                  boost::gil::bilinear_sampler());
-          boost::gil::copy_and_convert_pixels(
-              boost::gil::const_view(resized),
-              boost::gil::subimage_view(boost::gil::view(combined), roi.first.x,
-                                        roi.first.y, resizedWidth,
-                                        resizedHeight));
-        } else {
-          boost::gil::copy_and_convert_pixels(
-              boost::gil::const_view(rawImg),
-              boost::gil::subimage_view(boost::gil::view(combined), roi.first.x,
-                                        roi.first.y, resizedWidth,
-                                        resizedHeight));
+            tiles);
+
+        const auto outPath = options.outputDirectory /
+                             std::format(renderFileNameFormat, index);
+        // every worker is already busy with a wallpaper of its own
+        writeJpegParallel(outPath, boost::gil::const_view(wallpaper),
+                          workers->get_executor(), 1);
+
+        const seconds elapsed =
+            std::chrono::steady_clock::now() - wallpaperStart;
+        const double decoded = tiles.decodedPixels / 1e6;
+        std::lock_guard lock(printMutex);
+        total += tiles;
+        std::cout << std::format(
+            "{}: {} tiles, {} failed, {:.3f}s, {:.1f} MP decoded, "
+            "{:.1f} MP/s, {} MB peak\n",
+            outPath.filename().string(), rois.size(), tiles.failures,
+            elapsed.count(), decoded, decoded / elapsed.count(),
+            tiles.peakBytes >> 20);
+      });
+
+      const seconds elapsed = std::chrono::steady_clock::now() - start;
+      const double decoded = total.decodedPixels / 1e6;
+      std::cout << std::format(
+          "Rendered {} wallpapers at {}x{} in {:.3f}s: {:.2f} wallpapers/s, "
+          "{:.1f} MP decoded, {:.1f} MP/s, {} tile failures ({} refilled, "
+          "{} unfilled)\n",
+          options.count, options.width, options.height, elapsed.count(),
+          options.count / elapsed.count(), decoded, decoded / elapsed.count(),
+          total.failures, total.refills, total.unfilled);
+    }
+
+    void App::internSources(std::uint32_t monitorIndex) {
+      auto& monitor = config.monitors.at(monitorIndex);
+      auto& state = monitorStates.at(monitorIndex);
+
+      internArchiveMembers(monitor);
+      state.sources.reserve(monitor.backgroundPaths.size());
+      Fingerprint print;
+      {
+        std::lock_guard lock(catalogMutex);
+        for (const auto& [path, weight] :
+             std::views::zip(monitor.backgroundPaths, monitor.weights)) {
+          state.sources.push_back(catalog.intern(path));
+          state.sampler.push(weight);
+          print.addPath(path);
+          print.add(std::format("{}\n", weight));
+        }
+      }
+      state.sourcesFingerprint = print.value();
+      // the catalog holds the only copy of each path
+      monitor.backgroundPaths = {};
+      monitor.weights = {};
+
+      // probed in a random order so the background catalog is as likely to
+      // get to a source before it is picked as any other
+      state.pending = state.sources;
+      std::ranges::shuffle(state.pending, state.mt);
+
+      log(severity_level::debug, "Monitor {} has {} sources", monitorIndex,
+          state.sources.size());
+    }
+
+    void App::internArchiveMembers(ConfigMonitor& monitor) {
+      {
+        std::lock_guard lock(catalogMutex);
+        for (const auto& member : monitor.archiveMembers) {
+          catalog.setArchiveMember(
+              catalog.intern(monitor.backgroundPaths[member.source]),
+              monitor.archives[member.archive], member.location);
+        }
+      }
+      monitor.archives = {};
+      monitor.archiveMembers = {};
+    }
+
+    asio::awaitable<void> App::catalogSources(std::uint32_t monitorIndex) {
+      auto& state = monitorStates.at(monitorIndex);
+      const auto start = std::chrono::steady_clock::now();
+      std::size_t found = 0;
+
+      while (!stopped && !state.pending.empty()) {
+        const auto count = std::min(catalogBatchSize, state.pending.size());
+        const auto first = state.pending.end() - count;
+        std::vector<ImageId> batch(first, state.pending.end());
+        state.pending.erase(first, state.pending.end());
+
+        found += co_await runOn(ioWorkers->get_executor(),
+                                [this, batch = std::move(batch)] {
+                                  return std::ranges::count_if(
+                                      batch, [this](ImageId id) {
+                                        return isUsableSource(id);
+                                      });
+                                });
+      }
+
+      log(severity_level::info,
+          "Monitor {} found {} usable sources in the background in {}",
+          monitorIndex, found,
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::steady_clock::now() - start));
+    }
+
+    ImageInfo App::sourceInfo(ImageId id) const {
+      std::shared_lock lock(catalogMutex);
+      return catalog.info(id);
+    }
+
+    std::filesystem::path App::sourcePath(ImageId id) const {
+      std::shared_lock lock(catalogMutex);
+      return catalog.path(id);
+    }
+
+    SourceFile App::openSource(ImageId id, AccessHint hint) const {
+      std::filesystem::path path;
+      std::optional<std::pair<std::filesystem::path, MemberLocation>> member;
+      {
+        std::shared_lock lock(catalogMutex);
+        path = catalog.path(id);
+        member = catalog.archiveMember(id);
+      }
+      // mapped outside the lock, the archive may not be in the page cache
+      return member ? SourceFile(member->first, member->second, hint)
+                    : SourceFile(path, hint);
+    }
+
+    void App::spawn(asio::awaitable<void> task) {
+      asio::co_spawn(timerContext, std::move(task),
+                     [this](const std::exception_ptr& e) {
+                       // runs on the timer context so eptr is not shared
+                       if (e && !eptr) {
+                         eptr = e;
+                         stop();
+                       }
+                     });
+    }
+
+    std::filesystem::path App::snapshotPath(std::uint32_t monitorIndex) const {
+      return tempDirectory /
+             std::format(snapshotFileFormat, fileNamePrefix, monitorIndex);
+    }
+
+    std::uint64_t App::snapshotFingerprint(std::uint32_t monitorIndex) {
+      const auto [width, height] = monitorResolution(monitorIndex);
+      Fingerprint print;
+      print.add(std::format("{} {}x{} #{:06x}",
+                            monitorStates.at(monitorIndex).sourcesFingerprint,
+                            width, height, config.background));
+      return print.value();
+    }
+
+    bool App::restoreSnapshot(std::uint32_t monitorIndex) {
+      auto& state = monitorStates.at(monitorIndex);
+      auto snapshot = loadSnapshot(snapshotPath(monitorIndex));
+      if (!snapshot) {
+        return false;
+      }
+      if (snapshot->fingerprint != snapshotFingerprint(monitorIndex)) {
+        log(severity_level::info,
+            "Monitor {} sources, resolution or background changed since it "
+            "was last run, making new wallpapers",
+            monitorIndex);
+        return false;
+      }
+
+      state.current = std::move(snapshot->current);
+      for (auto& path : snapshot->next) {
+        state.queue.push(std::move(path));
+      }
+      if (config.deferWhenBusy) {
+        const auto version = setter.topology()->version;
+        for (auto& path : snapshot->recent) {
+          state.recent.push_back({std::move(path), version});
         }
       }
+      state.mt = snapshot->mt;
+      state.savedMt = snapshot->mt;
+      state.savedFingerprint = snapshot->fingerprint;
+
+      // a delay shortened since the last run is kept to
+      const auto now = std::chrono::steady_clock::now();
+      const auto remaining =
+          std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+              snapshot->deadline - std::chrono::system_clock::now());
+      state.deadline =
+          now + std::clamp(remaining, std::chrono::steady_clock::duration{},
+                           transitionDelay(monitorIndex));
+      log(severity_level::info,
+          "Monitor {} carries on from its last run with {} wallpaper(s) "
+          "ready, next transition in {}",
+          monitorIndex, state.queue.contents().size(),
+          std::chrono::duration_cast<std::chrono::seconds>(state.deadline -
+                                                           now));
+      return true;
+    }
+
+    void App::writeSnapshot(std::uint32_t monitorIndex) {
+      const auto& state = monitorStates.at(monitorIndex);
+      MonitorSnapshot snapshot;
+      snapshot.fingerprint = state.savedFingerprint;
+      snapshot.current = state.current;
+      snapshot.next.assign(state.queue.contents().begin(),
+                           state.queue.contents().end());
+      for (const auto& recent : state.recent) {
+        snapshot.recent.push_back(recent.path);
+      }
+      snapshot.deadline =
+          std::chrono::system_clock::now() +
+          std::chrono::duration_cast<std::chrono::system_clock::duration>(
+              state.deadline - std::chrono::steady_clock::now());
+      snapshot.mt = state.savedMt;
+      saveSnapshot(snapshotPath(monitorIndex), snapshot);
+    }
+
+    asio::awaitable<void> App::runMonitor(std::uint32_t monitorIndex) {
+      auto& state = monitorStates.at(monitorIndex);
+      const auto delay = transitionDelay(monitorIndex);
+
+      const bool restored = !state.current.empty();
+      if (!restored) {
+        // immediately make the first one
+        auto first = co_await tryRenderWallpaper(monitorIndex);
+        if (!first) {
+          co_return;
+        }
+        state.current = std::move(*first);
+        state.savedMt = state.mt;
+        state.savedFingerprint = snapshotFingerprint(monitorIndex);
+      }
+      setter.setWallpaper(monitorIndex, state.current);
+      ++state.stats.transitions;
+      if (!restored) {
+        state.deadline = std::chrono::steady_clock::now() + delay;
+      }
+      writeSnapshot(monitorIndex);
+
+      spawn(produceWallpapers(monitorIndex));
+      spawn(catalogSources(monitorIndex));
+
+      co_await runTransitions(
+          state.timer, state.queue, state.deadline, delay, state.stats,
+          [this, monitorIndex, &state](std::filesystem::path next,
+                                       std::uint64_t missed) {
+            if (missed > 0) {
+              log(severity_level::warning,
+                  "Monitor {} missed {} transition(s), the next wallpaper "
+                  "was not ready in time",
+                  monitorIndex, missed);
+            }
+            setter.setWallpaper(monitorIndex, next);
+            retireWallpaper(monitorIndex, std::move(state.current));
+            state.current = std::move(next);
+            writeSnapshot(monitorIndex);
+            log(severity_level::debug, "Monitor {}: {}", monitorIndex,
+                state.stats.summary());
+          });
+      log(severity_level::info, "Async operation cancelled for monitor {}",
+          monitorIndex);
+    }
+
+    asio::awaitable<void> App::produceWallpapers(std::uint32_t monitorIndex) {
+      auto& state = monitorStates.at(monitorIndex);
+
+      while (co_await state.queue.waitForSpace()) {
+        if (config.deferWhenBusy) {
+          // each queued wallpaper takes a transition before this one
+          const auto queued = static_cast<std::chrono::steady_clock::rep>(
+              state.queue.contents().size());
+          const auto due =
+              state.deadline + transitionDelay(monitorIndex) * queued;
+          if (!co_await waitForIdle(monitorIndex, due)) {
+            if (auto recent = takeRecentWallpaper(monitorIndex)) {
+              ++state.stats.reused;
+              log(severity_level::info,
+                  "Monitor {} is still busy, showing {} again",
+                  monitorIndex, recent->string());
+              // takes the place of this round's wallpaper
+              finishRound(monitorIndex);
+              state.queue.push(std::move(*recent));
+              writeSnapshot(monitorIndex);
+              continue;
+            }
+          }
+        }
+
+        auto next = co_await tryRenderWallpaper(monitorIndex);
+        if (!next) {
+          co_return;
+        }
+
+        if (state.queue.isClosed()) {
+          std::filesystem::remove(*next);
+          co_return;
+        }
+
+        log(severity_level::debug, "Next wallpaper for monitor {} saved to {}",
+            monitorIndex, next->string());
+        state.queue.push(std::move(*next));
+        state.savedMt = state.mt;
+        state.savedFingerprint = snapshotFingerprint(monitorIndex);
+        writeSnapshot(monitorIndex);
+      }
+    }
+
+    asio::awaitable<bool> App::waitForIdle(
+        std::uint32_t monitorIndex,
+        std::chrono::steady_clock::time_point due) {
+      auto& state = monitorStates.at(monitorIndex);
+      const auto latestStart = due - 2 * state.renderTime;
+      bool deferred = false;
+
+      while (!stopped) {
+        const auto load = loadMonitor.sample();
+        if (!load.exceeds(config.busyLoad, config.busyPressure)) {
+          co_return true;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= latestStart) {
+          co_return false;
+        }
+        if (!deferred) {
+          deferred = true;
+          ++state.stats.deferrals;
+          log(severity_level::debug,
+              "Monitor {} is waiting for the machine to be idle, load {:.2f}, "
+              "CPU pressure {:.1f}%, memory pressure {:.1f}%",
+              monitorIndex, load.load.value_or(0.0),
+              load.cpuPressure.value_or(0.0),
+              load.memoryPressure.value_or(0.0));
+        }
+
+        boost::system::error_code ec;
+        state.retryTimer.expires_at(std::min(now + loadPollInterval,
+                                             latestStart));
+        co_await state.retryTimer.async_wait(
+            asio::redirect_error(asio::use_awaitable, ec));
+      }
+      co_return true;
+    }
+
+    void App::retireWallpaper(std::uint32_t monitorIndex,
+                              std::filesystem::path path) {
+      auto& state = monitorStates.at(monitorIndex);
+      if (config.deferWhenBusy) {
+        state.recent.push_back({std::move(path), setter.topology()->version});
+        if (state.recent.size() <= recentWallpapers) {
+          return;
+        }
+        path = std::move(state.recent.front().path);
+        state.recent.pop_front();
+      }
+      log(severity_level::debug, "Removing item: {}", path.string());
+      std::filesystem::remove(path);
+    }
+
+    std::optional<std::filesystem::path> App::takeRecentWallpaper(
+        std::uint32_t monitorIndex) {
+      auto& state = monitorStates.at(monitorIndex);
+      const auto version = setter.topology()->version;
+      // the oldest is the least likely to be remembered. Those shown on
+      // another display layout would not fit
+      while (!state.recent.empty()) {
+        auto oldest = std::move(state.recent.front());
+        state.recent.pop_front();
+        if (oldest.topologyVersion == version) {
+          return std::move(oldest.path);
+        }
+        std::filesystem::remove(oldest.path);
+      }
+      return std::nullopt;
+    }
+
+    asio::awaitable<std::optional<std::filesystem::path>>
+    App::tryRenderWallpaper(std::uint32_t monitorIndex) {
+      auto& state = monitorStates.at(monitorIndex);
+
+      while (!stopped) {
+        // nothing else can make the next transition and the workers may
+        // not get a CPU in time
+        const bool urgent =
+            config.lowPriority && state.queue.contents().empty() &&
+            state.deadline - std::chrono::steady_clock::now() <
+                transitionDelay(monitorIndex) / 2;
+        auto& pool = urgent ? *ioWorkers : *workers;
+        const auto threads = urgent ? config.ioThreads : workerThreads;
+        const auto start = std::chrono::steady_clock::now();
+        try {
+          auto rendered = co_await runOn(
+              pool.get_executor(), [this, monitorIndex, &pool, threads] {
+                return renderWallpaper(monitorIndex, pool, threads);
+              });
+          ++state.stats.generated;
+          state.stats.tiles += rendered.tiles;
+          const auto elapsed = std::chrono::steady_clock::now() - start;
+          state.renderTime = state.renderTime.count() == 0
+                                 ? elapsed
+                                 : (3 * state.renderTime + elapsed) / 4;
+          co_return std::move(rendered.path);
+        } catch (const std::exception& e) {
+          ++state.stats.failedRenders;
+          log(severity_level::error,
+              "Monitor {} failed to render a wallpaper, retrying in {}: {}",
+              monitorIndex, renderRetryDelay, e.what());
+        }
+
+        boost::system::error_code ec;
+        state.retryTimer.expires_after(renderRetryDelay);
+        co_await state.retryTimer.async_wait(
+            asio::redirect_error(asio::use_awaitable, ec));
+      }
+      co_return std::nullopt;
+    }
+
+    App::RenderedWallpaper App::renderWallpaper(std::uint32_t monitorIndex,
+                                                asio::thread_pool& pool,
+                                                std::size_t threads) {
+      TileStats tiles;
+      const auto [width, height] = monitorResolution(monitorIndex);
+      const auto canvas = holdCanvas(width, height, tiles);
+      if (config.bandHeight > 0) {
+        const auto outPath = nextWallpaperPath(monitorIndex);
+        composeBandedWallpaper(monitorIndex, outPath, tiles);
+        logPeakMemory(monitorIndex, tiles);
+        return {outPath, tiles};
+      }
+
+      const auto wallpaper = makeNextWallpaper(monitorIndex, tiles);
+      const auto outPath = nextWallpaperPath(monitorIndex);
+      writeJpegParallel(outPath, boost::gil::const_view(wallpaper),
+                        pool.get_executor(), threads);
+      logPeakMemory(monitorIndex, tiles);
+      return {outPath, tiles};
+    }
+
+    MemoryBudget::Reservation App::holdCanvas(std::uint32_t width,
+                                              std::uint32_t height,
+                                              TileStats& tiles) const {
+      const auto rows =
+          config.bandHeight > 0 ? std::min(config.bandHeight, height) : height;
+      auto canvas = memoryBudget->hold(std::uint64_t{width} * rows * 3);
+      tiles.peakBytes = std::max(tiles.peakBytes, memoryBudget->used());
+      return canvas;
+    }
+
+    void App::logPeakMemory(std::uint32_t monitorIndex,
+                            const TileStats& tiles) const {
+      if (const auto limit = memoryBudget->limit()) {
+        log(severity_level::debug,
+            "Monitor {} wallpaper peaked at an estimated {} MB of the {} MB "
+            "memory budget",
+            monitorIndex, tiles.peakBytes >> 20, limit >> 20);
+      }
+    }
+
+    std::filesystem::path App::nextWallpaperPath(std::uint32_t monitorIndex) {
+      auto& state = monitorStates.at(monitorIndex);
+      return tempDirectory /
+             std::format(fileNameFormat, fileNamePrefix, monitorIndex,
+                         std::chrono::system_clock::now(), state.generation++);
+    }
+
+    std::chrono::steady_clock::duration App::transitionDelay(
+        std::uint32_t monitorIndex) const {
+      const auto& monitor = config.monitors.at(monitorIndex);
+      return monitor.transitionDelay ? *monitor.transitionDelay
+                                     : config.globalTransitionDelay;
+    }
+
+    boost::gil::rgb8_image_t App::makeNextWallpaper(
+        std::uint32_t monitorIndex, TileStats& tiles) {
+      auto& state = monitorStates.at(monitorIndex);
+
+      const auto res = monitorResolution(monitorIndex);
+      boost::gil::rgb8_image_t combined(res.first, res.second,
+                                        toPixel(config.background));
+      auto layout =
+          state.tileGroup
+              ? sharedLayout(monitorIndex, res.first, res.second)
+              : layoutWallpaper(monitorIndex, res.first, res.second);
+
+      std::uint64_t sharedTiles = 0;
+      const auto failed = drawTiles(
+          boost::gil::view(combined), layout.sources, layout.rois,
+          [&](ImageId id, auto width, auto height) -> TileCache::Tile {
+            if (!state.tileGroup) {
+              return std::make_shared<const boost::gil::rgb8_image_t>(
+                  makeTile(id, width, height, tiles));
+            }
+            bool made = false;
+            auto tile = state.tileGroup->tiles.get(
+                state.round, id, width, height, [&] {
+                  made = true;
+                  return makeTile(id, width, height, tiles);
+                });
+            sharedTiles += made ? 0 : 1;
+            return tile;
+          },
+          tiles);
+      dropSources(monitorIndex, layout, failed);
+
+      if (state.tileGroup) {
+        log(severity_level::debug,
+            "Monitor {} reused {} of {} tiles decoded for other monitors",
+            monitorIndex, sharedTiles, layout.rois.size());
+      }
+      finishRound(monitorIndex);
 
       return combined;
     }
 
-    void App::stop() {
-      for (auto& timer : timers) {
-        timer.cancel();
+    App::Layout App::sharedLayout(std::uint32_t monitorIndex,
+                                  std::uint32_t width, std::uint32_t height) {
+      auto& state = monitorStates.at(monitorIndex);
+      auto& group = *state.tileGroup;
+      state.round = std::max(state.round, group.tiles.oldestRound());
+
+      std::lock_guard lock(group.mutex);
+      if (auto iter = group.layouts.find(state.round);
+          iter != group.layouts.end()) {
+        return iter->second;
       }
+      // laid out under the lock so the others wait for it rather than
+      // picking sources of their own
+      return group.layouts[state.round] =
+                 layoutWallpaper(monitorIndex, width, height);
     }
 
-    void App::onTimerExpiry(boost::asio::steady_timer& timer,
-                            unsigned monitorIndex, const std::string& name,
-                            const boost::system::error_code& ec) {
-      try {
-        if (ec) {
-          if (ec == asio::error::operation_aborted) {
-            log(severity_level::info,
-                "Async operation cancelled for monitor {}", monitorIndex);
-            return;
+    void App::finishRound(std::uint32_t monitorIndex) {
+      auto& state = monitorStates.at(monitorIndex);
+      if (auto* group = state.tileGroup.get()) {
+        const bool released = group->tiles.finishRound(state.round);
+        std::lock_guard lock(group->mutex);
+        if (released) {
+          group->layouts.erase(state.round);
+        }
+        // rounds left behind by a monitor that fell too far behind
+        std::erase_if(group->layouts,
+                      [oldest = group->tiles.oldestRound()](const auto& item) {
+                        return item.first < oldest;
+                      });
+      }
+      ++state.round;
+    }
+
+    App::Layout App::layoutWallpaper(std::uint32_t monitorIndex,
+                                     std::uint32_t width,
+                                     std::uint32_t height) {
+      auto& state = monitorStates.at(monitorIndex);
+
+      const auto accept = [&](std::size_t index) {
+        // includes sources quarantined by another monitor since the last
+        // wallpaper
+        if (state.sampler.weight(index) == 0) {
+          return false;
+        }
+        if (!isUsableSource(state.sources[index])) {
+          state.sampler.set(index, 0.0);
+          return false;
+        }
+        return true;
+      };
+
+      Layout layout;
+      layout.indices =
+          pickDistinct(state.sampler, sampleSize, state.mt, accept);
+
+      // rebuilt only when the catalog grows by half, so the background
+      // catalog causes a handful of rebuilds rather than one per wallpaper
+      if (const auto usable = usableCount.load();
+          !state.gapIndex || state.gapIndex->height() != height ||
+          usable > state.gapIndexUsable + state.gapIndexUsable / 2) {
+        state.gapIndex = indexSources(state.sources, state.sampler, height);
+        state.gapIndexUsable = usable;
+      }
+      fillGap(layout.indices, state.sources, *state.gapIndex, width, state.mt,
+              accept);
+
+      for (const auto index : layout.indices) {
+        layout.sources.push_back(state.sources[index]);
+      }
+      layout.rois = layoutSources(layout.sources, width, height);
+      return layout;
+    }
+
+    void App::dropSources(std::uint32_t monitorIndex, const Layout& layout,
+                          std::span<const ImageId> failed) {
+      auto& state = monitorStates.at(monitorIndex);
+      // failed sources are only tried again once the file is replaced
+      for (const auto index : layout.indices) {
+        if (std::ranges::find(failed, state.sources[index]) != failed.end()) {
+          state.sampler.set(index, 0.0);
+        }
+      }
+    }
+
+    GapIndex App::indexSources(std::span<const ImageId> sources,
+                               const WeightedSampler& sampler,
+                               std::uint32_t height) const {
+      std::vector<GapIndex::Entry> entries;
+      {
+        std::shared_lock lock(catalogMutex);
+        for (std::size_t i = 0; i < sources.size(); ++i) {
+          if (catalog.status(sources[i]) == Catalog::Status::usable) {
+            entries.push_back(
+                {getScaledDimsFromHeight(height, catalog.info(sources[i]))
+                     .first,
+                 sampler.weight(i), i});
+          }
+        }
+      }
+      return GapIndex(height, std::move(entries));
+    }
+
+    void App::fillGap(std::vector<std::size_t>& picked,
+                      std::span<const ImageId> sources, const GapIndex& gaps,
+                      std::uint32_t width, std::mt19937& rng,
+                      const std::function<bool(std::size_t)>& accept) const {
+      const auto scaledWidth = [&](std::size_t index) {
+        return getScaledDimsFromHeight(gaps.height(),
+                                       sourceInfo(sources[index]))
+            .first;
+      };
+
+      // the same rule as determineRoisFromImageInfo, the row ends at the
+      // first source which does not fit
+      std::uint32_t used = 0;
+      std::size_t fitted = 0;
+      for (; fitted < picked.size(); ++fitted) {
+        const auto sourceWidth = scaledWidth(picked[fitted]);
+        if (used + sourceWidth > width) {
+          break;
+        }
+        used += sourceWidth;
+      }
+
+      for (std::size_t attempt = 0; attempt < maxGapFillAttempts; ++attempt) {
+        const auto index = gaps.pick(width - used, rng);
+        if (!index) {
+          break;
+        }
+        const auto row = picked.begin() + static_cast<std::ptrdiff_t>(fitted);
+        if (const auto found = std::ranges::find(picked, *index);
+            found < row) {
+          continue;
+        } else if (found != picked.end()) {
+          std::rotate(row, found, found + 1);
+        } else if (accept(*index)) {
+          picked.insert(row, *index);
+        } else {
+          continue;
+        }
+        used += scaledWidth(*index);
+        ++fitted;
+      }
+    }
+
+    std::vector<App::Roi> App::layoutSources(std::span<const ImageId> sources,
+                                             std::uint32_t width,
+                                             std::uint32_t height) const {
+      auto info = sources | std::views::transform([this](ImageId id) {
+                    return sourceInfo(id);
+                  });
+
+      // only the size of the view is used by the layout
+      const boost::gil::rgb8_view_t bounds(
+          boost::gil::point_t(width, height), boost::gil::rgb8_loc_t());
+      return determineRoisFromImageInfo(bounds, info);
+    }
+
+    std::vector<ImageId> App::drawTiles(const boost::gil::rgb8_view_t& canvas,
+                                        std::span<ImageId> sources,
+                                        std::span<const Roi> rois,
+                                        const TileLoader& loadTile,
+                                        TileStats& tiles) {
+      // sources past the end of the layout replace tiles which fail
+      auto spares = sources.subspan(rois.size());
+      std::vector<ImageId> failed;
+      std::optional<GutterFill> gutters;
+      if (config.blurGutters) {
+        gutters.emplace(static_cast<std::uint32_t>(canvas.width()),
+                        static_cast<std::uint32_t>(canvas.height()));
+      }
+
+      for (const auto& [id, roi] : std::views::zip(sources, rois)) {
+        const auto tileWidth =
+            static_cast<std::uint32_t>(roi.second.x - roi.first.x);
+        const auto tileHeight =
+            static_cast<std::uint32_t>(roi.second.y - roi.first.y);
+        const auto slot = boost::gil::subimage_view(
+            canvas, roi.first.x, roi.first.y, tileWidth, tileHeight);
+
+        bool drawn = true;
+        try {
+          const auto tile = loadTile(id, tileWidth, tileHeight);
+          boost::gil::copy_pixels(boost::gil::const_view(*tile), slot);
+        } catch (...) {
+          ++tiles.failures;
+          handleTileFailure(id, std::current_exception());
+          failed.push_back(id);
+          drawn = refillTile(slot, spares, tiles);
+          if (drawn) {
+            ++tiles.refills;
           } else {
-            asio::detail::throw_error(ec);
+            ++tiles.unfilled;
           }
         }
+        // added while the tile is still in cache
+        if (gutters && drawn) {
+          gutters->addTile(slot, static_cast<std::uint32_t>(roi.first.x),
+                           static_cast<std::uint32_t>(roi.first.y));
+        }
+      }
 
-        const auto currentWallpaperPath = tempDirectory / name;
-        setter.setWallpaper(monitorIndex, currentWallpaperPath);
+      if (gutters) {
+        gutters->fill(canvas, gutterBrightness);
+      }
+      return failed;
+    }
 
-        auto next = makeNextWallpaper(monitorIndex);
-        const auto now = std::chrono::system_clock::now();
-        const auto nextName = std::vformat(
-            fileNameFormat, std::make_format_args(monitorIndex, now));
+    void App::composeBandedWallpaper(std::uint32_t monitorIndex,
+                                     const std::filesystem::path& outPath,
+                                     TileStats& tiles) {
+      const auto [width, height] = monitorResolution(monitorIndex);
+      auto layout = layoutWallpaper(monitorIndex, width, height);
 
-        // Remove old files
-        for (const auto& entry :
-             std::filesystem::directory_iterator(tempDirectory)) {
-          if (entry.path() != currentWallpaperPath) {
-            log(severity_level::debug, "Removing item: {}",
-                entry.path().string());
-            std::filesystem::remove_all(entry);
+      auto spares = std::span(layout.sources).subspan(layout.rois.size());
+      std::vector<ImageId> failed;
+
+      // every tile is opened before the first band is written, while a
+      // source which fails can still be swapped for a spare
+      std::vector<BandTile> bandTiles;
+      std::vector<ImageId> bandTileIds;
+      for (const auto& [id, roi] :
+           std::views::zip(layout.sources, layout.rois)) {
+        const auto x = static_cast<std::uint32_t>(roi.first.x);
+        const auto y = static_cast<std::uint32_t>(roi.first.y);
+        const auto tileWidth = static_cast<std::uint32_t>(roi.second.x) - x;
+        const auto tileHeight = static_cast<std::uint32_t>(roi.second.y) - y;
+        try {
+          bandTiles.push_back({sourcePath(id), x, y,
+                               openTileRows(id, tileWidth, tileHeight)});
+          bandTileIds.push_back(id);
+        } catch (...) {
+          ++tiles.failures;
+          handleTileFailure(id, std::current_exception());
+          failed.push_back(id);
+          if (auto refill =
+                  refillBandTile(x, y, tileWidth, tileHeight, spares)) {
+            bandTiles.push_back(std::move(refill->second));
+            bandTileIds.push_back(refill->first);
+            ++tiles.refills;
+          } else {
+            ++tiles.unfilled;
           }
         }
+      }
 
-        boost::gil::write_view(
-            tempDirectory / nextName, boost::gil::const_view(next),
-            boost::gil::image_write_info<boost::gil::jpeg_tag>());
-        const auto delay = config.monitors[monitorIndex].transitionDelay
-                               ? *config.monitors[monitorIndex].transitionDelay
-                               : config.globalTransitionDelay;
+      try {
+        JpegWriter writer(outPath, width, height);
+        composeBands(bandTiles, writer, width, height, config.bandHeight,
+                     toPixel(config.background),
+                     [&](const BandTile& tile, std::exception_ptr error) {
+                       // rows already written cannot be taken back, so the
+                       // rest of the tile is left as background
+                       const auto id = bandTileIds[static_cast<std::size_t>(
+                           &tile - bandTiles.data())];
+                       ++tiles.failures;
+                       ++tiles.unfilled;
+                       handleTileFailure(id, error);
+                       failed.push_back(id);
+                     });
+        writer.finish();
+      } catch (...) {
+        std::error_code ec;
+        std::filesystem::remove(outPath, ec);
+        throw;
+      }
 
-        log(severity_level::debug, "Next wallpaper for monitor {} saved to {}",
-            monitorIndex, (tempDirectory / nextName).string());
-        log(severity_level::debug, "Next wallpaper will be set in {}", delay);
-
-        timer.expires_after(delay);
-        timer.async_wait(
-            [this, &timer, monitorIndex, nextName](const auto& ec) {
-              onTimerExpiry(timer, monitorIndex, nextName, ec);
-            });
+      dropSources(monitorIndex, layout, failed);
+    }
+
+    std::uint32_t App::decodeScale(const ImageInfo& info, std::uint32_t width,
+                                   std::uint32_t height) const {
+      const auto scale =
+          chooseDecodeScale(info, width, height, config.maxDecodePixels);
+      if (!scale) {
+        throw DecodeError(std::format(
+            "{}x{} is over the decode budget of {} pixels", info.width(),
+            info.height(), config.maxDecodePixels));
+      }
+      return *scale;
+    }
+
+    std::unique_ptr<TileRows> App::openTileRows(ImageId id,
+                                                std::uint32_t width,
+                                                std::uint32_t height) const {
+      const auto info = sourceInfo(id);
+      return std::make_unique<TileRows>(openSource(id), info.getType(),
+                                        decodeScale(info, width, height),
+                                        width, height,
+                                        toPixel(config.background));
+    }
+
+    boost::gil::rgb8_image_t App::makeTile(ImageId id, std::uint32_t width,
+                                           std::uint32_t height,
+                                           TileStats& tiles) const {
+      const auto info = sourceInfo(id);
+      auto scale = decodeScale(info, width, height);
+
+      // the decoded image, the first level of its pyramid and the tile
+      const auto tileBytes = std::uint64_t{width} * height * 3;
+      const auto cost = [&](std::uint32_t s) {
+        const auto decoded = estimateDecodeBytes(info, s);
+        return decoded + decoded / 4 + tileBytes;
+      };
+      // a decode which cannot fit beside the wallpapers being made is made
+      // smaller, at some cost in sharpness, rather than going ahead alone
+      if (memoryBudget->limit() > 0 && supportsReducedScale(info.getType())) {
+        const auto headroom = memoryBudget->headroom();
+        while (scale < maxDecodeScale && cost(scale) > headroom) {
+          scale *= 2;
+        }
+      }
+      const auto reservation = memoryBudget->borrow(cost(scale));
+      tiles.peakBytes = std::max(tiles.peakBytes, memoryBudget->used());
+
+      const auto file = openSource(id);
+      auto decoded = decodeImageRgb8(file.data(), info.getType(),
+                                     toPixel(config.background), scale);
+      tiles.decodedPixels += decoded.width() * decoded.height();
+      if (decoded.width() == width && decoded.height() == height) {
+        return decoded;
+      }
+
+      boost::gil::rgb8_image_t tile(width, height);
+      resample(boost::gil::const_view(decoded), boost::gil::view(tile));
+      return tile;
+    }
+
+    void App::handleTileFailure(ImageId id, std::exception_ptr error) {
+      const auto path = sourcePath(id);
+      try {
+        std::rethrow_exception(error);
+      } catch (const DecodeError& e) {
+        quarantine.add(path, e.what());
+        std::lock_guard lock(catalogMutex);
+        catalog.setUnusable(id);
       } catch (const std::exception& e) {
-        if (!eptr) {
-          eptr = std::make_exception_ptr(e);
-          stop();
+        log(severity_level::warning, "Failed to make a tile from {}: {}",
+            path.string(), e.what());
+      } catch (...) {
+        log(severity_level::warning, "Failed to make a tile from {}",
+            path.string());
+      }
+    }
+
+    bool App::refillTile(const boost::gil::rgb8_view_t& slot,
+                         std::span<ImageId>& spares, TileStats& tiles) {
+      const auto slotWidth = static_cast<std::uint32_t>(slot.width());
+      const auto slotHeight = static_cast<std::uint32_t>(slot.height());
+
+      for (std::size_t attempt = 0;
+           attempt < maxRefillAttempts && !spares.empty(); ++attempt) {
+        const auto id = takeSpare(slotWidth, slotHeight, spares);
+        if (!isUsableSource(id)) {
+          continue;
+        }
+
+        const auto [width, height] =
+            getScaledDimsToFit(slotWidth, slotHeight, sourceInfo(id));
+        try {
+          const auto tile = makeTile(id, width, height, tiles);
+          boost::gil::copy_pixels(
+              boost::gil::const_view(tile),
+              boost::gil::subimage_view(
+                  slot, static_cast<std::ptrdiff_t>((slotWidth - width) / 2),
+                  static_cast<std::ptrdiff_t>((slotHeight - height) / 2),
+                  static_cast<std::ptrdiff_t>(width),
+                  static_cast<std::ptrdiff_t>(height)));
+          log(severity_level::debug, "Refilled a failed tile with {}",
+              sourcePath(id).string());
+          return true;
+        } catch (...) {
+          handleTileFailure(id, std::current_exception());
+        }
+      }
+      return false;
+    }
+
+    std::optional<std::pair<ImageId, BandTile>> App::refillBandTile(
+        std::uint32_t x, std::uint32_t y, std::uint32_t slotWidth,
+        std::uint32_t slotHeight, std::span<ImageId>& spares) {
+      for (std::size_t attempt = 0;
+           attempt < maxRefillAttempts && !spares.empty(); ++attempt) {
+        const auto id = takeSpare(slotWidth, slotHeight, spares);
+        if (!isUsableSource(id)) {
+          continue;
+        }
+
+        const auto [width, height] =
+            getScaledDimsToFit(slotWidth, slotHeight, sourceInfo(id));
+        try {
+          BandTile tile{sourcePath(id), x + (slotWidth - width) / 2,
+                        y + (slotHeight - height) / 2,
+                        openTileRows(id, width, height)};
+          log(severity_level::debug, "Refilled a failed tile with {}",
+              tile.path.string());
+          return std::pair(id, std::move(tile));
+        } catch (...) {
+          handleTileFailure(id, std::current_exception());
+        }
+      }
+      return std::nullopt;
+    }
+
+    ImageId App::takeSpare(std::uint32_t slotWidth, std::uint32_t slotHeight,
+                           std::span<ImageId>& spares) const {
+      const double slotAspect = static_cast<double>(slotWidth) / slotHeight;
+      // the spare closest to the slot's shape leaves the smallest gap.
+      // Spares are shuffled so ties are broken randomly
+      const auto best = std::ranges::min_element(
+          spares, std::less{}, [this, slotAspect](ImageId id) {
+            const auto info = sourceInfo(id);
+            const double aspect =
+                static_cast<double>(info.width()) / info.height();
+            return std::abs(std::log(aspect / slotAspect));
+          });
+      std::ranges::swap(*best, spares.front());
+      const auto id = spares.front();
+      spares = spares.subspan(1);
+      return id;
+    }
+
+    std::pair<std::uint32_t, std::uint32_t> App::monitorResolution(
+        std::uint32_t monitorIndex) {
+      auto& state = monitorStates.at(monitorIndex);
+      const auto topology = setter.topology();
+      if (topology->version == state.topologyVersion) {
+        return state.resolution;
+      }
+
+      const auto resolution = topology->resolution(monitorIndex);
+      if (state.topologyVersion != 0 && resolution != state.resolution) {
+        log(severity_level::info, "Monitor {} changed from {}x{} to {}x{}",
+            monitorIndex, state.resolution.first, state.resolution.second,
+            resolution.first, resolution.second);
+        // both were built for the old size
+        state.gapIndex.reset();
+        if (state.tileGroup) {
+          state.tileGroup->tiles.leave(state.round);
+          state.tileGroup.reset();
+        }
+      }
+      state.topologyVersion = topology->version;
+      state.resolution = resolution;
+      return resolution;
+    }
+
+    void App::shareTileCaches() {
+      if (config.bandHeight > 0) {
+        // banded wallpapers stream their tiles, there is nothing to share
+        return;
+      }
+
+      std::map<std::tuple<std::uint32_t, std::uint32_t,
+                          std::chrono::steady_clock::duration, std::uint64_t>,
+               std::vector<std::uint32_t>>
+          groups;
+      for (auto i : config.monitors | std::views::keys) {
+        const auto [width, height] = monitorResolution(i);
+        groups[{width, height, transitionDelay(i),
+                monitorStates.at(i).sourcesFingerprint}]
+            .push_back(i);
+      }
+
+      for (const auto& members : groups | std::views::values) {
+        if (members.size() < 2) {
+          continue;
+        }
+        // a monitor can be a full queue and the wallpaper it is making
+        // behind the others before it stops sharing
+        auto group = std::make_shared<TileGroup>(
+            members.size(), config.prefetch + 2, *memoryBudget);
+        for (auto i : members) {
+          monitorStates.at(i).tileGroup = group;
+          log(severity_level::debug,
+              "Monitor {} shares decoded tiles with {} other monitor(s)", i,
+              members.size() - 1);
         }
       }
     }
 
+    void App::stop() {
+      stopped = true;
+      // timers and queues are only touched from the timer context
+      asio::post(timerContext, [this] {
+        for (auto& state : monitorStates | std::views::values) {
+          state.timer.cancel();
+          state.retryTimer.cancel();
+          state.queue.close();
+        }
+      });
+    }
+
   }  // namespace wp
 }  // namespace brilliant
\ No newline at end of file
@@ -9,19 +9,43 @@
 #pragma once
 
 #include <atomic>
+#include <cstdint>
 #include <exception>
+#include <deque>
 #include <filesystem>
+#include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <random>
+#include <shared_mutex>
+#include <span>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/io_context.hpp>
 #include <boost/asio/steady_timer.hpp>
+#include <boost/asio/thread_pool.hpp>
 
+#include "AsyncQueue.hpp"
+#include "BandCompositor.hpp"
+#include "Catalog.hpp"
+#include "CommandLine.hpp"
 #include "Config.hpp"
+#include "GapIndex.hpp"
 #include "ImageProcessing.hpp"
+#include "MemoryBudget.hpp"
+#include "MonitorSnapshot.hpp"
+#include "Quarantine.hpp"
+#include "SourceArchive.hpp"
+#include "Stats.hpp"
+#include "SystemLoad.hpp"
+#include "TileCache.hpp"
 #include "WallpaperSetter.hpp"
+#include "WeightedSampler.hpp"
 
 namespace brilliant {
   namespace wp {
@@ -30,55 +54,719 @@ namespace brilliant {
      * application
      *
      * A standalone class was used to allow for easier exception handling across
-     * threads and to separate app functionality into logical pieces. The app 
-     * creates a thread pool to handle creation and setting of wallpapers. 
-     * 
-     * The first time the app is run, a wallpaper is generated for each configured 
-     * monitor and the wallpaper is set when that is done. The next wallpaper is generated 
-     * and stored and then a timer dedicated to that monitor is set. Once the timer
-     * expires the previously generated wallpaper is set for that monitor and the process
-     * begins again.
+     * threads and to separate app functionality into logical pieces.
+     *
+     * Source paths are interned into a Catalog shared by every monitor and
+     * monitors only hold the IDs of their sources.
+     *
+     * Each configured monitor is driven by its own coroutine. The coroutines
+     * and their timers live on a dedicated io_context so a transition is never
+     * queued behind image work. Decoding, scaling and encoding are handed off
+     * to a separate worker pool and the coroutine resumes on the timer context
+     * once the work is done. Probing sources and making a wallpaper that is
+     * due soon go to a small I/O pool at normal priority instead, so the
+     * worker pool can be confined to idle CPUs with Config::lowPriority and
+     * Config::cpuAffinity without holding up a transition.
+     *
+     * Each wallpaper is made from a small sample of the monitor's sources,
+     * picked in proportion to their configured weights. A source is probed
+     * the first time it is picked, so startup does not grow with the size of
+     * the library, and the rest are cataloged in the background. After the
+     * first wallpaper a producer keeps up to Config::prefetch
+     * wallpapers rendered ahead and the monitor's timer sets the oldest one
+     * each time it expires.
      */
     class App {
     public:
       /**
        * @brief Construct an App object
-       * @param argc The number of arguments from the command line
-       * @param argv Arguments from the command line
+       * @param options Options from the command line
        */
-      App(int argc, const char* argv[]);
+      explicit App(const CommandLine& options);
 
       /**
        * @brief Run the app
-       * 
-       * Starts the thread pool and delegates building wallpapers to the pool threads.
+       *
+       * Starts a coroutine per monitor and runs the timer context until every
+       * monitor has stopped.
        */
       void run();
 
+      /**
+       * @brief Render a batch of wallpapers to a directory
+       * @param options The number and size of the wallpapers and where they
+       * are written
+       *
+       * Every configured source is cataloged, then the wallpapers are made
+       * in parallel on the worker pool from random samples of the sources.
+       * Each wallpaper is seeded from the app's seed and its own index, so a
+       * run with the same seed and sources always makes the same wallpapers
+       * however the work is scheduled. The time taken by each wallpaper and
+       * the throughput of the whole batch are printed.
+       */
+      void render(const RenderOptions& options);
+
       /**
        * @brief Make the next wallpaper
        * @param monitorIndex The monitor to generate a wallpaper for
+       * @param tiles Incremented for each tile whose source failed
        * @return The generated image
+       *
+       * A tile whose source fails to load is replaced by the unused source
+       * closest to its shape, fitted inside the same region. The rest of the
+       * layout is kept. Failed sources are dropped from the monitor and
+       * sources which cannot be decoded are quarantined.
        */
-      ImageType makeNextWallpaper(unsigned monitorIndex);
+      boost::gil::rgb8_image_t makeNextWallpaper(std::uint32_t monitorIndex,
+                                                 TileStats& tiles);
 
       /**
-       * @brief Stop the thread pool
+       * @brief Stop every monitor
+       *
+       * Safe to call from any thread. Pending timers are cancelled and work
+       * already running on the worker pool is allowed to finish.
        */
       void stop();
 
+    private:
       /**
-       * @brief Callback to handle setting the wallpaper on timer expiry.
-       * @param timer The timer object that is handling the callback
-       * @param monitorIndex The index of the monitor that is having its wallpaper set
-       * @param name The name of the file to set as the wallpaper
-       * @param ec An error code passed from the timer
+       * @brief A wallpaper which has been shown, kept to show again
        */
-      void onTimerExpiry(boost::asio::steady_timer& timer,
-                         unsigned monitorIndex, const std::string& name,
-                         const boost::system::error_code& ec);
+      struct RecentWallpaper {
+        //! The path to the saved wallpaper
+        std::filesystem::path path;
+
+        //! The display topology version it was shown with
+        std::uint64_t topologyVersion;
+      };
+
+      struct TileGroup;
+
+      /**
+       * @brief Per monitor state, only touched by that monitor's coroutine
+       */
+      struct MonitorState {
+        //! The timer used to wait for the next transition
+        boost::asio::steady_timer timer;
+
+        //! The timer used to wait before retrying a failed render or
+        //! checking the load again
+        boost::asio::steady_timer retryTimer;
+
+        //! Wallpapers rendered ahead of their transition
+        AsyncQueue<std::filesystem::path> queue;
+
+        //! A random number generator for this monitor
+        std::mt19937 mt;
+
+        //! mt as of the last wallpaper made, which is what is saved as mt
+        //! may be in use by a render
+        std::mt19937 savedMt{};
+
+        //! The snapshot fingerprint as of the last wallpaper made
+        std::uint64_t savedFingerprint = 0;
+
+        //! A Fingerprint of the configured sources and their weights
+        std::uint64_t sourcesFingerprint = 0;
+
+        //! The wallpaper being shown, empty before the first
+        std::filesystem::path current{};
+
+        //! The number of wallpapers generated, used to keep file names unique
+        std::uint64_t generation = 0;
+
+        //! Scheduling counters
+        MonitorStats stats{};
+
+        //! Tiles and layouts shared with monitors of the same resolution,
+        //! delay and sources. Null when no other monitor matches
+        std::shared_ptr<TileGroup> tileGroup{};
+
+        //! The next round of tileGroup this monitor will finish. Rounds
+        //! count the wallpapers shown, made or not
+        std::uint64_t round = 0;
+
+        //! Every configured source. A source's index is its index in
+        //! sampler
+        std::vector<ImageId> sources{};
+
+        //! Picks sources by their configured weights. Sources which are
+        //! unusable or have failed are given a weight of 0
+        WeightedSampler sampler{};
+
+        //! Sources not probed yet, only touched by catalogSources
+        std::vector<ImageId> pending{};
+
+        //! Usable sources by their width at the monitor's height, used to
+        //! fill the end of each row. Null until the first wallpaper
+        std::optional<GapIndex> gapIndex{};
+
+        //! App::usableCount when gapIndex was built
+        std::size_t gapIndexUsable = 0;
+
+        //! The display topology version resolution was read from, 0 before
+        //! the first wallpaper
+        std::uint64_t topologyVersion = 0;
+
+        //! The width and height of the monitor in pixels
+        std::pair<std::uint32_t, std::uint32_t> resolution{};
+
+        //! When the next wallpaper is due, the epoch until the first one is
+        //! set
+        std::chrono::steady_clock::time_point deadline{};
+
+        //! Wallpapers shown recently, oldest first. Only kept with
+        //! Config::deferWhenBusy
+        std::deque<RecentWallpaper> recent{};
+
+        //! A moving average of how long a render takes, 0 before the first
+        std::chrono::steady_clock::duration renderTime{};
+      };
+
+      /**
+       * @brief Intern a monitor's configured sources and their weights
+       * @param monitorIndex The index of the monitor
+       *
+       * Nothing is probed. Every source is left in MonitorState::pending in
+       * a random order.
+       */
+      void internSources(std::uint32_t monitorIndex);
+
+      /**
+       * @brief Record where a monitor's sources in archives are
+       * @param monitor The monitor's config, its archive members are
+       * cleared as the catalog holds them from then on
+       */
+      void internArchiveMembers(ConfigMonitor& monitor);
+
+      /**
+       * @brief Probe a monitor's pending sources on the I/O pool
+       * @param monitorIndex The index of the monitor
+       * @return An awaitable which completes when every source is probed or
+       * the monitor is stopped
+       *
+       * Sources are probed a batch at a time so they are ready before they
+       * are picked.
+       */
+      boost::asio::awaitable<void> catalogSources(std::uint32_t monitorIndex);
+
+      /**
+       * @brief Get the cached metadata of a usable source
+       * @param id The source image, must have passed isUsableSource
+       * @return A copy of the metadata
+       */
+      ImageInfo sourceInfo(ImageId id) const;
+
+      /**
+       * @brief Get the path of a source
+       * @param id The source image
+       * @return The path
+       */
+      std::filesystem::path sourcePath(ImageId id) const;
+
+      /**
+       * @brief Map a source's contents, from its file or its archive
+       * @param id The source image
+       * @param hint How the contents will be accessed
+       * @return The encoded source
+       * @throws std::system_error if the file or archive cannot be mapped
+       * @throws ArchiveError if the source cannot be read from its archive
+       */
+      SourceFile openSource(ImageId id,
+                            AccessHint hint = AccessHint::sequential) const;
+
+      /**
+       * @brief Run a monitor coroutine on the timer context
+       * @param task The coroutine to run
+       *
+       * The first exception thrown by any task is stored and stops the app.
+       */
+      void spawn(boost::asio::awaitable<void> task);
+
+      /**
+       * @brief Get the file a monitor's snapshot is saved to
+       * @param monitorIndex The index of the monitor
+       * @return The path in the temp directory
+       */
+      std::filesystem::path snapshotPath(std::uint32_t monitorIndex) const;
+
+      /**
+       * @brief Identify what a monitor's wallpapers are made from
+       * @param monitorIndex The index of the monitor
+       * @return A Fingerprint of the monitor's resolution, sources and
+       * weights and the background colour
+       *
+       * Only called while the monitor is not rendering, as it reads the
+       * resolution.
+       */
+      std::uint64_t snapshotFingerprint(std::uint32_t monitorIndex);
+
+      /**
+       * @brief Carry on from a monitor's saved snapshot
+       * @param monitorIndex The index of the monitor
+       * @return True if the snapshot was used
+       *
+       * The snapshot is used if it was saved for the same fingerprint. Its
+       * wallpapers are queued and its deadline kept, so nothing is made
+       * again. A deadline which passed while the app was not running is
+       * due at once.
+       */
+      bool restoreSnapshot(std::uint32_t monitorIndex);
+
+      /**
+       * @brief Save a monitor's snapshot
+       * @param monitorIndex The index of the monitor
+       *
+       * Only called from the timer context.
+       */
+      void writeSnapshot(std::uint32_t monitorIndex);
+
+      /**
+       * @brief The transition loop for a single monitor
+       * @param monitorIndex The index of the monitor
+       * @return An awaitable which completes when the monitor is stopped
+       *
+       * Sets the first wallpaper, restored or made at once, then sets the
+       * next queued wallpaper each time the transition delay passes. A
+       * wallpaper that is not ready in time is counted and reported as a
+       * missed deadline rather than shifting the schedule.
+       */
+      boost::asio::awaitable<void> runMonitor(std::uint32_t monitorIndex);
+
+      /**
+       * @brief The generation loop for a single monitor
+       * @param monitorIndex The index of the monitor
+       * @return An awaitable which completes when the monitor is stopped
+       *
+       * Keeps the monitor's queue filled up to the prefetch depth. Nothing is
+       * generated while the queue is full.
+       *
+       * With Config::deferWhenBusy each render waits for the machine to be
+       * idle. If it is still busy when the render has to start to be ready
+       * in time, a recent wallpaper is queued again instead, or the render
+       * goes ahead if there is none.
+       */
+      boost::asio::awaitable<void> produceWallpapers(
+          std::uint32_t monitorIndex);
+
+      /**
+       * @brief Wait for the machine to be idle
+       * @param monitorIndex The index of the monitor
+       * @param due When the wallpaper about to be made will be shown
+       * @return An awaitable holding true once the machine is idle or the
+       * monitor is stopped, false if it is still busy when the render has
+       * to start
+       *
+       * The render has to start twice the usual render time before it is
+       * due, as a busy machine renders slower. The load is checked every
+       * few seconds until then.
+       */
+      boost::asio::awaitable<bool> waitForIdle(
+          std::uint32_t monitorIndex,
+          std::chrono::steady_clock::time_point due);
+
+      /**
+       * @brief Keep or remove a wallpaper which has been replaced
+       * @param monitorIndex The index of the monitor
+       * @param path The wallpaper
+       *
+       * Kept in MonitorState::recent with Config::deferWhenBusy, removing
+       * the oldest beyond a few, otherwise removed.
+       */
+      void retireWallpaper(std::uint32_t monitorIndex,
+                           std::filesystem::path path);
+
+      /**
+       * @brief Take the oldest recent wallpaper to show again
+       * @param monitorIndex The index of the monitor
+       * @return The path of the wallpaper, or nullopt if none was shown with
+       * the current display topology
+       */
+      std::optional<std::filesystem::path> takeRecentWallpaper(
+          std::uint32_t monitorIndex);
+
+      /**
+       * @brief A wallpaper saved to the temp directory
+       */
+      struct RenderedWallpaper {
+        //! The path to the saved wallpaper
+        std::filesystem::path path;
+
+        //! Tile failures while making the wallpaper
+        TileStats tiles;
+      };
+
+      /**
+       * @brief Render wallpapers on the worker pool until one succeeds
+       * @param monitorIndex The monitor to generate a wallpaper for
+       * @return An awaitable holding the path to the saved wallpaper, or
+       * nullopt if the monitor was stopped first
+       *
+       * A failed render is counted and logged and only holds up this
+       * monitor. The other monitors keep running.
+       *
+       * With Config::lowPriority a render is moved to the I/O pool when
+       * nothing is queued and less than half the transition delay is left
+       * before the monitor's next deadline, such as the first wallpaper.
+       * A render already running in the background is not moved, so a
+       * prefetch of 2 or more gives a busy machine the most slack.
+       */
+      boost::asio::awaitable<std::optional<std::filesystem::path>>
+      tryRenderWallpaper(std::uint32_t monitorIndex);
+
+      /**
+       * @brief Make the next wallpaper and save it to the temp directory
+       * @param monitorIndex The monitor to generate a wallpaper for
+       * @param pool The pool the render is running on, which also encodes
+       * @param threads The number of threads in pool
+       * @return The path to the saved wallpaper and its tile failures
+       *
+       * With Config::bandHeight set the wallpaper is composited and encoded
+       * a band at a time, otherwise it is made in full by makeNextWallpaper
+       * and then encoded.
+       */
+      RenderedWallpaper renderWallpaper(std::uint32_t monitorIndex,
+                                        boost::asio::thread_pool& pool,
+                                        std::size_t threads);
+
+      /**
+       * @brief Reserve the memory budget for a wallpaper's canvas
+       * @param width The width of the wallpaper
+       * @param height The height of the wallpaper
+       * @param tiles Where the peak estimated memory is recorded
+       * @return The reservation, held until the wallpaper is written
+       *
+       * In banded mode only a band of rows is counted.
+       */
+      MemoryBudget::Reservation holdCanvas(std::uint32_t width,
+                                           std::uint32_t height,
+                                           TileStats& tiles) const;
+
+      /**
+       * @brief Log how much of the memory budget a wallpaper used at most
+       * @param monitorIndex The monitor the wallpaper is for
+       * @param tiles The stats of the wallpaper
+       */
+      void logPeakMemory(std::uint32_t monitorIndex,
+                         const TileStats& tiles) const;
+
+      /**
+       * @brief Name the next wallpaper for a monitor
+       * @param monitorIndex The monitor the wallpaper is for
+       * @return A unique path in the temp directory
+       */
+      std::filesystem::path nextWallpaperPath(std::uint32_t monitorIndex);
+
+      //! A region of a wallpaper as its top left and bottom right corners
+      using Roi = std::pair<boost::gil::point_t, boost::gil::point_t>;
+
+      //! Makes or fetches the tile for a source at a width and height
+      using TileLoader =
+          std::function<TileCache::Tile(ImageId, std::uint32_t, std::uint32_t)>;
+
+      /**
+       * @brief Lay out sources in the order given
+       * @param sources The sources to lay out, must have passed
+       * isUsableSource
+       * @param width The width of the wallpaper in pixels
+       * @param height The height of the wallpaper in pixels
+       * @return The region filled by each of the first sources
+       */
+      std::vector<Roi> layoutSources(std::span<const ImageId> sources,
+                                     std::uint32_t width,
+                                     std::uint32_t height) const;
+
+      /**
+       * @brief Draw laid out sources onto a wallpaper
+       * @param canvas The wallpaper to draw on
+       * @param sources The laid out sources followed by the spares
+       * @param rois The region filled by each of the first sources
+       * @param loadTile Makes or fetches the tile for a source
+       * @param tiles Incremented for each tile whose source failed
+       * @return The sources which failed
+       *
+       * A tile whose source fails is refilled from the spares. With
+       * Config::blurGutters the rest of the canvas, including any tile left
+       * empty, is filled with a blur of the tiles by GutterFill.
+       */
+      std::vector<ImageId> drawTiles(const boost::gil::rgb8_view_t& canvas,
+                                     std::span<ImageId> sources,
+                                     std::span<const Roi> rois,
+                                     const TileLoader& loadTile,
+                                     TileStats& tiles);
+
+      /**
+       * @brief The sources picked for a wallpaper and where they go
+       */
+      struct Layout {
+        //! The picked sources. Those after the laid out ones are spares
+        std::vector<ImageId> sources;
+
+        //! The index of each picked source in MonitorState::sources
+        std::vector<std::size_t> indices;
+
+        //! The region filled by each of the first sources
+        std::vector<Roi> rois;
+      };
+
+      /**
+       * @brief What the monitors sharing a TileCache share
+       *
+       * The first monitor to make a round lays it out and the others use
+       * the same layout, so every tile of the round is decoded once.
+       */
+      struct TileGroup {
+        /**
+         * @brief Construct a TileGroup
+         * @param participants The number of monitors in the group
+         * @param maxRounds The most rounds to keep tiles and layouts for
+         * @param budget Tracks the memory of kept tiles
+         */
+        TileGroup(std::size_t participants, std::uint64_t maxRounds,
+                  MemoryBudget& budget)
+            : tiles(participants, maxRounds, &budget) {}
+
+        //! The tiles of each round in flight
+        TileCache tiles;
+
+        //! Guards layouts
+        std::mutex mutex;
+
+        //! The layout of each round in flight
+        std::map<std::uint64_t, Layout> layouts;
+      };
+
+      /**
+       * @brief Get the layout of a grouped monitor's current round
+       * @param monitorIndex The monitor to lay out a wallpaper for, which
+       * must be in a TileGroup
+       * @param width The width of the wallpaper in pixels
+       * @param height The height of the wallpaper in pixels
+       * @return The layout the group's first monitor to make the round
+       * picked
+       *
+       * A monitor which has fallen so far behind that its round has been
+       * released moves on to the group's oldest round first.
+       */
+      Layout sharedLayout(std::uint32_t monitorIndex, std::uint32_t width,
+                          std::uint32_t height);
+
+      /**
+       * @brief Finish a monitor's current round and move on to the next
+       * @param monitorIndex The index of the monitor
+       *
+       * Called once for every wallpaper the monitor shows, whether it was
+       * made, shown again or restored, so monitors sharing tiles stay in
+       * step. Does nothing to the tiles of a monitor not in a group.
+       */
+      void finishRound(std::uint32_t monitorIndex);
+
+      /**
+       * @brief Pick a monitor's sources by weight and lay out the next
+       * wallpaper
+       * @param monitorIndex The monitor to lay out a wallpaper for
+       * @param width The width of the wallpaper in pixels
+       * @param height The height of the wallpaper in pixels
+       * @return The picked sources and their regions
+       *
+       * Picked sources are probed if they have not been yet. Sources which
+       * are unusable, including those quarantined since the last wallpaper,
+       * are dropped from the monitor as they are picked. The gap left at the
+       * end of the row is filled from MonitorState::gapIndex, which is
+       * rebuilt when the height changes or the catalog has grown by half.
+       */
+      Layout layoutWallpaper(std::uint32_t monitorIndex, std::uint32_t width,
+                             std::uint32_t height);
+
+      /**
+       * @brief Index the usable sources of a wallpaper by their scaled width
+       * @param sources The sources. An entry's item is its index here
+       * @param sampler The weight of each source
+       * @param height The height of the wallpaper in pixels
+       * @return The index
+       *
+       * Sources which have not been probed yet are left out.
+       */
+      GapIndex indexSources(std::span<const ImageId> sources,
+                            const WeightedSampler& sampler,
+                            std::uint32_t height) const;
+
+      /**
+       * @brief Fill the space left at the end of a row of picked sources
+       * @param picked Indices into sources in layout order. Sources which
+       * fill the gap are inserted after the ones which fit
+       * @param sources The sources the indices and the gap index refer to
+       * @param gaps The sources by width at the height of the wallpaper
+       * @param width The width of the wallpaper in pixels
+       * @param rng The random number generator
+       * @param accept Called with each index not picked before. Returns
+       * false to leave the source out
+       *
+       * Picked sources which did not fit are spares, a spare which fits the
+       * gap is moved into the row rather than picked again.
+       */
+      void fillGap(std::vector<std::size_t>& picked,
+                   std::span<const ImageId> sources, const GapIndex& gaps,
+                   std::uint32_t width, std::mt19937& rng,
+                   const std::function<bool(std::size_t)>& accept) const;
+
+      /**
+       * @brief Stop picking sources which failed
+       * @param monitorIndex The monitor the sources belong to
+       * @param layout The layout the sources were picked for
+       * @param failed The sources which failed
+       */
+      void dropSources(std::uint32_t monitorIndex, const Layout& layout,
+                       std::span<const ImageId> failed);
+
+      /**
+       * @brief Composite the next wallpaper a band of rows at a time and
+       * encode each band as it is finished
+       * @param monitorIndex The monitor to generate a wallpaper for
+       * @param outPath The file to write
+       * @param tiles Incremented for each tile whose source failed
+       *
+       * Memory use is bounded by Config::bandHeight rather than the height
+       * of the monitor. A tile which fails to open is refilled like in
+       * makeNextWallpaper. A tile which fails part way through keeps the rows
+       * already written and the rest of it is left as background.
+       */
+      void composeBandedWallpaper(std::uint32_t monitorIndex,
+                                  const std::filesystem::path& outPath,
+                                  TileStats& tiles);
+
+      /**
+       * @brief Create the I/O and worker pools from the config
+       *
+       * With Config::lowPriority or Config::cpuAffinity every worker
+       * thread is scheduled before any work is posted. A thread which
+       * cannot be scheduled is logged and keeps the default.
+       */
+      void startWorkers();
+
+      /**
+       * @brief Check a source image can be used and cache its metadata
+       * @param id The source image
+       * @return True if the image can be decoded within the configured limits
+       *
+       * Images which cannot be probed are quarantined. The result is kept
+       * in the catalog so each source is only probed once. Safe to call from
+       * any thread.
+       */
+      bool isUsableSource(ImageId id);
+
+      /**
+       * @brief Decode a source image and scale it to the given size
+       * @param id The source image
+       * @param width The width of the tile in pixels
+       * @param height The height of the tile in pixels
+       * @param tiles Incremented by the number of pixels decoded
+       * @return The scaled tile
+       * @throws DecodeError if the image cannot be decoded within the decode
+       * budget
+       *
+       * Large sources are decoded at the smallest reduced scale which still
+       * covers the tile.
+       */
+      boost::gil::rgb8_image_t makeTile(ImageId id, std::uint32_t width,
+                                        std::uint32_t height,
+                                        TileStats& tiles) const;
+
+      /**
+       * @brief Start streaming a source image scaled to the given size
+       * @param id The source image
+       * @param width The width of the tile in pixels
+       * @param height The height of the tile in pixels
+       * @return The tile's rows
+       * @throws DecodeError if the image cannot be decoded within the decode
+       * budget
+       */
+      std::unique_ptr<TileRows> openTileRows(ImageId id, std::uint32_t width,
+                                             std::uint32_t height) const;
+
+      /**
+       * @brief Choose the scale to decode a source at for a tile
+       * @param info The metadata of the source
+       * @param width The width of the tile in pixels
+       * @param height The height of the tile in pixels
+       * @return The denominator of the decode scale
+       * @throws DecodeError if the source is over the decode budget at every
+       * scale
+       */
+      std::uint32_t decodeScale(const ImageInfo& info, std::uint32_t width,
+                                std::uint32_t height) const;
+
+      /**
+       * @brief Quarantine or log a source which failed to make a tile
+       * @param id The source image
+       * @param error The exception thrown while making the tile
+       */
+      void handleTileFailure(ImageId id, std::exception_ptr error);
+
+      /**
+       * @brief Fill a failed tile's region with a spare source
+       * @param slot The region of the wallpaper the failed tile was to fill
+       * @param spares Sources not used by the layout. Spares which are tried
+       * are removed from the front
+       * @param tiles Incremented by the number of pixels decoded
+       * @return True if a spare was loaded into the slot
+       */
+      bool refillTile(const boost::gil::rgb8_view_t& slot,
+                      std::span<ImageId>& spares, TileStats& tiles);
+
+      /**
+       * @brief Open a spare source in place of a banded tile which failed
+       * @param x The column of the failed tile's left edge
+       * @param y The row of the failed tile's top edge
+       * @param slotWidth The width of the failed tile
+       * @param slotHeight The height of the failed tile
+       * @param spares Sources not used by the layout. Spares which are tried
+       * are removed from the front
+       * @return The spare and its tile fitted and centred in the slot, or
+       * nullopt if no spare could be opened
+       */
+      std::optional<std::pair<ImageId, BandTile>> refillBandTile(
+          std::uint32_t x, std::uint32_t y, std::uint32_t slotWidth,
+          std::uint32_t slotHeight, std::span<ImageId>& spares);
+
+      /**
+       * @brief Take the spare closest to a slot's shape
+       * @param slotWidth The width of the slot
+       * @param slotHeight The height of the slot
+       * @param spares Sources not used by the layout, must not be empty. The
+       * chosen spare is moved to the front and removed from the span
+       * @return The chosen spare
+       */
+      ImageId takeSpare(std::uint32_t slotWidth, std::uint32_t slotHeight,
+                        std::span<ImageId>& spares) const;
+
+      /**
+       * @brief Get the resolution of a monitor for its next wallpaper
+       * @param monitorIndex The index of the monitor
+       * @return A pair containing the width and height in pixels
+       *
+       * When the display topology has changed the resolution of the monitor,
+       * its gap index is dropped and it stops sharing tiles with monitors
+       * which had the same resolution.
+       */
+      std::pair<std::uint32_t, std::uint32_t> monitorResolution(
+          std::uint32_t monitorIndex);
+
+      /**
+       * @brief Group monitors which generate identical wallpaper sizes from
+       * the same sources on the same schedule and give each group a shared
+       * TileGroup
+       */
+      void shareTileCaches();
+
+      /**
+       * @brief Get the delay between transitions for a monitor
+       * @param monitorIndex The index of the monitor
+       * @return The monitor specific delay if set, otherwise the global delay
+       */
+      std::chrono::steady_clock::duration transitionDelay(
+          std::uint32_t monitorIndex) const;
 
-    private:
       //! A flag to indicate the app has been stopped
       std::atomic_bool stopped;
 
@@ -88,8 +776,22 @@ namespace brilliant {
       //! The wallpaper setter object
       WallpaperSetter setter;
 
-      //! Storage for timers handling callbacks 
-      std::vector<boost::asio::steady_timer> timers;
+      //! Runs the monitor coroutines and their timers
+      boost::asio::io_context timerContext;
+
+      //! Probes sources and makes wallpapers that are due soon. Created
+      //! once the config is loaded
+      std::optional<boost::asio::thread_pool> ioWorkers;
+
+      //! Runs decoding, scaling and encoding. Created once the config is
+      //! loaded
+      std::optional<boost::asio::thread_pool> workers;
+
+      //! The number of threads in workers
+      std::size_t workerThreads = 0;
+
+      //! Per monitor state keyed by monitor index
+      std::unordered_map<std::uint32_t, MonitorState> monitorStates;
 
       //! An exception pointer used to get exceptions across thread boundaries
       std::exception_ptr eptr;
@@ -97,18 +799,38 @@ namespace brilliant {
       //! A random device
       std::random_device rd;
 
-      //! A random number generator
+      //! The seed given on the command line, otherwise a random one
+      std::uint32_t seed;
+
+      //! A random number generator, used to seed the per monitor generators
       std::mt19937 mt;
 
-      //! The temp directory. %TEMP%/briliant_wp on Windows and /tmp/brilliant_wp on Linux
+      //! The temp directory. %TEMP%/briliant_wp on Windows and /tmp/brilliant_wp on Linux, unless given on the command line
       std::filesystem::path tempDirectory;
 
       //! The install directory, used to find the config file. %PROGRAM_FILES%/brilliant_wp on Windows, /usr/local/bin/brilliant_wp on Linux
       std::filesystem::path installDirectory;
 
-      //! Map of image paths to their metadata
-      std::unordered_map<std::filesystem::path, ImageInfo> fileInfoCache;
+      //! Source images which failed to load, kept in the temp directory
+      Quarantine quarantine;
+
+      //! Guards catalog, which is filled by the background catalog while
+      //! wallpapers are rendered
+      mutable std::shared_mutex catalogMutex;
+
+      //! Every source image and its metadata
+      Catalog catalog;
+
+      //! The number of sources found usable so far
+      std::atomic_size_t usableCount = 0;
+
+      //! How busy the machine is, only sampled from the timer context
+      LoadMonitor loadMonitor;
+
+      //! Bounds the estimated memory of canvases and decodes. Created once
+      //! the config is loaded
+      mutable std::optional<MemoryBudget> memoryBudget;
     };
 
   }  // namespace wp
-}  // namespace brilliant
\ No newline at end of file
+}  // namespace brilliant
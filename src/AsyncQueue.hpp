@@ -0,0 +1,150 @@
+/**
+ *
+ *  @file      AsyncQueue.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements the AsyncQueue class template
+ */
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <optional>
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief A bounded queue with one producer and one consumer coroutine
+     * @tparam T The queued type
+     *
+     * Both sides must run on the same single threaded executor. The producer
+     * waits for space before doing any work, which is what gives the
+     * wallpaper pipeline its backpressure: nothing is rendered unless there is
+     * a slot for it. Waiting is implemented with a timer per side that is
+     * cancelled to wake the waiter, the usual asio stand-in for a condition
+     * variable.
+     */
+    template <class T>
+    class AsyncQueue {
+    public:
+      /**
+       * @brief Construct an AsyncQueue
+       * @param executor The executor both coroutines run on
+       * @param maxItems The maximum number of queued items
+       */
+      AsyncQueue(const boost::asio::any_io_executor& executor,
+                 std::size_t maxItems)
+          : capacity(maxItems), spaceTimer(executor), itemTimer(executor) {}
+
+      /**
+       * @brief Wait until there is room for another item
+       * @return An awaitable holding false if the queue was closed while
+       * waiting, true otherwise
+       */
+      boost::asio::awaitable<bool> waitForSpace() {
+        while (!closed && items.size() >= capacity) {
+          co_await wait(spaceTimer);
+        }
+        co_return !closed;
+      }
+
+      /**
+       * @brief Wait for an item and remove it from the queue
+       * @return An awaitable holding the item, or nullopt if the queue was
+       * closed while waiting
+       */
+      boost::asio::awaitable<std::optional<T>> pop() {
+        while (!closed && items.empty()) {
+          co_await wait(itemTimer);
+        }
+        co_return tryPop();
+      }
+
+      /**
+       * @brief Remove an item from the queue without waiting
+       * @return The item or nullopt if the queue is empty or closed
+       */
+      std::optional<T> tryPop() {
+        if (closed || items.empty()) {
+          return std::nullopt;
+        }
+        std::optional<T> item(std::move(items.front()));
+        items.pop_front();
+        spaceTimer.cancel();
+        return item;
+      }
+
+      /**
+       * @brief Add an item to the back of the queue
+       * @param item The item to add
+       *
+       * The producer is expected to call waitForSpace() first. Items pushed
+       * past the capacity are still queued.
+       */
+      void push(T item) {
+        items.push_back(std::move(item));
+        itemTimer.cancel();
+      }
+
+      /**
+       * @brief Close the queue and wake both sides
+       */
+      void close() {
+        closed = true;
+        spaceTimer.cancel();
+        itemTimer.cancel();
+      }
+
+      /**
+       * @brief Check if the queue has been closed
+       * @return True if the queue has been closed
+       */
+      bool isClosed() const { return closed; }
+
+      /**
+       * @brief Get the queued items
+       * @return The items, front first
+       */
+      const std::deque<T>& contents() const { return items; }
+
+    private:
+      /**
+       * @brief Block the calling coroutine until the timer is cancelled
+       * @param timer The timer to wait on
+       * @return An awaitable which completes when woken
+       */
+      static boost::asio::awaitable<void> wait(
+          boost::asio::steady_timer& timer) {
+        boost::system::error_code ec;
+        timer.expires_at(std::chrono::steady_clock::time_point::max());
+        co_await timer.async_wait(
+            boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+      }
+
+      //! The queued items
+      std::deque<T> items;
+
+      //! The maximum number of items
+      std::size_t capacity;
+
+      //! Flag set once the queue is closed
+      bool closed = false;
+
+      //! Wakes the producer when an item is removed
+      boost::asio::steady_timer spaceTimer;
+
+      //! Wakes the consumer when an item is added
+      boost::asio::steady_timer itemTimer;
+    };
+
+  }  // namespace wp
+}  // namespace brilliant
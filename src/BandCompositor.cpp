@@ -0,0 +1,142 @@
+/**
+ *
+ *  @file      BandCompositor.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements functions for compositing and encoding a wallpaper in
+ *  horizontal bands
+ */
+#include "BandCompositor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace brilliant {
+  namespace wp {
+
+    namespace {
+      /**
+       * @brief Blend two pixels
+       * @param a The first pixel
+       * @param b The second pixel
+       * @param weight The weight of b out of 256
+       * @return The blended pixel
+       */
+      boost::gil::rgb8_pixel_t lerp(const boost::gil::rgb8_pixel_t& a,
+                                    const boost::gil::rgb8_pixel_t& b,
+                                    std::uint32_t weight) {
+        const auto channel = [weight](std::uint32_t x, std::uint32_t y) {
+          return static_cast<std::uint8_t>(
+              (x * (256 - weight) + y * weight + 128) >> 8);
+        };
+        return {channel(a[0], b[0]), channel(a[1], b[1]),
+                channel(a[2], b[2])};
+      }
+    }  // namespace
+
+    TileRows::TileRows(SourceFile sourceFile, const ImageTags& tags,
+                       std::uint32_t scale, std::uint32_t width,
+                       std::uint32_t height,
+                       boost::gil::rgb8_pixel_t background)
+        : file(std::move(sourceFile)),
+          decoder(file.data(), tags, background, scale),
+          tileWidth(width),
+          tileHeight(height),
+          columns(makeTaps(decoder.width(), width)),
+          rows(makeTaps(decoder.height(), height)),
+          source(decoder.width()) {
+      scaled[0].resize(width);
+      scaled[1].resize(width);
+    }
+
+    std::uint32_t TileRows::width() const { return tileWidth; }
+
+    std::uint32_t TileRows::height() const { return tileHeight; }
+
+    void TileRows::readRow(boost::gil::rgb8_pixel_t* out) {
+      if (decoder.width() == tileWidth && decoder.height() == tileHeight) {
+        decoder.readRow(out);
+        return;
+      }
+
+      const auto tap = rows[nextRow++];
+      const auto last = std::min(tap.index + 1, decoder.height() - 1);
+      while (rowsDecoded <= last) {
+        decoder.readRow(source.data());
+        // rows before the tap are never sampled so are not scaled
+        if (rowsDecoded >= tap.index) {
+          auto& dst = scaled[rowsDecoded % 2];
+          for (std::uint32_t x = 0; x < tileWidth; ++x) {
+            const auto column = columns[x];
+            const auto next = std::min(column.index + 1, decoder.width() - 1);
+            dst[x] = lerp(source[column.index], source[next], column.weight);
+          }
+        }
+        ++rowsDecoded;
+      }
+
+      const auto& upper = scaled[tap.index % 2];
+      const auto& lower = scaled[last % 2];
+      for (std::uint32_t x = 0; x < tileWidth; ++x) {
+        out[x] = lerp(upper[x], lower[x], tap.weight);
+      }
+    }
+
+    std::vector<TileRows::Tap> TileRows::makeTaps(std::uint32_t srcSize,
+                                                  std::uint32_t dstSize) {
+      std::vector<Tap> taps(dstSize);
+      const double ratio = static_cast<double>(srcSize) / dstSize;
+      for (std::uint32_t i = 0; i < dstSize; ++i) {
+        // pixel centres line up, so edges are neither dropped nor repeated
+        const double pos = std::clamp((i + 0.5) * ratio - 0.5, 0.0,
+                                      static_cast<double>(srcSize - 1));
+        const auto index = static_cast<std::uint32_t>(pos);
+        taps[i] = {index, static_cast<std::uint32_t>(
+                              std::lround((pos - index) * 256))};
+      }
+      return taps;
+    }
+
+    void composeBands(
+        std::span<BandTile> tiles, JpegWriter& writer, std::uint32_t width,
+        std::uint32_t height, std::uint32_t bandHeight,
+        boost::gil::rgb8_pixel_t background,
+        const std::function<void(const BandTile&, std::exception_ptr)>&
+            onFailure) {
+      boost::gil::rgb8_image_t band(width, std::min(bandHeight, height));
+      for (std::uint32_t top = 0; top < height; top += bandHeight) {
+        const auto bandRows = std::min(bandHeight, height - top);
+        const auto view = boost::gil::subimage_view(
+            boost::gil::view(band), 0, 0, static_cast<std::ptrdiff_t>(width),
+            static_cast<std::ptrdiff_t>(bandRows));
+        boost::gil::fill_pixels(view, background);
+
+        for (auto& tile : tiles) {
+          if (!tile.rows) {
+            continue;
+          }
+          const auto bottom = tile.y + tile.rows->height();
+          const auto first = std::max(top, tile.y);
+          const auto last = std::min(top + bandRows, bottom);
+          try {
+            for (auto y = first; y < last; ++y) {
+              tile.rows->readRow(&*view.row_begin(y - top) + tile.x);
+            }
+          } catch (...) {
+            tile.rows.reset();
+            onFailure(tile, std::current_exception());
+            continue;
+          }
+          if (last == bottom) {
+            tile.rows.reset();
+          }
+        }
+
+        writer.writeRows(view);
+      }
+    }
+
+  }  // namespace wp
+}  // namespace brilliant
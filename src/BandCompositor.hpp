@@ -0,0 +1,168 @@
+/**
+ *
+ *  @file      BandCompositor.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Defines functions for compositing and encoding a wallpaper in horizontal
+ *  bands
+ */
+#pragma once
+
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include <boost/gil.hpp>
+
+#include "ImageDecoder.hpp"
+#include "JpegWriter.hpp"
+#include "SourceArchive.hpp"
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief Produces the rows of a source image scaled to a tile's size
+     *
+     * The source is decoded a row at a time by a RowDecoder and resized with
+     * bilinear filtering as it goes, so only three source sized rows are
+     * held no matter how tall the tile is.
+     */
+    class TileRows {
+    public:
+      /**
+       * @brief Start decoding a mapped source image
+       * @param sourceFile The source image
+       * @param tags A variant containing the image type tag
+       * @param scale The denominator of the decode scale, see
+       * chooseDecodeScale
+       * @param width The width of the tile in pixels
+       * @param height The height of the tile in pixels
+       * @param background The colour transparent pixels are blended onto
+       * @throws DecodeError if the image header cannot be read
+       */
+      TileRows(SourceFile sourceFile, const ImageTags& tags,
+               std::uint32_t scale, std::uint32_t width, std::uint32_t height,
+               boost::gil::rgb8_pixel_t background);
+
+      TileRows(const TileRows&) = delete;
+      TileRows& operator=(const TileRows&) = delete;
+
+      /**
+       * @brief Get the width of the tile
+       * @return The width in pixels
+       */
+      std::uint32_t width() const;
+
+      /**
+       * @brief Get the height of the tile
+       * @return The height in pixels
+       */
+      std::uint32_t height() const;
+
+      /**
+       * @brief Produce the next row of the tile
+       * @param out Receives width() pixels
+       * @throws DecodeError if the source cannot be decoded
+       */
+      void readRow(boost::gil::rgb8_pixel_t* out);
+
+    private:
+      /**
+       * @brief Where an output pixel samples its source
+       */
+      struct Tap {
+        //! The first source pixel
+        std::uint32_t index;
+
+        //! The weight of the pixel after index, out of 256
+        std::uint32_t weight;
+      };
+
+      /**
+       * @brief Map each output pixel along one axis onto the source
+       * @param srcSize The source size along the axis
+       * @param dstSize The output size along the axis
+       * @return One tap per output pixel
+       */
+      static std::vector<Tap> makeTaps(std::uint32_t srcSize,
+                                       std::uint32_t dstSize);
+
+      //! The mapped source image, must outlive the decoder
+      SourceFile file;
+
+      //! Decodes the source a row at a time
+      RowDecoder decoder;
+
+      //! The width of the tile in pixels
+      std::uint32_t tileWidth;
+
+      //! The height of the tile in pixels
+      std::uint32_t tileHeight;
+
+      //! Horizontal taps, one per output column
+      std::vector<Tap> columns;
+
+      //! Vertical taps, one per output row
+      std::vector<Tap> rows;
+
+      //! The last decoded source row
+      std::vector<boost::gil::rgb8_pixel_t> source;
+
+      //! Horizontally scaled source rows, indexed by source row parity
+      std::vector<boost::gil::rgb8_pixel_t> scaled[2];
+
+      //! The number of source rows decoded so far
+      std::uint32_t rowsDecoded = 0;
+
+      //! The next output row
+      std::uint32_t nextRow = 0;
+    };
+
+    /**
+     * @brief A tile placed on a banded wallpaper
+     */
+    struct BandTile {
+      //! The source image
+      std::filesystem::path path;
+
+      //! The column of the tile's left edge
+      std::uint32_t x = 0;
+
+      //! The row of the tile's top edge
+      std::uint32_t y = 0;
+
+      //! The tile's rows. Released once the tile is written or fails
+      std::unique_ptr<TileRows> rows;
+    };
+
+    /**
+     * @brief Composite tiles onto a background a band at a time and hand
+     * each band to a JpegWriter
+     * @param tiles The tiles to composite. Tiles without rows are skipped
+     * @param writer Receives every row of the wallpaper
+     * @param width The width of the wallpaper in pixels
+     * @param height The height of the wallpaper in pixels
+     * @param bandHeight The number of rows composited at a time
+     * @param background The colour of the wallpaper outside the tiles
+     * @param onFailure Called with a tile whose source failed part way
+     * through. The rest of the tile is left as background
+     *
+     * Only one band of the wallpaper is held at a time. Tiles are decoded
+     * as the bands reach them and release their source once their last row
+     * is written.
+     */
+    void composeBands(
+        std::span<BandTile> tiles, JpegWriter& writer, std::uint32_t width,
+        std::uint32_t height, std::uint32_t bandHeight,
+        boost::gil::rgb8_pixel_t background,
+        const std::function<void(const BandTile&, std::exception_ptr)>&
+            onFailure);
+
+  }  // namespace wp
+}  // namespace brilliant
@@ -0,0 +1,113 @@
+/**
+ *
+ *  @file      Catalog.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements the Catalog class
+ */
+#include "Catalog.hpp"
+
+#include <functional>
+#include <limits>
+#include <stdexcept>
+
+namespace brilliant {
+  namespace wp {
+
+    Catalog::Catalog()
+        : offsets{0}, index(0, Hash{this}, Equal{this}) {}
+
+    ImageId Catalog::intern(const std::filesystem::path& path) {
+      const StringView chars = path.native();
+      if (const auto iter = index.find(chars); iter != index.end()) {
+        return *iter;
+      }
+
+      if (size() >= std::numeric_limits<ImageId>::max() ||
+          pool.size() + chars.size() >
+              std::numeric_limits<std::uint32_t>::max()) {
+        throw std::length_error("Too many source images to catalog");
+      }
+      const auto id = static_cast<ImageId>(size());
+      pool.insert(pool.end(), chars.begin(), chars.end());
+      offsets.push_back(static_cast<std::uint32_t>(pool.size()));
+      widths.push_back(0);
+      heights.push_back(0);
+      types.emplace_back();
+      interlaced.push_back(false);
+      statuses.push_back(Status::unknown);
+      archiveIndexes.push_back(0);
+      locations.emplace_back();
+      index.insert(id);
+      return id;
+    }
+
+    std::size_t Catalog::size() const { return statuses.size(); }
+
+    std::filesystem::path Catalog::path(ImageId id) const {
+      return std::filesystem::path(view(id));
+    }
+
+    Catalog::Status Catalog::status(ImageId id) const {
+      return statuses.at(id);
+    }
+
+    bool Catalog::setUsable(ImageId id, const ImageInfo& info) {
+      if (statuses.at(id) != Status::unknown) {
+        return false;
+      }
+      widths[id] = info.width();
+      heights[id] = info.height();
+      types[id] = info.getType();
+      interlaced[id] = info.interlaced();
+      statuses[id] = Status::usable;
+      return true;
+    }
+
+    void Catalog::setUnusable(ImageId id) { statuses.at(id) = Status::unusable; }
+
+    ImageInfo Catalog::info(ImageId id) const {
+      return ImageInfo(widths.at(id), heights[id], types[id], interlaced[id]);
+    }
+
+    void Catalog::setArchiveMember(ImageId id,
+                                   const std::filesystem::path& archive,
+                                   const MemberLocation& location) {
+      auto iter = archiveIndex.find(archive);
+      if (iter == archiveIndex.end()) {
+        // 0 is kept for sources which are files of their own
+        const auto next = static_cast<std::uint32_t>(archives.size());
+        if (archives.size() >= std::numeric_limits<std::uint32_t>::max() - 1) {
+          throw std::length_error("Too many source archives to catalog");
+        }
+        iter = archiveIndex.emplace(archive, next).first;
+        archives.push_back(archive);
+      }
+      archiveIndexes.at(id) = iter->second + 1;
+      locations[id] = location;
+    }
+
+    std::optional<std::pair<std::filesystem::path, MemberLocation>>
+    Catalog::archiveMember(ImageId id) const {
+      if (const auto archive = archiveIndexes.at(id); archive != 0) {
+        return std::pair(archives[archive - 1], locations[id]);
+      }
+      return std::nullopt;
+    }
+
+    Catalog::StringView Catalog::view(ImageId id) const {
+      return StringView(pool.data() + offsets.at(id),
+                        offsets[id + 1] - offsets[id]);
+    }
+
+    std::size_t Catalog::Hash::operator()(ImageId id) const {
+      return (*this)(catalog->view(id));
+    }
+
+    std::size_t Catalog::Hash::operator()(StringView path) const {
+      return std::hash<StringView>{}(path);
+    }
+
+  }  // namespace wp
+}  // namespace brilliant
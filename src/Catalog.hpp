@@ -0,0 +1,248 @@
+/**
+ *
+ *  @file      Catalog.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Defines the Catalog class
+ */
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "ImageProcessing.hpp"
+#include "MemberLocation.hpp"
+
+namespace brilliant {
+  namespace wp {
+
+    //! Identifies a source image in the Catalog
+    using ImageId = std::uint32_t;
+
+    /**
+     * @brief Interned source image paths and their metadata
+     *
+     * Each distinct path is stored once in a single string pool and given an
+     * ImageId, so monitors which share sources share their entries and hold
+     * only IDs. IDs are handed out in order from 0 and stay valid for the
+     * life of the catalog. Metadata is kept in one array per field, indexed
+     * by ID. A source in an archive is interned by the archive's path
+     * followed by its path in the archive, and also keeps where it is in
+     * the archive.
+     *
+     * The catalog is not synchronised. The App guards it with a lock.
+     */
+    class Catalog {
+    public:
+      /**
+       * @brief Whether a source has been probed and the result
+       */
+      enum class Status : std::uint8_t {
+        //! Not probed yet
+        unknown,
+        //! Probed and can be decoded, its metadata is set
+        usable,
+        //! Failed to probe, is too large or was quarantined
+        unusable
+      };
+
+      /**
+       * @brief Construct an empty Catalog
+       */
+      Catalog();
+
+      Catalog(const Catalog&) = delete;
+      Catalog& operator=(const Catalog&) = delete;
+
+      /**
+       * @brief Get the ID of a path, adding it if it is new
+       * @param path The source image
+       * @return The ID of the path
+       * @throws std::length_error if the catalog is full
+       */
+      ImageId intern(const std::filesystem::path& path);
+
+      /**
+       * @brief Get the number of interned paths
+       * @return The number of paths, one more than the largest ID
+       */
+      std::size_t size() const;
+
+      /**
+       * @brief Get the path of an ID
+       * @param id An ID returned by intern
+       * @return The path
+       */
+      std::filesystem::path path(ImageId id) const;
+
+      /**
+       * @brief Get whether a source has been probed
+       * @param id An ID returned by intern
+       * @return The status of the source
+       */
+      Status status(ImageId id) const;
+
+      /**
+       * @brief Record the metadata of a usable source
+       * @param id An ID returned by intern
+       * @param info The metadata of the source
+       * @return True if the source was unknown and is now usable. False if
+       * it was already settled, by a probe which finished first or by
+       * setUnusable, and is left as it was
+       */
+      bool setUsable(ImageId id, const ImageInfo& info);
+
+      /**
+       * @brief Record that a source cannot be used
+       * @param id An ID returned by intern
+       */
+      void setUnusable(ImageId id);
+
+      /**
+       * @brief Get the metadata of a usable source
+       * @param id An ID whose status is usable
+       * @return The metadata
+       */
+      ImageInfo info(ImageId id) const;
+
+      /**
+       * @brief Record that a source is a member of an archive
+       * @param id An ID returned by intern
+       * @param archive The archive the source is in
+       * @param location Where the source is in the archive
+       * @throws std::length_error if the catalog has too many archives
+       */
+      void setArchiveMember(ImageId id, const std::filesystem::path& archive,
+                            const MemberLocation& location);
+
+      /**
+       * @brief Get where a source in an archive is
+       * @param id An ID returned by intern
+       * @return The archive and where the source is in it, or nullopt if
+       * the source is a file of its own
+       */
+      std::optional<std::pair<std::filesystem::path, MemberLocation>>
+      archiveMember(ImageId id) const;
+
+    private:
+      //! The character type of native paths
+      using Char = std::filesystem::path::value_type;
+
+      //! A view of a path in the string pool
+      using StringView = std::basic_string_view<Char>;
+
+      /**
+       * @brief Get the characters of an interned path
+       * @param id An ID returned by intern
+       * @return A view into the string pool, invalidated by intern
+       */
+      StringView view(ImageId id) const;
+
+      /**
+       * @brief Hashes IDs by their path, and paths being looked up
+       */
+      struct Hash {
+        //! Allows lookup by StringView
+        using is_transparent = void;
+
+        /**
+         * @brief Hash an interned path
+         * @param id The ID of the path
+         * @return The hash value
+         */
+        std::size_t operator()(ImageId id) const;
+
+        /**
+         * @brief Hash a path
+         * @param path The path
+         * @return The hash value
+         */
+        std::size_t operator()(StringView path) const;
+
+        //! The catalog the IDs belong to
+        const Catalog* catalog;
+      };
+
+      /**
+       * @brief Compares IDs by their path, and with paths being looked up
+       */
+      struct Equal {
+        //! Allows lookup by StringView
+        using is_transparent = void;
+
+        /**
+         * @brief Compare an interned path with an interned path or a path
+         * @param a An ID or a path
+         * @param b An ID or a path
+         * @return True if the paths are equal
+         */
+        template <class A, class B>
+        bool operator()(const A& a, const B& b) const {
+          return resolve(a) == resolve(b);
+        }
+
+        /**
+         * @brief Get the characters of an ID or a path
+         * @param id The ID of the path
+         * @return The characters of the path
+         */
+        StringView resolve(ImageId id) const { return catalog->view(id); }
+
+        /**
+         * @brief Get the characters of a path
+         * @param path The path
+         * @return The path unchanged
+         */
+        StringView resolve(StringView path) const { return path; }
+
+        //! The catalog the IDs belong to
+        const Catalog* catalog;
+      };
+
+      //! Every interned path, one after the other
+      std::vector<Char> pool;
+
+      //! Where each path starts in the pool, followed by the end of the pool
+      std::vector<std::uint32_t> offsets;
+
+      //! The width of each usable source in pixels
+      std::vector<std::uint32_t> widths;
+
+      //! The height of each usable source in pixels
+      std::vector<std::uint32_t> heights;
+
+      //! The format of each usable source
+      std::vector<ImageTags> types;
+
+      //! Whether each usable source is stored interlaced
+      std::vector<bool> interlaced;
+
+      //! Whether each source has been probed
+      std::vector<Status> statuses;
+
+      //! The archive each source is in, as one more than its index in
+      //! archives, or 0 for a file of its own
+      std::vector<std::uint32_t> archiveIndexes;
+
+      //! Where each source in an archive is in it
+      std::vector<MemberLocation> locations;
+
+      //! Every archive a source is in
+      std::vector<std::filesystem::path> archives;
+
+      //! Finds the index of an archive in archives
+      std::unordered_map<std::filesystem::path, std::uint32_t> archiveIndex;
+
+      //! Finds the ID of a path
+      std::unordered_set<ImageId, Hash, Equal> index;
+    };
+
+  }  // namespace wp
+}  // namespace brilliant
@@ -0,0 +1,179 @@
+/**
+ *
+ *  @file      CommandLine.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements the command line parser
+ */
+#include "CommandLine.hpp"
+
+#include <charconv>
+#include <format>
+#include <string>
+#include <system_error>
+#include <tuple>
+#include <utility>
+
+namespace brilliant {
+  namespace wp {
+
+    using namespace std::string_view_literals;
+
+    namespace {
+      /**
+       * @brief Parse a whole argument as an unsigned number
+       * @param name The option the value belongs to, used in errors
+       * @param value The text to parse
+       * @return The number
+       * @throws CommandLineError if the text is not a number in range
+       */
+      std::uint32_t parseNumber(std::string_view name, std::string_view value) {
+        std::uint32_t number = 0;
+        const auto [end, ec] =
+            std::from_chars(value.data(), value.data() + value.size(), number);
+        if (ec != std::errc() || end != value.data() + value.size()) {
+          throw CommandLineError(
+              std::format("{} expects a number, got '{}'", name, value));
+        }
+        return number;
+      }
+
+      /**
+       * @brief Parse a size given as WIDTHxHEIGHT
+       * @param name The option the value belongs to, used in errors
+       * @param value The text to parse
+       * @return The width and height, both non zero
+       * @throws CommandLineError if the text is not a valid size
+       */
+      std::pair<std::uint32_t, std::uint32_t> parseSize(
+          std::string_view name, std::string_view value) {
+        const auto x = value.find('x');
+        if (x == std::string_view::npos) {
+          throw CommandLineError(std::format(
+              "{} expects WIDTHxHEIGHT, got '{}'", name, value));
+        }
+        const auto width = parseNumber(name, value.substr(0, x));
+        const auto height = parseNumber(name, value.substr(x + 1));
+        if (width == 0 || height == 0) {
+          throw CommandLineError(
+              std::format("{} must not be empty, got '{}'", name, value));
+        }
+        return {width, height};
+      }
+
+      /**
+       * @brief Parse a log level name
+       * @param name The option the value belongs to, used in errors
+       * @param value One of trace, debug, info, warning, error or fatal
+       * @return The log level
+       * @throws CommandLineError if the name is not a log level
+       */
+      severity_level parseLogLevel(std::string_view name,
+                                   std::string_view value) {
+        severity_level level{};
+        if (!boost::log::trivial::from_string(value.data(), value.size(),
+                                              level)) {
+          throw CommandLineError(
+              std::format("{} expects one of trace, debug, info, warning, "
+                          "error or fatal, got '{}'",
+                          name, value));
+        }
+        return level;
+      }
+    }  // namespace
+
+    std::string_view usage() {
+      return "Usage: BrilliantWallpaper [options]\n"
+             "       BrilliantWallpaper [options] render --size WIDTHxHEIGHT "
+             "--out DIR [--count N]\n"
+             "\n"
+             "Options:\n"
+             "  --config PATH      Read the config from PATH\n"
+             "  --temp-dir PATH    Keep wallpapers and the quarantine in PATH\n"
+             "  --seed N           Seed the random number generator\n"
+             "  --log-level LEVEL  One of trace, debug, info, warning, error "
+             "or fatal\n"
+             "  -h, --help         Print this message\n"
+             "\n"
+             "render writes N wallpapers made from every configured source to "
+             "DIR\n"
+             "and prints how long each took:\n"
+             "  --size WIDTHxHEIGHT  The size of each wallpaper\n"
+             "  --out DIR            The directory to write to, created if "
+             "needed\n"
+             "  --count N            The number of wallpapers, default 1\n"sv;
+    }
+
+    CommandLine parseCommandLine(std::span<const char* const> args) {
+      CommandLine options;
+      bool sized = false;
+
+      for (std::size_t i = 0; i < args.size(); ++i) {
+        std::string_view arg = args[i];
+        std::optional<std::string_view> inlineValue;
+        if (const auto eq = arg.find('=');
+            arg.starts_with("--"sv) && eq != std::string_view::npos) {
+          inlineValue = arg.substr(eq + 1);
+          arg = arg.substr(0, eq);
+        }
+
+        const auto value = [&]() -> std::string_view {
+          if (inlineValue) {
+            return *inlineValue;
+          }
+          if (++i == args.size()) {
+            throw CommandLineError(std::format("{} expects a value", arg));
+          }
+          return args[i];
+        };
+        const auto renderOption = [&]() -> RenderOptions& {
+          if (!options.render) {
+            throw CommandLineError(
+                std::format("{} is only valid after render", arg));
+          }
+          return *options.render;
+        };
+
+        if (arg == "-h"sv || arg == "--help"sv) {
+          options.help = true;
+        } else if (arg == "--config"sv) {
+          options.configFile = std::filesystem::path(value());
+        } else if (arg == "--temp-dir"sv) {
+          options.tempDirectory = std::filesystem::path(value());
+        } else if (arg == "--seed"sv) {
+          options.seed = parseNumber(arg, value());
+        } else if (arg == "--log-level"sv) {
+          options.logLevel = parseLogLevel(arg, value());
+        } else if (arg == "render"sv && !options.render) {
+          options.render.emplace();
+        } else if (arg == "--count"sv) {
+          auto& render = renderOption();
+          render.count = parseNumber(arg, value());
+          if (render.count == 0) {
+            throw CommandLineError("--count must be at least 1");
+          }
+        } else if (arg == "--size"sv) {
+          auto& render = renderOption();
+          std::tie(render.width, render.height) = parseSize(arg, value());
+          sized = true;
+        } else if (arg == "--out"sv) {
+          renderOption().outputDirectory = std::filesystem::path(value());
+        } else {
+          throw CommandLineError(std::format("Unknown argument '{}'", arg));
+        }
+      }
+
+      if (options.render && !options.help) {
+        if (!sized) {
+          throw CommandLineError("render expects --size");
+        }
+        if (options.render->outputDirectory.empty()) {
+          throw CommandLineError("render expects --out");
+        }
+      }
+      return options;
+    }
+
+  }  // namespace wp
+}  // namespace brilliant
@@ -0,0 +1,92 @@
+/**
+ *
+ *  @file      CommandLine.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Defines the command line options and their parser
+ */
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+
+#include "Log.hpp"
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief Exception thrown when the command line cannot be parsed
+     */
+    struct CommandLineError : public std::runtime_error {
+      using std::runtime_error::runtime_error;
+    };
+
+    /**
+     * @brief Options for the render subcommand
+     */
+    struct RenderOptions {
+      //! The number of wallpapers to render
+      std::uint32_t count = 1;
+
+      //! The width of each wallpaper in pixels
+      std::uint32_t width = 0;
+
+      //! The height of each wallpaper in pixels
+      std::uint32_t height = 0;
+
+      //! The directory the wallpapers are written to
+      std::filesystem::path outputDirectory;
+    };
+
+    /**
+     * @brief Options given on the command line
+     *
+     * Options which were not given are left empty so the app can fall back
+     * to its defaults.
+     */
+    struct CommandLine {
+      //! Seed for the random number generator
+      std::optional<std::uint32_t> seed;
+
+      //! Alternative path to the config file
+      std::optional<std::filesystem::path> configFile;
+
+      //! Alternative path to the temp directory
+      std::optional<std::filesystem::path> tempDirectory;
+
+      //! The lowest severity which is logged
+      std::optional<severity_level> logLevel;
+
+      //! Set when the render subcommand was given
+      std::optional<RenderOptions> render;
+
+      //! Set when usage was asked for
+      bool help = false;
+    };
+
+    /**
+     * @brief Get the usage text
+     * @return A description of every option
+     */
+    std::string_view usage();
+
+    /**
+     * @brief Parse the command line
+     * @param args The arguments, not including the program name
+     * @return The parsed options
+     * @throws CommandLineError if an option is unknown, is missing its value
+     * or its value is invalid
+     *
+     * Options take their value as the next argument or after an '=', eg:
+     * `--seed 42` or `--seed=42`.
+     */
+    CommandLine parseCommandLine(std::span<const char* const> args);
+
+  }  // namespace wp
+}  // namespace brilliant
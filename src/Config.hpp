@@ -9,13 +9,18 @@
 #pragma once
 
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <exception>
 #include <filesystem>
 #include <iosfwd>
 #include <optional>
+#include <stdexcept>
 #include <unordered_map>
 #include <vector>
 
+#include "MemberLocation.hpp"
+
 namespace brilliant {
   namespace wp {
 
@@ -26,15 +31,40 @@ namespace brilliant {
       using runtime_error::runtime_error;
     };
 
+    /**
+     * @brief Where a source found in an archive is
+     */
+    struct ConfigArchiveMember {
+      //! The index of the source in ConfigMonitor::backgroundPaths
+      std::size_t source;
+
+      //! The index of the archive in ConfigMonitor::archives
+      std::uint32_t archive;
+
+      //! Where the source is in the archive
+      MemberLocation location;
+    };
+
     /**
      * @brief Configuration data for a monitor
      */
     struct ConfigMonitor {
-      //! Paths to images used for wallpapers
+      //! Paths to images used for wallpapers. A source in an archive is the
+      //! archive's path followed by its path in the archive
       std::vector<std::filesystem::path> backgroundPaths;
 
+      //! The archives sources were found in
+      std::vector<std::filesystem::path> archives;
+
+      //! Where each source found in an archive is
+      std::vector<ConfigArchiveMember> archiveMembers;
+
+      //! How likely each path in backgroundPaths is to be picked, relative
+      //! to the others
+      std::vector<float> weights;
+
       //! The monitor specific transition delay
-      std::optional<std::chrono::minutes> transitionDelay;
+      std::optional<std::chrono::milliseconds> transitionDelay;
 
       //! The index of the monitor
       std::optional<std::uint32_t> index;
@@ -45,8 +75,60 @@ namespace brilliant {
      */
     struct Config {
       //! The global transition delay
-      std::chrono::minutes globalTransitionDelay;
-      
+      std::chrono::milliseconds globalTransitionDelay;
+
+      //! How many wallpapers each monitor renders ahead of its transitions
+      std::size_t prefetch;
+
+      //! The colour behind letterboxed tiles and transparent pixels as
+      //! 0xRRGGBB
+      std::uint32_t background;
+
+      //! Fill the gaps between tiles with a darkened blur of the tiles
+      //! beside them rather than the background colour. Not done in banded
+      //! mode
+      bool blurGutters;
+
+      //! The most pixels a source image may be decoded to. Larger jpeg and
+      //! png images are decoded at a reduced scale, others are skipped
+      std::uint64_t maxDecodePixels;
+
+      //! Source images larger than this many bytes are skipped
+      std::uintmax_t maxFileSize;
+
+      //! Rows composited and encoded at a time. 0 composites the whole
+      //! wallpaper before encoding it
+      std::uint32_t bandHeight;
+
+      //! The most memory, in bytes, the wallpapers being made are estimated
+      //! to use at once. 0 for no limit
+      std::uint64_t memoryBudget;
+
+      //! Threads which probe sources and make wallpapers that are due
+      //! soon, at normal priority
+      std::uint32_t ioThreads;
+
+      //! Threads which decode, composite and encode wallpapers ahead of
+      //! their transitions. 0 uses one per hardware thread
+      std::uint32_t cpuThreads;
+
+      //! Run the cpuThreads only when a CPU would otherwise be idle
+      bool lowPriority;
+
+      //! The CPUs the cpuThreads may run on, every CPU if empty
+      std::vector<std::uint32_t> cpuAffinity;
+
+      //! Hold back making wallpapers while the machine is busy, showing a
+      //! recent one again if it is still busy at the deadline
+      bool deferWhenBusy;
+
+      //! The load average per CPU above which the machine is busy
+      double busyLoad;
+
+      //! The percent of time threads waited for a CPU or for memory above
+      //! which the machine is busy
+      double busyPressure;
+
       //! Storage for monitor specific config data
       std::unordered_map<std::uint32_t, ConfigMonitor> monitors;
     };
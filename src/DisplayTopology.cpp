@@ -0,0 +1,57 @@
+/**
+ *
+ *  @file      DisplayTopology.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements the DisplayTopology and TopologyCache classes
+ */
+#include "DisplayTopology.hpp"
+
+#include <format>
+#include <stdexcept>
+
+#include "Log.hpp"
+
+namespace brilliant {
+  namespace wp {
+
+    std::pair<std::uint32_t, std::uint32_t> DisplayTopology::resolution(
+        std::uint32_t monitorIndex) const {
+      if (monitorIndex >= monitors.size() ||
+          monitors[monitorIndex].width == 0) {
+        throw std::runtime_error(
+            std::format("Monitor {} is not attached", monitorIndex));
+      }
+      const auto& monitor = monitors[monitorIndex];
+      return {monitor.width, monitor.height};
+    }
+
+    TopologyCache::TopologyCache(Query queryMonitors)
+        : query(std::move(queryMonitors)) {}
+
+    std::shared_ptr<const DisplayTopology> TopologyCache::get() {
+      std::lock_guard lock(mutex);
+      if (!stale) {
+        return current;
+      }
+
+      auto monitors = query();
+      stale = false;
+      if (!current || monitors != current->monitors) {
+        const auto version = current ? current->version + 1 : 1;
+        current = std::make_shared<const DisplayTopology>(
+            DisplayTopology{version, std::move(monitors)});
+        log(severity_level::info, "Display topology {} has {} monitor(s)",
+            version, current->monitors.size());
+      }
+      return current;
+    }
+
+    void TopologyCache::invalidate() {
+      std::lock_guard lock(mutex);
+      stale = true;
+    }
+
+  }  // namespace wp
+}  // namespace brilliant
@@ -0,0 +1,117 @@
+/**
+ *
+ *  @file      DisplayTopology.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Defines the DisplayTopology and TopologyCache classes
+ */
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief The layout of one monitor
+     */
+    struct MonitorInfo {
+      //! The width of the monitor in pixels
+      std::uint32_t width;
+
+      //! The height of the monitor in pixels
+      std::uint32_t height;
+
+      //! The display scale, 1 at 96 DPI
+      double scale;
+
+      //! Identifies the physical monitor, as UTF-8
+      std::string deviceId;
+
+      /**
+       * @brief Compare two monitors
+       * @return True if every field is equal
+       */
+      bool operator==(const MonitorInfo&) const = default;
+    };
+
+    /**
+     * @brief A snapshot of every monitor
+     */
+    struct DisplayTopology {
+      //! Increases each time the monitors change. The first snapshot is 1
+      std::uint64_t version;
+
+      //! The monitors by index
+      std::vector<MonitorInfo> monitors;
+
+      /**
+       * @brief Get the resolution of a monitor
+       * @param monitorIndex The index of the monitor
+       * @return A pair containing the width and height of the monitor in
+       * pixels
+       * @throws std::runtime_error if there is no such monitor attached
+       */
+      std::pair<std::uint32_t, std::uint32_t> resolution(
+          std::uint32_t monitorIndex) const;
+    };
+
+    /**
+     * @brief Keeps the display topology between changes
+     *
+     * The topology is queried the first time it is needed and again only
+     * after invalidate is called, normally when the OS reports a display
+     * change. A query which finds the same monitors keeps the current
+     * snapshot and version, so callers can compare versions to tell when
+     * anything they keyed by resolution is out of date.
+     *
+     * All member functions are safe to call from any thread.
+     */
+    class TopologyCache {
+    public:
+      //! Queries the OS for every monitor
+      using Query = std::function<std::vector<MonitorInfo>()>;
+
+      /**
+       * @brief Construct a TopologyCache
+       * @param queryMonitors Queries the OS for every monitor
+       */
+      explicit TopologyCache(Query queryMonitors);
+
+      /**
+       * @brief Get the current topology, querying it if it is out of date
+       * @return The snapshot, which does not change once returned
+       */
+      std::shared_ptr<const DisplayTopology> get();
+
+      /**
+       * @brief Mark the topology out of date
+       *
+       * Cheap enough to call from an OS notification. The query happens on
+       * the next call to get.
+       */
+      void invalidate();
+
+    private:
+      //! Queries the OS for every monitor
+      Query query;
+
+      //! Guards every member below
+      std::mutex mutex;
+
+      //! The last snapshot, null before the first query
+      std::shared_ptr<const DisplayTopology> current;
+
+      //! Whether the snapshot needs to be queried again
+      bool stale = true;
+    };
+
+  }  // namespace wp
+}  // namespace brilliant
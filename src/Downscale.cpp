@@ -0,0 +1,282 @@
+/**
+ *
+ *  @file      Downscale.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements functions for scaling decoded images to tile sizes
+ */
+#include "Downscale.hpp"
+
+#include <boost/gil/extension/numeric/resample.hpp>
+#include <boost/gil/extension/numeric/sampler.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace brilliant {
+  namespace wp {
+
+    namespace {
+
+      //! Fixed point weights of the area filter sum to 1 << weightBits
+      constexpr int weightBits = 12;
+
+      //! Intermediate rows keep this many bits of each weighted sum
+      constexpr int intermediateShift = 4;
+
+      /**
+       * @brief Get the raw channels of a row
+       * @param view The view
+       * @param y The row
+       * @return A pointer to the first channel of the row
+       */
+      const std::uint8_t* rowChannels(const boost::gil::rgb8c_view_t& view,
+                                      std::ptrdiff_t y) {
+        return reinterpret_cast<const std::uint8_t*>(&*view.row_begin(y));
+      }
+
+      /**
+       * @brief Get the raw channels of a row
+       * @param view The view
+       * @param y The row
+       * @return A pointer to the first channel of the row
+       */
+      std::uint8_t* rowChannels(const boost::gil::rgb8_view_t& view,
+                                std::ptrdiff_t y) {
+        return reinterpret_cast<std::uint8_t*>(&*view.row_begin(y));
+      }
+
+      /**
+       * @brief Halve a pair of rows
+       * @param top The channels of the first row
+       * @param bottom The channels of the second row
+       * @param out The channels of the destination row
+       * @param width The number of destination pixels
+       *
+       * The two source rows and the destination are separate images, which
+       * __restrict promises so the averages can be vectorized.
+       */
+      void halveRow(const std::uint8_t* __restrict top,
+                    const std::uint8_t* __restrict bottom,
+                    std::uint8_t* __restrict out, std::size_t width) {
+        for (std::size_t x = 0; x < width; ++x) {
+          const auto* a = top + x * 6;
+          const auto* b = bottom + x * 6;
+          for (std::size_t c = 0; c < 3; ++c) {
+            out[x * 3 + c] = static_cast<std::uint8_t>(
+                (a[c] + a[c + 3] + b[c] + b[c + 3] + 2) >> 2);
+          }
+        }
+      }
+
+      /**
+       * @brief The source pixels under each destination pixel along one axis
+       *
+       * Every destination pixel has the same number of taps, padded with
+       * zero weights, so the inner loops have a fixed trip count and do not
+       * branch differently from one pixel to the next.
+       */
+      struct AreaTaps {
+        //! The number of source pixels each destination pixel reads
+        std::size_t count = 0;
+
+        //! The first source pixel of each destination pixel
+        std::vector<std::uint32_t> first;
+
+        //! count shares for each destination pixel, summing to
+        //! 1 << weightBits
+        std::vector<std::uint32_t> weights;
+      };
+
+      /**
+       * @brief Work out the area filter along one axis
+       * @param srcSize The number of source pixels, at least dstSize
+       * @param dstSize The number of destination pixels
+       * @return The taps of every destination pixel
+       */
+      AreaTaps areaTaps(std::uint32_t srcSize, std::uint32_t dstSize) {
+        const double ratio = static_cast<double>(srcSize) / dstSize;
+        AreaTaps taps;
+        // no more taps than there are source pixels, so a narrow source is
+        // not read past its end
+        taps.count = std::min<std::size_t>(
+            static_cast<std::size_t>(std::ceil(ratio)) + 1, srcSize);
+        taps.first.resize(dstSize);
+        taps.weights.resize(dstSize * taps.count);
+        for (std::uint32_t i = 0; i < dstSize; ++i) {
+          const double begin = i * ratio;
+          const double end = (i + 1) * ratio;
+          const auto last =
+              std::min(srcSize, static_cast<std::uint32_t>(std::ceil(end)));
+          // start early at the right edge so every tap is inside the source,
+          // the extra taps have no share
+          const auto first =
+              std::min(static_cast<std::uint32_t>(begin),
+                       srcSize - static_cast<std::uint32_t>(taps.count));
+          taps.first[i] = first;
+
+          auto* weights = taps.weights.data() + i * taps.count;
+          std::uint32_t total = 0;
+          for (auto s = first; s < last; ++s) {
+            const double overlap = std::max(
+                0.0, std::min<double>(s + 1, end) - std::max<double>(s, begin));
+            const auto weight = static_cast<std::uint32_t>(
+                std::lround(overlap / ratio * (1 << weightBits)));
+            weights[s - first] = weight;
+            total += weight;
+          }
+          // rounding error goes to the largest share so the sum is exact
+          *std::max_element(weights, weights + taps.count) +=
+              (1u << weightBits) - total;
+        }
+        return taps;
+      }
+
+      /**
+       * @brief Add a weighted source row to the sums of a destination row
+       * @param in The source channels
+       * @param sums The sums of the channels
+       * @param weight The share of the source row
+       * @param count The number of channels
+       *
+       * The rows are contiguous and never overlap, so the compiler
+       * vectorizes this.
+       */
+      void accumulateRow(const std::uint8_t* __restrict in,
+                         std::uint32_t* __restrict sums, std::uint32_t weight,
+                         std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i) {
+          sums[i] += in[i] * weight;
+        }
+      }
+
+      /**
+       * @brief Drop the sums of a row to intermediate precision
+       * @param sums The sums of the channels
+       * @param out The intermediate channels
+       * @param count The number of channels
+       */
+      void narrowRow(const std::uint32_t* __restrict sums,
+                     std::uint16_t* __restrict out, std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i) {
+          out[i] = static_cast<std::uint16_t>(
+              (sums[i] + (1u << (intermediateShift - 1))) >> intermediateShift);
+        }
+      }
+
+      /**
+       * @brief Scale a row horizontally with an area filter
+       * @tparam Count The number of taps, 0 to read it from taps
+       * @param in The intermediate channels
+       * @param out The destination channels
+       * @param taps The horizontal taps
+       * @param width The number of destination pixels
+       */
+      template <std::size_t Count>
+      void areaRow(const std::uint16_t* __restrict in,
+                   std::uint8_t* __restrict out, const AreaTaps& taps,
+                   std::size_t width) {
+        constexpr int shift = 2 * weightBits - intermediateShift;
+        const auto count = Count ? Count : taps.count;
+        const auto* __restrict first = taps.first.data();
+        const auto* __restrict weights = taps.weights.data();
+        for (std::size_t x = 0; x < width; ++x, weights += count) {
+          std::uint32_t r = 1u << (shift - 1);
+          std::uint32_t g = r;
+          std::uint32_t b = r;
+          const auto* pixel = in + std::size_t{first[x]} * 3;
+          for (std::size_t t = 0; t < count; ++t, pixel += 3) {
+            r += pixel[0] * weights[t];
+            g += pixel[1] * weights[t];
+            b += pixel[2] * weights[t];
+          }
+          out[x * 3] = static_cast<std::uint8_t>(std::min(255u, r >> shift));
+          out[x * 3 + 1] =
+              static_cast<std::uint8_t>(std::min(255u, g >> shift));
+          out[x * 3 + 2] =
+              static_cast<std::uint8_t>(std::min(255u, b >> shift));
+        }
+      }
+
+      /**
+       * @brief Scale down with an area filter
+       * @param src The view to scale
+       * @param dst The destination view, no larger than src on either axis
+       *
+       * Fastest within 2x, where each destination pixel reads three source
+       * pixels along each axis, but any reduction works. Rows are combined
+       * first, which vectorizes, so the horizontal pass only runs once per
+       * destination row.
+       */
+      void areaResample(const boost::gil::rgb8c_view_t& src,
+                        const boost::gil::rgb8_view_t& dst) {
+        const auto dstWidth = static_cast<std::uint32_t>(dst.width());
+        const auto dstHeight = static_cast<std::uint32_t>(dst.height());
+        const auto columns =
+            areaTaps(static_cast<std::uint32_t>(src.width()), dstWidth);
+        const auto rows =
+            areaTaps(static_cast<std::uint32_t>(src.height()), dstHeight);
+        const auto srcRowSize = static_cast<std::size_t>(src.width()) * 3;
+        const auto scaleRow = columns.count == 3 ? &areaRow<3>
+                              : columns.count == 2 ? &areaRow<2>
+                                                   : &areaRow<0>;
+
+        std::vector<std::uint32_t> sums(srcRowSize);
+        std::vector<std::uint16_t> combined(srcRowSize);
+        for (std::uint32_t y = 0; y < dstHeight; ++y) {
+          std::ranges::fill(sums, 0u);
+          for (std::size_t t = 0; t < rows.count; ++t) {
+            if (const auto weight = rows.weights[y * rows.count + t]) {
+              const auto row =
+                  static_cast<std::ptrdiff_t>(rows.first[y] + t);
+              accumulateRow(rowChannels(src, row), sums.data(), weight,
+                            srcRowSize);
+            }
+          }
+          narrowRow(sums.data(), combined.data(), srcRowSize);
+          scaleRow(combined.data(), rowChannels(dst, y), columns, dstWidth);
+        }
+      }
+    }  // namespace
+
+    void halve(const boost::gil::rgb8c_view_t& src,
+               const boost::gil::rgb8_view_t& dst) {
+      const auto width = static_cast<std::size_t>(dst.width());
+      for (std::ptrdiff_t y = 0; y < dst.height(); ++y) {
+        halveRow(rowChannels(src, 2 * y), rowChannels(src, 2 * y + 1),
+                 rowChannels(dst, y), width);
+      }
+    }
+
+    void resample(const boost::gil::rgb8c_view_t& src,
+                  const boost::gil::rgb8_view_t& dst) {
+      if (src.dimensions() == dst.dimensions()) {
+        boost::gil::copy_pixels(src, dst);
+        return;
+      }
+      if (src.width() < dst.width() || src.height() < dst.height()) {
+        boost::gil::resize_view(src, dst, boost::gil::bilinear_sampler());
+        return;
+      }
+
+      // each level is a quarter of the one before, so they take a third of
+      // the time of the first
+      std::optional<boost::gil::rgb8_image_t> level;
+      auto current = src;
+      while (current.width() >= 2 * dst.width() &&
+             current.height() >= 2 * dst.height()) {
+        boost::gil::rgb8_image_t next(current.width() / 2,
+                                      current.height() / 2);
+        halve(current, boost::gil::view(next));
+        level = std::move(next);
+        current = boost::gil::const_view(*level);
+      }
+      areaResample(current, dst);
+    }
+
+  }  // namespace wp
+}  // namespace brilliant
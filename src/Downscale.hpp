@@ -0,0 +1,43 @@
+/**
+ *
+ *  @file      Downscale.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Defines functions for scaling decoded images to tile sizes
+ */
+#pragma once
+
+#include <boost/gil.hpp>
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief Halve an image with a 2x2 box filter
+     * @param src The view to halve
+     * @param dst The destination view, src's dimensions halved and rounded
+     * down. A last odd row or column of src is dropped
+     *
+     * Works on whole rows of raw channels with integer arithmetic so the
+     * compiler can vectorize it.
+     */
+    void halve(const boost::gil::rgb8c_view_t& src,
+               const boost::gil::rgb8_view_t& dst);
+
+    /**
+     * @brief Scale an image to the size of a destination view
+     * @param src The view to scale
+     * @param dst The destination view
+     *
+     * A reduction of 2x or more is first halved with halve until it is
+     * within 2x of dst, so the cost of a large source is mostly one cheap
+     * pass and every source pixel contributes. The rest is done in one pass
+     * which averages the area of the source under each destination pixel.
+     * Enlargements are bilinear.
+     */
+    void resample(const boost::gil::rgb8c_view_t& src,
+                  const boost::gil::rgb8_view_t& dst);
+
+  }  // namespace wp
+}  // namespace brilliant
@@ -0,0 +1,36 @@
+/**
+ *
+ *  @file      GapIndex.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements the GapIndex class
+ */
+#include "GapIndex.hpp"
+
+namespace brilliant {
+  namespace wp {
+
+    GapIndex::GapIndex(std::uint32_t height, std::vector<Entry> entries)
+        : indexHeight(height) {
+      std::erase_if(entries, [](const auto& entry) { return entry.weight == 0; });
+      std::ranges::sort(entries, {}, &Entry::width);
+
+      widths.reserve(entries.size());
+      cumulativeWeights.reserve(entries.size());
+      items.reserve(entries.size());
+      std::uint64_t sum = 0;
+      for (const auto& entry : entries) {
+        sum += entry.weight;
+        widths.push_back(entry.width);
+        cumulativeWeights.push_back(sum);
+        items.push_back(entry.item);
+      }
+    }
+
+    std::uint32_t GapIndex::height() const { return indexHeight; }
+
+    std::size_t GapIndex::size() const { return items.size(); }
+
+  }  // namespace wp
+}  // namespace brilliant
@@ -0,0 +1,105 @@
+/**
+ *
+ *  @file      GapIndex.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Defines the GapIndex class
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief Finds sources narrow enough to fill the gap at the end of a row
+     *
+     * Sources are sorted by their width once scaled to the height of a
+     * wallpaper, with a running sum of their weights. Picking a source that
+     * fits a gap is two binary searches, so it is O(log n) however large the
+     * library. The index is built for one height and does not change, build
+     * a new one when the height or the sources change.
+     */
+    class GapIndex {
+    public:
+      /**
+       * @brief A source to index
+       */
+      struct Entry {
+        //! The width of the source scaled to the height of the index
+        std::uint32_t width;
+
+        //! How likely the source is to be picked, relative to the others. 0
+        //! leaves it out
+        std::uint64_t weight;
+
+        //! Identifies the source to the caller
+        std::size_t item;
+      };
+
+      /**
+       * @brief Build an index
+       * @param height The wallpaper height the widths were scaled to
+       * @param entries The sources to index
+       */
+      GapIndex(std::uint32_t height, std::vector<Entry> entries);
+
+      /**
+       * @brief Get the wallpaper height the index was built for
+       * @return The height in pixels
+       */
+      std::uint32_t height() const;
+
+      /**
+       * @brief Get the number of sources in the index
+       * @return The number of sources with a weight over 0
+       */
+      std::size_t size() const;
+
+      /**
+       * @brief Pick a source that fits a gap
+       * @tparam URBG The random number generator type
+       * @param maxWidth The width of the gap in pixels
+       * @param rng The random number generator
+       * @return The item of a source no wider than the gap, picked in
+       * proportion to its weight, or nullopt if none fit
+       */
+      template <class URBG>
+      std::optional<std::size_t> pick(std::uint32_t maxWidth,
+                                      URBG& rng) const {
+        const auto fits = static_cast<std::size_t>(
+            std::ranges::upper_bound(widths, maxWidth) - widths.begin());
+        if (fits == 0) {
+          return std::nullopt;
+        }
+        std::uniform_int_distribution<std::uint64_t> dist(
+            0, cumulativeWeights[fits - 1] - 1);
+        const auto point = dist(rng);
+        const auto chosen = std::ranges::upper_bound(cumulativeWeights, point) -
+                            cumulativeWeights.begin();
+        return items[static_cast<std::size_t>(chosen)];
+      }
+
+    private:
+      //! The wallpaper height the widths were scaled to
+      std::uint32_t indexHeight;
+
+      //! The scaled width of each source, ascending
+      std::vector<std::uint32_t> widths;
+
+      //! The sum of the weights of each source and every narrower one
+      std::vector<std::uint64_t> cumulativeWeights;
+
+      //! The item of each source
+      std::vector<std::size_t> items;
+    };
+
+  }  // namespace wp
+}  // namespace brilliant
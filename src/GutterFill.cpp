@@ -0,0 +1,224 @@
+/**
+ *
+ *  @file      GutterFill.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements the GutterFill class
+ */
+#include "GutterFill.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace brilliant {
+  namespace wp {
+
+    namespace {
+      //! Every this many pixels and rows of a tile is sampled
+      constexpr std::uint32_t sampleStep = 4;
+
+      //! The samples in a grid cell covered by a tile
+      constexpr float samplesPerCell = static_cast<float>(
+          (GutterFill::scale / sampleStep) * (GutterFill::scale / sampleStep));
+
+      //! The radius of the box blur in grid cells. Two passes reach twice as
+      //! far, 128 pixels either side of a tile
+      constexpr std::uint32_t blurRadius = 4;
+
+      //! The number of times the box blur is run, two is close to a tent
+      constexpr int blurPasses = 2;
+
+      //! How much coverage is needed for the fill to hide what is under it,
+      //! as the inverse of the share of a cell. Next to a short tile is
+      //! only about a third covered
+      constexpr float coverageGain = 4.0f;
+
+      /**
+       * @brief Get the first sample of a tile along one axis
+       * @param origin Where the tile starts on the wallpaper
+       * @return The offset into the tile
+       *
+       * Samples are fixed to the wallpaper rather than to each tile, so
+       * every cell is sampled alike whichever tile covers it.
+       */
+      std::uint32_t firstSample(std::uint32_t origin) {
+        constexpr auto offset = sampleStep / 2;
+        return (offset + sampleStep - origin % sampleStep) % sampleStep;
+      }
+
+      /**
+       * @brief Box blur one line of cells with 4 channels each
+       * @param src The first cell of the line
+       * @param dst Where the first blurred cell is written
+       * @param count The number of cells in the line
+       * @param step The floats from one cell to the next
+       *
+       * Each cell is the average of the cells within the radius which are
+       * inside the line, so the edges of the wallpaper are not darkened.
+       */
+      void blurLine(const float* src, float* dst, std::size_t count,
+                    std::size_t step) {
+        std::array<float, 4> sum{};
+        const auto add = [&](std::size_t i, float sign) {
+          for (std::size_t c = 0; c < 4; ++c) {
+            sum[c] += sign * src[i * step + c];
+          }
+        };
+
+        for (std::size_t i = 0; i < std::min<std::size_t>(blurRadius, count);
+             ++i) {
+          add(i, 1.0f);
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+          if (i + blurRadius < count) {
+            add(i + blurRadius, 1.0f);
+          }
+          const auto first = i > blurRadius ? i - blurRadius : 0;
+          const auto last = std::min(i + blurRadius, count - 1);
+          const auto norm = 1.0f / static_cast<float>(last - first + 1);
+          for (std::size_t c = 0; c < 4; ++c) {
+            dst[i * step + c] = sum[c] * norm;
+          }
+          if (i >= blurRadius) {
+            add(i - blurRadius, -1.0f);
+          }
+        }
+      }
+    }  // namespace
+
+    GutterFill::GutterFill(std::uint32_t wallpaperWidth,
+                           std::uint32_t wallpaperHeight)
+        : width(wallpaperWidth),
+          height(wallpaperHeight),
+          gridWidth((wallpaperWidth + scale - 1) / scale),
+          gridHeight((wallpaperHeight + scale - 1) / scale),
+          sums(std::size_t{gridWidth} * gridHeight * 4) {}
+
+    void GutterFill::addTile(const boost::gil::rgb8c_view_t& tile,
+                             std::uint32_t x, std::uint32_t y) {
+      const auto tileWidth = static_cast<std::uint32_t>(tile.width());
+      const auto tileHeight = static_cast<std::uint32_t>(tile.height());
+      tiles.push_back({x, y, x + tileWidth, y + tileHeight});
+
+      for (auto row = firstSample(y); row < tileHeight; row += sampleStep) {
+        const auto cellRow = std::size_t{(y + row) / scale} * gridWidth;
+        const auto pixels = tile.row_begin(static_cast<std::ptrdiff_t>(row));
+        for (auto col = firstSample(x); col < tileWidth; col += sampleStep) {
+          auto* cell = &sums[(cellRow + (x + col) / scale) * 4];
+          const auto& pixel = pixels[static_cast<std::ptrdiff_t>(col)];
+          cell[0] += pixel[0];
+          cell[1] += pixel[1];
+          cell[2] += pixel[2];
+          ++cell[3];
+        }
+      }
+    }
+
+    void GutterFill::fill(const boost::gil::rgb8_view_t& wallpaper,
+                          float brightness) const {
+      if (tiles.empty()) {
+        return;
+      }
+
+      // the colour sums and the sample count are blurred alike, so the
+      // colour is the average of the tiles nearby however much of the
+      // area they cover
+      std::vector<float> grid(sums.begin(), sums.end());
+      std::vector<float> blurred(grid.size());
+      const std::size_t rowStep = std::size_t{gridWidth} * 4;
+      for (int pass = 0; pass < blurPasses; ++pass) {
+        for (std::size_t y = 0; y < gridHeight; ++y) {
+          blurLine(&grid[y * rowStep], &blurred[y * rowStep], gridWidth, 4);
+        }
+        for (std::size_t x = 0; x < gridWidth; ++x) {
+          blurLine(&blurred[x * 4], &grid[x * 4], gridHeight, rowStep);
+        }
+      }
+
+      // premultiplied by how much the fill covers, so it fades out
+      // smoothly when enlarged
+      for (std::size_t i = 0; i < grid.size(); i += 4) {
+        const auto count = grid[i + 3];
+        const auto alpha =
+            std::min(1.0f, count / samplesPerCell * coverageGain);
+        const auto colour = count > 0.0f ? alpha * brightness / count : 0.0f;
+        for (std::size_t c = 0; c < 3; ++c) {
+          grid[i + c] *= colour;
+        }
+        grid[i + 3] = alpha;
+      }
+
+      auto sorted = tiles;
+      std::ranges::sort(sorted, {}, &Rect::x0);
+
+      // the two grid cells either side of each column or row and how far
+      // between them it is
+      struct Tap {
+        std::uint32_t first;
+        std::uint32_t second;
+        float between;
+      };
+      const auto toGrid = [](std::uint32_t pos, std::uint32_t size) {
+        const auto at = std::clamp(
+            (static_cast<float>(pos) + 0.5f) / scale - 0.5f, 0.0f,
+            static_cast<float>(size - 1));
+        const auto first = static_cast<std::uint32_t>(at);
+        return Tap{first, std::min(first + 1, size - 1),
+                   at - static_cast<float>(first)};
+      };
+      std::vector<Tap> columns(width);
+      for (std::uint32_t x = 0; x < width; ++x) {
+        columns[x] = toGrid(x, gridWidth);
+      }
+
+      std::vector<float> row(rowStep);
+      for (std::uint32_t y = 0; y < height; ++y) {
+        const auto down = toGrid(y, gridHeight);
+        const auto* above = &grid[down.first * rowStep];
+        const auto* below = &grid[down.second * rowStep];
+
+        const auto pixels = wallpaper.row_begin(static_cast<std::ptrdiff_t>(y));
+        const auto fillSpan = [&](std::uint32_t from, std::uint32_t to) {
+          if (from >= to) {
+            return;
+          }
+          // only the cells under the span are enlarged down to this row
+          for (auto i = std::size_t{columns[from].first} * 4;
+               i < (std::size_t{columns[to - 1].second} + 1) * 4; ++i) {
+            row[i] = above[i] + (below[i] - above[i]) * down.between;
+          }
+          for (auto x = from; x < to; ++x) {
+            const auto across = columns[x];
+            // read before the pixel is written, which may alias anything
+            std::array<float, 4> fill;
+            for (std::size_t c = 0; c < 4; ++c) {
+              const auto a = row[across.first * 4 + c];
+              const auto b = row[across.second * 4 + c];
+              fill[c] = a + (b - a) * across.between;
+            }
+            auto& pixel = pixels[static_cast<std::ptrdiff_t>(x)];
+            for (std::size_t c = 0; c < 3; ++c) {
+              const auto value =
+                  fill[c] + static_cast<float>(pixel[c]) * (1.0f - fill[3]);
+              pixel[c] = static_cast<std::uint8_t>(
+                  std::min(255.0f, value + 0.5f));
+            }
+          }
+        };
+
+        std::uint32_t x = 0;
+        for (const auto& tile : sorted) {
+          if (y < tile.y0 || y >= tile.y1) {
+            continue;
+          }
+          fillSpan(x, tile.x0);
+          x = std::max(x, tile.x1);
+        }
+        fillSpan(x, width);
+      }
+    }
+
+  }  // namespace wp
+}  // namespace brilliant
@@ -0,0 +1,94 @@
+/**
+ *
+ *  @file      GutterFill.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Defines the GutterFill class
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <boost/gil.hpp>
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief Fills the gaps between tiles with a blur of the tiles beside
+     * them
+     *
+     * Nothing is blurred at full resolution. Each tile is averaged into a
+     * grid 16 times smaller than the wallpaper as it is drawn. The grid is
+     * box blurred, with the tiles' coverage blurred alongside so the gaps
+     * do not darken the result, and then enlarged into the gaps only.
+     * Far from any tile the fill fades into what is already there.
+     */
+    class GutterFill {
+    public:
+      //! How many times smaller than the wallpaper the grid is
+      static constexpr std::uint32_t scale = 16;
+
+      /**
+       * @brief Construct a GutterFill
+       * @param wallpaperWidth The width of the wallpaper
+       * @param wallpaperHeight The height of the wallpaper
+       */
+      GutterFill(std::uint32_t wallpaperWidth, std::uint32_t wallpaperHeight);
+
+      /**
+       * @brief Add a tile drawn on the wallpaper
+       * @param tile The tile, usually the view of the wallpaper it was
+       * drawn to
+       * @param x The left of the tile on the wallpaper
+       * @param y The top of the tile on the wallpaper
+       *
+       * Only every 4th pixel of every 4th row is read, so a tile is
+       * cheapest to add straight after it is drawn, while it is in cache.
+       */
+      void addTile(const boost::gil::rgb8c_view_t& tile, std::uint32_t x,
+                   std::uint32_t y);
+
+      /**
+       * @brief Fill every pixel of the wallpaper no tile was added over
+       * @param wallpaper The wallpaper the tiles were drawn on
+       * @param brightness How much of the blurred colour is kept, from 0
+       * for black to 1 for none darkened
+       */
+      void fill(const boost::gil::rgb8_view_t& wallpaper,
+                float brightness) const;
+
+    private:
+      /**
+       * @brief Where a tile was drawn, as [x0, x1) by [y0, y1)
+       */
+      struct Rect {
+        std::uint32_t x0;
+        std::uint32_t y0;
+        std::uint32_t x1;
+        std::uint32_t y1;
+      };
+
+      //! The width of the wallpaper
+      std::uint32_t width;
+
+      //! The height of the wallpaper
+      std::uint32_t height;
+
+      //! The width of the grid
+      std::uint32_t gridWidth;
+
+      //! The height of the grid
+      std::uint32_t gridHeight;
+
+      //! The red, green and blue sums and sample count of each grid cell
+      std::vector<std::uint32_t> sums;
+
+      //! Every tile added
+      std::vector<Rect> tiles;
+    };
+
+  }  // namespace wp
+}  // namespace brilliant
@@ -0,0 +1,1042 @@
+/**
+ *
+ *  @file      ImageDecoder.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements functions for probing and decoding images held in memory
+ */
+#include "ImageDecoder.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <format>
+#include <istream>
+#include <memory>
+#include <streambuf>
+#include <utility>
+#include <vector>
+
+#include <png.h>
+
+#include "JpegError.hpp"
+#include "PixelConversion.hpp"
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief Produces the rows of a decoded rgb8 image in order
+     *
+     * Implemented per format below. RowDecoder only exposes this interface.
+     */
+    class RowSource {
+    public:
+      virtual ~RowSource() = default;
+
+      /**
+       * @brief Get the width of the rows
+       * @return The width in pixels
+       */
+      virtual std::uint32_t width() const = 0;
+
+      /**
+       * @brief Get the number of rows
+       * @return The height in pixels
+       */
+      virtual std::uint32_t height() const = 0;
+
+      /**
+       * @brief Decode the next row
+       * @param out Receives width() rgb8 pixels
+       */
+      virtual void readRow(std::uint8_t* out) = 0;
+
+      /**
+       * @brief Decode every row not read yet into an image
+       * @return The decoded image
+       */
+      virtual boost::gil::rgb8_image_t readAll() {
+        boost::gil::rgb8_image_t img(width(), height());
+        const auto view = boost::gil::view(img);
+        for (std::ptrdiff_t y = 0; y < view.height(); ++y) {
+          readRow(reinterpret_cast<std::uint8_t*>(&*view.row_begin(y)));
+        }
+        return img;
+      }
+    };
+
+    namespace {
+
+      /**
+       * @brief A read only stream buffer over a block of memory
+       *
+       * Used to feed boost::gil readers for formats which are not decoded by
+       * hand.
+       */
+      class MemoryStreamBuf : public std::streambuf {
+      public:
+        /**
+         * @brief Construct a MemoryStreamBuf
+         * @param data The memory to read from
+         */
+        explicit MemoryStreamBuf(std::span<const std::byte> data) {
+          // the get area is never written through, std::streambuf just has
+          // no notion of const memory
+          auto* begin =
+              const_cast<char*>(reinterpret_cast<const char*>(data.data()));
+          setg(begin, begin, begin + data.size());
+        }
+
+      protected:
+        /**
+         * @brief Move the read position relative to a location in the buffer
+         * @param off The offset to move by
+         * @param dir The location the offset is relative to
+         * @param which The stream direction, only input is supported
+         * @return The new position or -1 on failure
+         */
+        pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                         std::ios_base::openmode which) override {
+          if (!(which & std::ios_base::in)) {
+            return pos_type(off_type(-1));
+          }
+
+          off_type base = 0;
+          if (dir == std::ios_base::cur) {
+            base = gptr() - eback();
+          } else if (dir == std::ios_base::end) {
+            base = egptr() - eback();
+          }
+
+          const off_type target = base + off;
+          if (target < 0 || target > egptr() - eback()) {
+            return pos_type(off_type(-1));
+          }
+          setg(eback(), eback() + target, egptr());
+          return pos_type(target);
+        }
+
+        /**
+         * @brief Move the read position to an absolute location
+         * @param pos The position to move to
+         * @param which The stream direction, only input is supported
+         * @return The new position or -1 on failure
+         */
+        pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+          return seekoff(off_type(pos), std::ios_base::beg, which);
+        }
+      };
+
+      /**
+       * @brief Reads jpeg images from memory using libjpeg-turbo
+       */
+      class JpegReader {
+      public:
+        /**
+         * @brief Construct a JpegReader and read the image header
+         * @param data The encoded image
+         */
+        explicit JpegReader(std::span<const std::byte> data) {
+          cinfo.err = installJpegErrorManager(err);
+          jpeg_create_decompress(&cinfo);
+
+          if (setjmp(err.jump)) {
+            jpeg_destroy_decompress(&cinfo);
+            throw DecodeError(
+                std::format("Failed to read jpeg header: {}", err.message));
+          }
+
+          jpeg_mem_src(&cinfo,
+                       reinterpret_cast<const unsigned char*>(data.data()),
+                       static_cast<unsigned long>(data.size()));
+          jpeg_read_header(&cinfo, TRUE);
+        }
+
+        JpegReader(const JpegReader&) = delete;
+        JpegReader& operator=(const JpegReader&) = delete;
+
+        /**
+         * @brief Destroy a JpegReader
+         */
+        ~JpegReader() { jpeg_destroy_decompress(&cinfo); }
+
+        /**
+         * @brief Get the width of the image
+         * @return The width of the image in pixels
+         */
+        std::uint32_t width() const { return cinfo.image_width; }
+
+        /**
+         * @brief Get the height of the image
+         * @return The height of the image in pixels
+         */
+        std::uint32_t height() const { return cinfo.image_height; }
+
+        /**
+         * @brief Decode the image
+         * @return The decoded image. gray8 for grayscale jpegs, otherwise rgb8
+         */
+        ImageType decode() {
+          if (cinfo.num_components == 1) {
+            return ImageType(
+                readInto<boost::gil::gray8_image_t>(JCS_GRAYSCALE));
+          }
+          return ImageType(readInto<boost::gil::rgb8_image_t>(JCS_RGB));
+        }
+
+        /**
+         * @brief Start decoding the image as rgb8 regardless of the stored
+         * colour space
+         * @param scale The denominator of the output scale, one of 1, 2, 4
+         * or 8
+         *
+         * Grayscale is expanded by libjpeg while writing each scanline so no
+         * gray8 intermediate is needed. Scaled output is produced by
+         * libjpeg's reduced size inverse DCT, which skips most of the work
+         * of a full size decode. Rows are then read with readRgb8Row.
+         */
+        void startRgb8(std::uint32_t scale = 1) {
+          cinfo.scale_num = 1;
+          cinfo.scale_denom = scale;
+          // libjpeg cannot convert cmyk to rgb itself
+          const bool cmyk = cinfo.jpeg_color_space == JCS_CMYK ||
+                            cinfo.jpeg_color_space == JCS_YCCK;
+          prepareOutput(cmyk ? JCS_CMYK : JCS_RGB);
+          if (cmyk) {
+            cmykRow.resize(std::size_t{cinfo.output_width} * 4);
+          }
+
+          if (setjmp(err.jump)) {
+            throw DecodeError(
+                std::format("Failed to decode jpeg: {}", err.message));
+          }
+          jpeg_start_decompress(&cinfo);
+        }
+
+        /**
+         * @brief Get the width of the decoded rows
+         * @return The output width in pixels, valid once decoding started
+         */
+        std::uint32_t outputWidth() const { return cinfo.output_width; }
+
+        /**
+         * @brief Get the number of decoded rows
+         * @return The output height in pixels, valid once decoding started
+         */
+        std::uint32_t outputHeight() const { return cinfo.output_height; }
+
+        /**
+         * @brief Decode the next row of an image started by startRgb8
+         * @param out Receives outputWidth rgb8 pixels
+         */
+        void readRgb8Row(std::uint8_t* out) {
+          if (setjmp(err.jump)) {
+            throw DecodeError(
+                std::format("Failed to decode jpeg: {}", err.message));
+          }
+
+          if (cmykRow.empty()) {
+            JSAMPROW row = out;
+            jpeg_read_scanlines(&cinfo, &row, 1);
+            return;
+          }
+
+          JSAMPROW row = cmykRow.data();
+          jpeg_read_scanlines(&cinfo, &row, 1);
+          // photoshop writes inverted cmyk and is the main source of these
+          const bool inverted = cinfo.saw_Adobe_marker;
+          const auto ink = [inverted](JSAMPLE v) {
+            return static_cast<unsigned>(inverted ? v : 255 - v);
+          };
+          for (std::size_t x = 0; x < cinfo.output_width; ++x) {
+            const JSAMPLE* cmyk = &cmykRow[x * 4];
+            const auto k = ink(cmyk[3]);
+            for (std::size_t c = 0; c < 3; ++c) {
+              out[x * 3 + c] =
+                  static_cast<std::uint8_t>(ink(cmyk[c]) * k / 255);
+            }
+          }
+        }
+
+      private:
+        /**
+         * @brief Set the output colour space and calculate the output size
+         * @param colorSpace The libjpeg output colour space
+         */
+        void prepareOutput(J_COLOR_SPACE colorSpace) {
+          if (setjmp(err.jump)) {
+            throw DecodeError(
+                std::format("Failed to prepare jpeg decode: {}", err.message));
+          }
+
+          cinfo.out_color_space = colorSpace;
+          jpeg_calc_output_dimensions(&cinfo);
+        }
+
+        /**
+         * @brief Decode the image straight into an image of the given type
+         * @tparam Image The boost::gil image type to decode into
+         * @param colorSpace The libjpeg output colour space matching Image
+         * @return The decoded image
+         */
+        template <class Image>
+        Image readInto(J_COLOR_SPACE colorSpace) {
+          prepareOutput(colorSpace);
+          Image img(cinfo.output_width, cinfo.output_height);
+          auto view = boost::gil::view(img);
+
+          if (setjmp(err.jump)) {
+            throw DecodeError(
+                std::format("Failed to decode jpeg: {}", err.message));
+          }
+
+          jpeg_start_decompress(&cinfo);
+          while (cinfo.output_scanline < cinfo.output_height) {
+            JSAMPROW row = reinterpret_cast<JSAMPROW>(
+                &*view.row_begin(static_cast<std::ptrdiff_t>(
+                    cinfo.output_scanline)));
+            jpeg_read_scanlines(&cinfo, &row, 1);
+          }
+          jpeg_finish_decompress(&cinfo);
+          return img;
+        }
+
+        //! Scanline buffer for cmyk images, empty otherwise
+        std::vector<JSAMPLE> cmykRow;
+
+        //! The libjpeg error manager
+        JpegErrorManager err{};
+
+        //! The libjpeg decompressor
+        jpeg_decompress_struct cinfo{};
+      };
+
+      /**
+       * @brief The read position of a png held in memory
+       */
+      struct PngSource {
+        //! The encoded image
+        std::span<const std::byte> data;
+
+        //! The offset of the next byte to read
+        std::size_t offset = 0;
+      };
+
+      /**
+       * @brief libpng read callback
+       * @param png The libpng read struct
+       * @param out The buffer to copy into
+       * @param length The number of bytes to copy
+       */
+      void readPngData(png_structp png, png_bytep out, png_size_t length) {
+        auto* source = static_cast<PngSource*>(png_get_io_ptr(png));
+        if (source->data.size() - source->offset < length) {
+          png_error(png, "Unexpected end of png data");
+        }
+        std::memcpy(out, source->data.data() + source->offset, length);
+        source->offset += length;
+      }
+
+      //! The maximum length of a stored libpng error message
+      constexpr std::size_t pngMessageLength = 256;
+
+      /**
+       * @brief libpng fatal error handler
+       * @param png The libpng read struct
+       * @param message The error message
+       */
+      void onPngError(png_structp png, png_const_charp message) {
+        auto* buffer = static_cast<char*>(png_get_error_ptr(png));
+        std::strncpy(buffer, message, pngMessageLength - 1);
+        png_longjmp(png, 1);
+      }
+
+      /**
+       * @brief libpng warning handler. Warnings are ignored
+       */
+      void onPngWarning(png_structp, png_const_charp) {}
+
+      /**
+       * @brief Shrink rgb8 rows by an integer factor as they are produced
+       *
+       * Each output pixel is the average of a scale x scale block of input
+       * pixels, so only one output row of sums is held at a time. Blocks on
+       * the right and bottom edges may be partial.
+       */
+      class BoxReducer {
+      public:
+        /**
+         * @brief Construct a BoxReducer
+         * @param inputWidth The width of the input rows in pixels
+         * @param factor The number of input pixels per output pixel in each
+         * direction
+         */
+        BoxReducer(std::uint32_t inputWidth, std::uint32_t factor)
+            : srcWidth(inputWidth),
+              scale(factor),
+              sums(std::size_t{(inputWidth + factor - 1) / factor} * 3) {}
+
+        /**
+         * @brief Add the next input row
+         * @param row The input row, 3 bytes per pixel
+         * @param out Receives the next output row if this input row
+         * completes it
+         * @return True if out was written
+         */
+        bool addRow(const std::uint8_t* row, std::uint8_t* out) {
+          for (std::size_t x = 0; x < srcWidth; ++x) {
+            auto* sum = &sums[x / scale * 3];
+            sum[0] += row[x * 3 + 0];
+            sum[1] += row[x * 3 + 1];
+            sum[2] += row[x * 3 + 2];
+          }
+          if (++rows == scale) {
+            flush(out);
+            return true;
+          }
+          return false;
+        }
+
+        /**
+         * @brief Write out a partial block of rows left at the bottom edge
+         * @param out Receives the last output row if there is one
+         * @return True if out was written
+         */
+        bool finish(std::uint8_t* out) {
+          if (rows > 0) {
+            flush(out);
+            return true;
+          }
+          return false;
+        }
+
+      private:
+        /**
+         * @brief Write the averaged sums to an output row and reset them
+         * @param out The output row
+         */
+        void flush(std::uint8_t* out) {
+          for (std::size_t x = 0; x < sums.size() / 3; ++x) {
+            const auto columns =
+                std::min<std::size_t>(scale, srcWidth - x * scale);
+            const auto count = static_cast<std::uint32_t>(columns * rows);
+            for (std::size_t c = 0; c < 3; ++c) {
+              out[x * 3 + c] = static_cast<std::uint8_t>(
+                  (sums[x * 3 + c] + count / 2) / count);
+            }
+          }
+          std::ranges::fill(sums, 0u);
+          rows = 0;
+        }
+
+        //! The width of the input rows in pixels
+        std::uint32_t srcWidth;
+
+        //! The number of input pixels per output pixel in each direction
+        std::uint32_t scale;
+
+        //! Channel sums for the output row being accumulated
+        std::vector<std::uint32_t> sums;
+
+        //! The number of input rows added to sums
+        std::uint32_t rows = 0;
+      };
+
+      /**
+       * @brief Reads png images from memory using libpng
+       */
+      class PngReader {
+      public:
+        /**
+         * @brief Construct a PngReader and read the image header
+         * @param data The encoded image
+         */
+        explicit PngReader(std::span<const std::byte> data) : source{data} {
+          png = png_create_read_struct(PNG_LIBPNG_VER_STRING, message,
+                                       onPngError, onPngWarning);
+          if (!png) {
+            throw DecodeError("Failed to create png read struct");
+          }
+          info = png_create_info_struct(png);
+          if (!info) {
+            png_destroy_read_struct(&png, nullptr, nullptr);
+            throw DecodeError("Failed to create png info struct");
+          }
+
+          if (setjmp(png_jmpbuf(png))) {
+            png_destroy_read_struct(&png, &info, nullptr);
+            throw DecodeError(
+                std::format("Failed to read png header: {}", message));
+          }
+
+          png_set_read_fn(png, &source, readPngData);
+          png_read_info(png, info);
+        }
+
+        PngReader(const PngReader&) = delete;
+        PngReader& operator=(const PngReader&) = delete;
+
+        /**
+         * @brief Destroy a PngReader
+         */
+        ~PngReader() { png_destroy_read_struct(&png, &info, nullptr); }
+
+        /**
+         * @brief Get the width of the image
+         * @return The width of the image in pixels
+         */
+        std::uint32_t width() const { return png_get_image_width(png, info); }
+
+        /**
+         * @brief Get the height of the image
+         * @return The height of the image in pixels
+         */
+        std::uint32_t height() const {
+          return png_get_image_height(png, info);
+        }
+
+        /**
+         * @brief Decode the image
+         * @return The decoded image in the ImageType alternative closest to
+         * the stored format
+         */
+        ImageType decode() {
+          configureNative();
+
+          const auto colorType = png_get_color_type(png, info);
+          const auto bitDepth = png_get_bit_depth(png, info);
+          switch (colorType) {
+          case PNG_COLOR_TYPE_RGB:
+            return ImageType(readInto<boost::gil::rgb8_image_t>());
+          case PNG_COLOR_TYPE_RGB_ALPHA:
+            return bitDepth == 16
+                       ? ImageType(readInto<boost::gil::rgba16_image_t>())
+                       : ImageType(readInto<boost::gil::rgba8_image_t>());
+          case PNG_COLOR_TYPE_GRAY:
+            return bitDepth == 16
+                       ? ImageType(readInto<boost::gil::gray16_image_t>())
+                       : ImageType(readInto<boost::gil::gray8_image_t>());
+          case PNG_COLOR_TYPE_GRAY_ALPHA:
+            return bitDepth == 16
+                       ? ImageType(
+                             readInto<boost::gil::gray_alpha16_image_t>())
+                       : ImageType(
+                             readInto<boost::gil::gray_alpha8_image_t>());
+          default:
+            throw DecodeError(std::format(
+                "Unsupported png color type {} with bit depth {}", colorType,
+                bitDepth));
+          }
+        }
+
+        /**
+         * @brief Check if the image is stored interlaced
+         * @return True for Adam7 interlaced images
+         */
+        bool interlaced() const {
+          return png_get_interlace_type(png, info) != PNG_INTERLACE_NONE;
+        }
+
+        /**
+         * @brief Set up libpng transforms so every row comes out as rgb8
+         * @param background The colour transparent pixels are blended onto
+         *
+         * libpng expands, narrows and composites each row as it is decoded
+         * so no full size intermediate in the stored format is needed.
+         */
+        void configureRgb8(boost::gil::rgb8_pixel_t background) {
+          if (setjmp(png_jmpbuf(png))) {
+            throw DecodeError(
+                std::format("Failed to configure png decode: {}", message));
+          }
+
+          const auto colorType = png_get_color_type(png, info);
+          const bool hasTrns = png_get_valid(png, info, PNG_INFO_tRNS) != 0;
+
+          expand();
+          if (png_get_bit_depth(png, info) == 16) {
+            // rounds rather than truncating like png_set_strip_16
+            png_set_scale_16(png);
+          }
+          if ((colorType & PNG_COLOR_MASK_COLOR) == 0) {
+            png_set_gray_to_rgb(png);
+          }
+          if ((colorType & PNG_COLOR_MASK_ALPHA) != 0 || hasTrns) {
+            // unlike png_set_strip_alpha, this keeps transparent areas from
+            // showing whatever colour happens to be stored under them
+            png_color_16 colour{};
+            colour.red = boost::gil::at_c<0>(background);
+            colour.green = boost::gil::at_c<1>(background);
+            colour.blue = boost::gil::at_c<2>(background);
+            colour.gray = colour.green;
+            png_set_background(png, &colour, PNG_BACKGROUND_GAMMA_SCREEN, 0,
+                               1.0);
+          }
+          png_set_interlace_handling(png);
+          png_read_update_info(png, info);
+        }
+
+        /**
+         * @brief Decode an image configured by configureRgb8
+         * @param scale The denominator of the output scale
+         * @return The decoded image
+         *
+         * Used for interlaced images, which only have complete rows after
+         * their last pass. Non interlaced images are read with readRow.
+         */
+        boost::gil::rgb8_image_t readRgb8(std::uint32_t scale) {
+          auto full = readInto<boost::gil::rgb8_image_t>();
+          if (scale == 1) {
+            return full;
+          }
+
+          boost::gil::rgb8_image_t img((width() + scale - 1) / scale,
+                                       (height() + scale - 1) / scale);
+          const auto src = boost::gil::const_view(full);
+          const auto dst = boost::gil::view(img);
+          BoxReducer reducer(width(), scale);
+          std::ptrdiff_t y = 0;
+          const auto out = [&dst, &y] {
+            return reinterpret_cast<std::uint8_t*>(&*dst.row_begin(y));
+          };
+          for (std::ptrdiff_t row = 0; row < src.height(); ++row) {
+            if (reducer.addRow(reinterpret_cast<const std::uint8_t*>(
+                                   &*src.row_begin(row)),
+                               out())) {
+              ++y;
+            }
+          }
+          if (y < dst.height()) {
+            reducer.finish(out());
+          }
+          return img;
+        }
+
+        /**
+         * @brief Decode the next row of a non interlaced image
+         * @param out Receives one row in the configured output format
+         */
+        void readRow(std::uint8_t* out) {
+          if (setjmp(png_jmpbuf(png))) {
+            throw DecodeError(std::format("Failed to decode png: {}", message));
+          }
+          png_read_row(png, out, nullptr);
+        }
+
+      private:
+        /**
+         * @brief Set up the libpng transforms shared by every output format
+         *
+         * Palettes become rgb, low bit depth gray becomes 8 bit and tRNS
+         * chunks become an alpha channel.
+         */
+        void expand() {
+          const auto colorType = png_get_color_type(png, info);
+          if (colorType == PNG_COLOR_TYPE_PALETTE) {
+            png_set_palette_to_rgb(png);
+          }
+          if (colorType == PNG_COLOR_TYPE_GRAY &&
+              png_get_bit_depth(png, info) < 8) {
+            png_set_expand_gray_1_2_4_to_8(png);
+          }
+          if (png_get_valid(png, info, PNG_INFO_tRNS)) {
+            png_set_tRNS_to_alpha(png);
+          }
+        }
+
+        /**
+         * @brief Set up libpng transforms so the output maps onto one of the
+         * ImageType alternatives
+         */
+        void configureNative() {
+          if (setjmp(png_jmpbuf(png))) {
+            throw DecodeError(
+                std::format("Failed to configure png decode: {}", message));
+          }
+
+          const auto colorType = png_get_color_type(png, info);
+          const auto bitDepth = png_get_bit_depth(png, info);
+          const bool hasTrns = png_get_valid(png, info, PNG_INFO_tRNS) != 0;
+
+          expand();
+          if (bitDepth == 16) {
+            if (colorType == PNG_COLOR_TYPE_RGB && !hasTrns) {
+              // there is no rgb16 alternative in ImageType
+              png_set_strip_16(png);
+            } else if constexpr (std::endian::native == std::endian::little) {
+              png_set_swap(png);
+            }
+          }
+          png_set_interlace_handling(png);
+          png_read_update_info(png, info);
+        }
+
+        /**
+         * @brief Decode the image into an image of the given type
+         * @tparam Image The boost::gil image type matching the configured
+         * output format
+         * @return The decoded image
+         */
+        template <class Image>
+        Image readInto() {
+          Image img(width(), height());
+          auto view = boost::gil::view(img);
+          std::vector<png_bytep> rows(height());
+          for (std::size_t y = 0; y < rows.size(); ++y) {
+            rows[y] = reinterpret_cast<png_bytep>(
+                &*view.row_begin(static_cast<std::ptrdiff_t>(y)));
+          }
+
+          if (setjmp(png_jmpbuf(png))) {
+            throw DecodeError(std::format("Failed to decode png: {}", message));
+          }
+
+          png_read_image(png, rows.data());
+          png_read_end(png, nullptr);
+          return img;
+        }
+
+        //! The read position in the encoded image
+        PngSource source;
+
+        //! The libpng read struct
+        png_structp png = nullptr;
+
+        //! The libpng info struct
+        png_infop info = nullptr;
+
+        //! The last error message reported by libpng
+        char message[pngMessageLength]{};
+      };
+
+      /**
+       * @brief Read image metadata using boost::gil
+       * @tparam Tag The image format tag
+       * @param data The encoded image
+       * @param tag The image format tag
+       * @return ImageInfo for the image
+       */
+      template <class Tag>
+      ImageInfo probeWithGil(std::span<const std::byte> data, const Tag& tag) {
+        MemoryStreamBuf buffer(data);
+        std::istream is(&buffer);
+        try {
+          const auto backend = boost::gil::read_image_info(is, tag);
+          return ImageInfo(static_cast<std::uint32_t>(backend._info._width),
+                           static_cast<std::uint32_t>(backend._info._height),
+                           tag);
+        } catch (const std::exception& e) {
+          throw DecodeError(
+              std::format("Failed to read image header: {}", e.what()));
+        }
+      }
+
+      /**
+       * @brief Decode an image using boost::gil
+       * @tparam Tag The image format tag
+       * @param data The encoded image
+       * @param tag The image format tag
+       * @return The decoded image
+       */
+      template <class Tag>
+      ImageType decodeWithGil(std::span<const std::byte> data, const Tag& tag) {
+        MemoryStreamBuf buffer(data);
+        std::istream is(&buffer);
+        ImageType img;
+        try {
+          boost::gil::read_image(is, img, tag);
+        } catch (const std::exception& e) {
+          throw DecodeError(
+              std::format("Failed to decode image: {}", e.what()));
+        }
+        return img;
+      }
+
+      /**
+       * @brief Hands out the rows of an image decoded up front
+       */
+      class ImageRowSource : public RowSource {
+      public:
+        /**
+         * @brief Construct an ImageRowSource
+         * @param decoded The decoded image
+         */
+        explicit ImageRowSource(boost::gil::rgb8_image_t decoded)
+            : img(std::move(decoded)) {}
+
+        std::uint32_t width() const override {
+          return static_cast<std::uint32_t>(img.width());
+        }
+
+        std::uint32_t height() const override {
+          return static_cast<std::uint32_t>(img.height());
+        }
+
+        void readRow(std::uint8_t* out) override {
+          const auto row = boost::gil::const_view(img).row_begin(y++);
+          std::memcpy(out, &*row, std::size_t{width()} * 3);
+        }
+
+        boost::gil::rgb8_image_t readAll() override {
+          if (y == 0) {
+            return std::move(img);
+          }
+          return RowSource::readAll();
+        }
+
+      private:
+        //! The decoded image
+        boost::gil::rgb8_image_t img;
+
+        //! The next row to hand out
+        std::ptrdiff_t y = 0;
+      };
+
+      /**
+       * @brief Decodes a jpeg one scanline at a time
+       */
+      class JpegRowSource : public RowSource {
+      public:
+        /**
+         * @brief Construct a JpegRowSource and start decoding
+         * @param data The encoded image
+         * @param scale The denominator of the output scale
+         */
+        JpegRowSource(std::span<const std::byte> data, std::uint32_t scale)
+            : reader(data) {
+          reader.startRgb8(scale);
+        }
+
+        std::uint32_t width() const override { return reader.outputWidth(); }
+
+        std::uint32_t height() const override {
+          return reader.outputHeight();
+        }
+
+        void readRow(std::uint8_t* out) override { reader.readRgb8Row(out); }
+
+      private:
+        //! The jpeg being decoded
+        JpegReader reader;
+      };
+
+      /**
+       * @brief Decodes a non interlaced png one row at a time, folding rows
+       * into a BoxReducer when decoding at a reduced scale
+       */
+      class PngRowSource : public RowSource {
+      public:
+        /**
+         * @brief Construct a PngRowSource
+         * @param pngReader A reader configured by PngReader::configureRgb8
+         * @param factor The denominator of the output scale
+         */
+        PngRowSource(std::unique_ptr<PngReader> pngReader, std::uint32_t factor)
+            : reader(std::move(pngReader)),
+              scale(factor),
+              reducer(reader->width(), factor),
+              row(factor == 1 ? 0 : std::size_t{reader->width()} * 3) {}
+
+        std::uint32_t width() const override {
+          return (reader->width() + scale - 1) / scale;
+        }
+
+        std::uint32_t height() const override {
+          return (reader->height() + scale - 1) / scale;
+        }
+
+        void readRow(std::uint8_t* out) override {
+          if (scale == 1) {
+            reader->readRow(out);
+            return;
+          }
+          while (rowsRead < reader->height()) {
+            reader->readRow(row.data());
+            ++rowsRead;
+            if (reducer.addRow(row.data(), out)) {
+              return;
+            }
+          }
+          reducer.finish(out);
+        }
+
+      private:
+        //! The png being decoded
+        std::unique_ptr<PngReader> reader;
+
+        //! The denominator of the output scale
+        std::uint32_t scale;
+
+        //! Averages blocks of decoded rows when scale is above 1
+        BoxReducer reducer;
+
+        //! The decoded row being reduced, empty when scale is 1
+        std::vector<std::uint8_t> row;
+
+        //! The number of rows decoded so far
+        std::uint32_t rowsRead = 0;
+      };
+
+      /**
+       * @brief Make the row source best suited to an image's format
+       * @param data The encoded image
+       * @param tags A variant containing the image type tag
+       * @param background The colour transparent pixels are blended onto
+       * @param scale The denominator of the output scale
+       * @return The row source
+       */
+      std::unique_ptr<RowSource> makeRowSource(
+          std::span<const std::byte> data, const ImageTags& tags,
+          boost::gil::rgb8_pixel_t background, std::uint32_t scale) {
+        return std::visit(
+            [data, background,
+             scale](const auto& tag) -> std::unique_ptr<RowSource> {
+              using Tag = std::decay_t<decltype(tag)>;
+              if constexpr (std::is_same_v<Tag, boost::gil::jpeg_tag>) {
+                return std::make_unique<JpegRowSource>(data, scale);
+              } else if constexpr (std::is_same_v<Tag, boost::gil::png_tag>) {
+                auto reader = std::make_unique<PngReader>(data);
+                reader->configureRgb8(background);
+                if (reader->interlaced()) {
+                  return std::make_unique<ImageRowSource>(
+                      reader->readRgb8(scale));
+                }
+                return std::make_unique<PngRowSource>(std::move(reader),
+                                                      scale);
+              } else {
+                const auto img = decodeWithGil(data, tag);
+                boost::gil::rgb8_image_t rgb(img.dimensions());
+                convertToRgb8(boost::gil::const_view(img),
+                              boost::gil::view(rgb), background);
+                return std::make_unique<ImageRowSource>(std::move(rgb));
+              }
+            },
+            tags);
+      }
+
+    }  // namespace
+
+    ImageInfo probeImage(std::span<const std::byte> data,
+                         const ImageTags& tags) {
+      return std::visit(
+          [data, &tags](const auto& tag) -> ImageInfo {
+            using Tag = std::decay_t<decltype(tag)>;
+            if constexpr (std::is_same_v<Tag, boost::gil::jpeg_tag>) {
+              JpegReader reader(data);
+              return ImageInfo(reader.width(), reader.height(), tags);
+            } else if constexpr (std::is_same_v<Tag, boost::gil::png_tag>) {
+              PngReader reader(data);
+              return ImageInfo(reader.width(), reader.height(), tags,
+                               reader.interlaced());
+            } else {
+              return probeWithGil(data, tag);
+            }
+          },
+          tags);
+    }
+
+    ImageType decodeImage(std::span<const std::byte> data,
+                          const ImageTags& tags) {
+      return std::visit(
+          [data](const auto& tag) -> ImageType {
+            using Tag = std::decay_t<decltype(tag)>;
+            if constexpr (std::is_same_v<Tag, boost::gil::jpeg_tag>) {
+              return JpegReader(data).decode();
+            } else if constexpr (std::is_same_v<Tag, boost::gil::png_tag>) {
+              return PngReader(data).decode();
+            } else {
+              return decodeWithGil(data, tag);
+            }
+          },
+          tags);
+    }
+
+    bool supportsReducedScale(const ImageTags& tags) {
+      return std::holds_alternative<boost::gil::jpeg_tag>(tags) ||
+             std::holds_alternative<boost::gil::png_tag>(tags);
+    }
+
+    std::optional<std::uint32_t> chooseDecodeScale(const ImageInfo& info,
+                                                   std::uint32_t minWidth,
+                                                   std::uint32_t minHeight,
+                                                   std::uint64_t maxPixels) {
+      const std::uint32_t limit =
+          supportsReducedScale(info.getType()) ? maxDecodeScale : 1;
+      const auto scaledSize = [&info](std::uint32_t scale) {
+        return std::pair<std::uint64_t, std::uint64_t>(
+            (std::uint64_t{info.width()} + scale - 1) / scale,
+            (std::uint64_t{info.height()} + scale - 1) / scale);
+      };
+      const auto fitsBudget = [&](std::uint32_t scale) {
+        const auto [w, h] = scaledSize(scale);
+        return w * h <= maxPixels;
+      };
+      const auto coversMinimum = [&](std::uint32_t scale) {
+        const auto [w, h] = scaledSize(scale);
+        return w >= minWidth && h >= minHeight;
+      };
+
+      std::uint32_t scale = 1;
+      while (!fitsBudget(scale)) {
+        if (scale == limit) {
+          return std::nullopt;
+        }
+        scale *= 2;
+      }
+
+      // go further while the result still covers the requested size
+      while (scale < limit && coversMinimum(scale * 2)) {
+        scale *= 2;
+      }
+      return scale;
+    }
+
+    std::uint64_t estimateDecodeBytes(const ImageInfo& info,
+                                      std::uint32_t scale) {
+      if (!supportsReducedScale(info.getType())) {
+        return std::uint64_t{info.width()} * info.height() * (8 + 3);
+      }
+      const auto width = (std::uint64_t{info.width()} + scale - 1) / scale;
+      const auto height = (std::uint64_t{info.height()} + scale - 1) / scale;
+      if (info.interlaced() && scale > 1) {
+        // decoded in full and then reduced into the result
+        return (std::uint64_t{info.width()} * info.height() + width * height) *
+               3;
+      }
+      return width * height * 3;
+    }
+
+    boost::gil::rgb8_image_t decodeImageRgb8(
+        std::span<const std::byte> data, const ImageTags& tags,
+        boost::gil::rgb8_pixel_t background, std::uint32_t scale) {
+      return makeRowSource(data, tags, background, scale)->readAll();
+    }
+
+    RowDecoder::RowDecoder(std::span<const std::byte> data,
+                           const ImageTags& tags,
+                           boost::gil::rgb8_pixel_t background,
+                           std::uint32_t scale)
+        : source(makeRowSource(data, tags, background, scale)) {}
+
+    RowDecoder::RowDecoder(RowDecoder&&) noexcept = default;
+
+    RowDecoder& RowDecoder::operator=(RowDecoder&&) noexcept = default;
+
+    RowDecoder::~RowDecoder() = default;
+
+    std::uint32_t RowDecoder::width() const { return source->width(); }
+
+    std::uint32_t RowDecoder::height() const { return source->height(); }
+
+    void RowDecoder::readRow(boost::gil::rgb8_pixel_t* out) {
+      if (rowsRead == height()) {
+        throw DecodeError("Read past the last row of the image");
+      }
+      source->readRow(reinterpret_cast<std::uint8_t*>(out));
+      ++rowsRead;
+    }
+
+  }  // namespace wp
+}  // namespace brilliant
@@ -0,0 +1,177 @@
+/**
+ *
+ *  @file      ImageDecoder.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Defines functions for probing and decoding images held in memory
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+
+#include "ImageProcessing.hpp"
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief Decoder specific exception type
+     */
+    struct DecodeError : std::runtime_error {
+      using runtime_error::runtime_error;
+    };
+
+    /**
+     * @brief Read the metadata of an encoded image
+     * @param data The encoded image, usually the contents of a MappedFile
+     * @param tags A variant containing the image type tag
+     * @return ImageInfo for the image
+     * @throws DecodeError if the image header cannot be read
+     *
+     * Jpeg and png images are read by libjpeg-turbo and libpng directly from
+     * memory. Other formats go through boost::gil using a stream over the
+     * same memory.
+     */
+    ImageInfo probeImage(std::span<const std::byte> data,
+                         const ImageTags& tags);
+
+    /**
+     * @brief Decode an encoded image
+     * @param data The encoded image, usually the contents of a MappedFile
+     * @param tags A variant containing the image type tag
+     * @return The decoded image
+     * @throws DecodeError if the image cannot be decoded
+     */
+    ImageType decodeImage(std::span<const std::byte> data,
+                          const ImageTags& tags);
+
+    //! The largest scale denominator supported by a reduced scale decode
+    constexpr std::uint32_t maxDecodeScale = 8;
+
+    /**
+     * @brief Check if a format can be decoded at a reduced scale
+     * @param tags A variant containing the image type tag
+     * @return True for jpeg and png images
+     */
+    bool supportsReducedScale(const ImageTags& tags);
+
+    /**
+     * @brief Choose the scale to decode an image at
+     * @param info The metadata of the image
+     * @param minWidth The smallest width the decoded image may have
+     * @param minHeight The smallest height the decoded image may have
+     * @param maxPixels The most pixels the decoded image may have
+     * @return The denominator of the scale, a power of 2 no larger than
+     * maxDecodeScale. nullopt if the image cannot be decoded within
+     * maxPixels
+     *
+     * maxPixels takes priority over minWidth and minHeight. Formats which do
+     * not support a reduced scale decode always get 1.
+     */
+    std::optional<std::uint32_t> chooseDecodeScale(const ImageInfo& info,
+                                                   std::uint32_t minWidth,
+                                                   std::uint32_t minHeight,
+                                                   std::uint64_t maxPixels);
+
+    /**
+     * @brief Estimate the memory decodeImageRgb8 needs for an image
+     * @param info The metadata of the image
+     * @param scale The denominator of the scale, see chooseDecodeScale
+     * @return The estimated peak in bytes
+     *
+     * jpeg and png images are decoded a row at a time into the 3 byte
+     * result. Interlaced pngs are decoded in full at 3 bytes per pixel
+     * before they are reduced. Other formats are decoded whole by
+     * boost::gil first, at up to 8 bytes per pixel, and then converted.
+     */
+    std::uint64_t estimateDecodeBytes(const ImageInfo& info,
+                                      std::uint32_t scale);
+
+    /**
+     * @brief Decode an encoded image straight into the composite format
+     * @param data The encoded image, usually the contents of a MappedFile
+     * @param tags A variant containing the image type tag
+     * @param background The colour transparent pixels are blended onto
+     * @param scale The denominator of the output scale, see
+     * chooseDecodeScale. Ignored by formats without reduced scale support
+     * @return The decoded image, its size is the stored size divided by
+     * scale and rounded up
+     * @throws DecodeError if the image cannot be decoded
+     *
+     * libjpeg-turbo and libpng are asked for rgb8 output so gray expansion,
+     * 16 bit narrowing and alpha compositing happen while each row is
+     * decoded. A 16 bit rgba png needs 3 bytes per pixel instead of 8. Other
+     * formats are decoded by boost::gil and converted with convertToRgb8.
+     */
+    boost::gil::rgb8_image_t decodeImageRgb8(
+        std::span<const std::byte> data, const ImageTags& tags,
+        boost::gil::rgb8_pixel_t background, std::uint32_t scale = 1);
+
+    class RowSource;
+
+    /**
+     * @brief Decodes an image into rgb8 one row at a time
+     *
+     * Jpeg and non interlaced png images are decoded as rows are read, so
+     * only the rows libjpeg and libpng work on are held in memory. Other
+     * formats and interlaced pngs are decoded in full up front and handed
+     * out row by row. The encoded data must outlive the decoder.
+     */
+    class RowDecoder {
+    public:
+      /**
+       * @brief Construct a RowDecoder and read the image header
+       * @param data The encoded image, usually the contents of a MappedFile
+       * @param tags A variant containing the image type tag
+       * @param background The colour transparent pixels are blended onto
+       * @param scale The denominator of the output scale, see
+       * chooseDecodeScale. Ignored by formats without reduced scale support
+       * @throws DecodeError if the image header cannot be read
+       */
+      RowDecoder(std::span<const std::byte> data, const ImageTags& tags,
+                 boost::gil::rgb8_pixel_t background, std::uint32_t scale = 1);
+
+      RowDecoder(RowDecoder&&) noexcept;
+      RowDecoder& operator=(RowDecoder&&) noexcept;
+
+      /**
+       * @brief Destroy a RowDecoder
+       */
+      ~RowDecoder();
+
+      /**
+       * @brief Get the width of the decoded rows
+       * @return The stored width divided by scale and rounded up
+       */
+      std::uint32_t width() const;
+
+      /**
+       * @brief Get the number of decoded rows
+       * @return The stored height divided by scale and rounded up
+       */
+      std::uint32_t height() const;
+
+      /**
+       * @brief Decode the next row
+       * @param out Receives width() pixels
+       * @throws DecodeError if the row cannot be decoded or every row has
+       * already been read
+       */
+      void readRow(boost::gil::rgb8_pixel_t* out);
+
+    private:
+      //! The format specific decoder
+      std::unique_ptr<RowSource> source;
+
+      //! The number of rows read so far
+      std::uint32_t rowsRead = 0;
+    };
+
+  }  // namespace wp
+}  // namespace brilliant
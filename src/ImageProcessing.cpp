@@ -8,12 +8,15 @@
  */
 #include "ImageProcessing.hpp"
 
+#include <algorithm>
 #include <format>
 #include <fstream>
 #include <ranges>
 #include <type_traits>
 
+#include "ImageDecoder.hpp"
 #include "Log.hpp"
+#include "MappedFile.hpp"
 
 namespace brilliant {
   namespace wp {
@@ -27,46 +30,53 @@ namespace brilliant {
       return static_cast<std::byte>(i);
     }
 
-    ImageInfo::ImageInfo(const ImageInfoType& info) : info(info) {}
+    ImageInfo::ImageInfo(const ImageInfoType& info)
+        : imageWidth(std::visit(
+              [](const auto& i) {
+                return static_cast<std::uint32_t>(i._info._width);
+              },
+              info)),
+          imageHeight(std::visit(
+              [](const auto& i) {
+                return static_cast<std::uint32_t>(i._info._height);
+              },
+              info)),
+          type(std::visit(
+              [](const auto& i) -> ImageTags {
+                return typename std::decay_t<decltype(i)>::format_tag_t();
+              },
+              info)) {}
 
     ImageInfo::ImageInfo(const std::filesystem::path& path,
                          const ImageTags& tags)
-        : ImageInfo(getImageInfo(path, tags)) {}
-
-    std::uint32_t ImageInfo::height() const {
-      return std::visit(
-          [](const auto& i) {
-            return static_cast<std::uint32_t>(i._info._height);
-          },
-          info);
-    }
+        : ImageInfo(probeImage(MappedFile(path, AccessHint::normal).data(),
+                               tags)) {}
 
-    std::uint32_t ImageInfo::width() const {
-      return std::visit(
-          [](const auto& i) {
-            return static_cast<std::uint32_t>(i._info._width);
-          },
-          info);
-    }
+    ImageInfo::ImageInfo(std::uint32_t width, std::uint32_t height,
+                         const ImageTags& tags, bool interlaced)
+        : imageWidth(width),
+          imageHeight(height),
+          type(tags),
+          imageInterlaced(interlaced) {}
 
-    ImageTags ImageInfo::getType() const {
-      return std::visit(
-          [](const auto& i) -> ImageTags {
-            return std::decay_t<decltype(i)>::format_tag_t();
-          },
-          info);
-    }
+    std::uint32_t ImageInfo::height() const { return imageHeight; }
 
-    ImageInfoType ImageInfo::getImageInfo(const std::filesystem::path& path,
-                                          const ImageTags& tags) {
-      return std::visit(
-          [path](const auto& type) -> ImageInfoType {
-            return boost::gil::read_image_info(path, type);
-          },
-          tags);
-    }
+    std::uint32_t ImageInfo::width() const { return imageWidth; }
+
+    ImageTags ImageInfo::getType() const { return type; }
+
+    bool ImageInfo::interlaced() const { return imageInterlaced; }
 
     std::optional<ImageTags> getImageType(const std::filesystem::path& path) {
+      if (std::basic_ifstream<std::byte> file(path, std::ios::binary); file) {
+        std::array<std::byte, 8> bytes{};
+        file.read(bytes.data(), bytes.size());
+        return getImageType(bytes);
+      }
+      return std::nullopt;
+    }
+
+    std::optional<ImageTags> getImageType(std::span<const std::byte> header) {
       constexpr std::array<std::byte, 2> bmpHeader{0x42_bt, 0x4D_bt};
       constexpr std::array<std::byte, 3> jpgHeader{0xff_bt, 0xd8_bt, 0xff_bt};
       constexpr std::array<std::byte, 8> pngHeader = {0x89_bt, 0x50_bt, 0x4e_bt,
@@ -85,27 +95,26 @@ namespace brilliant {
       constexpr std::array<std::byte, 3> ppmHeader2 = {0x50_bt, 0x36_bt,
                                                        0x0a_bt};
 
-      if (std::basic_ifstream<std::byte> file(path, std::ios::binary); file) {
-        std::array<std::byte, 8> bytes{};
-        file.read(bytes.data(), bytes.size());
-
-        if (std::ranges::equal(bytes | std::views::take(bmpHeader.size()),
-                               bmpHeader)) {
-          return boost::gil::bmp_tag{};
-        } else if (std::ranges::equal(
-                       bytes | std::views::take(jpgHeader.size()), jpgHeader)) {
-          return boost::gil::jpeg_tag{};
-        } else if (std::ranges::equal(bytes, pngHeader)) {
-          return boost::gil::png_tag{};
-        } else if (auto firstThreeBytes = bytes | std::views::take(3);
-                   std::ranges::equal(firstThreeBytes, pbmHeader1) ||
-                   std::ranges::equal(firstThreeBytes, pbmHeader2) ||
-                   std::ranges::equal(firstThreeBytes, pgmHeader1) ||
-                   std::ranges::equal(firstThreeBytes, pgmHeader2) ||
-                   std::ranges::equal(firstThreeBytes, ppmHeader1) ||
-                   std::ranges::equal(firstThreeBytes, ppmHeader2)) {
-          return boost::gil::pnm_tag{};
-        }
+      std::array<std::byte, 8> bytes{};
+      std::ranges::copy(header | std::views::take(bytes.size()),
+                        bytes.begin());
+
+      if (std::ranges::equal(bytes | std::views::take(bmpHeader.size()),
+                             bmpHeader)) {
+        return boost::gil::bmp_tag{};
+      } else if (std::ranges::equal(bytes | std::views::take(jpgHeader.size()),
+                                    jpgHeader)) {
+        return boost::gil::jpeg_tag{};
+      } else if (std::ranges::equal(bytes, pngHeader)) {
+        return boost::gil::png_tag{};
+      } else if (auto firstThreeBytes = bytes | std::views::take(3);
+                 std::ranges::equal(firstThreeBytes, pbmHeader1) ||
+                 std::ranges::equal(firstThreeBytes, pbmHeader2) ||
+                 std::ranges::equal(firstThreeBytes, pgmHeader1) ||
+                 std::ranges::equal(firstThreeBytes, pgmHeader2) ||
+                 std::ranges::equal(firstThreeBytes, ppmHeader1) ||
+                 std::ranges::equal(firstThreeBytes, ppmHeader2)) {
+        return boost::gil::pnm_tag{};
       }
       return std::nullopt;
     }
@@ -130,5 +139,15 @@ namespace brilliant {
       return {info.width(), info.height()};
     }
 
+    std::pair<std::uint32_t, std::uint32_t> getScaledDimsToFit(
+        std::uint32_t maxWidth, std::uint32_t maxHeight,
+        const ImageInfo& info) {
+      const double scale = std::min(
+          {1.0, static_cast<double>(maxWidth) / info.width(),
+           static_cast<double>(maxHeight) / info.height()});
+      return {std::max(1u, static_cast<std::uint32_t>(info.width() * scale)),
+              std::max(1u, static_cast<std::uint32_t>(info.height() * scale))};
+    }
+
   }  // namespace wp
 }  // namespace brilliant
\ No newline at end of file
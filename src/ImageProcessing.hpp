@@ -15,6 +15,7 @@
 #include <boost/gil/extension/io/pnm.hpp>
 #include <filesystem>
 #include <optional>
+#include <span>
 #include <variant>
 #include <vector>
 // TODO: webp?
@@ -88,6 +89,16 @@ namespace brilliant {
        */
       ImageInfo(const std::filesystem::path& path, const ImageTags& tags);
 
+      /**
+       * @brief Construct an ImageInfo object from already known metadata
+       * @param width The width of the image in pixels
+       * @param height The height of the image in pixels
+       * @param tags A variant containing the image type tag
+       * @param interlaced True if the image is stored interlaced
+       */
+      ImageInfo(std::uint32_t width, std::uint32_t height,
+                const ImageTags& tags, bool interlaced = false);
+
       /**
        * @brief Get the height of the image in pixels
        * @return The height of the image in pixels
@@ -106,18 +117,25 @@ namespace brilliant {
        */
       ImageTags getType() const;
 
-    private:
       /**
-       * @brief Create a boost::gil backend from a file and image type info
-       * @param path The path to the image
-       * @param tags A variant containing the image tag type
-       * @return A boost::gil reader backend for the given image
+       * @brief Check if the image is stored interlaced
+       * @return True for Adam7 interlaced pngs, which are decoded in full
+       * before they are scaled
        */
-      static ImageInfoType getImageInfo(const std::filesystem::path& path,
-                                        const ImageTags& tags);
+      bool interlaced() const;
+
+    private:
+      //! The width of the image in pixels
+      std::uint32_t imageWidth;
+
+      //! The height of the image in pixels
+      std::uint32_t imageHeight;
+
+      //! The image type tag
+      ImageTags type;
 
-      //! The boost::gil reader backend
-      ImageInfoType info;
+      //! True if the image is stored interlaced
+      bool imageInterlaced = false;
     };
 
     /**
@@ -128,6 +146,15 @@ namespace brilliant {
      */
     std::optional<ImageTags> getImageType(const std::filesystem::path& path);
 
+    /**
+     * @brief Get the image file type from the leading bytes of an image
+     * @param header The start of the encoded image. At least 8 bytes are needed
+     * to identify every supported format
+     * @return An optional holding a variant containing the image tag type if
+     * successful. A nullopt otherwise.
+     */
+    std::optional<ImageTags> getImageType(std::span<const std::byte> header);
+
     /**
      * @brief Scale an image's dimensions in pixels based on the desired height
      * in pixels
@@ -140,6 +167,18 @@ namespace brilliant {
     std::pair<std::uint32_t, std::uint32_t> getScaledDimsFromHeight(
         std::uint32_t srcHeight, const ImageInfo& info);
 
+    /**
+     * @brief Scale an image's dimensions in pixels to fit inside a box while
+     * keeping its aspect ratio
+     * @param maxWidth The width of the box in pixels
+     * @param maxHeight The height of the box in pixels
+     * @param info ImageInfo for the target image
+     * @return A pair containing the width and height of the scaled target
+     * image in pixels. Images which already fit are not scaled up
+     */
+    std::pair<std::uint32_t, std::uint32_t> getScaledDimsToFit(
+        std::uint32_t maxWidth, std::uint32_t maxHeight, const ImageInfo& info);
+
     /**
      * @brief Determine regions of interest (ROIs) for a list of images to be
      * copied to the source image
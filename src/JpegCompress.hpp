@@ -0,0 +1,76 @@
+/**
+ *
+ *  @file      JpegCompress.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Defines the libjpeg destination and row handling shared by the jpeg
+ *  writers
+ */
+#pragma once
+
+#include <cstddef>
+
+#include <boost/gil.hpp>
+
+#include "JpegError.hpp"
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief Base of a libjpeg destination which forwards libjpeg's callbacks
+     * to the derived class
+     * @tparam Derived The destination. Its init() points pub at an empty
+     * buffer, empty(cinfo) makes room when the buffer is full and
+     * term(cinfo) takes the rest once the image is complete
+     */
+    template <class Derived>
+    struct JpegDestination {
+      //! The libjpeg destination manager, the only member so a compressor's
+      //! dest points at the destination
+      jpeg_destination_mgr pub{};
+
+      JpegDestination() {
+        pub.init_destination = [](j_compress_ptr cinfo) {
+          from(cinfo).init();
+        };
+        pub.empty_output_buffer = [](j_compress_ptr cinfo) -> boolean {
+          from(cinfo).empty(cinfo);
+          // libjpeg ignores free_in_buffer here, so the destination must
+          // have made room rather than suspend
+          return TRUE;
+        };
+        pub.term_destination = [](j_compress_ptr cinfo) {
+          from(cinfo).term(cinfo);
+        };
+      }
+
+      /**
+       * @brief Get the destination a compressor writes to
+       * @param cinfo The compressor
+       * @return The destination
+       */
+      static Derived& from(j_compress_ptr cinfo) {
+        return static_cast<Derived&>(
+            *reinterpret_cast<JpegDestination*>(cinfo->dest));
+      }
+    };
+
+    /**
+     * @brief Compress rows into a started compressor
+     * @param cinfo The compressor, started with the width of the rows
+     * @param rows The rows to compress
+     */
+    inline void writeJpegRows(j_compress_ptr cinfo,
+                              const boost::gil::rgb8c_view_t& rows) {
+      for (std::ptrdiff_t y = 0; y < rows.height(); ++y) {
+        // libjpeg takes mutable rows but only reads them
+        JSAMPROW row = const_cast<JSAMPROW>(
+            reinterpret_cast<const JSAMPLE*>(&*rows.row_begin(y)));
+        jpeg_write_scanlines(cinfo, &row, 1);
+      }
+    }
+
+  }  // namespace wp
+}  // namespace brilliant
@@ -0,0 +1,64 @@
+/**
+ *
+ *  @file      JpegError.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Defines the libjpeg error handling shared by the jpeg reader and writer
+ */
+#pragma once
+
+// jpeglib.h expects FILE to be declared
+#include <csetjmp>
+#include <cstdio>
+
+#include <jpeglib.h>
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief libjpeg error manager which jumps back to the caller instead of
+     * calling exit()
+     */
+    struct JpegErrorManager {
+      //! The libjpeg error manager, must be the first member
+      jpeg_error_mgr pub;
+
+      //! Jump target set before calling into libjpeg
+      std::jmp_buf jump;
+
+      //! The formatted error message
+      char message[JMSG_LENGTH_MAX];
+    };
+
+    /**
+     * @brief libjpeg fatal error handler
+     * @param cinfo The libjpeg object that raised the error
+     */
+    inline void onJpegError(j_common_ptr cinfo) {
+      auto* err = reinterpret_cast<JpegErrorManager*>(cinfo->err);
+      (*cinfo->err->format_message)(cinfo, err->message);
+      std::longjmp(err->jump, 1);
+    }
+
+    /**
+     * @brief libjpeg message handler. Warnings are ignored, libjpeg would
+     * otherwise print them to stderr
+     */
+    inline void onJpegMessage(j_common_ptr) {}
+
+    /**
+     * @brief Point a libjpeg object at a JpegErrorManager
+     * @param err The error manager to install
+     * @return The libjpeg error manager to store in the object's err field
+     */
+    inline jpeg_error_mgr* installJpegErrorManager(JpegErrorManager& err) {
+      auto* pub = jpeg_std_error(&err.pub);
+      err.pub.error_exit = onJpegError;
+      err.pub.output_message = onJpegMessage;
+      return pub;
+    }
+
+  }  // namespace wp
+}  // namespace brilliant
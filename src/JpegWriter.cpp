@@ -0,0 +1,159 @@
+/**
+ *
+ *  @file      JpegWriter.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements the JpegWriter class
+ */
+#include "JpegWriter.hpp"
+
+#include <array>
+#include <format>
+#include <fstream>
+
+#include "JpegCompress.hpp"
+
+#include <jerror.h>
+
+namespace brilliant {
+  namespace wp {
+
+    namespace {
+      //! The number of compressed bytes buffered before writing to the file
+      constexpr std::size_t outputBufferSize = 64 * 1024;
+
+      /**
+       * @brief libjpeg destination which writes to an ofstream
+       */
+      struct FileDestination : JpegDestination<FileDestination> {
+        //! The file being written
+        std::ofstream file;
+
+        //! Compressed bytes not yet written to the file
+        std::array<JOCTET, outputBufferSize> buffer;
+
+        /**
+         * @brief Point libjpeg at the empty buffer
+         */
+        void init() {
+          pub.next_output_byte = buffer.data();
+          pub.free_in_buffer = buffer.size();
+        }
+
+        /**
+         * @brief Write the full buffer to the file
+         * @param cinfo The compressor
+         */
+        void empty(j_compress_ptr cinfo) {
+          write(cinfo, buffer.size());
+          init();
+        }
+
+        /**
+         * @brief Write the rest of the buffer to the file
+         * @param cinfo The compressor
+         */
+        void term(j_compress_ptr cinfo) {
+          write(cinfo, buffer.size() - pub.free_in_buffer);
+          file.flush();
+          if (!file) {
+            ERREXIT(cinfo, JERR_FILE_WRITE);
+          }
+        }
+
+        /**
+         * @brief Write the start of the buffer to the file
+         * @param cinfo The compressor
+         * @param count The number of bytes to write
+         */
+        void write(j_compress_ptr cinfo, std::size_t count) {
+          file.write(reinterpret_cast<const char*>(buffer.data()),
+                     static_cast<std::streamsize>(count));
+          if (!file) {
+            ERREXIT(cinfo, JERR_FILE_WRITE);
+          }
+        }
+      };
+    }  // namespace
+
+    /**
+     * @brief The libjpeg compressor and its destination
+     */
+    struct JpegWriter::State {
+      //! Where compressed bytes go
+      FileDestination dest{};
+
+      //! The libjpeg error manager
+      JpegErrorManager err{};
+
+      //! The libjpeg compressor
+      jpeg_compress_struct cinfo{};
+    };
+
+    JpegWriter::JpegWriter(const std::filesystem::path& path,
+                           std::uint32_t width, std::uint32_t height,
+                           int quality)
+        : state(std::make_unique<State>()) {
+      auto& dest = state->dest;
+      dest.file.open(path, std::ios::binary | std::ios::trunc);
+      if (!dest.file) {
+        throw EncodeError(std::format("Failed to create {}", path.string()));
+      }
+
+      auto& cinfo = state->cinfo;
+      cinfo.err = installJpegErrorManager(state->err);
+      jpeg_create_compress(&cinfo);
+      cinfo.dest = &dest.pub;
+
+      if (setjmp(state->err.jump)) {
+        jpeg_destroy_compress(&cinfo);
+        throw EncodeError(std::format("Failed to start jpeg {}: {}",
+                                      path.string(), state->err.message));
+      }
+
+      cinfo.image_width = width;
+      cinfo.image_height = height;
+      cinfo.input_components = 3;
+      cinfo.in_color_space = JCS_RGB;
+      jpeg_set_defaults(&cinfo);
+      jpeg_set_quality(&cinfo, quality, TRUE);
+      jpeg_start_compress(&cinfo, TRUE);
+    }
+
+    JpegWriter::~JpegWriter() { jpeg_destroy_compress(&state->cinfo); }
+
+    void JpegWriter::writeRows(const boost::gil::rgb8c_view_t& rows) {
+      auto& cinfo = state->cinfo;
+      if (rows.width() != static_cast<std::ptrdiff_t>(cinfo.image_width)) {
+        throw EncodeError(std::format("Rows are {} pixels wide, expected {}",
+                                      rows.width(), cinfo.image_width));
+      }
+
+      if (setjmp(state->err.jump)) {
+        throw EncodeError(
+            std::format("Failed to write jpeg rows: {}", state->err.message));
+      }
+
+      writeJpegRows(&cinfo, rows);
+    }
+
+    void JpegWriter::finish() {
+      auto& cinfo = state->cinfo;
+      if (cinfo.next_scanline != cinfo.image_height) {
+        throw EncodeError(std::format("Only {} of {} rows were written",
+                                      cinfo.next_scanline,
+                                      cinfo.image_height));
+      }
+
+      if (setjmp(state->err.jump)) {
+        throw EncodeError(
+            std::format("Failed to finish jpeg: {}", state->err.message));
+      }
+
+      jpeg_finish_compress(&cinfo);
+      state->dest.file.close();
+    }
+
+  }  // namespace wp
+}  // namespace brilliant
@@ -0,0 +1,83 @@
+/**
+ *
+ *  @file      JpegWriter.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Defines the JpegWriter class
+ */
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+
+#include <boost/gil.hpp>
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief Encoder specific exception type
+     */
+    struct EncodeError : std::runtime_error {
+      using runtime_error::runtime_error;
+    };
+
+    //! The jpeg quality boost::gil writes with, kept so output is unchanged
+    constexpr int defaultJpegQuality = 100;
+
+    /**
+     * @brief Encodes a jpeg file a band of scanlines at a time
+     *
+     * Rows are compressed by libjpeg-turbo as they are written and the
+     * compressed bytes go straight to the file, so only the band handed to
+     * writeRows has to be held by the caller.
+     */
+    class JpegWriter {
+    public:
+      /**
+       * @brief Create the file and write the jpeg header
+       * @param path The file to write
+       * @param width The width of the image in pixels
+       * @param height The height of the image in pixels
+       * @param quality The libjpeg quality, 1 to 100
+       * @throws EncodeError if the file cannot be created
+       */
+      JpegWriter(const std::filesystem::path& path, std::uint32_t width,
+                 std::uint32_t height, int quality = defaultJpegQuality);
+
+      JpegWriter(const JpegWriter&) = delete;
+      JpegWriter& operator=(const JpegWriter&) = delete;
+
+      /**
+       * @brief Destroy a JpegWriter. A file which was not finished is left
+       * incomplete
+       */
+      ~JpegWriter();
+
+      /**
+       * @brief Compress the next rows of the image
+       * @param rows The rows, as wide as the image
+       * @throws EncodeError if the rows cannot be written
+       */
+      void writeRows(const boost::gil::rgb8c_view_t& rows);
+
+      /**
+       * @brief Write the end of the image and close the file
+       * @throws EncodeError if fewer rows than the height were written or
+       * the file cannot be completed
+       */
+      void finish();
+
+    private:
+      //! libjpeg state, kept out of the header
+      struct State;
+
+      //! The compressor and its file
+      std::unique_ptr<State> state;
+    };
+
+  }  // namespace wp
+}  // namespace brilliant
@@ -12,6 +12,8 @@
 #include <format>
 #include <string_view>
 
+#include <boost/log/core.hpp>
+#include <boost/log/expressions.hpp>
 #include <boost/log/trivial.hpp>
 
 namespace brilliant {
@@ -35,5 +37,14 @@ namespace brilliant {
                                              const_cast<const Args&>(args)...));
     }
 
+    /**
+     * @brief Drop log messages below a severity
+     * @param level The lowest severity which is logged
+     */
+    inline void setLogLevel(severity_level level) {
+      boost::log::core::get()->set_filter(boost::log::trivial::severity >=
+                                          level);
+    }
+
   }  // namespace wp
 }  // namespace brilliant
\ No newline at end of file
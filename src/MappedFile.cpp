@@ -0,0 +1,37 @@
+/**
+ *
+ *  @file      MappedFile.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements the MappedFile class
+ */
+#include "MappedFile.hpp"
+
+#ifdef WIN32
+#include "Win/MappedFileImpl.hpp"
+#else
+#include "Posix/MappedFileImpl.hpp"
+#endif
+
+namespace brilliant {
+  namespace wp {
+
+    MappedFile::MappedFile(const std::filesystem::path& path, AccessHint hint)
+        : _impl(std::make_unique<MappedFileImpl>(path, hint)) {}
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept = default;
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept = default;
+
+    MappedFile::~MappedFile() = default;
+
+    std::span<const std::byte> MappedFile::data() const {
+      // a moved-from MappedFile has no mapping
+      return _impl ? _impl->data() : std::span<const std::byte>();
+    }
+
+    std::size_t MappedFile::size() const { return data().size(); }
+
+  }  // namespace wp
+}  // namespace brilliant
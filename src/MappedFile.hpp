@@ -0,0 +1,86 @@
+/**
+ *
+ *  @file      MappedFile.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Defines the MappedFile class
+ */
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <span>
+
+namespace brilliant {
+  namespace wp {
+    //! Forward declare the implementation type
+    class MappedFileImpl;
+
+    /**
+     * @brief Hint describing how the contents of a mapped file will be read
+     */
+    enum class AccessHint {
+      //! Only a small part of the file will be touched, eg: reading a header
+      normal,
+
+      //! The whole file will be read front to back, eg: decoding an image
+      sequential
+    };
+
+    /**
+     * @brief A read only memory mapping of a file
+     *
+     * Lets the image codecs read straight out of the page cache instead of
+     * copying file contents through buffered stdio streams.
+     */
+    class MappedFile {
+    public:
+      /**
+       * @brief Map the file at the given path into memory
+       * @param path The path of the file to map
+       * @param hint How the mapped contents will be accessed
+       * @throws std::system_error if the file cannot be opened or mapped
+       */
+      explicit MappedFile(const std::filesystem::path& path,
+                          AccessHint hint = AccessHint::sequential);
+
+      /**
+       * @brief Move construct a MappedFile
+       * @param other The MappedFile to move from
+       */
+      MappedFile(MappedFile&& other) noexcept;
+
+      /**
+       * @brief Move assign a MappedFile
+       * @param other The MappedFile to move from
+       * @return A reference to this object
+       */
+      MappedFile& operator=(MappedFile&& other) noexcept;
+
+      /**
+       * @brief Unmap the file
+       */
+      ~MappedFile();
+
+      /**
+       * @brief Get the contents of the file
+       * @return A span over the mapped bytes. Empty for empty files and
+       * for a MappedFile which has been moved from
+       */
+      std::span<const std::byte> data() const;
+
+      /**
+       * @brief Get the size of the file
+       * @return The size of the file in bytes, or 0 if this MappedFile has
+       * been moved from
+       */
+      std::size_t size() const;
+
+    private:
+      //! A pointer to the platform specific mapping
+      std::unique_ptr<MappedFileImpl> _impl;
+    };
+  }  // namespace wp
+}  // namespace brilliant
@@ -0,0 +1,48 @@
+/**
+ *
+ *  @file      MemberLocation.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Defines where a source image is stored in an archive
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief How a member is stored in its archive
+     */
+    enum class MemberKind : std::uint8_t {
+      //! A file in a tar archive, its data follows its 512 byte header
+      tar,
+      //! A file stored uncompressed in a zip archive
+      zipStored,
+      //! A file compressed with deflate in a zip archive
+      zipDeflated
+    };
+
+    /**
+     * @brief Where a member's data is in its archive
+     */
+    struct MemberLocation {
+      //! Where the member's header starts in the archive. For zip members
+      //! this is the local header, which is only read with the data
+      std::uint64_t offset = 0;
+
+      //! The size of the member's data in the archive
+      std::uint64_t storedSize = 0;
+
+      //! The size of the member once read, larger than storedSize when it
+      //! is deflated
+      std::uint64_t size = 0;
+
+      //! How the member is stored
+      MemberKind kind = MemberKind::tar;
+    };
+
+  }  // namespace wp
+}  // namespace brilliant
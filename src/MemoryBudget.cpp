@@ -0,0 +1,116 @@
+/**
+ *
+ *  @file      MemoryBudget.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements the MemoryBudget class
+ */
+#include "MemoryBudget.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace brilliant {
+  namespace wp {
+
+    MemoryBudget::Reservation::Reservation(MemoryBudget& from,
+                                           std::uint64_t reserved, Kind how)
+        : budget(&from), bytes(reserved), kind(how) {}
+
+    MemoryBudget::Reservation::Reservation(Reservation&& other) noexcept
+        : budget(std::exchange(other.budget, nullptr)),
+          bytes(other.bytes),
+          kind(other.kind) {}
+
+    MemoryBudget::Reservation& MemoryBudget::Reservation::operator=(
+        Reservation&& other) noexcept {
+      if (this != &other) {
+        release();
+        budget = std::exchange(other.budget, nullptr);
+        bytes = other.bytes;
+        kind = other.kind;
+      }
+      return *this;
+    }
+
+    MemoryBudget::Reservation::~Reservation() { release(); }
+
+    void MemoryBudget::Reservation::release() {
+      if (budget) {
+        std::exchange(budget, nullptr)->give(bytes, kind);
+      }
+    }
+
+    MemoryBudget::MemoryBudget(std::uint64_t limit) : maxBytes(limit) {}
+
+    MemoryBudget::Reservation MemoryBudget::hold(std::uint64_t bytes) {
+      return reserve(bytes, Reservation::Kind::held);
+    }
+
+    MemoryBudget::Reservation MemoryBudget::borrow(std::uint64_t bytes) {
+      return reserve(bytes, Reservation::Kind::borrowed);
+    }
+
+    MemoryBudget::Reservation MemoryBudget::track(std::uint64_t bytes) {
+      return reserve(bytes, Reservation::Kind::tracked);
+    }
+
+    std::uint64_t MemoryBudget::limit() const { return maxBytes; }
+
+    std::uint64_t MemoryBudget::headroom() const {
+      std::lock_guard lock(mutex);
+      const auto kept = heldBytes + trackedBytes;
+      return maxBytes > kept ? maxBytes - kept : 0;
+    }
+
+    std::uint64_t MemoryBudget::used() const {
+      std::lock_guard lock(mutex);
+      return heldBytes + borrowedBytes + trackedBytes;
+    }
+
+    std::uint64_t MemoryBudget::peak() const {
+      std::lock_guard lock(mutex);
+      return peakBytes;
+    }
+
+    MemoryBudget::Reservation MemoryBudget::reserve(std::uint64_t bytes,
+                                                    Reservation::Kind kind) {
+      std::unique_lock lock(mutex);
+      if (maxBytes > 0 && kind != Reservation::Kind::tracked) {
+        returned.wait(lock, [&] {
+          // tracked memory takes up room but is not waited for alone
+          const auto blocking = kind == Reservation::Kind::borrowed
+                                    ? borrowedBytes
+                                    : heldBytes + borrowedBytes;
+          const auto used = heldBytes + borrowedBytes + trackedBytes;
+          return blocking == 0 || used + bytes <= maxBytes;
+        });
+      }
+      counter(kind) += bytes;
+      peakBytes =
+          std::max(peakBytes, heldBytes + borrowedBytes + trackedBytes);
+      return Reservation(*this, bytes, kind);
+    }
+
+    std::uint64_t& MemoryBudget::counter(Reservation::Kind kind) {
+      switch (kind) {
+        case Reservation::Kind::borrowed:
+          return borrowedBytes;
+        case Reservation::Kind::tracked:
+          return trackedBytes;
+        default:
+          return heldBytes;
+      }
+    }
+
+    void MemoryBudget::give(std::uint64_t bytes, Reservation::Kind kind) {
+      {
+        std::lock_guard lock(mutex);
+        counter(kind) -= bytes;
+      }
+      returned.notify_all();
+    }
+
+  }  // namespace wp
+}  // namespace brilliant
@@ -0,0 +1,187 @@
+/**
+ *
+ *  @file      MemoryBudget.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Defines the MemoryBudget class
+ */
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief Keeps estimated memory use under a limit by making work wait
+     *
+     * Memory is reserved in two ways. A job holds memory for as long as it
+     * runs, eg: a wallpaper's canvas, and borrows more for short steps
+     * while it holds, eg: a decode. Held memory waits for the budget while
+     * anything else is reserved. Borrowed memory only waits while other
+     * borrowed memory is out, as that is always returned without waiting
+     * on anything, so no job can wait on one which is waiting on it. A
+     * reservation which does not fit in an otherwise empty budget goes
+     * ahead alone rather than waiting forever.
+     *
+     * Memory which outlives any one job, eg: tiles kept for other
+     * monitors, is tracked. It takes up room in the budget but never
+     * waits, and nothing waits for it alone, as it may only be returned
+     * once the job waiting has finished.
+     *
+     * A limit of 0 never waits, but use and peak are still tracked.
+     */
+    class MemoryBudget {
+    public:
+      /**
+       * @brief Memory reserved from a budget, returned on destruction
+       */
+      class Reservation {
+      public:
+        /**
+         * @brief How memory was reserved
+         */
+        enum class Kind : std::uint8_t {
+          //! For the length of a job
+          held,
+          //! For a short step of a job
+          borrowed,
+          //! Kept beyond any one job
+          tracked
+        };
+
+        Reservation() = default;
+        Reservation(Reservation&& other) noexcept;
+        Reservation& operator=(Reservation&& other) noexcept;
+        ~Reservation();
+
+        /**
+         * @brief Return the memory early
+         */
+        void release();
+
+      private:
+        friend class MemoryBudget;
+
+        /**
+         * @brief Construct a Reservation
+         * @param from The budget the memory came from
+         * @param reserved The bytes reserved
+         * @param how How the memory was reserved
+         */
+        Reservation(MemoryBudget& from, std::uint64_t reserved, Kind how);
+
+        //! The budget the memory came from, null once released
+        MemoryBudget* budget = nullptr;
+
+        //! The bytes reserved
+        std::uint64_t bytes = 0;
+
+        //! How the memory was reserved
+        Kind kind = Kind::held;
+      };
+
+      /**
+       * @brief Construct a MemoryBudget
+       * @param limit The most bytes to have reserved at once, 0 for no
+       * limit
+       */
+      explicit MemoryBudget(std::uint64_t limit);
+
+      /**
+       * @brief Reserve memory for the length of a job
+       * @param bytes The estimated bytes
+       * @return The reservation
+       */
+      Reservation hold(std::uint64_t bytes);
+
+      /**
+       * @brief Reserve memory for a short step of a job
+       * @param bytes The estimated bytes
+       * @return The reservation
+       */
+      Reservation borrow(std::uint64_t bytes);
+
+      /**
+       * @brief Count memory kept beyond any one job without waiting
+       * @param bytes The estimated bytes
+       * @return The reservation
+       */
+      Reservation track(std::uint64_t bytes);
+
+      /**
+       * @brief Get the limit
+       * @return The limit in bytes, 0 for no limit
+       */
+      std::uint64_t limit() const;
+
+      /**
+       * @brief Get the memory left for borrowing
+       * @return The limit less every held and tracked reservation, 0 if
+       * that is over the limit. The largest a borrow can be without going
+       * ahead alone
+       */
+      std::uint64_t headroom() const;
+
+      /**
+       * @brief Get the memory reserved now
+       * @return The reserved bytes
+       */
+      std::uint64_t used() const;
+
+      /**
+       * @brief Get the most memory reserved at once
+       * @return The peak in bytes
+       */
+      std::uint64_t peak() const;
+
+    private:
+      /**
+       * @brief Wait for and take a reservation
+       * @param bytes The estimated bytes
+       * @param kind How to reserve the memory
+       * @return The reservation
+       */
+      Reservation reserve(std::uint64_t bytes, Reservation::Kind kind);
+
+      /**
+       * @brief Get the counter for a kind of reservation
+       * @param kind How the memory was reserved
+       * @return The counter, must be used with mutex held
+       */
+      std::uint64_t& counter(Reservation::Kind kind);
+
+      /**
+       * @brief Return a reservation's memory
+       * @param bytes The bytes reserved
+       * @param kind How the memory was reserved
+       */
+      void give(std::uint64_t bytes, Reservation::Kind kind);
+
+      //! The most bytes to have reserved at once, 0 for no limit
+      const std::uint64_t maxBytes;
+
+      //! Guards the counters
+      mutable std::mutex mutex;
+
+      //! Signalled when memory is returned
+      std::condition_variable returned;
+
+      //! The bytes held
+      std::uint64_t heldBytes = 0;
+
+      //! The bytes borrowed
+      std::uint64_t borrowedBytes = 0;
+
+      //! The bytes tracked
+      std::uint64_t trackedBytes = 0;
+
+      //! The most bytes reserved at once
+      std::uint64_t peakBytes = 0;
+    };
+
+  }  // namespace wp
+}  // namespace brilliant
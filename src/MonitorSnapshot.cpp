@@ -0,0 +1,158 @@
+/**
+ *
+ *  @file      MonitorSnapshot.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements saving and loading MonitorSnapshot
+ */
+#include "MonitorSnapshot.hpp"
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <system_error>
+
+#include "Log.hpp"
+#include "TextFields.hpp"
+
+namespace brilliant {
+  namespace wp {
+
+    namespace {
+      /**
+       * @brief Check a saved wallpaper still exists
+       * @param path The wallpaper
+       * @return True if it is a regular file
+       */
+      bool isSaved(const std::filesystem::path& path) {
+        std::error_code ec;
+        return std::filesystem::is_regular_file(path, ec);
+      }
+    }  // namespace
+
+    void Fingerprint::add(std::string_view bytes) {
+      for (const auto c : bytes) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ull;
+      }
+    }
+
+    void Fingerprint::addPath(const std::filesystem::path& path) {
+      add(std::string_view(toUtf8(path)));
+      // keeps "ab" + "c" apart from "a" + "bc"
+      add(std::string_view("\0", 1));
+    }
+
+    std::uint64_t Fingerprint::value() const { return hash; }
+
+    bool saveSnapshot(const std::filesystem::path& file,
+                      const MonitorSnapshot& snapshot) {
+      // key \t value, paths may repeat a key
+      std::ostringstream text;
+      text << std::format("fingerprint\t{}\n", snapshot.fingerprint);
+      text << std::format(
+          "deadline\t{}\n",
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              snapshot.deadline.time_since_epoch())
+              .count());
+      text << "mt\t" << snapshot.mt << '\n';
+      text << std::format("current\t{}\n", toUtf8(snapshot.current));
+      for (const auto& path : snapshot.next) {
+        text << std::format("next\t{}\n", toUtf8(path));
+      }
+      for (const auto& path : snapshot.recent) {
+        text << std::format("recent\t{}\n", toUtf8(path));
+      }
+
+      auto partial = file;
+      partial += ".partial";
+      {
+        std::ofstream out(partial, std::ios::binary | std::ios::trunc);
+        out << text.view();
+        out.close();
+        if (!out) {
+          log(severity_level::warning, "Failed to write snapshot {}",
+              partial.string());
+          return false;
+        }
+      }
+
+      std::error_code ec;
+      std::filesystem::rename(partial, file, ec);
+      if (ec) {
+        log(severity_level::warning, "Failed to replace snapshot {}: {}",
+            file.string(), ec.message());
+        std::filesystem::remove(partial, ec);
+        return false;
+      }
+      return true;
+    }
+
+    std::optional<MonitorSnapshot> loadSnapshot(
+        const std::filesystem::path& file) {
+      std::ifstream in(file, std::ios::binary);
+      if (!in) {
+        return std::nullopt;
+      }
+
+      MonitorSnapshot snapshot;
+      bool hasFingerprint = false;
+      bool hasDeadline = false;
+      bool hasMt = false;
+      std::string line;
+      while (std::getline(in, line)) {
+        const std::string_view text(line);
+        const auto tab = text.find('\t');
+        const auto key = text.substr(0, tab);
+        const auto value = text.substr(std::min(tab + 1, text.size()));
+        bool ok = true;
+        if (tab == std::string_view::npos) {
+          ok = false;
+        } else if (key == "fingerprint") {
+          ok = hasFingerprint = parseField(value, snapshot.fingerprint);
+        } else if (key == "deadline") {
+          std::int64_t ms = 0;
+          ok = hasDeadline = parseField(value, ms);
+          snapshot.deadline = std::chrono::system_clock::time_point(
+              std::chrono::duration_cast<
+                  std::chrono::system_clock::duration>(
+                  std::chrono::milliseconds(ms)));
+        } else if (key == "mt") {
+          std::istringstream state{std::string(value)};
+          state >> snapshot.mt;
+          ok = hasMt = !state.fail();
+        } else if (key == "current") {
+          snapshot.current = fromUtf8(value);
+        } else if (key == "next") {
+          snapshot.next.push_back(fromUtf8(value));
+        } else if (key == "recent") {
+          snapshot.recent.push_back(fromUtf8(value));
+        } else {
+          ok = false;
+        }
+
+        if (!ok) {
+          log(severity_level::warning, "Ignoring malformed snapshot {}: {}",
+              file.string(), line);
+          return std::nullopt;
+        }
+      }
+
+      if (!hasFingerprint || !hasDeadline || !hasMt ||
+          !isSaved(snapshot.current)) {
+        return std::nullopt;
+      }
+      std::erase_if(snapshot.next, [](const auto& path) {
+        return !isSaved(path);
+      });
+      std::erase_if(snapshot.recent, [](const auto& path) {
+        return !isSaved(path);
+      });
+      return snapshot;
+    }
+
+  }  // namespace wp
+}  // namespace brilliant
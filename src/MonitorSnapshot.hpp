@@ -0,0 +1,107 @@
+/**
+ *
+ *  @file      MonitorSnapshot.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Defines the state a monitor keeps across restarts
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <random>
+#include <string_view>
+#include <vector>
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief Identifies the inputs a wallpaper was made from
+     *
+     * A 64 bit FNV-1a hash, which unlike std::hash is the same on every
+     * platform and run.
+     */
+    class Fingerprint {
+    public:
+      /**
+       * @brief Add bytes to the fingerprint
+       * @param bytes The bytes to add
+       */
+      void add(std::string_view bytes);
+
+      /**
+       * @brief Add a path to the fingerprint as utf-8
+       * @param path The path to add
+       */
+      void addPath(const std::filesystem::path& path);
+
+      /**
+       * @brief Get the fingerprint
+       * @return The hash of everything added so far
+       */
+      std::uint64_t value() const;
+
+    private:
+      //! The hash so far, starting from the FNV offset basis
+      std::uint64_t hash = 0xcbf29ce484222325ull;
+    };
+
+    /**
+     * @brief What a monitor was showing and had ready when it was saved
+     *
+     * Saved after every transition and every wallpaper made, so a restart
+     * can carry on without making any wallpaper again.
+     */
+    struct MonitorSnapshot {
+      //! The Fingerprint of the config and resolution the wallpapers were
+      //! made for
+      std::uint64_t fingerprint = 0;
+
+      //! The wallpaper being shown
+      std::filesystem::path current;
+
+      //! Wallpapers made ahead of their transitions, in the order they are
+      //! shown
+      std::vector<std::filesystem::path> next;
+
+      //! Wallpapers shown recently, oldest first
+      std::vector<std::filesystem::path> recent;
+
+      //! When the next transition is due. The system clock is used as the
+      //! steady clock does not survive a reboot
+      std::chrono::system_clock::time_point deadline{};
+
+      //! The monitor's random number generator, so the sources picked after
+      //! a restart are the ones that would have been picked without it
+      std::mt19937 mt;
+    };
+
+    /**
+     * @brief Save a snapshot, replacing any previous one
+     * @param file The file to save to
+     * @param snapshot The snapshot to save
+     * @return True if the snapshot was saved
+     *
+     * The snapshot is written next to file and renamed over it, so a crash
+     * part way leaves the previous snapshot whole. Failures are logged.
+     */
+    bool saveSnapshot(const std::filesystem::path& file,
+                      const MonitorSnapshot& snapshot);
+
+    /**
+     * @brief Load a saved snapshot
+     * @param file The file the snapshot was saved to
+     * @return The snapshot, or nullopt if there is none, it is malformed or
+     * its current wallpaper no longer exists
+     *
+     * Wallpapers in next and recent which no longer exist are left out.
+     */
+    std::optional<MonitorSnapshot> loadSnapshot(
+        const std::filesystem::path& file);
+
+  }  // namespace wp
+}  // namespace brilliant
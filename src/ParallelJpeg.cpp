@@ -0,0 +1,329 @@
+/**
+ *
+ *  @file      ParallelJpeg.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements a jpeg encoder which compresses horizontal segments in
+ *  parallel
+ */
+#include "ParallelJpeg.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <boost/asio/post.hpp>
+
+#include "JpegCompress.hpp"
+
+namespace brilliant {
+  namespace wp {
+
+    namespace {
+      //! The most MCUs a DRI marker can put between restarts
+      constexpr std::size_t maxRestartInterval = 0xFFFF;
+
+      //! Segments per thread, more than one so a slow segment does not hold
+      //! up the rest
+      constexpr std::size_t segmentsPerThread = 4;
+
+      //! A compressed jpeg
+      using JpegBytes = std::vector<JOCTET>;
+
+      /**
+       * @brief libjpeg destination which appends to a vector
+       */
+      struct VectorDestination : JpegDestination<VectorDestination> {
+        //! The compressed bytes
+        JpegBytes bytes;
+
+        /**
+         * @brief Point libjpeg at the whole vector
+         */
+        void init() { resetBuffer(0); }
+
+        /**
+         * @brief Double the vector and point libjpeg at the new half
+         */
+        void empty(j_compress_ptr) {
+          const auto used = bytes.size();
+          bytes.resize(used * 2);
+          resetBuffer(used);
+        }
+
+        /**
+         * @brief Trim the vector to the compressed bytes
+         */
+        void term(j_compress_ptr) {
+          bytes.resize(bytes.size() - pub.free_in_buffer);
+        }
+
+        /**
+         * @brief Point libjpeg at the unused part of the vector
+         * @param used The number of bytes already written
+         */
+        void resetBuffer(std::size_t used) {
+          pub.next_output_byte = bytes.data() + used;
+          pub.free_in_buffer = bytes.size() - used;
+        }
+      };
+
+      /**
+       * @brief Compress rows as a standalone jpeg
+       * @param rows The rows to compress
+       * @param quality The libjpeg quality
+       * @return The compressed jpeg
+       *
+       * Every segment must use the same tables, so Huffman optimisation is
+       * off and the sampling factors are fixed.
+       */
+      JpegBytes compressSegment(const boost::gil::rgb8c_view_t& rows,
+                                int quality) {
+        VectorDestination dest{};
+        // jpeg compresses well, a quarter of the raw size rarely grows
+        dest.bytes.resize(std::max<std::size_t>(rows.size() * 3 / 4, 4096));
+
+        JpegErrorManager err{};
+        jpeg_compress_struct cinfo{};
+        cinfo.err = installJpegErrorManager(err);
+        jpeg_create_compress(&cinfo);
+        cinfo.dest = &dest.pub;
+
+        if (setjmp(err.jump)) {
+          jpeg_destroy_compress(&cinfo);
+          throw EncodeError(
+              std::format("Failed to compress jpeg segment: {}", err.message));
+        }
+
+        cinfo.image_width = static_cast<JDIMENSION>(rows.width());
+        cinfo.image_height = static_cast<JDIMENSION>(rows.height());
+        cinfo.input_components = 3;
+        cinfo.in_color_space = JCS_RGB;
+        jpeg_set_defaults(&cinfo);
+        jpeg_set_quality(&cinfo, quality, TRUE);
+        cinfo.optimize_coding = FALSE;
+        cinfo.comp_info[0].h_samp_factor = 2;
+        cinfo.comp_info[0].v_samp_factor = 2;
+        for (int c = 1; c < cinfo.num_components; ++c) {
+          cinfo.comp_info[c].h_samp_factor = 1;
+          cinfo.comp_info[c].v_samp_factor = 1;
+        }
+        jpeg_start_compress(&cinfo, TRUE);
+        writeJpegRows(&cinfo, rows);
+        jpeg_finish_compress(&cinfo);
+        jpeg_destroy_compress(&cinfo);
+        return std::move(dest.bytes);
+      }
+
+      /**
+       * @brief The layout of a compressed segment
+       */
+      struct SegmentLayout {
+        //! The offset of the SOF0 marker
+        std::size_t frame = 0;
+
+        //! The offset of the SOS marker
+        std::size_t scan = 0;
+
+        //! The offset of the entropy coded data after the SOS header
+        std::size_t data = 0;
+      };
+
+      /**
+       * @brief Find the frame and scan headers of a jpeg written by libjpeg
+       * @param jpeg The compressed jpeg
+       * @return The offsets of the headers
+       */
+      SegmentLayout findHeaders(const JpegBytes& jpeg) {
+        SegmentLayout layout;
+        // skip SOI, every marker after it up to SOS has a length
+        std::size_t pos = 2;
+        while (pos + 4 <= jpeg.size() && jpeg[pos] == 0xFF) {
+          const auto marker = jpeg[pos + 1];
+          const auto length =
+              static_cast<std::size_t>(jpeg[pos + 2] << 8 | jpeg[pos + 3]);
+          if (marker == 0xC0) {
+            layout.frame = pos;
+          } else if (marker == 0xDA) {
+            layout.scan = pos;
+            layout.data = pos + 2 + length;
+            return layout;
+          }
+          pos += 2 + length;
+        }
+        throw EncodeError("Compressed jpeg segment has no scan");
+      }
+
+      /**
+       * @brief Segments being compressed and the threads working on them
+       */
+      struct SegmentWork {
+        //! The image
+        boost::gil::rgb8c_view_t view;
+
+        //! The height of every segment but the last
+        std::size_t segmentRows = 0;
+
+        //! The libjpeg quality
+        int quality = 0;
+
+        //! The next segment to claim
+        std::atomic<std::size_t> next = 0;
+
+        //! The compressed segments
+        std::vector<JpegBytes> segments;
+
+        //! The first error thrown by each segment
+        std::vector<std::exception_ptr> errors;
+
+        //! Guards finished
+        std::mutex mutex;
+
+        //! Signalled each time a segment is finished
+        std::condition_variable cv;
+
+        //! The number of segments finished
+        std::size_t finished = 0;
+
+        /**
+         * @brief Compress segments until none are left to claim
+         */
+        void run() {
+          for (auto i = next++; i < segments.size(); i = next++) {
+            const auto top = i * segmentRows;
+            const auto rows = std::min(
+                segmentRows, static_cast<std::size_t>(view.height()) - top);
+            try {
+              segments[i] = compressSegment(
+                  boost::gil::subimage_view(
+                      view, 0, static_cast<std::ptrdiff_t>(top),
+                      view.width(), static_cast<std::ptrdiff_t>(rows)),
+                  quality);
+            } catch (...) {
+              errors[i] = std::current_exception();
+            }
+            {
+              std::lock_guard lock(mutex);
+              ++finished;
+            }
+            cv.notify_all();
+          }
+        }
+      };
+
+      /**
+       * @brief Join compressed segments into one jpeg
+       * @param segments The segments from top to bottom
+       * @param height The height of the whole image
+       * @param interval The number of MCUs in every segment but the last
+       * @return The joined jpeg
+       */
+      JpegBytes stitch(const std::vector<JpegBytes>& segments,
+                       std::size_t height, std::size_t interval) {
+        const auto& first = segments.front();
+        const auto headers = findHeaders(first);
+
+        std::size_t total = headers.data + 6;
+        for (const auto& segment : segments) {
+          total += segment.size() + 2;
+        }
+
+        JpegBytes out;
+        out.reserve(total);
+        out.insert(out.end(), first.begin(), first.begin() + headers.scan);
+        // SOF0 is marker, length and precision, then the height
+        out[headers.frame + 5] = static_cast<JOCTET>(height >> 8);
+        out[headers.frame + 6] = static_cast<JOCTET>(height);
+        const JOCTET dri[] = {0xFF, 0xDD, 0x00, 0x04,
+                              static_cast<JOCTET>(interval >> 8),
+                              static_cast<JOCTET>(interval)};
+        out.insert(out.end(), std::begin(dri), std::end(dri));
+        out.insert(out.end(), first.begin() + headers.scan,
+                   first.begin() + headers.data);
+
+        for (std::size_t i = 0; i < segments.size(); ++i) {
+          const auto& segment = segments[i];
+          // entropy coded data runs up to the EOI marker
+          out.insert(out.end(),
+                     segment.begin() + findHeaders(segment).data,
+                     segment.end() - 2);
+          if (i + 1 < segments.size()) {
+            out.push_back(0xFF);
+            out.push_back(static_cast<JOCTET>(0xD0 + i % 8));
+          }
+        }
+        out.push_back(0xFF);
+        out.push_back(0xD9);
+        return out;
+      }
+    }  // namespace
+
+    void writeJpegParallel(const std::filesystem::path& path,
+                           const boost::gil::rgb8c_view_t& view,
+                           const boost::asio::any_io_executor& executor,
+                           std::size_t threads, int quality) {
+      const auto width = static_cast<std::size_t>(view.width());
+      const auto height = static_cast<std::size_t>(view.height());
+      if (width == 0 || height == 0 || height > JPEG_MAX_DIMENSION) {
+        throw EncodeError(
+            std::format("Cannot encode a {}x{} jpeg", width, height));
+      }
+
+      const auto mcusPerRow = (width + jpegMcuSize - 1) / jpegMcuSize;
+      const auto mcuRows = (height + jpegMcuSize - 1) / jpegMcuSize;
+      const auto wanted = threads * segmentsPerThread;
+      // a single segment needs no restart markers so has no size limit
+      const auto segmentMcuRows =
+          threads <= 1
+              ? mcuRows
+              : std::clamp((mcuRows + wanted - 1) / wanted, std::size_t{1},
+                           std::max<std::size_t>(
+                               maxRestartInterval / mcusPerRow, 1));
+
+      auto work = std::make_shared<SegmentWork>();
+      work->view = view;
+      work->segmentRows = segmentMcuRows * jpegMcuSize;
+      work->quality = quality;
+      const auto count = (height + work->segmentRows - 1) / work->segmentRows;
+      work->segments.resize(count);
+      work->errors.resize(count);
+
+      // helpers which start after every segment is claimed just return, so
+      // the work is shared with them rather than owned by this frame
+      for (std::size_t i = 1; i < std::min(threads, count); ++i) {
+        boost::asio::post(executor, [work] { work->run(); });
+      }
+      work->run();
+      {
+        std::unique_lock lock(work->mutex);
+        work->cv.wait(lock, [&work, count] { return work->finished == count; });
+      }
+
+      for (const auto& error : work->errors) {
+        if (error) {
+          std::rethrow_exception(error);
+        }
+      }
+
+      const auto jpeg =
+          count == 1 ? std::move(work->segments.front())
+                     : stitch(work->segments, height,
+                              segmentMcuRows * mcusPerRow);
+      std::ofstream file(path, std::ios::binary | std::ios::trunc);
+      file.write(reinterpret_cast<const char*>(jpeg.data()),
+                 static_cast<std::streamsize>(jpeg.size()));
+      if (!file) {
+        throw EncodeError(std::format("Failed to write {}", path.string()));
+      }
+    }
+
+  }  // namespace wp
+}  // namespace brilliant
@@ -0,0 +1,51 @@
+/**
+ *
+ *  @file      ParallelJpeg.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Defines a jpeg encoder which compresses horizontal segments in parallel
+ */
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/gil.hpp>
+
+#include "JpegWriter.hpp"
+
+namespace brilliant {
+  namespace wp {
+
+    //! The height of a jpeg MCU row with 4:2:0 chroma subsampling, the
+    //! libjpeg default used by every encoder in the app
+    constexpr std::size_t jpegMcuSize = 16;
+
+    /**
+     * @brief Encode an image as a baseline jpeg using several threads
+     * @param path The file to write
+     * @param view The image
+     * @param executor Runs helper tasks. The calling thread encodes too and
+     * never waits on a task that has not started, so this may be the
+     * executor the caller is running on
+     * @param threads The most threads to encode on, including the caller
+     * @param quality The libjpeg quality, 1 to 100
+     * @throws EncodeError if the image cannot be encoded or written
+     *
+     * The image is cut into segments a whole number of MCU rows tall which
+     * libjpeg-turbo compresses independently. A segment starts with fresh DC
+     * predictions, just like the data after a restart marker, so the
+     * segments are joined with RST markers under a DRI interval of one
+     * segment. Any baseline decoder reads the result and it decodes to the
+     * same pixels as a single threaded encode.
+     */
+    void writeJpegParallel(const std::filesystem::path& path,
+                           const boost::gil::rgb8c_view_t& view,
+                           const boost::asio::any_io_executor& executor,
+                           std::size_t threads,
+                           int quality = defaultJpegQuality);
+
+  }  // namespace wp
+}  // namespace brilliant
@@ -0,0 +1,301 @@
+/**
+ *
+ *  @file      PixelConversion.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements functions for converting decoded images to the composite format
+ */
+#include "PixelConversion.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace brilliant {
+  namespace wp {
+
+    namespace {
+
+      /**
+       * @brief Divide by 255 with rounding, exact for the products of two 8
+       * bit values
+       * @param value The value to divide
+       * @return value / 255 rounded to the nearest integer
+       */
+      constexpr std::uint32_t div255(std::uint32_t value) {
+        value += 128;
+        return (value + (value >> 8)) >> 8;
+      }
+
+      /**
+       * @brief Round a 16 bit channel to 8 bits
+       * @param value The 16 bit channel value
+       * @return value * 255 / 65535 rounded to the nearest integer
+       */
+      constexpr std::uint32_t narrow(std::uint32_t value) {
+        return (value * 255 + 32895) >> 16;
+      }
+
+      /**
+       * @brief Composite a channel onto a background channel
+       * @param channel The 8 bit foreground channel
+       * @param alpha The 8 bit alpha value
+       * @param background The 8 bit background channel
+       * @return The composited 8 bit channel
+       */
+      constexpr std::uint8_t blend(std::uint32_t channel, std::uint32_t alpha,
+                                   std::uint32_t background) {
+        return static_cast<std::uint8_t>(
+            div255(channel * alpha + background * (255 - alpha)));
+      }
+
+      static_assert(div255(255 * 255) == 255);
+      static_assert(narrow(65535) == 255 && narrow(257) == 1);
+      static_assert(blend(200, 0, 10) == 10 && blend(200, 255, 10) == 200);
+
+      /**
+       * @brief Background channels passed to every kernel
+       */
+      struct Background {
+        //! Red channel
+        std::uint32_t r;
+
+        //! Green channel
+        std::uint32_t g;
+
+        //! Blue channel
+        std::uint32_t b;
+      };
+
+      /**
+       * @brief Base template for row conversion kernels
+       * @tparam Pixel The source pixel type
+       *
+       * Rows never overlap so the pointers are marked __restrict, without it
+       * the compiler assumes every store may alias the source and will not
+       * vectorize the loops.
+       */
+      template <class Pixel>
+      struct RowKernel;
+
+      /**
+       * @brief rgb8 rows are copied as is
+       */
+      template <>
+      struct RowKernel<boost::gil::rgb8_pixel_t> {
+        //! The source channel type
+        using Channel = std::uint8_t;
+
+        /**
+         * @brief Convert a row
+         * @param in The source channels
+         * @param out The destination channels
+         * @param width The number of pixels in the row
+         */
+        static void convert(const Channel* __restrict in,
+                            std::uint8_t* __restrict out, std::size_t width,
+                            const Background&) {
+          std::memcpy(out, in, width * 3);
+        }
+      };
+
+      /**
+       * @brief rgba8 rows are composited onto the background
+       */
+      template <>
+      struct RowKernel<boost::gil::rgba8_pixel_t> {
+        //! The source channel type
+        using Channel = std::uint8_t;
+
+        /**
+         * @brief Convert a row
+         * @param in The source channels
+         * @param out The destination channels
+         * @param width The number of pixels in the row
+         * @param bg The background colour
+         */
+        static void convert(const Channel* __restrict in,
+                            std::uint8_t* __restrict out, std::size_t width,
+                            const Background& bg) {
+          for (std::size_t x = 0; x < width; ++x) {
+            const std::uint32_t a = in[x * 4 + 3];
+            out[x * 3 + 0] = blend(in[x * 4 + 0], a, bg.r);
+            out[x * 3 + 1] = blend(in[x * 4 + 1], a, bg.g);
+            out[x * 3 + 2] = blend(in[x * 4 + 2], a, bg.b);
+          }
+        }
+      };
+
+      /**
+       * @brief rgba16 rows are narrowed then composited onto the background
+       */
+      template <>
+      struct RowKernel<boost::gil::rgba16_pixel_t> {
+        //! The source channel type
+        using Channel = std::uint16_t;
+
+        /**
+         * @brief Convert a row
+         * @param in The source channels
+         * @param out The destination channels
+         * @param width The number of pixels in the row
+         * @param bg The background colour
+         */
+        static void convert(const Channel* __restrict in,
+                            std::uint8_t* __restrict out, std::size_t width,
+                            const Background& bg) {
+          for (std::size_t x = 0; x < width; ++x) {
+            const std::uint32_t a = narrow(in[x * 4 + 3]);
+            out[x * 3 + 0] = blend(narrow(in[x * 4 + 0]), a, bg.r);
+            out[x * 3 + 1] = blend(narrow(in[x * 4 + 1]), a, bg.g);
+            out[x * 3 + 2] = blend(narrow(in[x * 4 + 2]), a, bg.b);
+          }
+        }
+      };
+
+      /**
+       * @brief gray8 rows are replicated into each channel
+       */
+      template <>
+      struct RowKernel<boost::gil::gray8_pixel_t> {
+        //! The source channel type
+        using Channel = std::uint8_t;
+
+        /**
+         * @brief Convert a row
+         * @param in The source channels
+         * @param out The destination channels
+         * @param width The number of pixels in the row
+         */
+        static void convert(const Channel* __restrict in,
+                            std::uint8_t* __restrict out, std::size_t width,
+                            const Background&) {
+          for (std::size_t x = 0; x < width; ++x) {
+            out[x * 3 + 0] = in[x];
+            out[x * 3 + 1] = in[x];
+            out[x * 3 + 2] = in[x];
+          }
+        }
+      };
+
+      /**
+       * @brief gray16 rows are narrowed and replicated into each channel
+       */
+      template <>
+      struct RowKernel<boost::gil::gray16_pixel_t> {
+        //! The source channel type
+        using Channel = std::uint16_t;
+
+        /**
+         * @brief Convert a row
+         * @param in The source channels
+         * @param out The destination channels
+         * @param width The number of pixels in the row
+         */
+        static void convert(const Channel* __restrict in,
+                            std::uint8_t* __restrict out, std::size_t width,
+                            const Background&) {
+          for (std::size_t x = 0; x < width; ++x) {
+            const auto v = static_cast<std::uint8_t>(narrow(in[x]));
+            out[x * 3 + 0] = v;
+            out[x * 3 + 1] = v;
+            out[x * 3 + 2] = v;
+          }
+        }
+      };
+
+      /**
+       * @brief gray_alpha8 rows are composited onto the background
+       */
+      template <>
+      struct RowKernel<boost::gil::gray_alpha8_pixel_t> {
+        //! The source channel type
+        using Channel = std::uint8_t;
+
+        /**
+         * @brief Convert a row
+         * @param in The source channels
+         * @param out The destination channels
+         * @param width The number of pixels in the row
+         * @param bg The background colour
+         */
+        static void convert(const Channel* __restrict in,
+                            std::uint8_t* __restrict out, std::size_t width,
+                            const Background& bg) {
+          for (std::size_t x = 0; x < width; ++x) {
+            const std::uint32_t v = in[x * 2];
+            const std::uint32_t a = in[x * 2 + 1];
+            out[x * 3 + 0] = blend(v, a, bg.r);
+            out[x * 3 + 1] = blend(v, a, bg.g);
+            out[x * 3 + 2] = blend(v, a, bg.b);
+          }
+        }
+      };
+
+      /**
+       * @brief gray_alpha16 rows are narrowed then composited onto the
+       * background
+       */
+      template <>
+      struct RowKernel<boost::gil::gray_alpha16_pixel_t> {
+        //! The source channel type
+        using Channel = std::uint16_t;
+
+        /**
+         * @brief Convert a row
+         * @param in The source channels
+         * @param out The destination channels
+         * @param width The number of pixels in the row
+         * @param bg The background colour
+         */
+        static void convert(const Channel* __restrict in,
+                            std::uint8_t* __restrict out, std::size_t width,
+                            const Background& bg) {
+          for (std::size_t x = 0; x < width; ++x) {
+            const std::uint32_t v = narrow(in[x * 2]);
+            const std::uint32_t a = narrow(in[x * 2 + 1]);
+            out[x * 3 + 0] = blend(v, a, bg.r);
+            out[x * 3 + 1] = blend(v, a, bg.g);
+            out[x * 3 + 2] = blend(v, a, bg.b);
+          }
+        }
+      };
+
+      /**
+       * @brief Run the kernel for a concrete source view over every row
+       * @tparam View The concrete source view type
+       * @param src The source view
+       * @param dst The destination view
+       * @param bg The background colour
+       */
+      template <class View>
+      void convertRows(const View& src, const boost::gil::rgb8_view_t& dst,
+                       const Background& bg) {
+        using Kernel = RowKernel<
+            std::remove_const_t<typename View::value_type>>;
+        using Channel = typename Kernel::Channel;
+
+        const auto width = static_cast<std::size_t>(src.width());
+        for (std::ptrdiff_t y = 0; y < src.height(); ++y) {
+          Kernel::convert(reinterpret_cast<const Channel*>(&*src.row_begin(y)),
+                          reinterpret_cast<std::uint8_t*>(&*dst.row_begin(y)),
+                          width, bg);
+        }
+      }
+
+    }  // namespace
+
+    void convertToRgb8(const ImageType::const_view_t& src,
+                       const boost::gil::rgb8_view_t& dst,
+                       boost::gil::rgb8_pixel_t background) {
+      const Background bg{boost::gil::at_c<0>(background),
+                          boost::gil::at_c<1>(background),
+                          boost::gil::at_c<2>(background)};
+      boost::gil::apply_operation(
+          src, [&dst, &bg](const auto& view) { convertRows(view, dst, bg); });
+    }
+
+  }  // namespace wp
+}  // namespace brilliant
@@ -0,0 +1,36 @@
+/**
+ *
+ *  @file      PixelConversion.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Defines functions for converting decoded images to the composite format
+ */
+#pragma once
+
+#include <boost/gil.hpp>
+
+#include "ImageProcessing.hpp"
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief Convert a view of any ImageType alternative to rgb8
+     * @param src The view to convert
+     * @param dst The destination view, must have the same dimensions as src
+     * @param background The colour alpha channels are composited onto
+     *
+     * The conversion kernel is chosen once for the whole view from the source
+     * pixel type rather than per pixel as boost::gil's color_convert does.
+     * Each kernel works on whole rows of raw channels using integer
+     * arithmetic so the compiler can vectorize it. 16 bit channels are
+     * rounded to 8 bits and alpha is composited onto the background instead
+     * of being dropped.
+     */
+    void convertToRgb8(const ImageType::const_view_t& src,
+                       const boost::gil::rgb8_view_t& dst,
+                       boost::gil::rgb8_pixel_t background);
+
+  }  // namespace wp
+}  // namespace brilliant
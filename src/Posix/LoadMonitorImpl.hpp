@@ -0,0 +1,64 @@
+/**
+ *
+ *  @file      LoadMonitorImpl.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements the POSIX specific LoadMonitorImpl class
+ */
+#pragma once
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+
+#include "../SystemLoad.hpp"
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief POSIX specific implementation of a LoadMonitor
+     *
+     * Every measure is left unset where its file cannot be read, eg: on
+     * kernels without pressure stall information or outside Linux.
+     */
+    class LoadMonitorImpl {
+    public:
+      /**
+       * @brief Read the load and pressure files
+       * @return The sample
+       */
+      LoadSample sample() const {
+        LoadSample sample;
+        if (const auto load = parseLoadAverage(read("/proc/loadavg"))) {
+          sample.load = *load / cpus;
+        }
+        sample.cpuPressure = parsePressure(read("/proc/pressure/cpu"));
+        sample.memoryPressure = parsePressure(read("/proc/pressure/memory"));
+        return sample;
+      }
+
+    private:
+      /**
+       * @brief Read a whole file
+       * @param path The file
+       * @return The contents, empty if it cannot be read
+       *
+       * Files in /proc report a size of 0, so they are read to the end
+       * rather than by size.
+       */
+      static std::string read(const char* path) {
+        std::ifstream file(path);
+        return {std::istreambuf_iterator<char>(file),
+                std::istreambuf_iterator<char>()};
+      }
+
+      //! The number of CPUs the load average is shared between
+      double cpus = std::max(1u, std::thread::hardware_concurrency());
+    };
+
+  }  // namespace wp
+}  // namespace brilliant
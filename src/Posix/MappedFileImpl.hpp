@@ -0,0 +1,98 @@
+/**
+ *
+ *  @file      MappedFileImpl.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements the POSIX specific MappedFileImpl class
+ */
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <system_error>
+
+#include "../MappedFile.hpp"
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief POSIX specific implementation of a MappedFile
+     */
+    class MappedFileImpl {
+    public:
+      /**
+       * @brief Map a file into memory
+       * @param path The path of the file to map
+       * @param hint How the mapped contents will be accessed
+       */
+      MappedFileImpl(const std::filesystem::path& path, AccessHint hint) {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+          throw std::system_error(errno, std::system_category(),
+                                  path.string());
+        }
+
+        struct stat st {};
+        if (::fstat(fd, &st) != 0) {
+          const int err = errno;
+          ::close(fd);
+          throw std::system_error(err, std::system_category(), path.string());
+        }
+        size = static_cast<std::size_t>(st.st_size);
+
+        if (size != 0) {
+          view = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        // the mapping keeps its own reference to the file
+        const int err = errno;
+        ::close(fd);
+
+        if (view == MAP_FAILED) {
+          throw std::system_error(err, std::system_category(), path.string());
+        }
+
+        if (view && hint == AccessHint::sequential) {
+          // advisory only, a failure here does not affect correctness
+          ::madvise(view, size, MADV_SEQUENTIAL);
+        }
+      }
+
+      MappedFileImpl(const MappedFileImpl&) = delete;
+      MappedFileImpl& operator=(const MappedFileImpl&) = delete;
+
+      /**
+       * @brief Unmap the file
+       */
+      ~MappedFileImpl() {
+        if (view && view != MAP_FAILED) {
+          ::munmap(view, size);
+        }
+      }
+
+      /**
+       * @brief Get the mapped contents
+       * @return A span over the mapped bytes
+       */
+      std::span<const std::byte> data() const {
+        return {static_cast<const std::byte*>(view), view ? size : 0};
+      }
+
+    private:
+      //! The address of the mapping
+      void* view = nullptr;
+
+      //! The size of the file in bytes
+      std::size_t size = 0;
+    };
+
+  }  // namespace wp
+}  // namespace brilliant
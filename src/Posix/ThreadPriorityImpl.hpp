@@ -0,0 +1,72 @@
+/**
+ *
+ *  @file      ThreadPriorityImpl.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements the POSIX specific thread scheduling functions
+ */
+#pragma once
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <span>
+#include <system_error>
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief Move the calling thread to the idle scheduling class
+     */
+    inline void lowerThreadPriorityImpl() {
+#ifdef SCHED_IDLE
+      const sched_param param{};
+      if (::pthread_setschedparam(::pthread_self(), SCHED_IDLE, &param) == 0) {
+        return;
+      }
+#endif
+      // on Linux this only applies to the calling thread, elsewhere it
+      // lowers the whole process
+      if (::setpriority(PRIO_PROCESS, 0, 19) != 0) {
+        throw std::system_error(errno, std::system_category(),
+                                "setpriority");
+      }
+    }
+
+    /**
+     * @brief Restrict the calling thread to a set of CPUs
+     * @param cpus The indexes of the CPUs, not empty
+     */
+    inline void setThreadAffinityImpl(std::span<const std::uint32_t> cpus) {
+#ifdef __linux__
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      for (const auto cpu : cpus) {
+        if (cpu >= CPU_SETSIZE) {
+          throw std::system_error(
+              std::make_error_code(std::errc::invalid_argument),
+              "pthread_setaffinity_np");
+        }
+        CPU_SET(cpu, &set);
+      }
+      if (const int err =
+              ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+          err != 0) {
+        throw std::system_error(err, std::system_category(),
+                                "pthread_setaffinity_np");
+      }
+#else
+      (void)cpus;
+      throw std::system_error(
+          std::make_error_code(std::errc::function_not_supported),
+          "CPU affinity");
+#endif
+    }
+
+  }  // namespace wp
+}  // namespace brilliant
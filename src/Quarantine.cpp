@@ -0,0 +1,124 @@
+/**
+ *
+ *  @file      Quarantine.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements the Quarantine class
+ */
+#include "Quarantine.hpp"
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <string>
+#include <system_error>
+
+#include "Log.hpp"
+#include "TextFields.hpp"
+
+namespace brilliant {
+  namespace wp {
+
+    Quarantine::Quarantine(std::filesystem::path list)
+        : listPath(std::move(list)) {
+      std::ifstream file(listPath);
+      std::string line;
+      while (std::getline(file, line)) {
+        // size \t modified \t path \t reason
+        const std::string_view text(line);
+        const auto first = text.find('\t');
+        const auto second = text.find('\t', first + 1);
+        const auto third = text.find('\t', second + 1);
+        Fingerprint print;
+        if (third == std::string_view::npos ||
+            !parseField(text.substr(0, first), print.size) ||
+            !parseField(text.substr(first + 1, second - first - 1),
+                        print.modified)) {
+          log(severity_level::warning,
+              "Ignoring malformed quarantine entry: {}", line);
+          continue;
+        }
+        entries.insert_or_assign(
+            fromUtf8(text.substr(second + 1, third - second - 1)), print);
+      }
+
+      if (!entries.empty()) {
+        log(severity_level::info, "Loaded {} quarantined file(s) from {}",
+            entries.size(), listPath.string());
+      }
+    }
+
+    bool Quarantine::contains(const std::filesystem::path& path) const {
+      Fingerprint stored;
+      {
+        std::lock_guard lock(mutex);
+        const auto it = entries.find(path);
+        if (it == entries.end()) {
+          return false;
+        }
+        stored = it->second;
+      }
+      // stat without the lock so other sources are not held up by the disk
+      return stored == fingerprint(path);
+    }
+
+    void Quarantine::add(const std::filesystem::path& path,
+                         std::string_view reason) {
+      const auto print = fingerprint(path);
+      std::string cleanReason(reason);
+      // entries are tab separated and one per line
+      std::ranges::replace_if(
+          cleanReason,
+          [](char c) { return c == '\t' || c == '\n' || c == '\r'; }, ' ');
+
+      std::lock_guard lock(mutex);
+      const auto it = entries.find(path);
+      if (it != entries.end() && it->second == print) {
+        return;
+      }
+      entries.insert_or_assign(path, print);
+
+      std::ofstream file(listPath, std::ios::app);
+      file << std::format("{}\t{}\t{}\t{}\n", print.size, print.modified,
+                          toUtf8(path), cleanReason);
+      if (!file) {
+        log(severity_level::warning, "Failed to write quarantine list {}",
+            listPath.string());
+      }
+      log(severity_level::warning, "Quarantined {}: {}", path.string(),
+          cleanReason);
+    }
+
+    std::size_t Quarantine::size() const {
+      std::lock_guard lock(mutex);
+      return entries.size();
+    }
+
+    Quarantine::Fingerprint Quarantine::fingerprint(
+        const std::filesystem::path& path) {
+      // a source in an archive is not a file of its own, so it takes the
+      // archive's size and time and is tried again when the archive changes
+      std::error_code ec;
+      auto file = path;
+      while (!std::filesystem::is_regular_file(file, ec) &&
+             file.has_relative_path()) {
+        file = file.parent_path();
+      }
+
+      Fingerprint print;
+      print.size = std::filesystem::file_size(file, ec);
+      if (ec) {
+        return {};
+      }
+      const auto modified = std::filesystem::last_write_time(file, ec);
+      if (ec) {
+        return {};
+      }
+      print.modified =
+          static_cast<std::int64_t>(modified.time_since_epoch().count());
+      return print;
+    }
+
+  }  // namespace wp
+}  // namespace brilliant
@@ -0,0 +1,99 @@
+/**
+ *
+ *  @file      Quarantine.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Defines the Quarantine class
+ */
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief A persistent list of source images which failed to load
+     *
+     * Each entry records the size and modification time of the file when it
+     * failed. A file which has since been replaced or edited no longer
+     * matches its entry and is tried again. A source in an archive is
+     * recorded with the size and modification time of its archive. Entries
+     * are appended to a text file as they are added so they survive a
+     * restart, one per line as size, modification time, path and reason
+     * separated by tabs.
+     *
+     * All member functions are safe to call from any thread.
+     */
+    class Quarantine {
+    public:
+      /**
+       * @brief Construct a Quarantine and load any existing entries
+       * @param list The file the entries are stored in. It is created when
+       * the first entry is added
+       */
+      explicit Quarantine(std::filesystem::path list);
+
+      /**
+       * @brief Check if a file is quarantined
+       * @param path The source image
+       * @return True if the file has an entry and has not changed since
+       */
+      bool contains(const std::filesystem::path& path) const;
+
+      /**
+       * @brief Quarantine a file
+       * @param path The source image which failed
+       * @param reason Why the file failed, written to the list for the user
+       */
+      void add(const std::filesystem::path& path, std::string_view reason);
+
+      /**
+       * @brief Get the number of entries, including stale ones
+       * @return The number of entries
+       */
+      std::size_t size() const;
+
+    private:
+      /**
+       * @brief Identifies the version of a file which failed
+       */
+      struct Fingerprint {
+        //! The size of the file in bytes
+        std::uintmax_t size = 0;
+
+        //! The modification time of the file in file clock ticks
+        std::int64_t modified = 0;
+
+        /**
+         * @brief Compare two fingerprints
+         * @return True if both fields are equal
+         */
+        bool operator==(const Fingerprint&) const = default;
+      };
+
+      /**
+       * @brief Read the current fingerprint of a file
+       * @param path The file to read
+       * @return The fingerprint, or a zeroed fingerprint if the file cannot
+       * be read
+       */
+      static Fingerprint fingerprint(const std::filesystem::path& path);
+
+      //! The file the entries are stored in
+      std::filesystem::path listPath;
+
+      //! Guards entries and the list file
+      mutable std::mutex mutex;
+
+      //! Quarantined files and their fingerprint when they failed
+      std::unordered_map<std::filesystem::path, Fingerprint> entries;
+    };
+
+  }  // namespace wp
+}  // namespace brilliant
@@ -0,0 +1,451 @@
+/**
+ *
+ *  @file      SourceArchive.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements functions for reading source images straight out of zip and
+ *  tar archives
+ */
+#include "SourceArchive.hpp"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <charconv>
+#include <format>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <system_error>
+
+#include "TextFields.hpp"
+
+namespace brilliant {
+  namespace wp {
+
+    namespace {
+      //! Starts each zip local header
+      constexpr std::uint32_t zipLocalSignature = 0x04034b50;
+
+      //! Starts each zip central directory entry
+      constexpr std::uint32_t zipCentralSignature = 0x02014b50;
+
+      //! Starts the zip end of central directory record
+      constexpr std::uint32_t zipEndSignature = 0x06054b50;
+
+      //! Starts the zip64 end of central directory locator
+      constexpr std::uint32_t zip64LocatorSignature = 0x07064b50;
+
+      //! Starts the zip64 end of central directory record
+      constexpr std::uint32_t zip64EndSignature = 0x06064b50;
+
+      //! Marks a zip size or offset which is in the zip64 extra field
+      constexpr std::uint64_t zip64Marker = 0xffffffff;
+
+      //! The size of a tar header and the unit tar data is padded to
+      constexpr std::uint64_t tarBlock = 512;
+
+      /**
+       * @brief Get part of an archive
+       * @param data The archive
+       * @param offset Where the part starts
+       * @param size The size of the part
+       * @return The part
+       * @throws ArchiveError if the part is past the end of the archive
+       */
+      std::span<const std::byte> slice(std::span<const std::byte> data,
+                                       std::uint64_t offset,
+                                       std::uint64_t size) {
+        if (offset > data.size() || data.size() - offset < size) {
+          throw ArchiveError(
+              std::format("Archive is truncated at offset {}", offset));
+        }
+        return data.subspan(static_cast<std::size_t>(offset),
+                            static_cast<std::size_t>(size));
+      }
+
+      /**
+       * @brief Read a little endian integer from an archive
+       * @tparam T The unsigned integer type to read
+       * @param data The archive
+       * @param offset Where the integer starts
+       * @return The integer
+       * @throws ArchiveError if the integer is past the end of the archive
+       */
+      template <class T>
+      T readLe(std::span<const std::byte> data, std::uint64_t offset) {
+        const auto bytes = slice(data, offset, sizeof(T));
+        T value = 0;
+        for (std::size_t i = 0; i < sizeof(T); ++i) {
+          value = static_cast<T>(
+              value | static_cast<T>(std::to_integer<T>(bytes[i]) << (8 * i)));
+        }
+        return value;
+      }
+
+      /**
+       * @brief View bytes as text
+       * @param bytes The bytes
+       * @return The text, up to the first NUL if there is one
+       */
+      std::string_view toText(std::span<const std::byte> bytes) {
+        const std::string_view text(reinterpret_cast<const char*>(bytes.data()),
+                                    bytes.size());
+        return text.substr(0, text.find('\0'));
+      }
+
+      /**
+       * @brief Normalise a member name and check it is a usable file
+       * @param name The name, with leading / and ./ removed on success
+       * @return False for folders, empty names and names with a ".."
+       * component
+       */
+      bool cleanName(std::string& name) {
+        while (name.starts_with('/') || name.starts_with("./")) {
+          name.erase(0, name.starts_with('/') ? 1 : 2);
+        }
+        if (name.empty() || name.ends_with('/')) {
+          return false;
+        }
+        for (std::size_t start = 0; start <= name.size();) {
+          const auto end = std::min(name.find('/', start), name.size());
+          if (std::string_view(name).substr(start, end - start) == "..") {
+            return false;
+          }
+          start = end + 1;
+        }
+        return true;
+      }
+
+      /**
+       * @brief List the members of a zip archive from its central directory
+       * @param data The archive
+       * @return The regular files which can be read
+       * @throws ArchiveError if the archive is malformed
+       */
+      std::vector<ArchiveMember> indexZip(std::span<const std::byte> data) {
+        // the end record is last, followed only by a comment of up to 64KB
+        constexpr std::uint64_t endSize = 22;
+        if (data.size() < endSize) {
+          throw ArchiveError("Zip archive is too short");
+        }
+        auto end = std::uint64_t{data.size()} - endSize;
+        const auto earliest = end > 0xffff ? end - 0xffff : 0;
+        while (readLe<std::uint32_t>(data, end) != zipEndSignature) {
+          if (end == earliest) {
+            throw ArchiveError("Zip archive has no central directory");
+          }
+          --end;
+        }
+
+        std::uint64_t entries = readLe<std::uint16_t>(data, end + 10);
+        std::uint64_t at = readLe<std::uint32_t>(data, end + 16);
+        if ((entries == 0xffff || at == zip64Marker) && end >= 20 &&
+            readLe<std::uint32_t>(data, end - 20) == zip64LocatorSignature) {
+          const auto end64 = readLe<std::uint64_t>(data, end - 12);
+          if (readLe<std::uint32_t>(data, end64) != zip64EndSignature) {
+            throw ArchiveError("Zip archive has a bad zip64 end record");
+          }
+          entries = readLe<std::uint64_t>(data, end64 + 32);
+          at = readLe<std::uint64_t>(data, end64 + 48);
+        }
+
+        std::vector<ArchiveMember> members;
+        // every entry takes at least 46 bytes, a corrupt count cannot
+        // reserve more than the archive could hold
+        members.reserve(static_cast<std::size_t>(
+            std::min<std::uint64_t>(entries, data.size() / 46)));
+        for (std::uint64_t i = 0; i < entries; ++i) {
+          if (readLe<std::uint32_t>(data, at) != zipCentralSignature) {
+            throw ArchiveError(std::format(
+                "Zip archive has a bad central directory entry at {}", at));
+          }
+          const auto flags = readLe<std::uint16_t>(data, at + 8);
+          const auto method = readLe<std::uint16_t>(data, at + 10);
+          std::uint64_t storedSize = readLe<std::uint32_t>(data, at + 20);
+          std::uint64_t size = readLe<std::uint32_t>(data, at + 24);
+          const auto nameLength = readLe<std::uint16_t>(data, at + 28);
+          const auto extraLength = readLe<std::uint16_t>(data, at + 30);
+          const auto commentLength = readLe<std::uint16_t>(data, at + 32);
+          std::uint64_t offset = readLe<std::uint32_t>(data, at + 42);
+          std::string name(toText(slice(data, at + 46, nameLength)));
+
+          // values which do not fit are in the zip64 extra field, in this
+          // order and only if marked
+          auto extra = at + 46 + nameLength;
+          const auto extraEnd = extra + extraLength;
+          while (extra + 4 <= extraEnd) {
+            const auto id = readLe<std::uint16_t>(data, extra);
+            const auto length = readLe<std::uint16_t>(data, extra + 2);
+            auto field = extra + 4;
+            for (auto* value : {&size, &storedSize, &offset}) {
+              if (id == 1 && *value == zip64Marker &&
+                  field + 8 <= extra + 4 + length) {
+                *value = readLe<std::uint64_t>(data, field);
+                field += 8;
+              }
+            }
+            extra += 4 + length;
+          }
+          at = extraEnd + commentLength;
+
+          // bit 0 of the flags marks an encrypted member
+          if ((flags & 1) != 0 || (method != 0 && method != 8) ||
+              !cleanName(name)) {
+            continue;
+          }
+          members.push_back(
+              {std::move(name),
+               {offset, storedSize, method == 0 ? storedSize : size,
+                method == 0 ? MemberKind::zipStored
+                            : MemberKind::zipDeflated}});
+        }
+        return members;
+      }
+
+      /**
+       * @brief Read a number from a tar header field
+       * @param field The field
+       * @return The number
+       *
+       * Numbers are octal text, or big endian binary with the top bit of
+       * the first byte set when they do not fit, as GNU tar writes sizes
+       * over 8GB.
+       */
+      std::uint64_t tarNumber(std::span<const std::byte> field) {
+        std::uint64_t value = 0;
+        if (!field.empty() && (std::to_integer<unsigned>(field[0]) & 0x80)) {
+          value = std::to_integer<unsigned>(field[0]) & 0x7f;
+          for (const auto byte : field.subspan(1)) {
+            value = value << 8 | std::to_integer<unsigned>(byte);
+          }
+          return value;
+        }
+        auto text = toText(field);
+        text.remove_prefix(std::min(text.find_first_not_of(' '), text.size()));
+        for (const auto c : text) {
+          if (c < '0' || c > '7') {
+            break;
+          }
+          value = value * 8 + static_cast<std::uint64_t>(c - '0');
+        }
+        return value;
+      }
+
+      /**
+       * @brief Check the checksum of a tar header
+       * @param header The 512 byte header
+       * @return True if it matches, the header is not corrupt or something
+       * other than tar
+       */
+      bool tarChecksumMatches(std::span<const std::byte> header) {
+        // the checksum is of the header with its own field as spaces
+        std::uint64_t sum = 8 * ' ';
+        for (std::size_t i = 0; i < header.size(); ++i) {
+          if (i < 148 || i >= 156) {
+            sum += std::to_integer<unsigned>(header[i]);
+          }
+        }
+        return sum == tarNumber(header.subspan(148, 8));
+      }
+
+      /**
+       * @brief Read the records of a pax extended header
+       * @param records The header's data
+       * @param path Set to the path record if there is one
+       * @param size Set to the size record if there is one
+       * @throws ArchiveError if a record is malformed
+       */
+      void readPax(std::span<const std::byte> records, std::string& path,
+                   std::optional<std::uint64_t>& size) {
+        // each record is "<length> <key>=<value>\n", length included
+        std::string_view text(reinterpret_cast<const char*>(records.data()),
+                              records.size());
+        while (!text.empty() && text.front() != '\0') {
+          const auto space = text.find(' ');
+          std::size_t length = 0;
+          const auto [end, ec] =
+              std::from_chars(text.data(), text.data() + text.size(), length);
+          if (ec != std::errc() || end != text.data() + space ||
+              length <= space + 1 || length > text.size()) {
+            throw ArchiveError("Tar archive has a malformed pax header");
+          }
+          const auto record = text.substr(space + 1, length - space - 2);
+          const auto equals = record.find('=');
+          const auto key = record.substr(0, equals);
+          const auto value =
+              record.substr(std::min(equals + 1, record.size()));
+          if (key == "path") {
+            path = value;
+          } else if (key == "size") {
+            std::uint64_t parsed = 0;
+            if (!parseField(value, parsed)) {
+              throw ArchiveError("Tar archive has a malformed pax size");
+            }
+            size = parsed;
+          }
+          text.remove_prefix(length);
+        }
+      }
+
+      /**
+       * @brief List the members of a tar archive from their headers
+       * @param data The archive
+       * @return The regular files which can be read
+       * @throws ArchiveError if the archive is malformed
+       */
+      std::vector<ArchiveMember> indexTar(std::span<const std::byte> data) {
+        std::vector<ArchiveMember> members;
+        // set by a GNU long name or pax header for the header after it
+        std::string longName;
+        std::optional<std::uint64_t> paxSize;
+        std::uint64_t at = 0;
+        while (data.size() - at >= tarBlock) {
+          const auto header = slice(data, at, tarBlock);
+          // the archive ends with zeroed blocks
+          if (std::ranges::all_of(
+                  header, [](std::byte b) { return b == std::byte{}; })) {
+            break;
+          }
+          if (!tarChecksumMatches(header)) {
+            throw ArchiveError(
+                std::format("Tar archive has a bad header at {}", at));
+          }
+
+          const auto type = static_cast<char>(header[156]);
+          const auto isExtension = type == 'L' || type == 'x' || type == 'g';
+          const auto size = isExtension
+                                ? tarNumber(header.subspan(124, 12))
+                                : paxSize.value_or(
+                                      tarNumber(header.subspan(124, 12)));
+          const auto body = slice(data, at + tarBlock, size);
+          if (type == 'L') {
+            longName = toText(body);
+          } else if (type == 'x') {
+            readPax(body, longName, paxSize);
+          } else if (!isExtension) {
+            if (type == '0' || type == '\0' || type == '7') {
+              std::string name = longName;
+              if (name.empty()) {
+                // a POSIX ustar header splits long names in two
+                name = toText(header.subspan(0, 100));
+                const auto prefix = toText(header.subspan(345, 155));
+                if (toText(header.subspan(257, 6)) == "ustar" &&
+                    header[262] == std::byte{} && !prefix.empty()) {
+                  name = std::format("{}/{}", prefix, name);
+                }
+              }
+              if (cleanName(name)) {
+                members.push_back(
+                    {std::move(name), {at, size, size, MemberKind::tar}});
+              }
+            }
+            longName.clear();
+            paxSize.reset();
+          }
+          at += tarBlock + (size + tarBlock - 1) / tarBlock * tarBlock;
+          if (at > data.size()) {
+            break;
+          }
+        }
+        return members;
+      }
+    }  // namespace
+
+    bool isArchive(const std::filesystem::path& path) {
+      const auto extension = path.extension().u8string();
+      const auto lower = [](char8_t c) {
+        return c >= u8'A' && c <= u8'Z'
+                   ? static_cast<char8_t>(c - u8'A' + u8'a')
+                   : c;
+      };
+      return std::ranges::equal(extension, std::u8string_view(u8".zip"), {},
+                                lower) ||
+             std::ranges::equal(extension, std::u8string_view(u8".tar"), {},
+                                lower);
+    }
+
+    std::vector<ArchiveMember> indexArchive(std::span<const std::byte> data) {
+      // a zip starts with a local header, or its end record when it is empty
+      const auto text =
+          toText(data.first(std::min<std::size_t>(4, data.size())));
+      if (text.starts_with("PK")) {
+        return indexZip(data);
+      }
+      return indexTar(data);
+    }
+
+    std::span<const std::byte> readMember(std::span<const std::byte> archive,
+                                          const MemberLocation& location,
+                                          std::vector<std::byte>& buffer,
+                                          std::uint64_t limit) {
+      auto at = location.offset;
+      if (location.kind == MemberKind::tar) {
+        at += tarBlock;
+      } else {
+        // the local header's name and extra field may differ in length from
+        // the central directory's
+        if (readLe<std::uint32_t>(archive, at) != zipLocalSignature) {
+          throw ArchiveError(
+              std::format("Zip archive has no local header at {}", at));
+        }
+        at += 30 + readLe<std::uint16_t>(archive, at + 26) +
+              readLe<std::uint16_t>(archive, at + 28);
+      }
+      const auto stored = slice(archive, at, location.storedSize);
+      if (location.kind != MemberKind::zipDeflated) {
+        return stored.first(
+            static_cast<std::size_t>(std::min(limit, location.storedSize)));
+      }
+      const auto wanted = std::min(limit, location.size);
+      if (wanted == 0) {
+        return {};
+      }
+
+      if (stored.size() > std::numeric_limits<uInt>::max() ||
+          location.size > std::numeric_limits<uInt>::max()) {
+        throw ArchiveError(std::format(
+            "Zip member at {} is too large to inflate", location.offset));
+      }
+      buffer.resize(static_cast<std::size_t>(wanted));
+      z_stream stream{};
+      // negative window bits for the raw deflate data zip stores
+      if (::inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+        throw ArchiveError("Failed to start inflating a zip member");
+      }
+      stream.next_in =
+          reinterpret_cast<Bytef*>(const_cast<std::byte*>(stored.data()));
+      stream.avail_in = static_cast<uInt>(stored.size());
+      stream.next_out = reinterpret_cast<Bytef*>(buffer.data());
+      stream.avail_out = static_cast<uInt>(buffer.size());
+      const auto result = ::inflate(&stream, Z_FINISH);
+      const auto inflatedSize = stream.total_out;
+      ::inflateEnd(&stream);
+      // a prefix stops with the output full and the stream unfinished
+      const bool complete = wanted < location.size
+                                ? result == Z_OK || result == Z_BUF_ERROR
+                                : result == Z_STREAM_END;
+      if (!complete || inflatedSize != wanted) {
+        throw ArchiveError(std::format("Failed to inflate zip member at {}",
+                                       location.offset));
+      }
+      return buffer;
+    }
+
+    SourceFile::SourceFile(const std::filesystem::path& path, AccessHint hint)
+        : file(path, hint), contents(file.data()), size(contents.size()) {}
+
+    SourceFile::SourceFile(const std::filesystem::path& archive,
+                           const MemberLocation& location, AccessHint hint,
+                           std::uint64_t limit)
+        : file(archive, hint),
+          contents(readMember(file.data(), location, inflated, limit)),
+          size(location.size) {}
+
+    std::span<const std::byte> SourceFile::data() const { return contents; }
+
+    bool SourceFile::partial() const { return contents.size() < size; }
+
+  }  // namespace wp
+}  // namespace brilliant
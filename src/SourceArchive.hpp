@@ -0,0 +1,145 @@
+/**
+ *
+ *  @file      SourceArchive.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Defines functions for reading source images straight out of zip and tar
+ *  archives
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "MappedFile.hpp"
+#include "MemberLocation.hpp"
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief Archive specific exception type
+     */
+    struct ArchiveError : std::runtime_error {
+      using runtime_error::runtime_error;
+    };
+
+    /**
+     * @brief A regular file in an archive
+     */
+    struct ArchiveMember {
+      //! The member's path in the archive, utf-8 with / between components
+      std::string name;
+
+      //! Where the member's data is
+      MemberLocation location;
+    };
+
+    /**
+     * @brief Check if a path names an archive sources can be read from
+     * @param path The path
+     * @return True for .zip and .tar files, ignoring ASCII case
+     */
+    bool isArchive(const std::filesystem::path& path);
+
+    /**
+     * @brief List the regular files in a zip or uncompressed tar archive
+     * @param data The archive, usually the contents of a MappedFile
+     * @return Every regular file in the order it is listed
+     * @throws ArchiveError if the archive is malformed
+     *
+     * A zip archive is listed from its central directory alone, zip64
+     * included. A tar archive has a header before each member, so one page
+     * per member is read. GNU long names and pax paths and sizes are
+     * followed. Folders, links, encrypted members and members compressed
+     * with anything but deflate are left out, as are names which are
+     * absolute or climb out of the archive with "..".
+     */
+    std::vector<ArchiveMember> indexArchive(std::span<const std::byte> data);
+
+    /**
+     * @brief Get the data of a member of an archive
+     * @param archive The archive, usually the contents of a MappedFile
+     * @param location Where the member is, as found by indexArchive
+     * @param buffer Holds the member if it has to be inflated
+     * @param limit The most bytes of the member to read. A deflated member
+     * is only inflated that far
+     * @return The member's data, or its first limit bytes, a view into
+     * archive or buffer
+     * @throws ArchiveError if the member is past the end of the archive or
+     * cannot be inflated
+     */
+    std::span<const std::byte> readMember(
+        std::span<const std::byte> archive, const MemberLocation& location,
+        std::vector<std::byte>& buffer,
+        std::uint64_t limit = std::numeric_limits<std::uint64_t>::max());
+
+    /**
+     * @brief The contents of a source image, from a file of its own or an
+     * archive
+     *
+     * Files and stored archive members are read straight out of a
+     * MappedFile, nothing is extracted. Deflated zip members are inflated
+     * into memory.
+     */
+    class SourceFile {
+    public:
+      /**
+       * @brief Map a source image in a file of its own
+       * @param path The path of the file
+       * @param hint How the contents will be accessed
+       * @throws std::system_error if the file cannot be opened or mapped
+       */
+      explicit SourceFile(const std::filesystem::path& path,
+                          AccessHint hint = AccessHint::sequential);
+
+      /**
+       * @brief Map the archive a source image is in and find its data
+       * @param archive The path of the archive
+       * @param location Where the source is in the archive
+       * @param hint How the contents will be accessed
+       * @param limit The most bytes of the source to read, see readMember
+       * @throws std::system_error if the archive cannot be opened or mapped
+       * @throws ArchiveError if the source cannot be read from the archive
+       */
+      SourceFile(
+          const std::filesystem::path& archive, const MemberLocation& location,
+          AccessHint hint = AccessHint::sequential,
+          std::uint64_t limit = std::numeric_limits<std::uint64_t>::max());
+
+      /**
+       * @brief Get the contents of the source image
+       * @return A span over the encoded image, valid while this object is,
+       * moves included
+       */
+      std::span<const std::byte> data() const;
+
+      /**
+       * @brief Check if only the start of the source was read
+       * @return True if a limit cut the source short
+       */
+      bool partial() const;
+
+    private:
+      //! The mapped file or archive
+      MappedFile file;
+
+      //! A deflated member once it is inflated
+      std::vector<std::byte> inflated;
+
+      //! The encoded image, in file or inflated
+      std::span<const std::byte> contents;
+
+      //! The size of the whole encoded image
+      std::uint64_t size;
+    };
+
+  }  // namespace wp
+}  // namespace brilliant
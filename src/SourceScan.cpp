@@ -0,0 +1,186 @@
+/**
+ *
+ *  @file      SourceScan.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements functions for finding source images in configured folders
+ */
+#include "SourceScan.hpp"
+
+#include <algorithm>
+
+#include "MappedFile.hpp"
+#include "SourceArchive.hpp"
+
+namespace brilliant {
+  namespace wp {
+
+    namespace {
+      /**
+       * @brief Lower case an ASCII character
+       * @param c The character
+       * @return The lower case character, or c if it is not a letter
+       */
+      constexpr char lower(char c) {
+        return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+      }
+
+      /**
+       * @brief Get a path as UTF-8 with / between components
+       * @param path The path
+       * @return The path in the encoding of config patterns
+       *
+       * Unlike path::string this cannot fail for names outside the code page
+       * on Windows.
+       */
+      std::string toUtf8(const std::filesystem::path& path) {
+        const auto text = path.generic_u8string();
+        return std::string(text.begin(), text.end());
+      }
+
+      /**
+       * @brief Check an entry against a list of patterns
+       * @param patterns The patterns
+       * @param relative The entry's path relative to the scanned folder
+       * @param name The entry's name
+       * @return True if any pattern matches
+       */
+      bool matchesAny(const std::vector<std::string>& patterns,
+                      std::string_view relative, std::string_view name) {
+        return std::ranges::any_of(patterns, [&](std::string_view pattern) {
+          return matchGlob(pattern, pattern.contains('/') ? relative : name);
+        });
+      }
+
+      /**
+       * @brief Check a file has one of a list of extensions
+       * @param name The file's name
+       * @param extensions The extensions with their leading dot
+       * @return True if the file's extension is in the list, ignoring ASCII
+       * case
+       */
+      bool hasExtension(std::string_view name,
+                        const std::vector<std::string>& extensions) {
+        // as path::extension, a leading dot does not start an extension
+        const auto dot = name.rfind('.');
+        const auto extension = dot == std::string_view::npos || dot == 0
+                                   ? std::string_view()
+                                   : name.substr(dot);
+        return std::ranges::any_of(extensions, [&](std::string_view allowed) {
+          return std::ranges::equal(extension, allowed, {}, lower, lower);
+        });
+      }
+    }  // namespace
+
+    bool matchGlob(std::string_view pattern, std::string_view text) {
+      while (!pattern.empty()) {
+        if (pattern.starts_with("**")) {
+          pattern.remove_prefix(2);
+          // "a/**/b" also matches "a/b"
+          if (pattern.starts_with('/') && matchGlob(pattern.substr(1), text)) {
+            return true;
+          }
+          for (std::size_t i = 0; i <= text.size(); ++i) {
+            if (matchGlob(pattern, text.substr(i))) {
+              return true;
+            }
+          }
+          return false;
+        }
+        if (pattern.front() == '*') {
+          pattern.remove_prefix(1);
+          for (std::size_t i = 0; i <= text.size(); ++i) {
+            if (matchGlob(pattern, text.substr(i))) {
+              return true;
+            }
+            if (i < text.size() && text[i] == '/') {
+              break;
+            }
+          }
+          return false;
+        }
+        if (text.empty()) {
+          return false;
+        }
+        if (pattern.front() == '?' ? text.front() == '/'
+                                   : lower(pattern.front()) !=
+                                         lower(text.front())) {
+          return false;
+        }
+        pattern.remove_prefix(1);
+        text.remove_prefix(1);
+      }
+      return text.empty();
+    }
+
+    std::vector<std::filesystem::path> scanFolder(
+        const std::filesystem::path& folder, const ScanOptions& options) {
+      std::vector<std::filesystem::path> paths;
+      for (auto it = std::filesystem::recursive_directory_iterator(folder);
+           it != std::filesystem::recursive_directory_iterator(); ++it) {
+        const auto& entry = *it;
+        const auto relative = toUtf8(entry.path().lexically_relative(folder));
+        const auto name = toUtf8(entry.path().filename());
+
+        // the entry's type is cached from the directory listing
+        if (entry.is_directory()) {
+          if ((options.maxDepth &&
+               static_cast<std::uint32_t>(it.depth()) >= *options.maxDepth) ||
+              matchesAny(options.exclude, relative, name)) {
+            it.disable_recursion_pending();
+          }
+          continue;
+        }
+
+        if (entry.is_regular_file() &&
+            hasExtension(name, options.extensions) &&
+            (options.include.empty() ||
+             matchesAny(options.include, relative, name)) &&
+            !matchesAny(options.exclude, relative, name)) {
+          paths.push_back(entry.path());
+        }
+      }
+      return paths;
+    }
+
+    std::vector<ArchivedSource> scanArchive(
+        const std::filesystem::path& archive, const ScanOptions& options) {
+      std::vector<ArchivedSource> sources;
+      const MappedFile file(archive, AccessHint::normal);
+      for (auto& member : indexArchive(file.data())) {
+        const std::string_view relative(member.name);
+        const auto slash = relative.rfind('/');
+        const auto name = relative.substr(slash + 1);
+        if (!hasExtension(name, options.extensions) ||
+            (!options.include.empty() &&
+             !matchesAny(options.include, relative, name)) ||
+            matchesAny(options.exclude, relative, name)) {
+          continue;
+        }
+
+        // members are listed flat, so their folders are checked by name
+        // as scanFolder would have walked them
+        std::uint32_t depth = 0;
+        bool excluded = false;
+        for (auto end = relative.find('/'); end != std::string_view::npos;
+             end = relative.find('/', end + 1)) {
+          const auto folder = relative.substr(0, end);
+          excluded = excluded ||
+                     (options.maxDepth && depth >= *options.maxDepth) ||
+                     matchesAny(options.exclude, folder,
+                                folder.substr(folder.rfind('/') + 1));
+          ++depth;
+        }
+        if (!excluded) {
+          sources.push_back(
+              {archive / std::filesystem::path(std::u8string(
+                             relative.begin(), relative.end())),
+               member.location});
+        }
+      }
+      return sources;
+    }
+
+  }  // namespace wp
+}  // namespace brilliant
@@ -0,0 +1,94 @@
+/**
+ *
+ *  @file      SourceScan.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Defines functions for finding source images in configured folders
+ */
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "MemberLocation.hpp"
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief Which files in a configured folder are candidate sources
+     *
+     * Patterns are matched against the path of an entry relative to the
+     * folder, with / between components. A pattern without a / is matched
+     * against the entry's name alone, so "*.xmp" matches in every
+     * subfolder. * and ? match within a component, ** also matches across
+     * them. Matching ignores ASCII case.
+     */
+    struct ScanOptions {
+      //! A file must match one of these, unless it is empty
+      std::vector<std::string> include;
+
+      //! Files and folders which match one of these are skipped
+      std::vector<std::string> exclude;
+
+      //! The extensions, with their leading dot, a file must have one of
+      std::vector<std::string> extensions;
+
+      //! The deepest subfolders are searched. 0 searches only the folder
+      std::optional<std::uint32_t> maxDepth;
+    };
+
+    /**
+     * @brief Match a path against a glob pattern
+     * @param pattern The pattern
+     * @param text The path with / between components
+     * @return True if the whole path matches, ignoring ASCII case
+     */
+    bool matchGlob(std::string_view pattern, std::string_view text);
+
+    /**
+     * @brief Find the candidate sources in a folder and its subfolders
+     * @param folder The folder to search
+     * @param options Which files are candidates
+     * @return The path of every candidate in the order they were found
+     *
+     * Only the names and types from the directory listing are used, no
+     * file is opened. Excluded folders and those below maxDepth are not
+     * searched at all.
+     */
+    std::vector<std::filesystem::path> scanFolder(
+        const std::filesystem::path& folder, const ScanOptions& options);
+
+    /**
+     * @brief A candidate source found in an archive
+     */
+    struct ArchivedSource {
+      //! The archive's path followed by the member's path in the archive
+      std::filesystem::path path;
+
+      //! Where the member's data is in the archive
+      MemberLocation location;
+    };
+
+    /**
+     * @brief Find the candidate sources in a zip or tar archive
+     * @param archive The archive to search
+     * @param options Which members are candidates, matched against their
+     * path in the archive as if it were a folder
+     * @return Every candidate in the order the archive lists them
+     * @throws std::system_error if the archive cannot be mapped
+     * @throws ArchiveError if the archive is malformed
+     *
+     * Only the archive's index is read, see indexArchive. Nothing is
+     * extracted.
+     */
+    std::vector<ArchivedSource> scanArchive(
+        const std::filesystem::path& archive, const ScanOptions& options);
+
+  }  // namespace wp
+}  // namespace brilliant
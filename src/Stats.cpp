@@ -0,0 +1,55 @@
+/**
+ *
+ *  @file      Stats.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements the TileStats and MonitorStats structs
+ */
+#include "Stats.hpp"
+
+#include <algorithm>
+#include <format>
+
+namespace brilliant {
+  namespace wp {
+
+    TileStats& TileStats::operator+=(const TileStats& other) {
+      failures += other.failures;
+      refills += other.refills;
+      unfilled += other.unfilled;
+      decodedPixels += other.decodedPixels;
+      peakBytes = std::max(peakBytes, other.peakBytes);
+      return *this;
+    }
+
+    std::uint64_t MonitorStats::addTransition(
+        std::chrono::steady_clock::time_point& deadline,
+        std::chrono::steady_clock::duration delay,
+        std::chrono::steady_clock::time_point now, bool ready) {
+      const auto late = std::max(now - deadline,
+                                 std::chrono::steady_clock::duration::zero());
+      const auto passed = static_cast<std::uint64_t>(late / delay) + 1;
+      const auto missed = ready ? passed - 1 : passed;
+
+      ++transitions;
+      missedDeadlines += missed;
+      worstLateness = std::max(
+          worstLateness,
+          std::chrono::duration_cast<std::chrono::milliseconds>(late));
+      deadline += delay * static_cast<std::int64_t>(passed);
+      return missed;
+    }
+
+    std::string MonitorStats::summary() const {
+      return std::format(
+          "generated {}, transitions {}, missed deadlines {}, worst lateness "
+          "{}, failed renders {}, deferrals {}, reused {}, tile failures {} "
+          "({} refilled, {} unfilled), {:.1f} MP decoded, peak memory {} MB",
+          generated, transitions, missedDeadlines, worstLateness,
+          failedRenders, deferrals, reused, tiles.failures, tiles.refills,
+          tiles.unfilled, tiles.decodedPixels / 1e6, tiles.peakBytes >> 20);
+    }
+
+  }  // namespace wp
+}  // namespace brilliant
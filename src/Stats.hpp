@@ -0,0 +1,103 @@
+/**
+ *
+ *  @file      Stats.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Defines the TileStats and MonitorStats structs
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief Counters for the tiles made from sources and those which could
+     * not be made
+     */
+    struct TileStats {
+      //! Number of tiles whose source failed to load
+      std::uint64_t failures = 0;
+
+      //! Number of failed tiles replaced by another source
+      std::uint64_t refills = 0;
+
+      //! Number of failed tiles left empty because no replacement loaded
+      std::uint64_t unfilled = 0;
+
+      //! Number of pixels decoded from sources to make tiles
+      std::uint64_t decodedPixels = 0;
+
+      //! The most memory, in bytes, estimated in use while making the
+      //! wallpaper. Added by taking the larger of the two
+      std::uint64_t peakBytes = 0;
+
+      /**
+       * @brief Add another set of counters to this one
+       * @param other The counters to add
+       * @return This object
+       */
+      TileStats& operator+=(const TileStats& other);
+    };
+
+    /**
+     * @brief Counters describing how well a monitor keeps to its schedule
+     */
+    struct MonitorStats {
+      //! Number of wallpapers generated
+      std::uint64_t generated = 0;
+
+      //! Number of wallpapers set
+      std::uint64_t transitions = 0;
+
+      //! Number of deadlines which passed without a wallpaper ready for
+      //! them
+      std::uint64_t missedDeadlines = 0;
+
+      //! The latest a transition has been set after its deadline
+      std::chrono::milliseconds worstLateness{0};
+
+      //! Number of wallpapers which failed to render
+      std::uint64_t failedRenders = 0;
+
+      //! Number of renders held back because the machine was busy
+      std::uint64_t deferrals = 0;
+
+      //! Number of transitions which showed a recent wallpaper again
+      //! because the machine stayed busy until the deadline
+      std::uint64_t reused = 0;
+
+      //! Tile failures across every wallpaper generated
+      TileStats tiles;
+
+      /**
+       * @brief Count a transition and move on to the next deadline
+       * @param deadline The deadline the wallpaper was due at, moved on to
+       * the first one after now
+       * @param delay The time between deadlines
+       * @param now When the wallpaper was set
+       * @param ready True if the wallpaper was queued by its deadline
+       * @return The number of deadlines missed
+       *
+       * Every deadline up to now is counted once. The one the wallpaper
+       * was due at is only missed if it was not ready, any after it passed
+       * while waiting and are skipped rather than set back to back.
+       */
+      std::uint64_t addTransition(
+          std::chrono::steady_clock::time_point& deadline,
+          std::chrono::steady_clock::duration delay,
+          std::chrono::steady_clock::time_point now, bool ready);
+
+      /**
+       * @brief Summarise the counters for logging
+       * @return A single line summary
+       */
+      std::string summary() const;
+    };
+
+  }  // namespace wp
+}  // namespace brilliant
@@ -0,0 +1,82 @@
+/**
+ *
+ *  @file      SystemLoad.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements the LoadSample struct and the LoadMonitor class
+ */
+#include "SystemLoad.hpp"
+
+#ifdef WIN32
+#include "Win/LoadMonitorImpl.hpp"
+#else
+#include "Posix/LoadMonitorImpl.hpp"
+#endif
+
+#include <charconv>
+
+namespace brilliant {
+  namespace wp {
+
+    using namespace std::string_view_literals;
+
+    namespace {
+      //! How long a sample is reused for
+      constexpr std::chrono::seconds sampleInterval{1};
+
+      /**
+       * @brief Read a number from the start of some text
+       * @param text The text
+       * @return The number, or nullopt if the text does not start with one
+       */
+      std::optional<double> parseNumber(std::string_view text) {
+        double value = 0.0;
+        if (const auto [end, ec] =
+                std::from_chars(text.data(), text.data() + text.size(), value);
+            ec != std::errc{} || end == text.data()) {
+          return std::nullopt;
+        }
+        return value;
+      }
+    }  // namespace
+
+    bool LoadSample::exceeds(double maxLoad, double maxPressure) const {
+      return load.value_or(0.0) > maxLoad ||
+             cpuPressure.value_or(0.0) > maxPressure ||
+             memoryPressure.value_or(0.0) > maxPressure;
+    }
+
+    std::optional<double> parseLoadAverage(std::string_view text) {
+      return parseNumber(text);
+    }
+
+    std::optional<double> parsePressure(std::string_view text) {
+      constexpr auto some = "some "sv;
+      constexpr auto avg10 = "avg10="sv;
+      if (!text.starts_with(some)) {
+        return std::nullopt;
+      }
+      const auto line = text.substr(0, text.find('\n'));
+      const auto at = line.find(avg10);
+      if (at == std::string_view::npos) {
+        return std::nullopt;
+      }
+      return parseNumber(line.substr(at + avg10.size()));
+    }
+
+    LoadMonitor::LoadMonitor() : _impl(std::make_unique<LoadMonitorImpl>()) {}
+
+    LoadMonitor::~LoadMonitor() = default;
+
+    LoadSample LoadMonitor::sample() {
+      if (const auto now = std::chrono::steady_clock::now();
+          now - sampled >= sampleInterval) {
+        cached = _impl->sample();
+        sampled = now;
+      }
+      return cached;
+    }
+
+  }  // namespace wp
+}  // namespace brilliant
@@ -0,0 +1,93 @@
+/**
+ *
+ *  @file      SystemLoad.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Defines the LoadSample struct and the LoadMonitor class
+ */
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief How busy the machine is. Each measure is nullopt where the
+     * platform does not provide it
+     */
+    struct LoadSample {
+      //! Work per CPU, 1 when every CPU is busy. The 1 minute load average
+      //! on Linux, the busy fraction since the last sample on Windows
+      std::optional<double> load;
+
+      //! Percent of the last 10 seconds some threads waited for a CPU
+      std::optional<double> cpuPressure;
+
+      //! Percent of the last 10 seconds some threads waited for memory
+      std::optional<double> memoryPressure;
+
+      /**
+       * @brief Check the sample against busy thresholds
+       * @param maxLoad The most load per CPU which is still idle
+       * @param maxPressure The most CPU or memory pressure which is still
+       * idle
+       * @return True if any measure is over its threshold
+       */
+      bool exceeds(double maxLoad, double maxPressure) const;
+    };
+
+    /**
+     * @brief Read the 1 minute load average
+     * @param text The contents of /proc/loadavg
+     * @return The load average, or nullopt if it cannot be read
+     */
+    std::optional<double> parseLoadAverage(std::string_view text);
+
+    /**
+     * @brief Read the short term pressure of a resource
+     * @param text The contents of a file in /proc/pressure
+     * @return The avg10 of the "some" line, or nullopt if it cannot be read
+     */
+    std::optional<double> parsePressure(std::string_view text);
+
+    class LoadMonitorImpl;
+
+    /**
+     * @brief Samples how busy the machine is
+     *
+     * Reads /proc/loadavg and /proc/pressure on Linux, where pressure
+     * stall information is only available from kernel 4.20. Uses
+     * GetSystemTimes on Windows. Samples are cached for a second, so
+     * several callers polling together read the system once.
+     */
+    class LoadMonitor {
+    public:
+      LoadMonitor();
+      LoadMonitor(const LoadMonitor&) = delete;
+      LoadMonitor& operator=(const LoadMonitor&) = delete;
+      ~LoadMonitor();
+
+      /**
+       * @brief Get the current load
+       * @return The latest sample
+       */
+      LoadSample sample();
+
+    private:
+      //! The platform specific implementation
+      std::unique_ptr<LoadMonitorImpl> _impl;
+
+      //! The last sample taken
+      LoadSample cached;
+
+      //! When cached was taken
+      std::chrono::steady_clock::time_point sampled;
+    };
+
+  }  // namespace wp
+}  // namespace brilliant
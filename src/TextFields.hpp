@@ -0,0 +1,55 @@
+/**
+ *
+ *  @file      TextFields.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Helpers for reading and writing the tab separated state files
+ */
+
+#pragma once
+
+#include <charconv>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief Convert a path to a utf-8 encoded string
+     * @param path The path to convert
+     * @return The utf-8 encoded path
+     */
+    inline std::string toUtf8(const std::filesystem::path& path) {
+      const auto u8 = path.u8string();
+      return std::string(u8.begin(), u8.end());
+    }
+
+    /**
+     * @brief Convert a utf-8 encoded string to a path
+     * @param text The utf-8 encoded path
+     * @return The path
+     */
+    inline std::filesystem::path fromUtf8(std::string_view text) {
+      return std::filesystem::path(std::u8string(text.begin(), text.end()));
+    }
+
+    /**
+     * @brief Read an integer field from a line of a state file
+     * @tparam T The integer type to read
+     * @param text The field
+     * @param value Set to the field value on success
+     * @return True if the whole field was an integer
+     */
+    template <class T>
+    bool parseField(std::string_view text, T& value) {
+      const auto [ptr, ec] =
+          std::from_chars(text.data(), text.data() + text.size(), value);
+      return ec == std::errc() && ptr == text.data() + text.size();
+    }
+
+  }  // namespace wp
+}  // namespace brilliant
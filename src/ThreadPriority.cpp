@@ -0,0 +1,29 @@
+/**
+ *
+ *  @file      ThreadPriority.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements functions for scheduling the calling thread
+ */
+#include "ThreadPriority.hpp"
+
+#ifdef WIN32
+#include "Win/ThreadPriorityImpl.hpp"
+#else
+#include "Posix/ThreadPriorityImpl.hpp"
+#endif
+
+namespace brilliant {
+  namespace wp {
+
+    void lowerThreadPriority() { lowerThreadPriorityImpl(); }
+
+    void setThreadAffinity(std::span<const std::uint32_t> cpus) {
+      if (!cpus.empty()) {
+        setThreadAffinityImpl(cpus);
+      }
+    }
+
+  }  // namespace wp
+}  // namespace brilliant
@@ -0,0 +1,41 @@
+/**
+ *
+ *  @file      ThreadPriority.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Defines functions for scheduling the calling thread
+ */
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief Run the calling thread only when a CPU would otherwise be idle
+     *
+     * SCHED_IDLE on Linux, falling back to the highest nice value where it
+     * is not available. THREAD_MODE_BACKGROUND_BEGIN on Windows, which also
+     * lowers the thread's I/O and memory priority. Unprivileged POSIX
+     * threads cannot raise their priority again, so this is only for
+     * threads which stay in the background.
+     *
+     * Throws std::system_error on failure.
+     */
+    void lowerThreadPriority();
+
+    /**
+     * @brief Restrict the calling thread to a set of CPUs
+     * @param cpus The zero based indexes of the CPUs, every CPU if empty
+     *
+     * Throws std::system_error if a CPU does not exist or affinity is not
+     * supported on this platform. On Windows only the first 64 CPUs, the
+     * thread's processor group, can be used.
+     */
+    void setThreadAffinity(std::span<const std::uint32_t> cpus);
+
+  }  // namespace wp
+}  // namespace brilliant
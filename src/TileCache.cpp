@@ -0,0 +1,151 @@
+/**
+ *
+ *  @file      TileCache.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements the TileCache class
+ */
+#include "TileCache.hpp"
+
+#include <exception>
+#include <functional>
+
+namespace brilliant {
+  namespace wp {
+
+    TileCache::TileCache(std::size_t sharers, std::uint64_t roundLimit,
+                         MemoryBudget* tileBudget)
+        : participants(sharers), maxRounds(roundLimit), budget(tileBudget) {}
+
+    TileCache::Tile TileCache::get(std::uint64_t round, ImageId id,
+                                   std::uint32_t width, std::uint32_t height,
+                                   const TileFactory& make) {
+      Key key{round, id, width, height};
+      std::promise<Tile> promise;
+      std::unique_lock lock(mutex);
+      keepUpWith(round);
+      if (round < firstRound) {
+        lock.unlock();
+        return std::make_shared<const boost::gil::rgb8_image_t>(make());
+      }
+      if (auto iter = tiles.find(key); iter != tiles.end()) {
+        ++hitCount;
+        // copy the future so the wait happens outside the lock
+        auto future = iter->second;
+        lock.unlock();
+        return future.get();
+      }
+      tiles.emplace(key, promise.get_future().share());
+      lock.unlock();
+
+      try {
+        auto tile = keep(make);
+        promise.set_value(tile);
+        return tile;
+      } catch (...) {
+        promise.set_exception(std::current_exception());
+        lock.lock();
+        tiles.erase(key);
+        throw;
+      }
+    }
+
+    bool TileCache::finishRound(std::uint64_t round) {
+      std::lock_guard lock(mutex);
+      keepUpWith(round);
+      if (round < firstRound || ++finished[round] < participants) {
+        return false;
+      }
+      finished.erase(round);
+      std::erase_if(tiles, [round](const auto& item) {
+        return item.first.round == round;
+      });
+      return true;
+    }
+
+    void TileCache::leave(std::uint64_t nextRound) {
+      std::lock_guard lock(mutex);
+      --participants;
+      // rounds the participant finished no longer count it, so each open
+      // round is released once every remaining participant finishes it
+      for (auto iter = finished.begin(); iter != finished.end();) {
+        const auto [round, count] = *iter;
+        const auto remaining = round < nextRound ? count - 1 : count;
+        if (remaining > 0 && remaining < participants) {
+          iter->second = remaining;
+          ++iter;
+          continue;
+        }
+        iter = finished.erase(iter);
+        if (remaining > 0) {
+          std::erase_if(tiles, [round](const auto& item) {
+            return item.first.round == round;
+          });
+        }
+      }
+    }
+
+    std::uint64_t TileCache::oldestRound() const {
+      std::lock_guard lock(mutex);
+      return firstRound;
+    }
+
+    std::size_t TileCache::size() const {
+      std::lock_guard lock(mutex);
+      return tiles.size();
+    }
+
+    std::uint64_t TileCache::hits() const {
+      std::lock_guard lock(mutex);
+      return hitCount;
+    }
+
+    TileCache::Tile TileCache::keep(const TileFactory& make) {
+      if (!budget) {
+        return std::make_shared<const boost::gil::rgb8_image_t>(make());
+      }
+
+      // a tile and the memory counted for it
+      struct Kept {
+        //! The tile
+        boost::gil::rgb8_image_t image;
+
+        //! Counts the tile's pixels
+        MemoryBudget::Reservation reservation;
+      };
+      auto kept = std::make_shared<Kept>(Kept{make(), {}});
+      kept->reservation =
+          budget->track(static_cast<std::uint64_t>(kept->image.width()) *
+                        static_cast<std::uint64_t>(kept->image.height()) * 3);
+      // shares ownership of the reservation, so it is returned with the
+      // last copy of the tile
+      return Tile(kept, &kept->image);
+    }
+
+    void TileCache::keepUpWith(std::uint64_t round) {
+      if (round < firstRound + maxRounds) {
+        return;
+      }
+      // whoever has not finished these rounds is too far behind to share
+      // them
+      firstRound = round - maxRounds + 1;
+      finished.erase(finished.begin(), finished.lower_bound(firstRound));
+      std::erase_if(tiles, [this](const auto& item) {
+        return item.first.round < firstRound;
+      });
+    }
+
+    std::size_t TileCache::KeyHash::operator()(const Key& key) const {
+      std::size_t seed = std::hash<ImageId>{}(key.id);
+      const auto combine = [&seed](std::size_t value) {
+        seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+      };
+      combine(std::hash<std::uint64_t>{}(key.round));
+      combine(std::hash<std::uint32_t>{}(key.width));
+      combine(std::hash<std::uint32_t>{}(key.height));
+      return seed;
+    }
+
+  }  // namespace wp
+}  // namespace brilliant
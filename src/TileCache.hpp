@@ -0,0 +1,196 @@
+/**
+ *
+ *  @file      TileCache.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Defines the TileCache class
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <boost/gil.hpp>
+
+#include "Catalog.hpp"
+#include "MemoryBudget.hpp"
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief Shares scaled tiles between monitors generating the same round
+     *
+     * Monitors with the same resolution, transition delay and sources
+     * generate their wallpapers in lockstep, one round per transition, and
+     * every monitor draws the same sources in the same round. The first one
+     * to ask for a tile decodes and scales it and the others wait for and
+     * reuse the result. A round's tiles are released once every
+     * participating monitor has finished that round, whether it drew the
+     * round or skipped it.
+     *
+     * A participant can only fall so far behind. Once a round more than
+     * maxRounds ahead of the oldest open round is used, the oldest rounds
+     * are released early and a participant still drawing them makes its
+     * own tiles, so the cache never holds more than maxRounds rounds.
+     *
+     * Kept tiles are tracked in a MemoryBudget, if given, for as long as
+     * anything holds them, so decodes make room for them.
+     */
+    class TileCache {
+    public:
+      //! A scaled tile, shared between the wallpapers that use it
+      using Tile = std::shared_ptr<const boost::gil::rgb8_image_t>;
+
+      //! Produces a tile on a cache miss
+      using TileFactory = std::function<boost::gil::rgb8_image_t()>;
+
+      /**
+       * @brief Construct a TileCache
+       * @param sharers The number of monitors sharing the cache
+       * @param roundLimit The most rounds to keep tiles for, at least 1
+       * @param tileBudget Tracks the memory of kept tiles, or null. Must
+       * outlive every tile
+       */
+      TileCache(std::size_t sharers, std::uint64_t roundLimit,
+                MemoryBudget* tileBudget = nullptr);
+
+      /**
+       * @brief Get a tile, making it if no other monitor has in this round
+       * @param round The generation round the tile belongs to
+       * @param id The source image
+       * @param width The width of the tile in pixels
+       * @param height The height of the tile in pixels
+       * @param make Makes the tile on a miss
+       * @return The shared tile
+       *
+       * Exceptions thrown by make are passed on to every caller waiting for
+       * the same tile. A tile for a round which has been released is made
+       * and not kept.
+       */
+      Tile get(std::uint64_t round, ImageId id, std::uint32_t width,
+               std::uint32_t height, const TileFactory& make);
+
+      /**
+       * @brief Mark a round as finished for one participant
+       * @param round The round that was finished, or skipped without asking
+       * for any tiles
+       * @return True if every participant has now finished the round and
+       * its tiles were released
+       */
+      bool finishRound(std::uint64_t round);
+
+      /**
+       * @brief Stop a participant sharing the cache
+       * @param nextRound The first round the participant will not finish.
+       * It must have finished every round before it
+       *
+       * Used when a monitor's resolution changes and it no longer generates
+       * in lockstep with the others.
+       */
+      void leave(std::uint64_t nextRound);
+
+      /**
+       * @brief Get the oldest round which has not been released early
+       * @return The round. A participant behind it should move on to it to
+       * share tiles again
+       */
+      std::uint64_t oldestRound() const;
+
+      /**
+       * @brief Get the number of tiles kept
+       * @return The number of tiles made or being made in open rounds
+       */
+      std::size_t size() const;
+
+      /**
+       * @brief Get the number of tiles served without decoding
+       * @return The number of cache hits
+       */
+      std::uint64_t hits() const;
+
+    private:
+      /**
+       * @brief Identifies a tile within a round
+       */
+      struct Key {
+        //! The generation round
+        std::uint64_t round;
+
+        //! The source image
+        ImageId id;
+
+        //! The tile width in pixels
+        std::uint32_t width;
+
+        //! The tile height in pixels
+        std::uint32_t height;
+
+        /**
+         * @brief Compare two keys
+         * @return True if the keys are equal
+         */
+        bool operator==(const Key&) const = default;
+      };
+
+      /**
+       * @brief Hash function for Key
+       */
+      struct KeyHash {
+        /**
+         * @brief Hash a key
+         * @param key The key to hash
+         * @return The hash value
+         */
+        std::size_t operator()(const Key& key) const;
+      };
+
+      /**
+       * @brief Make a tile to keep
+       * @param make Makes the tile
+       * @return The tile, tracked in budget for as long as it is held
+       */
+      Tile keep(const TileFactory& make);
+
+      /**
+       * @brief Release the oldest rounds if a round is too far ahead of them
+       * @param round A round which is being used
+       *
+       * Must be called with mutex held.
+       */
+      void keepUpWith(std::uint64_t round);
+
+      //! Guards every member below
+      mutable std::mutex mutex;
+
+      //! Tiles that are made or being made, keyed by round, source and size
+      std::unordered_map<Key, std::shared_future<Tile>, KeyHash> tiles;
+
+      //! The number of participants that have finished each open round
+      std::map<std::uint64_t, std::size_t> finished;
+
+      //! The number of monitors sharing the cache
+      std::size_t participants;
+
+      //! The most rounds to keep tiles for
+      std::uint64_t maxRounds;
+
+      //! Tracks the memory of kept tiles, or null
+      MemoryBudget* budget;
+
+      //! Rounds before this one have been released early
+      std::uint64_t firstRound = 0;
+
+      //! The number of tiles served without decoding
+      std::uint64_t hitCount = 0;
+    };
+
+  }  // namespace wp
+}  // namespace brilliant
@@ -9,12 +9,22 @@
 #include "TomlConfigBuilder.hpp"
 
 #include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
 #include <format>
-#include <functional>
 #include <istream>
+#include <iterator>
+#include <limits>
 #include <ranges>
 #include <sstream>
+#include <string>
 #include <string_view>
+#include <vector>
+
+#include "SourceArchive.hpp"
+#include "SourceScan.hpp"
+#include "WeightedSampler.hpp"
 
 /**
  * @brief Template specialization of std::formatter for toml::parse_error
@@ -138,6 +148,48 @@ namespace brilliant {
       //! The global transition delay config key as a string_view
       constexpr auto globalTransitionDelay = "transitionDelay"sv;
 
+      //! The prefetch depth config key as a string_view
+      constexpr auto prefetch = "prefetch"sv;
+
+      //! The background colour config key as a string_view
+      constexpr auto background = "background"sv;
+
+      //! The gutter blur config key as a string_view
+      constexpr auto blurGutters = "blurGutters"sv;
+
+      //! The decode pixel budget config key as a string_view
+      constexpr auto maxDecodePixels = "maxDecodePixels"sv;
+
+      //! The source file size limit config key as a string_view
+      constexpr auto maxFileSize = "maxFileSize"sv;
+
+      //! The compositing band height config key as a string_view
+      constexpr auto bandHeight = "bandHeight"sv;
+
+      //! The memory budget config key as a string_view
+      constexpr auto memoryBudget = "memoryBudget"sv;
+
+      //! The I/O thread count config key as a string_view
+      constexpr auto ioThreads = "ioThreads"sv;
+
+      //! The CPU thread count config key as a string_view
+      constexpr auto cpuThreads = "cpuThreads"sv;
+
+      //! The background priority config key as a string_view
+      constexpr auto lowPriority = "lowPriority"sv;
+
+      //! The CPU affinity config key as a string_view
+      constexpr auto cpuAffinity = "cpuAffinity"sv;
+
+      //! The busy deferral config key as a string_view
+      constexpr auto deferWhenBusy = "deferWhenBusy"sv;
+
+      //! The busy load threshold config key as a string_view
+      constexpr auto busyLoad = "busyLoad"sv;
+
+      //! The busy pressure threshold config key as a string_view
+      constexpr auto busyPressure = "busyPressure"sv;
+
       //! The monitors config key as a string_view
       constexpr auto monitors = "monitors"sv;
 
@@ -150,13 +202,269 @@ namespace brilliant {
 
         //! The monitor index config key as a string_view
         constexpr auto index = "index"sv;
+
+        //! The path of a weighted wallpapers entry as a string_view
+        constexpr auto path = "path"sv;
+
+        //! The weight of a weighted wallpapers entry as a string_view
+        constexpr auto weight = "weight"sv;
+
+        //! The monitor specific folder include patterns config key as a
+        //! string_view
+        constexpr auto include = "include"sv;
+
+        //! The monitor specific folder exclude patterns config key as a
+        //! string_view
+        constexpr auto exclude = "exclude"sv;
+
+        //! The monitor specific folder extension list config key as a
+        //! string_view
+        constexpr auto extensions = "extensions"sv;
+
+        //! The monitor specific folder depth limit config key as a
+        //! string_view
+        constexpr auto maxDepth = "maxDepth"sv;
       }  // namespace monitor
     }  // namespace keys
 
     namespace defaults {
       //! Default global wallpaper transition in minutes
       constexpr auto globalTransitionMinutes = 30;
-    }
+
+      //! Default number of wallpapers rendered ahead of a transition
+      constexpr std::size_t prefetch = 1;
+
+      //! Default background colour, black
+      constexpr std::uint32_t background = 0x000000;
+
+      //! Default gutter fill, the background colour as before blurring was
+      //! added
+      constexpr bool blurGutters = false;
+
+      //! Default decode pixel budget, 8 bytes per pixel at most is 512MB
+      constexpr std::uint64_t maxDecodePixels = 64'000'000;
+
+      //! Default source file size limit, 256MB
+      constexpr std::uintmax_t maxFileSize = 256ull << 20;
+
+      //! Default band height, the whole wallpaper is composited at once
+      constexpr std::uint32_t bandHeight = 0;
+
+      //! Default memory budget, no limit
+      constexpr std::uint64_t memoryBudget = 0;
+
+      //! Default I/O thread count, enough to keep probing while a
+      //! wallpaper that is due is made
+      constexpr std::uint32_t ioThreads = 4;
+
+      //! Default CPU thread count, one per hardware thread
+      constexpr std::uint32_t cpuThreads = 0;
+
+      //! Default CPU thread priority, normal
+      constexpr bool lowPriority = false;
+
+      //! Default busy deferral, wallpapers are made as soon as there is room
+      constexpr bool deferWhenBusy = false;
+
+      //! Default busy load, most of every CPU in use
+      constexpr double busyLoad = 0.8;
+
+      //! Default busy pressure, threads stalled a fifth of the time
+      constexpr double busyPressure = 20.0;
+
+      //! Default weight of a wallpapers entry
+      constexpr double weight = 1.0;
+
+      //! Default extensions of files found in folders, those of the formats
+      //! which can be decoded
+      constexpr std::array extensions{".jpg"sv, ".jpeg"sv, ".jpe"sv,
+                                      ".jfif"sv, ".png"sv, ".bmp"sv,
+                                      ".dib"sv, ".pbm"sv, ".pgm"sv,
+                                      ".ppm"sv, ".pnm"sv};
+    }  // namespace defaults
+
+    namespace {
+      /**
+       * @brief Read a list of strings from a config node
+       * @param node The node holding the list, may be null
+       * @return The strings if the node is an array of strings, otherwise
+       * nullopt
+       */
+      std::optional<std::vector<std::string>> parseStrings(
+          const toml::node* node) {
+        if (!node || !node->is_array()) {
+          return std::nullopt;
+        }
+        std::vector<std::string> strings;
+        for (const auto& entry : *node->as_array()) {
+          const auto text = entry.value<std::string_view>();
+          if (!text) {
+            return std::nullopt;
+          }
+          strings.emplace_back(*text);
+        }
+        return strings;
+      }
+
+      /**
+       * @brief Read a list of CPU indexes from a config node
+       * @param node The node holding the list, may be null
+       * @return The indexes if the node is an array of non-negative
+       * integers, otherwise nullopt
+       */
+      std::optional<std::vector<std::uint32_t>> parseCpus(
+          const toml::node* node) {
+        if (!node || !node->is_array()) {
+          return std::nullopt;
+        }
+        std::vector<std::uint32_t> cpus;
+        for (const auto& entry : *node->as_array()) {
+          const auto cpu = entry.value<std::uint32_t>();
+          if (!cpu) {
+            return std::nullopt;
+          }
+          cpus.push_back(*cpu);
+        }
+        return cpus;
+      }
+
+      /**
+       * @brief Read a transition delay from a config node
+       * @param node The node holding the delay, may be null
+       * @return The delay if the node holds a valid one, otherwise nullopt
+       *
+       * A plain integer is a number of minutes. A string is a number followed
+       * by one of the units ms, s, m or h, eg: "2.5s" or "250ms". Delays must
+       * be at least a millisecond and at most a year.
+       */
+      std::optional<std::chrono::milliseconds> parseDelay(
+          const toml::node* node) {
+        if (!node) {
+          return std::nullopt;
+        }
+
+        // far from overflowing the clocks the delays are added to
+        constexpr std::chrono::milliseconds maxDelay =
+            std::chrono::hours(24 * 365);
+        if (const auto minutes = node->value<std::int64_t>()) {
+          if (*minutes <= 0 ||
+              *minutes > std::chrono::duration_cast<std::chrono::minutes>(
+                             maxDelay)
+                             .count()) {
+            return std::nullopt;
+          }
+          return std::chrono::minutes(*minutes);
+        }
+
+        const auto text = node->value<std::string_view>();
+        if (!text) {
+          return std::nullopt;
+        }
+        double count = 0.0;
+        const auto* end = text->data() + text->size();
+        const auto [ptr, ec] = std::from_chars(text->data(), end, count);
+        if (ec != std::errc()) {
+          return std::nullopt;
+        }
+
+        const auto unit = std::string_view(ptr, end);
+        std::chrono::duration<double, std::milli> delay;
+        if (unit == "ms"sv) {
+          delay = std::chrono::duration<double, std::milli>(count);
+        } else if (unit == "s"sv) {
+          delay = std::chrono::duration<double>(count);
+        } else if (unit == "m"sv) {
+          delay = std::chrono::duration<double, std::ratio<60>>(count);
+        } else if (unit == "h"sv) {
+          delay = std::chrono::duration<double, std::ratio<3600>>(count);
+        } else {
+          return std::nullopt;
+        }
+        // written so a nan count fails too
+        if (!(delay >= std::chrono::milliseconds(1) && delay <= maxDelay)) {
+          return std::nullopt;
+        }
+        return std::chrono::duration_cast<std::chrono::milliseconds>(delay);
+      }
+
+      /**
+       * @brief Read a colour from a config node
+       * @param node The node holding the colour, may be null
+       * @return The colour as 0xRRGGBB if the node holds a valid one,
+       * otherwise nullopt
+       *
+       * Colours are strings of the form "#RRGGBB".
+       */
+      std::optional<std::uint32_t> parseColour(const toml::node* node) {
+        if (!node) {
+          return std::nullopt;
+        }
+
+        const auto text = node->value<std::string_view>();
+        if (!text || text->size() != 7 || text->front() != '#') {
+          return std::nullopt;
+        }
+
+        std::uint32_t colour = 0;
+        const auto* end = text->data() + text->size();
+        const auto [ptr, ec] =
+            std::from_chars(text->data() + 1, end, colour, 16);
+        if (ec != std::errc() || ptr != end) {
+          return std::nullopt;
+        }
+        return colour;
+      }
+
+      /**
+       * @brief Read a size in bytes from a config node
+       * @param node The node holding the size, may be null
+       * @return The size if the node holds a valid one, otherwise nullopt
+       *
+       * A plain integer is a number of bytes. A string is a whole number
+       * followed by one of the units KB, MB or GB, eg: "512MB". Units are
+       * powers of 1024. Sizes must be greater than zero.
+       */
+      std::optional<std::uintmax_t> parseSize(const toml::node* node) {
+        if (!node) {
+          return std::nullopt;
+        }
+
+        std::optional<std::uintmax_t> size;
+        if (const auto bytes = node->value<std::int64_t>()) {
+          if (*bytes > 0) {
+            size = static_cast<std::uintmax_t>(*bytes);
+          }
+        } else if (const auto text = node->value<std::string_view>()) {
+          std::uintmax_t count = 0;
+          const auto* end = text->data() + text->size();
+          const auto [ptr, ec] = std::from_chars(text->data(), end, count);
+          if (ec != std::errc() || count == 0) {
+            return std::nullopt;
+          }
+
+          const auto unit = std::string_view(ptr, end);
+          int shift = 0;
+          if (unit == "KB"sv) {
+            shift = 10;
+          } else if (unit == "MB"sv) {
+            shift = 20;
+          } else if (unit == "GB"sv) {
+            shift = 30;
+          } else {
+            return std::nullopt;
+          }
+          // too large to count in bytes
+          if (count > std::numeric_limits<std::uintmax_t>::max() >> shift) {
+            return std::nullopt;
+          }
+          size = count << shift;
+        }
+        return size;
+      }
+    }  // namespace
+
+    TomlConfigBuilder::TomlConfigBuilder(FolderScanner folderScanner)
+        : scanner(std::move(folderScanner)) {}
 
     Config TomlConfigBuilder::build(const std::filesystem::path& path) {
       Config config{};
@@ -182,6 +490,97 @@ namespace brilliant {
       }
 
       auto& table = result.table();
+      if (auto delay = table.get(keys::globalTransitionDelay);
+          delay && !parseDelay(delay)) {
+        throw ConfigError(std::format("The field {} is not a valid delay: {}",
+                                      keys::globalTransitionDelay, *delay));
+      }
+
+      if (auto prefetch = table.get(keys::prefetch);
+          prefetch && prefetch->value<std::int64_t>().value_or(0) < 1) {
+        throw ConfigError(
+            std::format("The field {} is not a positive integer: {}",
+                        keys::prefetch, *prefetch));
+      }
+
+      if (auto background = table.get(keys::background);
+          background && !parseColour(background)) {
+        throw ConfigError(
+            std::format("The field {} is not a colour of the form #RRGGBB: {}",
+                        keys::background, *background));
+      }
+
+      if (auto blur = table.get(keys::blurGutters);
+          blur && !blur->is_boolean()) {
+        throw ConfigError(std::format("The field {} is not a boolean: {}",
+                                      keys::blurGutters, *blur));
+      }
+
+      if (auto pixels = table.get(keys::maxDecodePixels);
+          pixels && pixels->value<std::int64_t>().value_or(0) < 1) {
+        throw ConfigError(
+            std::format("The field {} is not a positive integer: {}",
+                        keys::maxDecodePixels, *pixels));
+      }
+
+      if (auto size = table.get(keys::maxFileSize); size && !parseSize(size)) {
+        throw ConfigError(std::format("The field {} is not a valid size: {}",
+                                      keys::maxFileSize, *size));
+      }
+
+      if (auto rows = table.get(keys::bandHeight);
+          rows && !rows->value<std::uint32_t>()) {
+        throw ConfigError(
+            std::format("The field {} is not a non-negative integer: {}",
+                        keys::bandHeight, *rows));
+      }
+
+      if (auto budget = table.get(keys::memoryBudget);
+          budget && !parseSize(budget)) {
+        throw ConfigError(std::format("The field {} is not a valid size: {}",
+                                      keys::memoryBudget, *budget));
+      }
+
+      if (auto threads = table.get(keys::ioThreads);
+          threads && threads->value<std::uint32_t>().value_or(0) < 1) {
+        throw ConfigError(
+            std::format("The field {} is not a positive integer: {}",
+                        keys::ioThreads, *threads));
+      }
+
+      if (auto threads = table.get(keys::cpuThreads);
+          threads && !threads->value<std::uint32_t>()) {
+        throw ConfigError(
+            std::format("The field {} is not a non-negative integer: {}",
+                        keys::cpuThreads, *threads));
+      }
+
+      if (auto low = table.get(keys::lowPriority); low && !low->is_boolean()) {
+        throw ConfigError(std::format("The field {} is not a boolean: {}",
+                                      keys::lowPriority, *low));
+      }
+
+      if (auto defer = table.get(keys::deferWhenBusy);
+          defer && !defer->is_boolean()) {
+        throw ConfigError(std::format("The field {} is not a boolean: {}",
+                                      keys::deferWhenBusy, *defer));
+      }
+
+      for (const auto key : {keys::busyLoad, keys::busyPressure}) {
+        if (auto threshold = table.get(key);
+            threshold && !(threshold->value<double>().value_or(0.0) > 0.0)) {
+          throw ConfigError(std::format(
+              "The field {} is not a positive number: {}", key, *threshold));
+        }
+      }
+
+      if (auto cpus = table.get(keys::cpuAffinity);
+          cpus && !parseCpus(cpus)) {
+        throw ConfigError(std::format(
+            "The field {} is not an array of non-negative integers: {}",
+            keys::cpuAffinity, *cpus));
+      }
+
       if (auto monitors = table.get(keys::monitors);
           monitors && monitors->is_array()) {
         if (monitors->as_array()->empty()) {
@@ -193,11 +592,29 @@ namespace brilliant {
           if constexpr (toml::is_table<decltype(monitor)>) {
             if (auto wallpapers = monitor.get(keys::monitor::wallpapers);
                 wallpapers && wallpapers->is_array()) {
-              wallpapers->as_array()->for_each([](auto&& path) {
-                if constexpr (!toml::is_string<decltype(path)>) {
+              wallpapers->as_array()->for_each([](auto&& entry) {
+                if constexpr (toml::is_table<decltype(entry)>) {
+                  if (auto path = entry.get(keys::monitor::path);
+                      !path || !path->is_string()) {
+                    throw ConfigError(std::format(
+                        "Entry {} has a table without a {} string: {}",
+                        keys::monitor::wallpapers, keys::monitor::path,
+                        toml::node_view(entry)));
+                  }
+                  if (auto weight = entry.get(keys::monitor::weight)) {
+                    const auto value =
+                        weight->template value<double>().value_or(0.0);
+                    if (!(value > 0.0 && value <= WeightedSampler::maxWeight)) {
+                      throw ConfigError(std::format(
+                          "Entry {}.{} is not a positive number up to {}: {}",
+                          keys::monitor::wallpapers, keys::monitor::weight,
+                          WeightedSampler::maxWeight, *weight));
+                    }
+                  }
+                } else if constexpr (!toml::is_string<decltype(entry)>) {
                   throw ConfigError(std::format(
-                      "Entry {} is not an array of strings: {}",
-                      keys::monitor::wallpapers, toml::node_view(path)));
+                      "Entry {} is not an array of strings or tables: {}",
+                      keys::monitor::wallpapers, toml::node_view(entry)));
                 }
               });
             } else if (wallpapers) {
@@ -211,10 +628,11 @@ namespace brilliant {
             }
 
             if (auto delay = monitor.get(keys::monitor::transitionDelay);
-                delay && !delay->is_number()) {
+                delay && !parseDelay(delay)) {
               throw ConfigError(
-                  std::format("Entry {}.{} is not a number: {}", keys::monitors,
-                              keys::monitor::transitionDelay, *delay));
+                  std::format("Entry {}.{} is not a valid delay: {}",
+                              keys::monitors, keys::monitor::transitionDelay,
+                              *delay));
             }
 
             if (auto index = monitor.get(keys::monitor::index);
@@ -223,6 +641,32 @@ namespace brilliant {
                                             keys::monitors,
                                             keys::monitor::index, *index));
             }
+
+            for (const auto key :
+                 {keys::monitor::include, keys::monitor::exclude}) {
+              if (auto patterns = monitor.get(key);
+                  patterns && !parseStrings(patterns)) {
+                throw ConfigError(
+                    std::format("Entry {}.{} is not an array of strings: {}",
+                                keys::monitors, key, *patterns));
+              }
+            }
+
+            if (auto extensions = monitor.get(keys::monitor::extensions);
+                extensions && parseStrings(extensions).value_or(
+                                  std::vector<std::string>{}).empty()) {
+              throw ConfigError(std::format(
+                  "Entry {}.{} is not a non-empty array of strings: {}",
+                  keys::monitors, keys::monitor::extensions, *extensions));
+            }
+
+            if (auto depth = monitor.get(keys::monitor::maxDepth);
+                depth && !depth->template value<std::uint32_t>()) {
+              throw ConfigError(
+                  std::format("Entry {}.{} is not a non-negative integer: {}",
+                              keys::monitors, keys::monitor::maxDepth,
+                              *depth));
+            }
           } else {
             throw ConfigError(
                 std::format("Found {} entry that is not a table: {}",
@@ -240,26 +684,65 @@ namespace brilliant {
 
     void TomlConfigBuilder::parse(Config& config, const toml::table& table) {
       if (auto transDelay =
-              table[keys::globalTransitionDelay].value<std::int64_t>()) {
-        config.globalTransitionDelay = std::chrono::minutes(*transDelay);
+              parseDelay(table.get(keys::globalTransitionDelay))) {
+        config.globalTransitionDelay = *transDelay;
       } else {
         config.globalTransitionDelay =
             std::chrono::minutes(defaults::globalTransitionMinutes);
       }
 
-      const auto monitors = table[keys::monitors].as_array();
-      auto configMonitors =
-          *monitors | std::views::transform([this](auto&& table) {
-            return parseMonitor(*table.as_table());
-          });
+      config.prefetch = static_cast<std::size_t>(table[keys::prefetch].value_or(
+          static_cast<std::int64_t>(defaults::prefetch)));
+
+      config.background = parseColour(table.get(keys::background))
+                              .value_or(defaults::background);
+
+      config.blurGutters =
+          table[keys::blurGutters].value_or(defaults::blurGutters);
+
+      config.maxDecodePixels =
+          static_cast<std::uint64_t>(table[keys::maxDecodePixels].value_or(
+              static_cast<std::int64_t>(defaults::maxDecodePixels)));
+
+      config.maxFileSize = parseSize(table.get(keys::maxFileSize))
+                               .value_or(defaults::maxFileSize);
+
+      config.bandHeight =
+          table[keys::bandHeight].value_or(defaults::bandHeight);
+
+      config.memoryBudget = parseSize(table.get(keys::memoryBudget))
+                                .value_or(defaults::memoryBudget);
 
-      auto hasIndex = [](const auto& configMonitor) {
-        return configMonitor.index.has_value();
-      };
+      config.ioThreads = table[keys::ioThreads].value_or(defaults::ioThreads);
 
-      for (const auto& configMonitor :
-           configMonitors | std::views::filter(hasIndex)) {
-        config.monitors.emplace(*configMonitor.index, configMonitor);
+      config.cpuThreads =
+          table[keys::cpuThreads].value_or(defaults::cpuThreads);
+
+      config.lowPriority =
+          table[keys::lowPriority].value_or(defaults::lowPriority);
+
+      config.cpuAffinity =
+          parseCpus(table.get(keys::cpuAffinity)).value_or(
+              std::vector<std::uint32_t>{});
+
+      config.deferWhenBusy =
+          table[keys::deferWhenBusy].value_or(defaults::deferWhenBusy);
+
+      config.busyLoad = table[keys::busyLoad].value_or(defaults::busyLoad);
+
+      config.busyPressure =
+          table[keys::busyPressure].value_or(defaults::busyPressure);
+
+      // each monitor is parsed once, its folders are walked once and its
+      // paths are moved rather than copied
+      std::vector<ConfigMonitor> notIndexed;
+      for (const auto& node : *table[keys::monitors].as_array()) {
+        auto configMonitor = parseMonitor(*node.as_table());
+        if (const auto index = configMonitor.index) {
+          config.monitors.emplace(*index, std::move(configMonitor));
+        } else {
+          notIndexed.push_back(std::move(configMonitor));
+        }
       }
 
       std::uint32_t min = 0u;
@@ -267,39 +750,87 @@ namespace brilliant {
         const auto keys = config.monitors | std::views::keys;
         min = std::min(*std::ranges::min_element(keys), min);
       }
-      auto notIndexed =
-          configMonitors | std::views::filter(std::not_fn(hasIndex));
       auto unusedIndexes =
           std::views::iota(min) | std::views::filter([&config](auto i) {
             return !config.monitors.count(i);
           });
 
-      for (const auto& [i, configMonitor] :
+      for (auto&& [i, configMonitor] :
            std::views::zip(unusedIndexes, notIndexed)) {
-        config.monitors.emplace(i, configMonitor);
+        config.monitors.emplace(i, std::move(configMonitor));
       }
     }
 
     ConfigMonitor TomlConfigBuilder::parseMonitor(const toml::table& table) {
       ConfigMonitor configMonitor;
 
-      for (const auto& path :
-           *table[keys::monitor::wallpapers].as_array() |
-               std::views::transform([](auto&& path) {
-                 return std::filesystem::path(*path.value<std::string_view>());
-               })) {
+      // folders are filtered as they are walked, files listed by name are
+      // always used
+      ScanOptions scan;
+      scan.include = parseStrings(table.get(keys::monitor::include))
+                         .value_or(std::vector<std::string>{});
+      scan.exclude = parseStrings(table.get(keys::monitor::exclude))
+                         .value_or(std::vector<std::string>{});
+      if (auto extensions =
+              parseStrings(table.get(keys::monitor::extensions))) {
+        scan.extensions = std::move(*extensions);
+        for (auto& extension : scan.extensions) {
+          if (!extension.starts_with('.')) {
+            extension.insert(extension.begin(), '.');
+          }
+        }
+      } else {
+        scan.extensions.assign(defaults::extensions.begin(),
+                               defaults::extensions.end());
+      }
+      scan.maxDepth = table[keys::monitor::maxDepth].value<std::uint32_t>();
+
+      for (const auto& entry : *table[keys::monitor::wallpapers].as_array()) {
+        // an entry is a path, or a table with a path and a weight
+        std::filesystem::path path;
+        double weight = defaults::weight;
+        if (const auto text = entry.value<std::string_view>()) {
+          path = *text;
+        } else {
+          const auto& weighted = *entry.as_table();
+          path = *weighted[keys::monitor::path].value<std::string_view>();
+          weight = weighted[keys::monitor::weight].value_or(defaults::weight);
+        }
+
         if (std::filesystem::is_directory(path)) {
-          configMonitor.backgroundPaths.append_range(
-              std::filesystem::recursive_directory_iterator(path));
+          auto found = scanner(path, scan);
+          configMonitor.backgroundPaths.insert(
+              configMonitor.backgroundPaths.end(),
+              std::make_move_iterator(found.begin()),
+              std::make_move_iterator(found.end()));
+        } else if (isArchive(path) && std::filesystem::is_regular_file(path)) {
+          // an archive is filtered like a folder from its index alone, its
+          // members are read in place when they are used
+          std::vector<ArchivedSource> found;
+          try {
+            found = scanArchive(path, scan);
+          } catch (const ArchiveError& e) {
+            throw ConfigError(std::format("Failed to read archive {}: {}",
+                                          path.string(), e.what()));
+          }
+          const auto archive =
+              static_cast<std::uint32_t>(configMonitor.archives.size());
+          configMonitor.archives.push_back(path);
+          for (auto& [memberPath, location] : found) {
+            configMonitor.archiveMembers.push_back(
+                {configMonitor.backgroundPaths.size(), archive, location});
+            configMonitor.backgroundPaths.push_back(std::move(memberPath));
+          }
         } else {
           configMonitor.backgroundPaths.push_back(path);
         }
+        // every file found in a folder has the folder's weight
+        configMonitor.weights.resize(configMonitor.backgroundPaths.size(),
+                                     static_cast<float>(weight));
       }
 
-      if (const auto value =
-              table[keys::monitor::transitionDelay].value<std::int64_t>()) {
-        configMonitor.transitionDelay = std::chrono::minutes(*value);
-      }
+      configMonitor.transitionDelay =
+          parseDelay(table.get(keys::monitor::transitionDelay));
 
       if (const auto index =
               table[keys::monitor::index].value<std::int64_t>()) {
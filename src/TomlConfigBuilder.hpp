@@ -15,7 +15,11 @@
 #endif  // TOML_EXCEPTIONS
 #include <toml++/toml.h>
 
+#include <functional>
+#include <vector>
+
 #include "ConfigBuilder.hpp"
+#include "SourceScan.hpp"
 
 namespace brilliant {
   namespace wp {
@@ -25,6 +29,23 @@ namespace brilliant {
      */
     class TomlConfigBuilder : public ConfigBuilder {
     public:
+      //! Finds the candidate sources in a configured folder
+      using FolderScanner = std::function<std::vector<std::filesystem::path>(
+          const std::filesystem::path&, const ScanOptions&)>;
+
+      /**
+       * @brief Construct a TomlConfigBuilder which searches folders with
+       * scanFolder
+       */
+      TomlConfigBuilder() = default;
+
+      /**
+       * @brief Construct a TomlConfigBuilder which searches folders with the
+       * given scanner, eg: to count the folders searched
+       * @param folderScanner Called once for each configured folder
+       */
+      explicit TomlConfigBuilder(FolderScanner folderScanner);
+
       /**
        * @brief Build config data from the given file
        * @param path The path to the file to read config from
@@ -64,6 +85,10 @@ namespace brilliant {
        * @return A ConfigMontior object containing monitor specific config data
        */
       ConfigMonitor parseMonitor(const toml::table& table);
+
+    private:
+      //! Searches each configured folder
+      FolderScanner scanner = scanFolder;
     };
 
   }  // namespace wp
@@ -0,0 +1,106 @@
+/**
+ *
+ *  @file      TransitionLoop.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements the coroutines which schedule each monitor's transitions
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <type_traits>
+#include <utility>
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+#include "AsyncQueue.hpp"
+#include "Stats.hpp"
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief Run a function on another executor and await its result
+     * @tparam Executor The executor type to run the function on
+     * @tparam F The function type
+     * @param executor The executor to run the function on
+     * @param f The function to run
+     * @return An awaitable holding the result of f. Exceptions thrown by f
+     * are rethrown in the awaiting coroutine
+     *
+     * The awaiting coroutine resumes on its own executor, so long running
+     * work does not hold up anything else scheduled there.
+     */
+    template <class Executor, class F>
+    boost::asio::awaitable<std::invoke_result_t<F&>> runOn(Executor executor,
+                                                           F f) {
+      co_return co_await boost::asio::co_spawn(
+          executor,
+          [f = std::move(f)]() mutable
+          -> boost::asio::awaitable<std::invoke_result_t<F&>> {
+            co_return f();
+          },
+          boost::asio::use_awaitable);
+    }
+
+    /**
+     * @brief Set a monitor's queued wallpapers as their deadlines pass
+     * @tparam Transition The type of the transition function
+     * @param timer Waits for each deadline. Cancelling it stops the loop
+     * @param queue The wallpapers rendered ahead. Closing it stops the loop
+     * @param deadline When the next wallpaper is due, moved on after each
+     * transition
+     * @param delay The time between transitions
+     * @param stats Counts transitions, missed deadlines and lateness
+     * @param transition Called with each wallpaper as it is due and the
+     * number of deadlines it missed, sets it as the monitor's wallpaper
+     * @return An awaitable which completes once the loop is stopped
+     *
+     * Must run on the same executor as the queue's producer. A wallpaper
+     * which is not ready in time is set as soon as it is. Deadlines are
+     * measured from the previous deadline so generation time does not push
+     * later transitions back, see MonitorStats::addTransition.
+     */
+    template <class Transition>
+    boost::asio::awaitable<void> runTransitions(
+        boost::asio::steady_timer& timer,
+        AsyncQueue<std::filesystem::path>& queue,
+        std::chrono::steady_clock::time_point& deadline,
+        std::chrono::steady_clock::duration delay, MonitorStats& stats,
+        Transition transition) {
+      while (true) {
+        boost::system::error_code ec;
+        timer.expires_at(deadline);
+        co_await timer.async_wait(
+            boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+        if (ec == boost::asio::error::operation_aborted || queue.isClosed()) {
+          co_return;
+        } else if (ec) {
+          boost::asio::detail::throw_error(ec);
+        }
+
+        auto next = queue.tryPop();
+        const bool ready = next.has_value();
+        if (!ready) {
+          next = co_await queue.pop();
+          if (!next) {
+            co_return;
+          }
+        }
+
+        const auto missed = stats.addTransition(
+            deadline, delay, std::chrono::steady_clock::now(), ready);
+        transition(std::move(*next), missed);
+      }
+    }
+
+  }  // namespace wp
+}  // namespace brilliant
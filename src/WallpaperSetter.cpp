@@ -16,7 +16,10 @@ namespace brilliant {
   namespace wp {
 
     WallpaperSetter::WallpaperSetter()
-        : _impl(std::make_unique<WallpaperSetterImpl>()) {}
+        : topologyCache([this] { return _impl->queryTopology(); }),
+          _impl(std::make_unique<WallpaperSetterImpl>()) {
+      _impl->watchDisplayChanges([this] { invalidateTopology(); });
+    }
 
     WallpaperSetter::~WallpaperSetter() = default;
 
@@ -27,8 +30,14 @@ namespace brilliant {
 
     std::pair<std::uint32_t, std::uint32_t> WallpaperSetter::getResolution(
         std::uint32_t monitorIndex) {
-      return _impl->getResolution(monitorIndex);
+      return topology()->resolution(monitorIndex);
+    }
+
+    std::shared_ptr<const DisplayTopology> WallpaperSetter::topology() {
+      return topologyCache.get();
     }
 
+    void WallpaperSetter::invalidateTopology() { topologyCache.invalidate(); }
+
   }  // namespace wp
 }  // namespace brilliant
\ No newline at end of file
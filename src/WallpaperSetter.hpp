@@ -8,10 +8,13 @@
  */
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
 #include <memory>
 #include <utility>
 
+#include "DisplayTopology.hpp"
+
 namespace brilliant {
   namespace wp {
     //! Forward declare the implementation type
@@ -44,11 +47,32 @@ namespace brilliant {
        * @brief Get the resolution of the given monitor in pixels
        * @param monitorIndex The index of the monitor to query
        * @return A pair containing the width and height of the monitor in pixels
+       * @throws std::runtime_error if the monitor is not attached
+       *
+       * Read from the cached topology, the OS is only asked after a display
+       * change.
        */
       std::pair<std::uint32_t, std::uint32_t> getResolution(
           std::uint32_t monitorIndex);
 
+      /**
+       * @brief Get every monitor's layout
+       * @return The cached topology, queried again after a display change
+       */
+      std::shared_ptr<const DisplayTopology> topology();
+
+      /**
+       * @brief Query the topology again the next time it is needed
+       *
+       * Display changes the OS reports do this automatically.
+       */
+      void invalidateTopology();
+
     private:
+      //! The monitors as of the last display change. Declared before _impl
+      //! so it outlives the display change notifications
+      TopologyCache topologyCache;
+
       //! A pointer to the wallpaper setter implementation object
       std::unique_ptr<WallpaperSetterImpl> _impl;
     };
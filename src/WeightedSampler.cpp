@@ -0,0 +1,85 @@
+/**
+ *
+ *  @file      WeightedSampler.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements the WeightedSampler class
+ */
+#include "WeightedSampler.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace brilliant {
+  namespace wp {
+
+    std::size_t WeightedSampler::size() const { return weights.size(); }
+
+    void WeightedSampler::push(double weight) {
+      // a new node covers the items from the one after its lowest set bit's
+      // span up to itself, which are all already in the tree
+      const auto units = toUnits(weight);
+      const auto node = weights.size() + 1;
+      std::uint64_t sum = units;
+      const auto lowBit = node & (~node + 1);
+      for (std::size_t child = node - 1; child > node - lowBit;
+           child -= child & (~child + 1)) {
+        sum += tree[child];
+      }
+      weights.push_back(units);
+      tree.push_back(sum);
+    }
+
+    void WeightedSampler::set(std::size_t index, double weight) {
+      const auto units = toUnits(weight);
+      // unsigned wrap around subtracts when the weight goes down
+      add(index, units - weights.at(index));
+      weights[index] = units;
+    }
+
+    std::uint64_t WeightedSampler::weight(std::size_t index) const {
+      return weights.at(index);
+    }
+
+    std::uint64_t WeightedSampler::total() const {
+      std::uint64_t sum = 0;
+      for (auto node = weights.size(); node > 0; node -= node & (~node + 1)) {
+        sum += tree[node];
+      }
+      return sum;
+    }
+
+    std::uint64_t WeightedSampler::toUnits(double weight) {
+      if (!(weight > 0.0)) {
+        return 0;
+      }
+      return std::max<std::uint64_t>(
+          1, static_cast<std::uint64_t>(std::llround(
+                 std::min(weight, maxWeight) * weightScale)));
+    }
+
+    void WeightedSampler::add(std::size_t index, std::uint64_t delta) {
+      for (auto node = index + 1; node < tree.size();
+           node += node & (~node + 1)) {
+        tree[node] += delta;
+      }
+    }
+
+    std::size_t WeightedSampler::find(std::uint64_t target) const {
+      // walk down from the largest power of two, skipping every node whose
+      // partial sum is still at or below the target
+      std::size_t node = 0;
+      for (auto step = std::bit_floor(weights.size()); step > 0; step >>= 1) {
+        if (const auto next = node + step;
+            next <= weights.size() && tree[next] <= target) {
+          node = next;
+          target -= tree[next];
+        }
+      }
+      return node;
+    }
+
+  }  // namespace wp
+}  // namespace brilliant
@@ -0,0 +1,157 @@
+/**
+ *
+ *  @file      WeightedSampler.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Defines the WeightedSampler class
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief Picks indices at random in proportion to their weights
+     *
+     * Weights are kept in a Fenwick tree, so adding an item, changing a
+     * weight and picking an index are all O(log n) and weights can change
+     * while the sampler is in use. An item with a weight of 0 is never
+     * picked.
+     *
+     * Weights are stored as fixed point integers with a resolution of
+     * 1/weightScale, so sums do not drift however often weights change.
+     * Any positive weight counts as at least the resolution and any weight
+     * above maxWeight counts as maxWeight.
+     */
+    class WeightedSampler {
+    public:
+      //! The number of fixed point units in a weight of 1
+      static constexpr std::uint64_t weightScale = 1024;
+
+      //! The largest weight, so totals of many items cannot overflow
+      static constexpr double maxWeight = 1'000'000.0;
+
+      /**
+       * @brief Get the number of items
+       * @return The number of items, including those with a weight of 0
+       */
+      std::size_t size() const;
+
+      /**
+       * @brief Add an item after the last one
+       * @param weight The weight of the item, 0 or more
+       */
+      void push(double weight);
+
+      /**
+       * @brief Change the weight of an item
+       * @param index The index of the item
+       * @param weight The new weight, 0 or more
+       */
+      void set(std::size_t index, double weight);
+
+      /**
+       * @brief Get the weight of an item
+       * @param index The index of the item
+       * @return The weight in fixed point units, 0 if it is never picked
+       */
+      std::uint64_t weight(std::size_t index) const;
+
+      /**
+       * @brief Get the sum of every weight
+       * @return The total in fixed point units
+       */
+      std::uint64_t total() const;
+
+      /**
+       * @brief Pick an index
+       * @tparam URBG The random number generator type
+       * @param rng The random number generator
+       * @return An index picked in proportion to its weight
+       *
+       * The total weight must be greater than 0.
+       */
+      template <class URBG>
+      std::size_t sample(URBG& rng) const {
+        std::uniform_int_distribution<std::uint64_t> dist(0, total() - 1);
+        return find(dist(rng));
+      }
+
+    private:
+      /**
+       * @brief Convert a weight to fixed point units
+       * @param weight The weight
+       * @return The weight in units
+       */
+      static std::uint64_t toUnits(double weight);
+
+      /**
+       * @brief Add to the weight of an item
+       * @param index The index of the item
+       * @param delta The units to add, wrapping to subtract
+       */
+      void add(std::size_t index, std::uint64_t delta);
+
+      /**
+       * @brief Find the item a point on the cumulative weights falls in
+       * @param target A point less than total()
+       * @return The index of the item whose weight covers the point
+       */
+      std::size_t find(std::uint64_t target) const;
+
+      //! The weight of each item in units
+      std::vector<std::uint64_t> weights;
+
+      //! The Fenwick tree of partial sums, one based
+      std::vector<std::uint64_t> tree{0};
+    };
+
+    //! How many picks per item are made before giving up on finding more
+    //! distinct items
+    constexpr std::size_t maxPicksPerItem = 8;
+
+    /**
+     * @brief Pick distinct items from a sampler in proportion to their
+     * weights
+     * @tparam URBG The random number generator type
+     * @tparam Accept The type of the accept function
+     * @param sampler The sampler to pick from
+     * @param count The most items to pick
+     * @param rng The random number generator
+     * @param accept Called with each newly picked index. Returns false to
+     * leave the item out, it should then also stop the sampler picking it
+     * @return The picked indices in the order they were picked
+     *
+     * Skipping repeats gives the same odds as picking without replacement
+     * and leaves the sampler unchanged. Picking stops early when a few
+     * heavy items keep being repeated. Only picked items are passed to
+     * accept, so an expensive check such as probing a source costs the
+     * number of picks rather than the number of items.
+     */
+    template <class URBG, class Accept>
+    std::vector<std::size_t> pickDistinct(const WeightedSampler& sampler,
+                                          std::size_t count, URBG& rng,
+                                          Accept accept) {
+      std::vector<std::size_t> picked;
+      for (std::size_t picks = 0; picked.size() < count &&
+                                  picks < count * maxPicksPerItem &&
+                                  sampler.total() > 0;
+           ++picks) {
+        const auto index = sampler.sample(rng);
+        if (std::ranges::find(picked, index) == picked.end() &&
+            accept(index)) {
+          picked.push_back(index);
+        }
+      }
+      return picked;
+    }
+
+  }  // namespace wp
+}  // namespace brilliant
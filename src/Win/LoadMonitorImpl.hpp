@@ -0,0 +1,74 @@
+/**
+ *
+ *  @file      LoadMonitorImpl.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements the Windows specific LoadMonitorImpl class
+ */
+#pragma once
+
+#include <windows.h>
+
+#include <cstdint>
+
+#include "../SystemLoad.hpp"
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief Windows specific implementation of a LoadMonitor
+     *
+     * Windows has no load average or pressure stall information, so load
+     * is the fraction of CPU time which was not idle since the previous
+     * sample and the pressures are left unset.
+     */
+    class LoadMonitorImpl {
+    public:
+      /**
+       * @brief Measure the CPU time used since the previous sample
+       * @return The sample, without a load the first time
+       */
+      LoadSample sample() {
+        FILETIME idle{};
+        FILETIME kernel{};
+        FILETIME user{};
+        if (!GetSystemTimes(&idle, &kernel, &user)) {
+          return {};
+        }
+
+        // kernel time includes idle time
+        const auto idleNow = ticks(idle);
+        const auto totalNow = ticks(kernel) + ticks(user);
+        LoadSample sample;
+        if (total != 0 && totalNow > total) {
+          sample.load = 1.0 - static_cast<double>(idleNow - idleTotal) /
+                                  static_cast<double>(totalNow - total);
+        }
+        idleTotal = idleNow;
+        total = totalNow;
+        return sample;
+      }
+
+    private:
+      /**
+       * @brief Convert a FILETIME to a count of 100ns ticks
+       * @param time The time
+       * @return The ticks
+       */
+      static std::uint64_t ticks(const FILETIME& time) {
+        return (std::uint64_t{time.dwHighDateTime} << 32) |
+               time.dwLowDateTime;
+      }
+
+      //! The idle ticks of every CPU at the previous sample
+      std::uint64_t idleTotal = 0;
+
+      //! The kernel and user ticks of every CPU at the previous sample, 0
+      //! before the first
+      std::uint64_t total = 0;
+    };
+
+  }  // namespace wp
+}  // namespace brilliant
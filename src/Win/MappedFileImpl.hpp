@@ -0,0 +1,129 @@
+/**
+ *
+ *  @file      MappedFileImpl.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements the Windows specific MappedFileImpl class
+ */
+#pragma once
+
+#include <windows.h>
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <system_error>
+
+#include "../MappedFile.hpp"
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief Windows specific implementation of a MappedFile
+     */
+    class MappedFileImpl {
+    public:
+      /**
+       * @brief Map a file into memory
+       * @param path The path of the file to map
+       * @param hint How the mapped contents will be accessed
+       */
+      MappedFileImpl(const std::filesystem::path& path, AccessHint hint) {
+        const DWORD flags = hint == AccessHint::sequential
+                                ? FILE_FLAG_SEQUENTIAL_SCAN
+                                : FILE_ATTRIBUTE_NORMAL;
+        file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                           nullptr, OPEN_EXISTING, flags, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+          throwLastError(path);
+        }
+
+        LARGE_INTEGER fileSize{};
+        if (!GetFileSizeEx(file, &fileSize)) {
+          const auto ec = lastError();
+          CloseHandle(file);
+          throw std::system_error(ec, path.string());
+        }
+        size = static_cast<std::size_t>(fileSize.QuadPart);
+
+        // mapping an empty file is an error on Windows
+        if (size == 0) {
+          return;
+        }
+
+        mapping =
+            CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) {
+          const auto ec = lastError();
+          CloseHandle(file);
+          throw std::system_error(ec, path.string());
+        }
+
+        view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!view) {
+          const auto ec = lastError();
+          CloseHandle(mapping);
+          CloseHandle(file);
+          throw std::system_error(ec, path.string());
+        }
+      }
+
+      MappedFileImpl(const MappedFileImpl&) = delete;
+      MappedFileImpl& operator=(const MappedFileImpl&) = delete;
+
+      /**
+       * @brief Unmap the file and close all handles
+       */
+      ~MappedFileImpl() {
+        if (view) {
+          UnmapViewOfFile(view);
+        }
+        if (mapping) {
+          CloseHandle(mapping);
+        }
+        CloseHandle(file);
+      }
+
+      /**
+       * @brief Get the mapped contents
+       * @return A span over the mapped bytes
+       */
+      std::span<const std::byte> data() const {
+        return {static_cast<const std::byte*>(view), view ? size : 0};
+      }
+
+    private:
+      /**
+       * @brief Get the calling thread's last error as an error code
+       * @return The last error code
+       */
+      static std::error_code lastError() {
+        return {static_cast<int>(GetLastError()), std::system_category()};
+      }
+
+      /**
+       * @brief Throw the calling thread's last error
+       * @param path The path of the file which caused the error
+       */
+      [[noreturn]] static void throwLastError(
+          const std::filesystem::path& path) {
+        throw std::system_error(lastError(), path.string());
+      }
+
+      //! The file handle
+      HANDLE file = INVALID_HANDLE_VALUE;
+
+      //! The file mapping handle
+      HANDLE mapping = nullptr;
+
+      //! The address of the mapped view
+      LPVOID view = nullptr;
+
+      //! The size of the file in bytes
+      std::size_t size = 0;
+    };
+
+  }  // namespace wp
+}  // namespace brilliant
@@ -0,0 +1,54 @@
+/**
+ *
+ *  @file      ThreadPriorityImpl.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Implements the Windows specific thread scheduling functions
+ */
+#pragma once
+
+#include <windows.h>
+
+#include <climits>
+#include <cstdint>
+#include <span>
+#include <system_error>
+
+namespace brilliant {
+  namespace wp {
+
+    /**
+     * @brief Move the calling thread to background mode
+     */
+    inline void lowerThreadPriorityImpl() {
+      if (!SetThreadPriority(GetCurrentThread(),
+                             THREAD_MODE_BACKGROUND_BEGIN)) {
+        throw std::system_error(static_cast<int>(GetLastError()),
+                                std::system_category(), "SetThreadPriority");
+      }
+    }
+
+    /**
+     * @brief Restrict the calling thread to a set of CPUs
+     * @param cpus The indexes of the CPUs, not empty
+     */
+    inline void setThreadAffinityImpl(std::span<const std::uint32_t> cpus) {
+      DWORD_PTR mask = 0;
+      for (const auto cpu : cpus) {
+        if (cpu >= sizeof(mask) * CHAR_BIT) {
+          throw std::system_error(
+              std::make_error_code(std::errc::invalid_argument),
+              "SetThreadAffinityMask");
+        }
+        mask |= DWORD_PTR{1} << cpu;
+      }
+      if (!SetThreadAffinityMask(GetCurrentThread(), mask)) {
+        throw std::system_error(static_cast<int>(GetLastError()),
+                                std::system_category(),
+                                "SetThreadAffinityMask");
+      }
+    }
+
+  }  // namespace wp
+}  // namespace brilliant
@@ -8,9 +8,12 @@
  */
 #include "WallpaperSetterImpl.hpp"
 
+#include <ShellScalingApi.h>
 #include <comdef.h>
 #include <comutil.h>
 
+#include <future>
+
 #include "../Log.hpp"
 
 namespace brilliant {
@@ -34,6 +37,13 @@ namespace brilliant {
                 }
               }) {}
 
+    WallpaperSetterImpl::~WallpaperSetterImpl() {
+      // closing the window ends its message loop so the thread can be joined
+      if (displayWindow) {
+        PostMessageW(displayWindow, WM_CLOSE, 0, 0);
+      }
+    }
+
     void WallpaperSetterImpl::setWallpaper(
         uint32_t monitorIndex, const std::filesystem::path& filepath) {
       auto monitorName = getMonitorName(monitorIndex);
@@ -45,17 +55,101 @@ namespace brilliant {
           monitorIndex);
     }
 
-    std::pair<uint32_t, uint32_t> WallpaperSetterImpl::getResolution(
-        uint32_t monitorIndex) {
-      auto monitorName = getMonitorName(monitorIndex);
+    std::vector<MonitorInfo> WallpaperSetterImpl::queryTopology() {
+      UINT count = 0;
+      CheckError(manager->GetMonitorDevicePathCount(&count));
 
-      RECT rect{};
-      const auto result = manager->GetMonitorRECT(monitorName.data(), &rect);
-      CheckError(result);
-      log(severity_level::debug,
-          "GetMonitorRECT() returned ok. Rect: t {}, l {}, b {}, r {}",
-          rect.top, rect.left, rect.bottom, rect.right);
-      return {rect.right, rect.bottom};
+      std::vector<MonitorInfo> monitors;
+      for (UINT i = 0; i < count; ++i) {
+        const auto monitorName = getMonitorName(i);
+        const auto id = std::filesystem::path(monitorName).u8string();
+        MonitorInfo monitor{0, 0, 1.0, std::string(id.begin(), id.end())};
+
+        RECT rect{};
+        // fails for monitors which are remembered but not attached
+        if (SUCCEEDED(manager->GetMonitorRECT(monitorName.data(), &rect))) {
+          monitor.width = static_cast<std::uint32_t>(rect.right - rect.left);
+          monitor.height = static_cast<std::uint32_t>(rect.bottom - rect.top);
+
+          UINT dpiX = USER_DEFAULT_SCREEN_DPI;
+          UINT dpiY = USER_DEFAULT_SCREEN_DPI;
+          if (const auto handle = MonitorFromRect(&rect, MONITOR_DEFAULTTONULL);
+              handle && SUCCEEDED(GetDpiForMonitor(handle, MDT_EFFECTIVE_DPI,
+                                                   &dpiX, &dpiY))) {
+            monitor.scale =
+                static_cast<double>(dpiX) / USER_DEFAULT_SCREEN_DPI;
+          }
+        }
+        log(severity_level::debug, "Monitor {} is {}x{} at {}x scale: {}", i,
+            monitor.width, monitor.height, monitor.scale, monitor.deviceId);
+        monitors.push_back(std::move(monitor));
+      }
+      return monitors;
+    }
+
+    void WallpaperSetterImpl::watchDisplayChanges(
+        std::function<void()> onChange) {
+      onDisplayChange = std::move(onChange);
+
+      std::promise<HWND> created;
+      auto window = created.get_future();
+      displayWatcher = std::jthread([this, &created] {
+        constexpr auto className = L"BrilliantWallpaperDisplayWatcher";
+        const auto instance = GetModuleHandleW(nullptr);
+        WNDCLASSW windowClass{};
+        windowClass.lpfnWndProc = displayWindowProc;
+        windowClass.hInstance = instance;
+        windowClass.lpszClassName = className;
+        RegisterClassW(&windowClass);
+
+        // never shown, it only receives broadcasts
+        const auto hwnd = CreateWindowExW(0, className, L"", 0, 0, 0, 0, 0,
+                                          nullptr, nullptr, instance, this);
+        if (!hwnd) {
+          log(severity_level::warning,
+              "Display changes will not be noticed, CreateWindowExW failed "
+              "with {}",
+              GetLastError());
+        }
+        created.set_value(hwnd);
+        if (!hwnd) {
+          return;
+        }
+
+        MSG message{};
+        while (GetMessageW(&message, nullptr, 0, 0) > 0) {
+          DispatchMessageW(&message);
+        }
+      });
+      displayWindow = window.get();
+    }
+
+    LRESULT CALLBACK WallpaperSetterImpl::displayWindowProc(HWND window,
+                                                           UINT message,
+                                                           WPARAM wParam,
+                                                           LPARAM lParam) {
+      switch (message) {
+        case WM_NCCREATE:
+          SetWindowLongPtrW(
+              window, GWLP_USERDATA,
+              reinterpret_cast<LONG_PTR>(
+                  reinterpret_cast<CREATESTRUCTW*>(lParam)->lpCreateParams));
+          break;
+        // resolution and layout changes send WM_DISPLAYCHANGE, scale changes
+        // only send WM_SETTINGCHANGE or WM_DPICHANGED
+        case WM_DISPLAYCHANGE:
+        case WM_SETTINGCHANGE:
+        case WM_DPICHANGED:
+          if (const auto* self = reinterpret_cast<WallpaperSetterImpl*>(
+                  GetWindowLongPtrW(window, GWLP_USERDATA))) {
+            self->onDisplayChange();
+          }
+          break;
+        case WM_DESTROY:
+          PostQuitMessage(0);
+          return 0;
+      }
+      return DefWindowProcW(window, message, wParam, lParam);
     }
 
     std::wstring WallpaperSetterImpl::getMonitorName(uint32_t monitorIndex) {
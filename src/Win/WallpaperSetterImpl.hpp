@@ -12,8 +12,12 @@
 #include <windows.h>
 
 #include <filesystem>
+#include <functional>
 #include <memory>
+#include <thread>
+#include <vector>
 
+#include "../DisplayTopology.hpp"
 #include "ComLib.hpp"
 
 namespace brilliant {
@@ -30,6 +34,12 @@ namespace brilliant {
        */
       WallpaperSetterImpl();
 
+      /**
+       * @brief Stop watching for display changes and destroy a
+       * WallpaperSetterImpl
+       */
+      ~WallpaperSetterImpl();
+
       /**
        * @brief Set the wallpaper of the given monitor to the image at the given
        * location
@@ -40,11 +50,20 @@ namespace brilliant {
                         const std::filesystem::path& filepath);
 
       /**
-       * @brief Get the resolution of a monitor
-       * @param monitorIndex The index of the monitor
-       * @return A pair containing the width and height of the monitor in pixels
+       * @brief Query the layout of every monitor
+       * @return The monitors by index. A monitor which is not attached has
+       * a size of 0
+       */
+      std::vector<MonitorInfo> queryTopology();
+
+      /**
+       * @brief Call a function whenever the displays change
+       * @param onChange Called on a background thread when a monitor is
+       * added, removed, resized or rescaled
+       *
+       * Must be called at most once.
        */
-      std::pair<uint32_t, uint32_t> getResolution(uint32_t monitorIndex);
+      void watchDisplayChanges(std::function<void()> onChange);
 
       /**
        * @brief Get the name of a monitor
@@ -61,11 +80,32 @@ namespace brilliant {
       static void CheckError(HRESULT result);
 
     private:
+      /**
+       * @brief Handle messages for the hidden display change window
+       * @param window The window
+       * @param message The message
+       * @param wParam The message's first parameter
+       * @param lParam The message's second parameter
+       * @return The result of the message
+       */
+      static LRESULT CALLBACK displayWindowProc(HWND window, UINT message,
+                                                WPARAM wParam, LPARAM lParam);
+
       //! The Com object which needs to exist to use Windows Com objects
       ComLib lib;
 
       //! An IDesktopWallpaper instance used to query and change the wallpaper. From the Windows Com library
       std::unique_ptr<IDesktopWallpaper, void (*)(IDesktopWallpaper*)> manager;
+
+      //! Called when the displays change
+      std::function<void()> onDisplayChange;
+
+      //! A hidden top level window, which unlike a message only window is
+      //! sent display change broadcasts. Null if it could not be created
+      HWND displayWindow = nullptr;
+
+      //! Runs the message loop of displayWindow
+      std::jthread displayWatcher;
     };
 
   }  // namespace wp
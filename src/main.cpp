@@ -11,13 +11,37 @@
 #include <sdkddkver.h>
 #endif 
 
+#include <iostream>
+#include <span>
+
 #include "App.hpp"
+#include "CommandLine.hpp"
 #include "Log.hpp"
 
 int main(int argc, const char* argv[]) {
+  brilliant::wp::CommandLine options;
+  try {
+    options = brilliant::wp::parseCommandLine(
+        std::span(argv, static_cast<std::size_t>(argc)).subspan(1));
+  } catch (const brilliant::wp::CommandLineError& e) {
+    std::cerr << e.what() << "\n\n" << brilliant::wp::usage();
+    return EXIT_FAILURE;
+  }
+  if (options.help) {
+    std::cout << brilliant::wp::usage();
+    return EXIT_SUCCESS;
+  }
+  if (options.logLevel) {
+    brilliant::wp::setLogLevel(*options.logLevel);
+  }
+
   try {
-    brilliant::wp::App app(argc, argv);
-    app.run();
+    brilliant::wp::App app(options);
+    if (options.render) {
+      app.render(*options.render);
+    } else {
+      app.run();
+    }
     return EXIT_SUCCESS;
   } catch (const std::exception& e) {
     brilliant::wp::log(brilliant::wp::severity_level::error,
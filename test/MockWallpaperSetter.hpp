@@ -7,10 +7,37 @@
  *  Defines the MockWallpaperSetter class
  */
 
+#include <gmock/gmock.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <vector>
+
+#include "DisplayTopology.hpp"
+
 class MockWallpaperSetterImpl {
 public:
+  MockWallpaperSetterImpl() {
+    ON_CALL(*this, watchDisplayChanges)
+        .WillByDefault(::testing::SaveArg<0>(&onDisplayChange));
+  }
+
   MOCK_METHOD(void, setWallpaper,
               (std::uint32_t, const std::filesystem::path&));
-  MOCK_METHOD((std::pair<std::uint32_t, std::uint32_t>), getResolution,
-              (std::uint32_t));
-};
\ No newline at end of file
+  MOCK_METHOD(std::vector<brilliant::wp::MonitorInfo>, queryTopology, ());
+  MOCK_METHOD(void, watchDisplayChanges, (std::function<void()>));
+
+  /**
+   * @brief Report a display change as the OS would
+   */
+  void changeDisplays() {
+    if (onDisplayChange) {
+      onDisplayChange();
+    }
+  }
+
+private:
+  //! The function passed to watchDisplayChanges
+  std::function<void()> onDisplayChange;
+};
@@ -0,0 +1,38 @@
+/**
+ *
+ *  @file      ScratchDirectory.hpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Defines the ScratchDirectoryTest fixture
+ */
+
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <string_view>
+
+/**
+ * @brief Creates a scratch directory for a test and removes it afterwards
+ */
+class ScratchDirectoryTest : public ::testing::Test {
+protected:
+  /**
+   * @brief Construct the fixture
+   * @param name The name of the scratch directory in the temp directory
+   */
+  explicit ScratchDirectoryTest(std::string_view name)
+      : dir(std::filesystem::temp_directory_path() / name) {}
+
+  void SetUp() override {
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+  }
+
+  void TearDown() override { std::filesystem::remove_all(dir); }
+
+  //! The scratch directory
+  const std::filesystem::path dir;
+};
@@ -0,0 +1,138 @@
+/**
+ *
+ *  @file      TestAsyncQueue.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Unit tests for the AsyncQueue class template
+ */
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <vector>
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+
+#include "AsyncQueue.hpp"
+
+namespace {
+  /**
+   * @brief Runs a queue's producer and consumer on one io_context
+   */
+  class TestAsyncQueue : public ::testing::Test {
+  protected:
+    /**
+     * @brief Start a coroutine on the context
+     * @param task The coroutine
+     *
+     * The context is polled rather than run, as a waiting side keeps it
+     * busy until it is woken.
+     */
+    void spawn(boost::asio::awaitable<void> task) {
+      boost::asio::co_spawn(context, std::move(task), boost::asio::detached);
+    }
+
+    //! Runs both sides
+    boost::asio::io_context context;
+
+    //! The queue under test
+    brilliant::wp::AsyncQueue<int> queue{context.get_executor(), 2};
+
+    //! What happened, in order
+    std::vector<int> events;
+  };
+}  // namespace
+
+TEST_F(TestAsyncQueue, testPopInOrder) {
+  queue.push(1);
+  queue.push(2);
+  EXPECT_EQ(queue.contents().size(), 2u);
+  EXPECT_EQ(queue.tryPop(), 1);
+  EXPECT_EQ(queue.tryPop(), 2);
+  EXPECT_EQ(queue.tryPop(), std::nullopt);
+}
+
+TEST_F(TestAsyncQueue, testWaitsForSpace) {
+  // the producer makes 4 items but only 2 fit until the consumer takes one
+  spawn([this]() -> boost::asio::awaitable<void> {
+    for (int i = 1; i <= 4; ++i) {
+      if (!co_await queue.waitForSpace()) {
+        co_return;
+      }
+      queue.push(i);
+      events.push_back(i);
+    }
+  }());
+  context.poll();
+  EXPECT_EQ(events, (std::vector<int>{1, 2}));
+  EXPECT_EQ(queue.contents().size(), 2u);
+
+  boost::asio::post(context, [this] { events.push_back(-*queue.tryPop()); });
+  context.poll();
+  EXPECT_EQ(events, (std::vector<int>{1, 2, -1, 3}));
+  EXPECT_EQ(queue.contents().size(), 2u);
+}
+
+TEST_F(TestAsyncQueue, testPushPastCapacity) {
+  queue.push(1);
+  queue.push(2);
+  queue.push(3);
+  EXPECT_EQ(queue.contents().size(), 3u);
+}
+
+TEST_F(TestAsyncQueue, testPopWaitsForItem) {
+  spawn([this]() -> boost::asio::awaitable<void> {
+    for (int i = 0; i < 2; ++i) {
+      events.push_back(*co_await queue.pop());
+    }
+  }());
+  context.poll();
+  EXPECT_TRUE(events.empty());
+
+  boost::asio::post(context, [this] {
+    queue.push(7);
+    queue.push(8);
+  });
+  context.poll();
+  EXPECT_EQ(events, (std::vector<int>{7, 8}));
+}
+
+TEST_F(TestAsyncQueue, testCloseWakesBothSides) {
+  brilliant::wp::AsyncQueue<int> full(context.get_executor(), 1);
+  full.push(1);
+  spawn([&]() -> boost::asio::awaitable<void> {
+    events.push_back(co_await full.waitForSpace() ? 1 : 0);
+  }());
+  spawn([this]() -> boost::asio::awaitable<void> {
+    const auto item = co_await queue.pop();
+    events.push_back(item ? *item : -1);
+  }());
+  context.poll();
+  EXPECT_TRUE(events.empty());
+
+  boost::asio::post(context, [&] {
+    full.close();
+    queue.close();
+  });
+  context.poll();
+  EXPECT_EQ(events, (std::vector<int>{0, -1}));
+  EXPECT_TRUE(queue.isClosed());
+}
+
+TEST_F(TestAsyncQueue, testClosedQueueHandsOutNothing) {
+  queue.push(1);
+  queue.close();
+  EXPECT_EQ(queue.tryPop(), std::nullopt);
+  // kept so they can be saved in a snapshot
+  EXPECT_EQ(queue.contents().size(), 1u);
+
+  bool space = true;
+  spawn([&]() -> boost::asio::awaitable<void> {
+    space = co_await queue.waitForSpace();
+  }());
+  context.poll();
+  EXPECT_FALSE(space);
+}
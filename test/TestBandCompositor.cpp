@@ -0,0 +1,125 @@
+/**
+ *
+ *  @file      TestBandCompositor.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Unit tests for banded compositing and the JpegWriter class
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <boost/gil/extension/io/jpeg.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <vector>
+
+#include "BandCompositor.hpp"
+#include "ImageDecoder.hpp"
+#include "JpegWriter.hpp"
+#include "MappedFile.hpp"
+#include "ScratchDirectory.hpp"
+
+namespace {
+  const boost::gil::rgb8_pixel_t background(10, 200, 30);
+
+  /**
+   * @brief Opens test images as tiles and writes into a scratch directory
+   */
+  class TestBandCompositor : public ScratchDirectoryTest {
+  protected:
+    TestBandCompositor() : ScratchDirectoryTest("brilliant_wp_bands") {}
+
+    /**
+     * @brief Open a test image as a tile
+     * @param path The test image
+     * @param width The width of the tile
+     * @param height The height of the tile
+     * @return The tile's rows
+     */
+    static std::unique_ptr<brilliant::wp::TileRows> openTile(
+        const std::filesystem::path& path, std::uint32_t width,
+        std::uint32_t height) {
+      const brilliant::wp::MappedFile file(path);
+      const auto tags = brilliant::wp::getImageType(file.data());
+      return std::make_unique<brilliant::wp::TileRows>(
+          brilliant::wp::SourceFile(path), *tags, 1, width, height,
+          background);
+    }
+  };
+}  // namespace
+
+TEST_F(TestBandCompositor, testTileRowsUnscaled) {
+  const brilliant::wp::MappedFile file("files/test.png");
+  const auto tags = brilliant::wp::getImageType(file.data());
+  const auto expected =
+      brilliant::wp::decodeImageRgb8(file.data(), *tags, background);
+  const auto e = boost::gil::const_view(expected);
+
+  auto tile = openTile("files/test.png",
+                       static_cast<std::uint32_t>(expected.width()),
+                       static_cast<std::uint32_t>(expected.height()));
+  std::vector<boost::gil::rgb8_pixel_t> row(tile->width());
+  for (std::ptrdiff_t y = 0; y < e.height(); ++y) {
+    tile->readRow(row.data());
+    EXPECT_TRUE(std::equal(row.begin(), row.end(), e.row_begin(y)));
+  }
+}
+
+TEST_F(TestBandCompositor, testTileRowsScaled) {
+  auto tile = openTile("files/test.jpg", 37, 23);
+  std::vector<boost::gil::rgb8_pixel_t> row(tile->width());
+  for (std::uint32_t y = 0; y < tile->height(); ++y) {
+    EXPECT_NO_THROW(tile->readRow(row.data()));
+  }
+}
+
+TEST_F(TestBandCompositor, testComposeBands) {
+  constexpr std::uint32_t width = 200;
+  constexpr std::uint32_t height = 90;
+
+  // composite the same tiles in one band and in many to compare
+  const auto compose = [this](std::uint32_t bandHeight) {
+    std::vector<brilliant::wp::BandTile> tiles(2);
+    tiles[0] = {"files/test.png", 10, 5, openTile("files/test.png", 80, 60)};
+    tiles[1] = {"files/test.jpg", 120, 30, openTile("files/test.jpg", 70, 60)};
+
+    const auto path = dir / std::format("bands{}.jpg", bandHeight);
+    brilliant::wp::JpegWriter writer(path, width, height);
+    brilliant::wp::composeBands(
+        tiles, writer, width, height, bandHeight, background,
+        [](const auto&, std::exception_ptr) { FAIL(); });
+    writer.finish();
+    EXPECT_TRUE(std::ranges::none_of(
+        tiles, [](const auto& tile) { return tile.rows != nullptr; }));
+
+    boost::gil::rgb8_image_t img;
+    boost::gil::read_image(path.string(), img, boost::gil::jpeg_tag());
+    return img;
+  };
+
+  const auto whole = compose(height);
+  const auto banded = compose(7);
+  ASSERT_EQ(whole.width(), width);
+  ASSERT_EQ(whole.height(), height);
+  EXPECT_TRUE(boost::gil::equal_pixels(boost::gil::const_view(whole),
+                                       boost::gil::const_view(banded)));
+
+  // outside the tiles is background, within jpeg error
+  const auto corner = boost::gil::const_view(whole)(0, 0);
+  for (int c = 0; c < 3; ++c) {
+    EXPECT_LE(std::abs(int(corner[c]) - int(background[c])), 4);
+  }
+}
+
+TEST_F(TestBandCompositor, testJpegWriterNeedsEveryRow) {
+  brilliant::wp::JpegWriter writer(dir / "short.jpg", 16, 16);
+  boost::gil::rgb8_image_t rows(16, 8, background);
+  writer.writeRows(boost::gil::const_view(rows));
+  EXPECT_THROW(writer.finish(), brilliant::wp::EncodeError);
+  writer.writeRows(boost::gil::const_view(rows));
+  EXPECT_NO_THROW(writer.finish());
+}
@@ -0,0 +1,116 @@
+/**
+ *
+ *  @file      TestCatalog.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Unit tests for the Catalog class
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <format>
+#include <variant>
+
+#include "Catalog.hpp"
+
+TEST(TestCatalog, testIntern) {
+  brilliant::wp::Catalog catalog;
+  EXPECT_EQ(catalog.size(), 0u);
+
+  const std::filesystem::path first("C:/Pictures/first.png");
+  const std::filesystem::path second("C:/Pictures/second.jpg");
+  const auto firstId = catalog.intern(first);
+  const auto secondId = catalog.intern(second);
+  EXPECT_EQ(firstId, 0u);
+  EXPECT_EQ(secondId, 1u);
+  EXPECT_EQ(catalog.intern(first), firstId);
+  EXPECT_EQ(catalog.intern(std::filesystem::path("")), 2u);
+  EXPECT_EQ(catalog.size(), 3u);
+
+  EXPECT_EQ(catalog.path(firstId), first);
+  EXPECT_EQ(catalog.path(secondId), second);
+  EXPECT_EQ(catalog.path(2), std::filesystem::path(""));
+}
+
+TEST(TestCatalog, testStatus) {
+  brilliant::wp::Catalog catalog;
+  const auto usable = catalog.intern("usable.png");
+  const auto unusable = catalog.intern("unusable.png");
+  using Status = brilliant::wp::Catalog::Status;
+  EXPECT_EQ(catalog.status(usable), Status::unknown);
+
+  catalog.setUsable(usable, brilliant::wp::ImageInfo(
+                                640, 480, boost::gil::png_tag{}));
+  catalog.setUnusable(unusable);
+  EXPECT_EQ(catalog.status(usable), Status::usable);
+  EXPECT_EQ(catalog.status(unusable), Status::unusable);
+
+  const auto info = catalog.info(usable);
+  EXPECT_EQ(info.width(), 640u);
+  EXPECT_EQ(info.height(), 480u);
+  EXPECT_TRUE(std::holds_alternative<boost::gil::png_tag>(info.getType()));
+
+  // quarantined after it was probed
+  catalog.setUnusable(usable);
+  EXPECT_EQ(catalog.status(usable), Status::unusable);
+}
+
+TEST(TestCatalog, testSetUsableOnce) {
+  brilliant::wp::Catalog catalog;
+  const auto id = catalog.intern("usable.png");
+  const auto unusable = catalog.intern("unusable.png");
+  using Status = brilliant::wp::Catalog::Status;
+
+  // two probes of the same source race, only the first settles it
+  EXPECT_TRUE(catalog.setUsable(
+      id, brilliant::wp::ImageInfo(640, 480, boost::gil::png_tag{})));
+  EXPECT_FALSE(catalog.setUsable(
+      id, brilliant::wp::ImageInfo(320, 240, boost::gil::png_tag{})));
+  EXPECT_EQ(catalog.info(id).width(), 640u);
+
+  // a source found unusable stays that way
+  catalog.setUnusable(unusable);
+  EXPECT_FALSE(catalog.setUsable(
+      unusable, brilliant::wp::ImageInfo(640, 480, boost::gil::png_tag{})));
+  EXPECT_EQ(catalog.status(unusable), Status::unusable);
+}
+
+TEST(TestCatalog, testManyPaths) {
+  // the pool grows while the index looks up earlier paths
+  brilliant::wp::Catalog catalog;
+  constexpr brilliant::wp::ImageId count = 10000;
+  for (brilliant::wp::ImageId i = 0; i < count; ++i) {
+    ASSERT_EQ(catalog.intern(std::format("folder/{}.jpg", i)), i);
+  }
+  for (brilliant::wp::ImageId i = 0; i < count; i += 97) {
+    EXPECT_EQ(catalog.intern(std::format("folder/{}.jpg", i)), i);
+    EXPECT_EQ(catalog.path(i), std::filesystem::path(
+                                   std::format("folder/{}.jpg", i)));
+  }
+  EXPECT_EQ(catalog.size(), count);
+}
+
+TEST(TestCatalog, testArchiveMember) {
+  brilliant::wp::Catalog catalog;
+  const auto file = catalog.intern("a.jpg");
+  const auto first = catalog.intern("photos.zip/b.jpg");
+  const auto second = catalog.intern("photos.zip/c.jpg");
+  EXPECT_FALSE(catalog.archiveMember(first));
+
+  using brilliant::wp::MemberKind;
+  catalog.setArchiveMember(first, "photos.zip",
+                           {100, 50, 80, MemberKind::zipDeflated});
+  catalog.setArchiveMember(second, "photos.zip",
+                           {300, 20, 20, MemberKind::zipStored});
+  EXPECT_FALSE(catalog.archiveMember(file));
+  const auto member = catalog.archiveMember(second);
+  ASSERT_TRUE(member);
+  EXPECT_EQ(member->first, std::filesystem::path("photos.zip"));
+  EXPECT_EQ(member->second.offset, 300u);
+  EXPECT_EQ(member->second.kind, MemberKind::zipStored);
+  EXPECT_EQ(catalog.archiveMember(first)->second.size, 80u);
+  // the member is still found by its path
+  EXPECT_EQ(catalog.intern("photos.zip/b.jpg"), first);
+}
@@ -0,0 +1,92 @@
+/**
+ *
+ *  @file      TestCommandLine.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Unit tests for the command line parser
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <initializer_list>
+#include <vector>
+
+#include "CommandLine.hpp"
+
+namespace {
+  /**
+   * @brief Parse a list of arguments
+   * @param args The arguments, not including the program name
+   * @return The parsed options
+   */
+  brilliant::wp::CommandLine parse(std::initializer_list<const char*> args) {
+    const std::vector<const char*> argv(args);
+    return brilliant::wp::parseCommandLine(argv);
+  }
+}  // namespace
+
+TEST(TestCommandLine, testDefaults) {
+  const auto options = parse({});
+  EXPECT_FALSE(options.seed);
+  EXPECT_FALSE(options.configFile);
+  EXPECT_FALSE(options.tempDirectory);
+  EXPECT_FALSE(options.logLevel);
+  EXPECT_FALSE(options.render);
+  EXPECT_FALSE(options.help);
+}
+
+TEST(TestCommandLine, testOptions) {
+  const auto options =
+      parse({"--seed", "42", "--config=my config.toml", "--temp-dir", "tmp",
+             "--log-level", "debug"});
+  EXPECT_EQ(options.seed, 42u);
+  EXPECT_EQ(options.configFile, std::filesystem::path("my config.toml"));
+  EXPECT_EQ(options.tempDirectory, std::filesystem::path("tmp"));
+  EXPECT_EQ(options.logLevel, brilliant::wp::severity_level::debug);
+  EXPECT_FALSE(options.render);
+
+  EXPECT_TRUE(parse({"-h"}).help);
+  // usage is printed instead of complaining about a missing --size
+  EXPECT_TRUE(parse({"render", "--help"}).help);
+}
+
+TEST(TestCommandLine, testRender) {
+  const auto options = parse(
+      {"--seed", "7", "render", "--size", "3840x1080", "--out", "out",
+       "--count=12", "--log-level", "warning"});
+  ASSERT_TRUE(options.render);
+  EXPECT_EQ(options.seed, 7u);
+  EXPECT_EQ(options.logLevel, brilliant::wp::severity_level::warning);
+  EXPECT_EQ(options.render->count, 12u);
+  EXPECT_EQ(options.render->width, 3840u);
+  EXPECT_EQ(options.render->height, 1080u);
+  EXPECT_EQ(options.render->outputDirectory, std::filesystem::path("out"));
+
+  EXPECT_EQ(parse({"render", "--size", "1x1", "--out", "out"}).render->count,
+            1u);
+}
+
+TEST(TestCommandLine, testErrors) {
+  using brilliant::wp::CommandLineError;
+  EXPECT_THROW(parse({"--unknown"}), CommandLineError);
+  EXPECT_THROW(parse({"--seed"}), CommandLineError);
+  EXPECT_THROW(parse({"--seed", "-1"}), CommandLineError);
+  EXPECT_THROW(parse({"--seed", "12abc"}), CommandLineError);
+  EXPECT_THROW(parse({"--seed", "99999999999"}), CommandLineError);
+  EXPECT_THROW(parse({"--log-level", "loud"}), CommandLineError);
+
+  // render options are only valid after render
+  EXPECT_THROW(parse({"--size", "1x1"}), CommandLineError);
+  EXPECT_THROW(parse({"render", "--out", "out"}), CommandLineError);
+  EXPECT_THROW(parse({"render", "--size", "1x1"}), CommandLineError);
+  EXPECT_THROW(parse({"render", "--size", "0x10", "--out", "out"}),
+               CommandLineError);
+  EXPECT_THROW(parse({"render", "--size", "1920", "--out", "out"}),
+               CommandLineError);
+  EXPECT_THROW(
+      parse({"render", "--size", "1x1", "--out", "out", "--count", "0"}),
+      CommandLineError);
+  EXPECT_THROW(parse({"render", "render"}), CommandLineError);
+}
@@ -0,0 +1,85 @@
+/**
+ *
+ *  @file      TestDisplayTopology.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Unit tests for the TopologyCache class
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include "DisplayTopology.hpp"
+#include "MockWallpaperSetter.hpp"
+
+using ::testing::Return;
+
+namespace {
+  /**
+   * @brief Connects a TopologyCache to a mock setter the way WallpaperSetter
+   * connects it to the OS
+   */
+  class TestDisplayTopology : public ::testing::Test {
+  protected:
+    void SetUp() override {
+      EXPECT_CALL(impl, watchDisplayChanges);
+      impl.watchDisplayChanges([this] { cache.invalidate(); });
+    }
+
+    //! Stands in for the OS
+    ::testing::NiceMock<MockWallpaperSetterImpl> impl;
+
+    //! The cache under test
+    brilliant::wp::TopologyCache cache{[this] { return impl.queryTopology(); }};
+
+    //! Two side by side monitors
+    std::vector<brilliant::wp::MonitorInfo> dual{
+        {1920, 1080, 1.0, "DISPLAY1"}, {2560, 1440, 1.25, "DISPLAY2"}};
+  };
+}  // namespace
+
+TEST_F(TestDisplayTopology, testQueriedOnce) {
+  EXPECT_CALL(impl, queryTopology).Times(1).WillOnce(Return(dual));
+
+  const auto first = cache.get();
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(cache.get(), first);
+  }
+  EXPECT_EQ(first->version, 1u);
+  EXPECT_EQ(first->resolution(1), std::make_pair(2560u, 1440u));
+  EXPECT_THROW(first->resolution(2), std::runtime_error);
+}
+
+TEST_F(TestDisplayTopology, testDisplayChange) {
+  auto rotated = dual;
+  std::swap(rotated[1].width, rotated[1].height);
+  EXPECT_CALL(impl, queryTopology)
+      .WillOnce(Return(dual))
+      .WillOnce(Return(dual))
+      .WillOnce(Return(rotated));
+
+  const auto first = cache.get();
+
+  // a change which leaves every monitor the same keeps the snapshot
+  impl.changeDisplays();
+  EXPECT_EQ(cache.get(), first);
+
+  impl.changeDisplays();
+  const auto second = cache.get();
+  EXPECT_EQ(second->version, 2u);
+  EXPECT_EQ(second->resolution(1), std::make_pair(1440u, 2560u));
+  EXPECT_EQ(first->resolution(1), std::make_pair(2560u, 1440u));
+  EXPECT_EQ(cache.get(), second);
+}
+
+TEST_F(TestDisplayTopology, testDetachedMonitor) {
+  auto detached = dual;
+  detached[0].width = 0;
+  detached[0].height = 0;
+  EXPECT_CALL(impl, queryTopology).WillOnce(Return(detached));
+  EXPECT_THROW(cache.get()->resolution(0), std::runtime_error);
+}
@@ -0,0 +1,94 @@
+/**
+ *
+ *  @file      TestDownscale.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Unit tests for scaling decoded images to tile sizes
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <boost/gil.hpp>
+#include <cstdint>
+#include <cstdlib>
+#include <tuple>
+
+#include "Downscale.hpp"
+
+TEST(TestDownscale, testHalve) {
+  boost::gil::rgb8_image_t src(5, 3);
+  auto view = boost::gil::view(src);
+  view(0, 0) = boost::gil::rgb8_pixel_t(0, 10, 255);
+  view(1, 0) = boost::gil::rgb8_pixel_t(1, 20, 255);
+  view(0, 1) = boost::gil::rgb8_pixel_t(2, 30, 255);
+  view(1, 1) = boost::gil::rgb8_pixel_t(3, 41, 255);
+
+  // the odd last row and column are dropped
+  boost::gil::rgb8_image_t dst(2, 1);
+  brilliant::wp::halve(boost::gil::const_view(src), boost::gil::view(dst));
+  EXPECT_EQ(boost::gil::view(dst)(0, 0), boost::gil::rgb8_pixel_t(2, 25, 255));
+}
+
+TEST(TestDownscale, testConstantStaysConstant) {
+  const boost::gil::rgb8_pixel_t colour(17, 128, 250);
+  boost::gil::rgb8_image_t src(997, 613, colour);
+  for (const auto [width, height] :
+       {std::pair{997, 613}, std::pair{600, 400}, std::pair{333, 200},
+        std::pair{41, 17}, std::pair{1, 1}}) {
+    boost::gil::rgb8_image_t dst(width, height);
+    brilliant::wp::resample(boost::gil::const_view(src),
+                            boost::gil::view(dst));
+    for (const auto& pixel : boost::gil::const_view(dst)) {
+      ASSERT_EQ(pixel, colour) << width << "x" << height;
+    }
+  }
+}
+
+TEST(TestDownscale, testCheckerboardAverages) {
+  // a one pixel checkerboard has no detail left at any reduction, point
+  // sampling it would give black or white instead of grey
+  boost::gil::rgb8_image_t src(1200, 900);
+  auto view = boost::gil::view(src);
+  for (std::ptrdiff_t y = 0; y < view.height(); ++y) {
+    for (std::ptrdiff_t x = 0; x < view.width(); ++x) {
+      const std::uint8_t value = (x + y) % 2 ? 255 : 0;
+      view(x, y) = boost::gil::rgb8_pixel_t(value, value, value);
+    }
+  }
+
+  for (const auto [width, height] :
+       {std::pair{600, 450}, std::pair{345, 250}, std::pair{97, 73}}) {
+    boost::gil::rgb8_image_t dst(width, height);
+    brilliant::wp::resample(boost::gil::const_view(src),
+                            boost::gil::view(dst));
+    for (const auto& pixel : boost::gil::const_view(dst)) {
+      ASSERT_LE(std::abs(static_cast<int>(pixel[0]) - 128), 12)
+          << width << "x" << height;
+    }
+  }
+}
+
+TEST(TestDownscale, testOnePixelWide) {
+  // fewer source pixels than an area tap reads along the narrow axis
+  for (const auto [width, height, dstWidth, dstHeight] :
+       {std::tuple{1, 40, 1, 7}, std::tuple{40, 1, 7, 1},
+        std::tuple{1, 1, 1, 1}, std::tuple{3, 2, 1, 1}}) {
+    boost::gil::rgb8_image_t src(width, height);
+    auto view = boost::gil::view(src);
+    for (std::ptrdiff_t y = 0; y < view.height(); ++y) {
+      for (std::ptrdiff_t x = 0; x < view.width(); ++x) {
+        view(x, y) = boost::gil::rgb8_pixel_t(100, 150, 200);
+      }
+    }
+    boost::gil::rgb8_image_t dst(dstWidth, dstHeight);
+    brilliant::wp::resample(boost::gil::const_view(src),
+                            boost::gil::view(dst));
+    for (const auto& pixel : boost::gil::const_view(dst)) {
+      ASSERT_EQ(pixel, boost::gil::rgb8_pixel_t(100, 150, 200))
+          << width << "x" << height << " to " << dstWidth << "x"
+          << dstHeight;
+    }
+  }
+}
@@ -0,0 +1,67 @@
+/**
+ *
+ *  @file      TestGapIndex.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Unit tests for the GapIndex class
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "GapIndex.hpp"
+
+TEST(TestGapIndex, testPickFits) {
+  using brilliant::wp::GapIndex;
+  const GapIndex index(1080, {{1920, 1024, 0},
+                              {810, 1024, 1},
+                              {1440, 1024, 2},
+                              {607, 0, 3},
+                              {2560, 1024, 4},
+                              {720, 1024, 5}});
+  EXPECT_EQ(index.height(), 1080u);
+  EXPECT_EQ(index.size(), 5u);
+
+  std::mt19937 mt(0);
+  EXPECT_EQ(index.pick(719, mt), std::nullopt);
+  for (int i = 0; i < 100; ++i) {
+    // the weightless source is never picked, even when it is the only fit
+    EXPECT_EQ(index.pick(720, mt), 5u);
+    const auto picked = index.pick(1000, mt);
+    ASSERT_TRUE(picked);
+    EXPECT_TRUE(*picked == 1 || *picked == 5);
+  }
+
+  std::vector<int> counts(6);
+  for (int i = 0; i < 1000; ++i) {
+    ++counts.at(*index.pick(10000, mt));
+  }
+  for (const auto item : {0, 1, 2, 4, 5}) {
+    EXPECT_GT(counts[item], 0) << "item " << item;
+  }
+  EXPECT_EQ(counts[3], 0);
+}
+
+TEST(TestGapIndex, testWeights) {
+  using brilliant::wp::GapIndex;
+  const GapIndex index(1080, {{100, 4096, 0}, {200, 1024, 1}, {5000, 1, 2}});
+
+  std::mt19937 mt(1);
+  constexpr int draws = 100000;
+  int first = 0;
+  for (int i = 0; i < draws; ++i) {
+    first += *index.pick(300, mt) == 0 ? 1 : 0;
+  }
+  EXPECT_NEAR(first / static_cast<double>(draws), 0.8, 0.01);
+}
+
+TEST(TestGapIndex, testEmpty) {
+  const brilliant::wp::GapIndex index(720, {});
+  std::mt19937 mt(2);
+  EXPECT_EQ(index.size(), 0u);
+  EXPECT_EQ(index.pick(1u << 20, mt), std::nullopt);
+}
@@ -0,0 +1,104 @@
+/**
+ *
+ *  @file      TestGutterFill.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Unit tests for filling the gaps between tiles
+ */
+
+#include <gtest/gtest.h>
+
+#include <boost/gil.hpp>
+#include <cstdint>
+
+#include "GutterFill.hpp"
+
+namespace {
+  /**
+   * @brief Draw a solid tile and add it to a GutterFill
+   * @param fill The GutterFill
+   * @param canvas The wallpaper
+   * @param x The left of the tile
+   * @param y The top of the tile
+   * @param width The width of the tile
+   * @param height The height of the tile
+   * @param colour The colour of the tile
+   */
+  void drawTile(brilliant::wp::GutterFill& fill,
+                const boost::gil::rgb8_view_t& canvas, std::uint32_t x,
+                std::uint32_t y, std::uint32_t width, std::uint32_t height,
+                boost::gil::rgb8_pixel_t colour) {
+    const auto slot = boost::gil::subimage_view(
+        canvas, static_cast<int>(x), static_cast<int>(y),
+        static_cast<int>(width), static_cast<int>(height));
+    boost::gil::fill_pixels(slot, colour);
+    fill.addTile(slot, x, y);
+  }
+}  // namespace
+
+TEST(TestGutterFill, testNoTiles) {
+  const boost::gil::rgb8_pixel_t background(10, 20, 30);
+  boost::gil::rgb8_image_t image(64, 32, background);
+  brilliant::wp::GutterFill fill(64, 32);
+  fill.fill(boost::gil::view(image), 0.5f);
+  for (const auto& pixel : boost::gil::const_view(image)) {
+    EXPECT_EQ(pixel, background);
+  }
+}
+
+TEST(TestGutterFill, testGapBetweenTiles) {
+  const boost::gil::rgb8_pixel_t red(200, 0, 0);
+  const boost::gil::rgb8_pixel_t blue(0, 0, 200);
+  boost::gil::rgb8_image_t image(240, 64, boost::gil::rgb8_pixel_t(0, 0, 0));
+  const auto view = boost::gil::view(image);
+  brilliant::wp::GutterFill fill(240, 64);
+  drawTile(fill, view, 0, 0, 100, 64, red);
+  drawTile(fill, view, 140, 0, 100, 64, blue);
+  fill.fill(view, 0.5f);
+
+  // tiles are left as they are
+  EXPECT_EQ(view(0, 0), red);
+  EXPECT_EQ(view(99, 63), red);
+  EXPECT_EQ(view(140, 0), blue);
+
+  // the gap takes on each side's colour, darkened, without going black
+  for (int y = 0; y < 64; ++y) {
+    const auto nearRed = view(100, y);
+    const auto middle = view(120, y);
+    const auto nearBlue = view(139, y);
+    EXPECT_GT(nearRed[0], nearRed[2]);
+    EXPECT_LT(nearBlue[0], nearBlue[2]);
+    EXPECT_NEAR(middle[0], middle[2], 20);
+    EXPECT_GT(middle[0] + middle[2], 80);
+    EXPECT_LE(nearRed[0], 101);
+    EXPECT_EQ(middle[1], 0);
+  }
+}
+
+TEST(TestGutterFill, testBarsAboveAndBelow) {
+  const boost::gil::rgb8_pixel_t grey(160, 160, 160);
+  boost::gil::rgb8_image_t image(64, 96, boost::gil::rgb8_pixel_t(0, 0, 0));
+  const auto view = boost::gil::view(image);
+  brilliant::wp::GutterFill fill(64, 96);
+  drawTile(fill, view, 0, 32, 64, 32, grey);
+  fill.fill(view, 1.0f);
+
+  EXPECT_NEAR(view(32, 31)[0], 160, 8);
+  EXPECT_NEAR(view(32, 64)[0], 160, 8);
+  EXPECT_GT(view(32, 0)[0], 0);
+  EXPECT_EQ(view(32, 48), grey);
+}
+
+TEST(TestGutterFill, testFadesFarFromTiles) {
+  const boost::gil::rgb8_pixel_t green(0, 255, 0);
+  boost::gil::rgb8_image_t image(1024, 32, green);
+  const auto view = boost::gil::view(image);
+  brilliant::wp::GutterFill fill(1024, 32);
+  drawTile(fill, view, 0, 0, 64, 32, boost::gil::rgb8_pixel_t(255, 0, 0));
+  fill.fill(view, 1.0f);
+
+  EXPECT_GT(view(70, 16)[0], 200);
+  EXPECT_LT(view(70, 16)[1], 50);
+  EXPECT_EQ(view(1000, 16), green);
+}
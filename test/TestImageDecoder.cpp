@@ -0,0 +1,178 @@
+/**
+ *
+ *  @file      TestImageDecoder.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Unit tests for the image decoding functions
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+#include "ImageDecoder.hpp"
+#include "MappedFile.hpp"
+#include "PixelConversion.hpp"
+
+namespace {
+  const boost::gil::rgb8_pixel_t background(10, 200, 30);
+
+  /**
+   * @brief Get the largest channel difference between decoding a file as rgb8
+   * and decoding it natively then converting
+   * @param path The file to decode
+   * @return The largest difference in any channel
+   */
+  int maxRgb8Difference(const std::filesystem::path& path) {
+    const brilliant::wp::MappedFile file(path);
+    const auto tags = brilliant::wp::getImageType(file.data());
+    EXPECT_TRUE(tags.has_value());
+
+    const auto native = brilliant::wp::decodeImage(file.data(), *tags);
+    boost::gil::rgb8_image_t expected(native.dimensions());
+    brilliant::wp::convertToRgb8(boost::gil::const_view(native),
+                                 boost::gil::view(expected), background);
+
+    const auto actual =
+        brilliant::wp::decodeImageRgb8(file.data(), *tags, background);
+    EXPECT_EQ(actual.dimensions(), expected.dimensions());
+
+    int diff = 0;
+    const auto a = boost::gil::const_view(actual);
+    const auto e = boost::gil::const_view(expected);
+    const auto pixels = static_cast<std::ptrdiff_t>(a.size());
+    for (std::ptrdiff_t i = 0; i < pixels; ++i) {
+      for (int c = 0; c < 3; ++c) {
+        diff = std::max(diff, std::abs(int(a[i][c]) - int(e[i][c])));
+      }
+    }
+    return diff;
+  }
+}  // namespace
+
+TEST(TestImageDecoder, testDecodeRgb8Jpg) {
+  EXPECT_EQ(maxRgb8Difference("files/test.jpg"), 0);
+}
+
+TEST(TestImageDecoder, testDecodeRgb8Png) {
+  EXPECT_EQ(maxRgb8Difference("files/test.png"), 0);
+}
+
+TEST(TestImageDecoder, testDecodeRgb8Bmp) {
+  EXPECT_EQ(maxRgb8Difference("files/test.bmp"), 0);
+}
+
+TEST(TestImageDecoder, testDecodeRgb8Rgba16) {
+  // libpng composites after scaling to 8 bits, convertToRgb8 rounds both
+  EXPECT_LE(maxRgb8Difference("files/rgba16.png"), 1);
+}
+
+TEST(TestImageDecoder, testDecodeRgb8GrayAlpha) {
+  EXPECT_EQ(maxRgb8Difference("files/gray_alpha8.png"), 0);
+}
+
+TEST(TestImageDecoder, testChooseDecodeScale) {
+  const brilliant::wp::ImageInfo jpg(16000, 12000, boost::gil::jpeg_tag{});
+  // the budget forces a reduced scale even when the tile is larger
+  EXPECT_EQ(brilliant::wp::chooseDecodeScale(jpg, 16000, 12000, 64'000'000),
+            2u);
+  // the scale goes as far as the tile allows
+  EXPECT_EQ(brilliant::wp::chooseDecodeScale(jpg, 3840, 2160, 64'000'000),
+            4u);
+  EXPECT_EQ(brilliant::wp::chooseDecodeScale(jpg, 1, 1, 64'000'000),
+            brilliant::wp::maxDecodeScale);
+  EXPECT_FALSE(brilliant::wp::chooseDecodeScale(jpg, 1, 1, 1000));
+
+  const brilliant::wp::ImageInfo bmp(16000, 12000, boost::gil::bmp_tag{});
+  EXPECT_EQ(brilliant::wp::chooseDecodeScale(bmp, 100, 100, 200'000'000),
+            1u);
+  EXPECT_FALSE(brilliant::wp::chooseDecodeScale(bmp, 100, 100, 64'000'000));
+}
+
+TEST(TestImageDecoder, testDecodeReducedScale) {
+  for (const auto* path : {"files/test.jpg", "files/test.png"}) {
+    const brilliant::wp::MappedFile file(path);
+    const auto tags = brilliant::wp::getImageType(file.data());
+    const auto info = brilliant::wp::probeImage(file.data(), *tags);
+    const auto img =
+        brilliant::wp::decodeImageRgb8(file.data(), *tags, background, 4);
+    EXPECT_EQ(img.width(), (info.width() + 3) / 4) << path;
+    EXPECT_EQ(img.height(), (info.height() + 3) / 4) << path;
+  }
+}
+
+TEST(TestImageDecoder, testRowDecoder) {
+  for (const auto* path : {"files/test.jpg", "files/test.png",
+                           "files/test.bmp", "files/rgba16.png"}) {
+    const brilliant::wp::MappedFile file(path);
+    const auto tags = brilliant::wp::getImageType(file.data());
+    const auto expected =
+        brilliant::wp::decodeImageRgb8(file.data(), *tags, background, 2);
+
+    brilliant::wp::RowDecoder decoder(file.data(), *tags, background, 2);
+    ASSERT_EQ(decoder.width(), expected.width()) << path;
+    ASSERT_EQ(decoder.height(), expected.height()) << path;
+
+    std::vector<boost::gil::rgb8_pixel_t> row(decoder.width());
+    const auto e = boost::gil::const_view(expected);
+    for (std::ptrdiff_t y = 0; y < e.height(); ++y) {
+      decoder.readRow(row.data());
+      EXPECT_TRUE(std::equal(row.begin(), row.end(), e.row_begin(y)))
+          << path << " row " << y;
+    }
+    EXPECT_THROW(decoder.readRow(row.data()), brilliant::wp::DecodeError);
+  }
+}
+
+TEST(TestImageDecoder, testInterlacedPng) {
+  const brilliant::wp::MappedFile file("files/interlaced.png");
+  const auto tags = brilliant::wp::getImageType(file.data());
+  ASSERT_TRUE(tags.has_value());
+  const auto info = brilliant::wp::probeImage(file.data(), *tags);
+  EXPECT_TRUE(info.interlaced());
+  EXPECT_FALSE(brilliant::wp::probeImage(
+                   brilliant::wp::MappedFile("files/test.png").data(), *tags)
+                   .interlaced());
+
+  const auto img =
+      brilliant::wp::decodeImageRgb8(file.data(), *tags, background);
+  const auto v = boost::gil::const_view(img);
+  for (std::ptrdiff_t y = 0; y < v.height(); ++y) {
+    for (std::ptrdiff_t x = 0; x < v.width(); ++x) {
+      EXPECT_EQ(v(x, y), boost::gil::rgb8_pixel_t(x * 32, y * 32, 128))
+          << x << "," << y;
+    }
+  }
+}
+
+TEST(TestImageDecoder, testEstimateDecodeBytes) {
+  const brilliant::wp::ImageInfo png(4000, 3000, boost::gil::png_tag{});
+  EXPECT_EQ(brilliant::wp::estimateDecodeBytes(png, 4), 1000u * 750 * 3);
+
+  // decoded in full before it is reduced, whatever the scale
+  const brilliant::wp::ImageInfo interlaced(4000, 3000, boost::gil::png_tag{},
+                                            true);
+  EXPECT_EQ(brilliant::wp::estimateDecodeBytes(interlaced, 4),
+            (4000u * 3000 + 1000u * 750) * 3);
+  EXPECT_EQ(brilliant::wp::estimateDecodeBytes(interlaced, 1),
+            4000u * 3000 * 3);
+
+  const brilliant::wp::ImageInfo bmp(4000, 3000, boost::gil::bmp_tag{});
+  EXPECT_EQ(brilliant::wp::estimateDecodeBytes(bmp, 4), 4000u * 3000 * 11);
+}
+
+TEST(TestMappedFile, testMovedFrom) {
+  brilliant::wp::MappedFile file("files/test.png");
+  const auto size = file.size();
+  ASSERT_GT(size, 0u);
+
+  const brilliant::wp::MappedFile moved(std::move(file));
+  EXPECT_EQ(moved.size(), size);
+  EXPECT_TRUE(file.data().empty());
+  EXPECT_EQ(file.size(), 0u);
+}
@@ -53,4 +53,18 @@ TEST(TestImageProcessing, testImageInfo) {
                                               boost::gil::bmp_tag>::type>()));
   EXPECT_EQ(info.height(), 361);
   EXPECT_EQ(info.width(), 410);
-}
\ No newline at end of file
+}
+
+TEST(TestImageProcessing, testGetScaledDimsToFit) {
+  const brilliant::wp::ImageInfo wide(400, 100, boost::gil::png_tag{});
+  EXPECT_EQ(brilliant::wp::getScaledDimsToFit(200, 200, wide),
+            (std::pair<std::uint32_t, std::uint32_t>(200, 50)));
+
+  const brilliant::wp::ImageInfo tall(100, 400, boost::gil::png_tag{});
+  EXPECT_EQ(brilliant::wp::getScaledDimsToFit(200, 200, tall),
+            (std::pair<std::uint32_t, std::uint32_t>(50, 200)));
+
+  // small images are not scaled up
+  EXPECT_EQ(brilliant::wp::getScaledDimsToFit(1000, 1000, tall),
+            (std::pair<std::uint32_t, std::uint32_t>(100, 400)));
+}
@@ -0,0 +1,146 @@
+/**
+ *
+ *  @file      TestMemoryBudget.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Tests holding and borrowing from a memory budget
+ */
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "MemoryBudget.hpp"
+
+TEST(TestMemoryBudget, testTracksUseAndPeak) {
+  brilliant::wp::MemoryBudget budget(100);
+  {
+    const auto canvas = budget.hold(40);
+    EXPECT_EQ(budget.used(), 40u);
+    EXPECT_EQ(budget.headroom(), 60u);
+    auto decode = budget.borrow(50);
+    EXPECT_EQ(budget.used(), 90u);
+    decode.release();
+    EXPECT_EQ(budget.used(), 40u);
+    // a released reservation is only returned once
+    decode.release();
+    EXPECT_EQ(budget.used(), 40u);
+  }
+  EXPECT_EQ(budget.used(), 0u);
+  EXPECT_EQ(budget.peak(), 90u);
+}
+
+TEST(TestMemoryBudget, testMovedReservationReturnsOnce) {
+  brilliant::wp::MemoryBudget budget(100);
+  brilliant::wp::MemoryBudget::Reservation outer;
+  {
+    auto inner = budget.hold(30);
+    outer = std::move(inner);
+  }
+  EXPECT_EQ(budget.used(), 30u);
+  outer = {};
+  EXPECT_EQ(budget.used(), 0u);
+}
+
+TEST(TestMemoryBudget, testBorrowWaitsForBorrow) {
+  brilliant::wp::MemoryBudget budget(100);
+  auto first = budget.borrow(60);
+  std::atomic_bool borrowed = false;
+  std::thread other([&] {
+    const auto second = budget.borrow(60);
+    borrowed = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(borrowed);
+  first.release();
+  other.join();
+  EXPECT_TRUE(borrowed);
+  EXPECT_EQ(budget.peak(), 60u);
+}
+
+TEST(TestMemoryBudget, testBorrowIgnoresHolds) {
+  brilliant::wp::MemoryBudget budget(100);
+  // held memory is only returned once its job's borrows are done, so a
+  // borrow waiting on it could wait forever
+  const auto canvas = budget.hold(90);
+  const auto decode = budget.borrow(60);
+  EXPECT_EQ(budget.used(), 150u);
+  EXPECT_EQ(budget.headroom(), 10u);
+}
+
+TEST(TestMemoryBudget, testHoldWaitsForEverything) {
+  brilliant::wp::MemoryBudget budget(100);
+  auto decode = budget.borrow(70);
+  std::atomic_bool held = false;
+  std::thread other([&] {
+    const auto canvas = budget.hold(40);
+    held = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(held);
+  decode.release();
+  other.join();
+  EXPECT_TRUE(held);
+}
+
+TEST(TestMemoryBudget, testOversizedGoesAheadAlone) {
+  brilliant::wp::MemoryBudget budget(100);
+  const auto canvas = budget.hold(250);
+  EXPECT_EQ(budget.used(), 250u);
+  EXPECT_EQ(budget.peak(), 250u);
+}
+
+TEST(TestMemoryBudget, testNoLimitNeverWaits) {
+  brilliant::wp::MemoryBudget budget(0);
+  const auto canvas = budget.hold(1ull << 40);
+  const auto decode = budget.borrow(1ull << 40);
+  const auto other = budget.hold(1ull << 40);
+  EXPECT_EQ(budget.limit(), 0u);
+  EXPECT_EQ(budget.used(), 3ull << 40);
+  EXPECT_EQ(budget.peak(), 3ull << 40);
+}
+
+TEST(TestMemoryBudget, testTrackedTakesRoom) {
+  brilliant::wp::MemoryBudget budget(100);
+  // tiles kept for other monitors
+  auto tiles = budget.track(70);
+  EXPECT_EQ(budget.used(), 70u);
+  EXPECT_EQ(budget.headroom(), 30u);
+
+  // a borrow too large for what is left waits for other borrows only
+  auto decode = budget.borrow(20);
+  std::atomic_bool borrowed = false;
+  std::thread other([&] {
+    const auto second = budget.borrow(20);
+    borrowed = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(borrowed);
+  decode.release();
+  other.join();
+  EXPECT_TRUE(borrowed);
+
+  tiles.release();
+  EXPECT_EQ(budget.used(), 0u);
+  EXPECT_EQ(budget.peak(), 90u);
+}
+
+TEST(TestMemoryBudget, testTrackedNeverWaits) {
+  brilliant::wp::MemoryBudget budget(100);
+  const auto canvas = budget.hold(80);
+  const auto decode = budget.borrow(50);
+  // over the limit, but tiles are only counted once they are made
+  const auto tiles = budget.track(60);
+  EXPECT_EQ(budget.used(), 190u);
+  EXPECT_EQ(budget.headroom(), 0u);
+}
+
+TEST(TestMemoryBudget, testNothingWaitsForTrackedAlone) {
+  brilliant::wp::MemoryBudget budget(100);
+  // kept until other monitors finish, which may need this canvas first
+  const auto tiles = budget.track(90);
+  const auto canvas = budget.hold(40);
+  EXPECT_EQ(budget.used(), 130u);
+}
@@ -0,0 +1,126 @@
+/**
+ *
+ *  @file      TestMonitorSnapshot.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Unit tests for saving and loading monitor snapshots
+ */
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+
+#include "MonitorSnapshot.hpp"
+#include "ScratchDirectory.hpp"
+
+namespace {
+  /**
+   * @brief Fills a scratch directory with wallpapers to snapshot
+   */
+  class TestMonitorSnapshot : public ScratchDirectoryTest {
+  protected:
+    TestMonitorSnapshot() : ScratchDirectoryTest("brilliant_wp_snapshot") {}
+
+    void SetUp() override {
+      ScratchDirectoryTest::SetUp();
+      for (const auto* name : {"current.jpg", "next0.jpg", "next1.jpg",
+                               "recent.jpg"}) {
+        std::ofstream(dir / name) << "jpeg";
+      }
+      file = dir / "m0.state";
+    }
+
+    /**
+     * @brief Make a snapshot of the scratch wallpapers
+     * @return The snapshot
+     */
+    brilliant::wp::MonitorSnapshot makeSnapshot() const {
+      brilliant::wp::MonitorSnapshot snapshot;
+      snapshot.fingerprint = 0xfedcba9876543210ull;
+      snapshot.current = dir / "current.jpg";
+      snapshot.next = {dir / "next0.jpg", dir / "next1.jpg"};
+      snapshot.recent = {dir / "recent.jpg"};
+      snapshot.deadline = std::chrono::system_clock::time_point(
+          std::chrono::milliseconds(1'700'000'123'456));
+      snapshot.mt.seed(42);
+      snapshot.mt.discard(1000);
+      return snapshot;
+    }
+
+    //! The snapshot file
+    std::filesystem::path file;
+  };
+}  // namespace
+
+TEST(TestFingerprint, testStable) {
+  brilliant::wp::Fingerprint empty;
+  EXPECT_EQ(empty.value(), 0xcbf29ce484222325ull);
+
+  // the published FNV-1a test vector
+  brilliant::wp::Fingerprint print;
+  print.add("a");
+  EXPECT_EQ(print.value(), 0xaf63dc4c8601ec8cull);
+
+  brilliant::wp::Fingerprint split;
+  split.addPath("ab");
+  split.addPath("c");
+  brilliant::wp::Fingerprint joined;
+  joined.addPath("a");
+  joined.addPath("bc");
+  EXPECT_NE(split.value(), joined.value());
+}
+
+TEST_F(TestMonitorSnapshot, testRoundTrip) {
+  const auto saved = makeSnapshot();
+  ASSERT_TRUE(brilliant::wp::saveSnapshot(file, saved));
+  EXPECT_EQ(std::distance(std::filesystem::directory_iterator(dir),
+                          std::filesystem::directory_iterator()),
+            5);
+
+  const auto loaded = brilliant::wp::loadSnapshot(file);
+  ASSERT_TRUE(loaded.has_value());
+  EXPECT_EQ(loaded->fingerprint, saved.fingerprint);
+  EXPECT_EQ(loaded->current, saved.current);
+  EXPECT_EQ(loaded->next, saved.next);
+  EXPECT_EQ(loaded->recent, saved.recent);
+  EXPECT_EQ(loaded->deadline, saved.deadline);
+  EXPECT_EQ(loaded->mt, saved.mt);
+}
+
+TEST_F(TestMonitorSnapshot, testReplaces) {
+  auto snapshot = makeSnapshot();
+  ASSERT_TRUE(brilliant::wp::saveSnapshot(file, snapshot));
+  snapshot.next.pop_back();
+  ASSERT_TRUE(brilliant::wp::saveSnapshot(file, snapshot));
+
+  const auto loaded = brilliant::wp::loadSnapshot(file);
+  ASSERT_TRUE(loaded.has_value());
+  EXPECT_EQ(loaded->next.size(), 1u);
+}
+
+TEST_F(TestMonitorSnapshot, testMissingWallpapers) {
+  ASSERT_TRUE(brilliant::wp::saveSnapshot(file, makeSnapshot()));
+  std::filesystem::remove(dir / "next0.jpg");
+  const auto loaded = brilliant::wp::loadSnapshot(file);
+  ASSERT_TRUE(loaded.has_value());
+  ASSERT_EQ(loaded->next.size(), 1u);
+  EXPECT_EQ(loaded->next[0], dir / "next1.jpg");
+
+  // nothing to carry on showing
+  std::filesystem::remove(dir / "current.jpg");
+  EXPECT_FALSE(brilliant::wp::loadSnapshot(file).has_value());
+}
+
+TEST_F(TestMonitorSnapshot, testMalformed) {
+  EXPECT_FALSE(brilliant::wp::loadSnapshot(file).has_value());
+
+  ASSERT_TRUE(brilliant::wp::saveSnapshot(file, makeSnapshot()));
+  std::ofstream(file, std::ios::app) << "fingerprint\tnot a number\n";
+  EXPECT_FALSE(brilliant::wp::loadSnapshot(file).has_value());
+
+  std::ofstream(file, std::ios::trunc)
+      << "current\t" << (dir / "current.jpg").string() << "\n";
+  EXPECT_FALSE(brilliant::wp::loadSnapshot(file).has_value());
+}
@@ -0,0 +1,106 @@
+/**
+ *
+ *  @file      TestParallelJpeg.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Unit tests for the parallel jpeg encoder
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <boost/gil/extension/io/jpeg.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <random>
+#include <thread>
+#include <utility>
+
+#include "JpegWriter.hpp"
+#include "ParallelJpeg.hpp"
+#include "ScratchDirectory.hpp"
+
+namespace {
+  /**
+   * @brief Makes noisy gradients to encode into a scratch directory
+   */
+  class TestParallelJpeg : public ScratchDirectoryTest {
+  protected:
+    TestParallelJpeg() : ScratchDirectoryTest("brilliant_wp_pjpeg") {}
+
+    /**
+     * @brief Make an image which exercises every MCU
+     * @param width The width of the image
+     * @param height The height of the image
+     * @return The image
+     */
+    static boost::gil::rgb8_image_t makeImage(std::uint32_t width,
+                                              std::uint32_t height) {
+      boost::gil::rgb8_image_t img(width, height);
+      std::mt19937 mt(0);
+      const auto view = boost::gil::view(img);
+      for (std::ptrdiff_t y = 0; y < view.height(); ++y) {
+        for (std::ptrdiff_t x = 0; x < view.width(); ++x) {
+          view(x, y) = boost::gil::rgb8_pixel_t(
+              static_cast<std::uint8_t>(x * 3 + mt() % 16),
+              static_cast<std::uint8_t>(y * 5),
+              static_cast<std::uint8_t>((x + y) * 2));
+        }
+      }
+      return img;
+    }
+
+    /**
+     * @brief Decode a jpeg file
+     * @param path The file to decode
+     * @return The decoded image
+     */
+    static boost::gil::rgb8_image_t read(const std::filesystem::path& path) {
+      boost::gil::rgb8_image_t img;
+      boost::gil::read_image(path.string(), img, boost::gil::jpeg_tag());
+      return img;
+    }
+  };
+}  // namespace
+
+TEST_F(TestParallelJpeg, testMatchesSingleThreaded) {
+  boost::asio::thread_pool pool(3);
+  // sizes which leave a partial MCU and a short last segment
+  for (const auto [width, height] :
+       {std::pair{640u, 480u}, std::pair{37u, 50u}, std::pair{300u, 17u}}) {
+    const auto img = makeImage(width, height);
+
+    const auto single = dir / "single.jpg";
+    brilliant::wp::JpegWriter writer(single, width, height);
+    writer.writeRows(boost::gil::const_view(img));
+    writer.finish();
+
+    for (const std::size_t threads : {1u, 2u, 4u, 16u}) {
+      const auto parallel = dir / "parallel.jpg";
+      brilliant::wp::writeJpegParallel(parallel, boost::gil::const_view(img),
+                                       pool.get_executor(), threads);
+      const auto expected = read(single);
+      const auto actual = read(parallel);
+      ASSERT_EQ(actual.dimensions(), expected.dimensions());
+      EXPECT_TRUE(boost::gil::equal_pixels(boost::gil::const_view(actual),
+                                           boost::gil::const_view(expected)))
+          << width << "x" << height << " on " << threads << " threads";
+    }
+  }
+  pool.join();
+}
+
+TEST_F(TestParallelJpeg, testCallerOnlyExecutor) {
+  // a pool with no free thread must not stop the caller finishing
+  boost::asio::thread_pool pool(1);
+  boost::asio::post(pool, [] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  });
+  const auto img = makeImage(256, 256);
+  EXPECT_NO_THROW(brilliant::wp::writeJpegParallel(
+      dir / "busy.jpg", boost::gil::const_view(img), pool.get_executor(), 8));
+  pool.join();
+}
@@ -0,0 +1,67 @@
+/**
+ *
+ *  @file      TestPixelConversion.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Unit tests for the pixel conversion kernels
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "PixelConversion.hpp"
+
+namespace {
+  const boost::gil::rgb8_pixel_t background(10, 20, 30);
+
+  /**
+   * @brief Convert a single pixel image to rgb8
+   * @tparam Image The source image type
+   * @param pixel The source pixel
+   * @return The converted pixel
+   */
+  template <class Image>
+  boost::gil::rgb8_pixel_t convertPixel(
+      const typename Image::value_type& pixel) {
+    const Image src(1, 1, pixel);
+    boost::gil::rgb8_image_t dst(1, 1);
+    brilliant::wp::convertToRgb8(
+        brilliant::wp::ImageType::const_view_t(boost::gil::const_view(src)),
+        boost::gil::view(dst), background);
+    return *boost::gil::const_view(dst).begin();
+  }
+}  // namespace
+
+TEST(TestPixelConversion, testRgb8) {
+  EXPECT_EQ(convertPixel<boost::gil::rgb8_image_t>({1, 2, 3}),
+            boost::gil::rgb8_pixel_t(1, 2, 3));
+}
+
+TEST(TestPixelConversion, testRgbaComposite) {
+  EXPECT_EQ(convertPixel<boost::gil::rgba8_image_t>({200, 100, 50, 255}),
+            boost::gil::rgb8_pixel_t(200, 100, 50));
+  EXPECT_EQ(convertPixel<boost::gil::rgba8_image_t>({200, 100, 50, 0}),
+            background);
+  EXPECT_EQ(convertPixel<boost::gil::rgba8_image_t>({200, 100, 50, 128}),
+            boost::gil::rgb8_pixel_t(105, 60, 40));
+}
+
+TEST(TestPixelConversion, testNarrowing) {
+  EXPECT_EQ(convertPixel<boost::gil::gray16_image_t>(
+                boost::gil::gray16_pixel_t(65535)),
+            boost::gil::rgb8_pixel_t(255, 255, 255));
+  EXPECT_EQ(convertPixel<boost::gil::gray16_image_t>(
+                boost::gil::gray16_pixel_t(257 * 77)),
+            boost::gil::rgb8_pixel_t(77, 77, 77));
+  EXPECT_EQ(
+      convertPixel<boost::gil::rgba16_image_t>({65535, 0, 257 * 9, 65535}),
+      boost::gil::rgb8_pixel_t(255, 0, 9));
+}
+
+TEST(TestPixelConversion, testGrayAlpha) {
+  EXPECT_EQ(convertPixel<boost::gil::gray_alpha8_image_t>({90, 255}),
+            boost::gil::rgb8_pixel_t(90, 90, 90));
+  EXPECT_EQ(convertPixel<boost::gil::gray_alpha16_image_t>({65535, 0}),
+            background);
+}
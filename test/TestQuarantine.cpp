@@ -0,0 +1,66 @@
+/**
+ *
+ *  @file      TestQuarantine.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Unit tests for the Quarantine class
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+
+#include "Quarantine.hpp"
+#include "ScratchDirectory.hpp"
+
+namespace {
+  /**
+   * @brief Creates a broken source image in a scratch directory
+   */
+  class TestQuarantine : public ScratchDirectoryTest {
+  protected:
+    TestQuarantine() : ScratchDirectoryTest("brilliant_wp_quarantine") {}
+
+    void SetUp() override {
+      ScratchDirectoryTest::SetUp();
+      source = dir / "broken.png";
+      std::ofstream(source) << "not a png";
+      list = dir / "quarantine.txt";
+    }
+
+    //! A source image which fails to load
+    std::filesystem::path source;
+
+    //! The quarantine list
+    std::filesystem::path list;
+  };
+}  // namespace
+
+TEST_F(TestQuarantine, testPersists) {
+  {
+    brilliant::wp::Quarantine quarantine(list);
+    EXPECT_FALSE(quarantine.contains(source));
+    quarantine.add(source, "bad\theader\n");
+    EXPECT_TRUE(quarantine.contains(source));
+  }
+
+  brilliant::wp::Quarantine reloaded(list);
+  EXPECT_EQ(reloaded.size(), 1u);
+  EXPECT_TRUE(reloaded.contains(source));
+}
+
+TEST_F(TestQuarantine, testChangedFileIsRetried) {
+  brilliant::wp::Quarantine quarantine(list);
+  quarantine.add(source, "bad header");
+  std::ofstream(source, std::ios::app) << " with more bytes";
+  EXPECT_FALSE(quarantine.contains(source));
+}
+
+TEST_F(TestQuarantine, testMalformedEntriesIgnored) {
+  std::ofstream(list) << "garbage\n";
+  brilliant::wp::Quarantine quarantine(list);
+  EXPECT_EQ(quarantine.size(), 0u);
+}
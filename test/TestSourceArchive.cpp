@@ -0,0 +1,407 @@
+/**
+ *
+ *  @file      TestSourceArchive.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Unit tests for reading source images out of zip and tar archives
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "ImageDecoder.hpp"
+#include "ImageProcessing.hpp"
+#include "SourceArchive.hpp"
+
+namespace {
+  /**
+   * @brief Encode a little endian integer
+   * @param value The integer
+   * @param size The number of bytes to encode
+   * @return The bytes
+   */
+  std::string le(std::uint64_t value, std::size_t size) {
+    std::string bytes;
+    for (std::size_t i = 0; i < size; ++i) {
+      bytes += static_cast<char>(value >> (8 * i));
+    }
+    return bytes;
+  }
+
+  /**
+   * @brief Make a tar member
+   * @param name The member's name
+   * @param data The member's data
+   * @param type The member's type flag
+   * @return The header, data and padding
+   */
+  std::string tarMember(std::string_view name, std::string_view data,
+                        char type = '0') {
+    std::string header(512, '\0');
+    const auto put = [&](std::size_t at, std::string_view text) {
+      header.replace(at, text.size(), text);
+    };
+    put(0, name);
+    put(100, "0000644");
+    put(124, std::format("{:011o}", data.size()));
+    header[156] = type;
+    put(257, "ustar");
+    put(263, "00");
+    put(148, "        ");
+    unsigned sum = 0;
+    for (const auto c : header) {
+      sum += static_cast<unsigned char>(c);
+    }
+    put(148, std::format("{:06o}", sum));
+    std::string member = header + std::string(data);
+    member.resize((member.size() + 511) / 512 * 512);
+    return member;
+  }
+
+  /**
+   * @brief Make a pax extended header record
+   * @param key The record's key
+   * @param value The record's value
+   * @return The record with its length
+   */
+  std::string paxRecord(std::string_view key, std::string_view value) {
+    // the length counts its own digits
+    const auto body = std::format(" {}={}\n", key, value);
+    auto length = body.size();
+    while (std::format("{}{}", length, body).size() != length) {
+      ++length;
+    }
+    return std::format("{}{}", length, body);
+  }
+
+  /**
+   * @brief A member of a zip archive to make
+   */
+  struct ZipEntry {
+    //! The member's name
+    std::string name;
+
+    //! The member's data once read
+    std::string data;
+
+    //! The compression method, 0 to store or 8 to deflate
+    std::uint16_t method = 0;
+
+    //! The general purpose flags
+    std::uint16_t flags = 0;
+  };
+
+  /**
+   * @brief Deflate data in a single stored block
+   * @param data The data, under 64KB
+   * @return A raw deflate stream which inflates to data
+   */
+  std::string deflateStored(std::string_view data) {
+    return "\x01" + le(data.size(), 2) + le(~data.size() & 0xffff, 2) +
+           std::string(data);
+  }
+
+  /**
+   * @brief Make a zip archive
+   * @param entries The members
+   * @param zip64 Put the member offsets and the central directory in zip64
+   * records
+   * @return The archive
+   */
+  std::string makeZip(const std::vector<ZipEntry>& entries,
+                      bool zip64 = false) {
+    std::string archive;
+    std::string central;
+    for (const auto& entry : entries) {
+      const auto stored =
+          entry.method == 8 ? deflateStored(entry.data) : entry.data;
+      const auto offset = archive.size();
+      archive += le(0x04034b50, 4) + le(20, 2) + le(entry.flags, 2) +
+                 le(entry.method, 2) + le(0, 8) + le(stored.size(), 4) +
+                 le(entry.data.size(), 4) + le(entry.name.size(), 2) +
+                 le(4, 2) + entry.name + "\xfe\xca" + le(0, 2) + stored;
+      const auto extra = zip64 ? le(1, 2) + le(8, 2) + le(offset, 8) : "";
+      central += le(0x02014b50, 4) + le(20, 2) + le(20, 2) +
+                 le(entry.flags, 2) + le(entry.method, 2) + le(0, 8) +
+                 le(stored.size(), 4) + le(entry.data.size(), 4) +
+                 le(entry.name.size(), 2) + le(extra.size(), 2) +
+                 le(0, 2) + le(0, 8) +
+                 le(zip64 ? 0xffffffff : offset, 4) + entry.name + extra;
+    }
+    const auto directory = archive.size();
+    archive += central;
+    if (zip64) {
+      const auto end64 = archive.size();
+      archive += le(0x06064b50, 4) + le(44, 8) + le(45, 2) + le(45, 2) +
+                 le(0, 8) + le(entries.size(), 8) + le(entries.size(), 8) +
+                 le(central.size(), 8) + le(directory, 8);
+      archive += le(0x07064b50, 4) + le(0, 4) + le(end64, 8) + le(1, 4);
+    }
+    archive += le(0x06054b50, 4) + le(0, 4) +
+               le(zip64 ? 0xffff : entries.size(), 2) +
+               le(zip64 ? 0xffff : entries.size(), 2) +
+               le(central.size(), 4) +
+               le(zip64 ? 0xffffffff : directory, 4) + le(7, 2) +
+               "comment";
+    return archive;
+  }
+
+  /**
+   * @brief View text as bytes
+   * @param text The text
+   * @return The bytes of the text
+   */
+  std::span<const std::byte> bytes(std::string_view text) {
+    return std::as_bytes(std::span(text));
+  }
+
+  /**
+   * @brief Read a member of an archive as text
+   * @param archive The archive
+   * @param member The member
+   * @return The member's data
+   */
+  std::string readText(std::string_view archive,
+                       const brilliant::wp::ArchiveMember& member) {
+    std::vector<std::byte> buffer;
+    const auto data =
+        brilliant::wp::readMember(bytes(archive), member.location, buffer);
+    return std::string(reinterpret_cast<const char*>(data.data()),
+                       data.size());
+  }
+}  // namespace
+
+TEST(TestSourceArchive, testIsArchive) {
+  EXPECT_TRUE(brilliant::wp::isArchive("photos/2019.zip"));
+  EXPECT_TRUE(brilliant::wp::isArchive("photos/2019.TAR"));
+  EXPECT_FALSE(brilliant::wp::isArchive("photos/2019.tar.gz"));
+  EXPECT_FALSE(brilliant::wp::isArchive("photos/zip"));
+  EXPECT_FALSE(brilliant::wp::isArchive("photos/a.jpg"));
+}
+
+TEST(TestSourceArchive, testIndexTar) {
+  const auto archive =
+      tarMember("a.jpg", "first") + tarMember("sub/", "", '5') +
+      tarMember("./sub/b.png", std::string(700, 'b')) +
+      tarMember("link.jpg", "", '2') + tarMember("../escape.jpg", "no") +
+      tarMember("/c.jpg", "") + std::string(1024, '\0');
+
+  const auto members = brilliant::wp::indexArchive(bytes(archive));
+  ASSERT_EQ(members.size(), 3u);
+  EXPECT_EQ(members[0].name, "a.jpg");
+  EXPECT_EQ(members[1].name, "sub/b.png");
+  EXPECT_EQ(members[2].name, "c.jpg");
+  EXPECT_EQ(members[0].location.offset, 0u);
+  EXPECT_EQ(members[1].location.offset, 1536u);
+  EXPECT_EQ(members[1].location.size, 700u);
+  EXPECT_EQ(members[1].location.kind, brilliant::wp::MemberKind::tar);
+
+  EXPECT_EQ(readText(archive, members[0]), "first");
+  EXPECT_EQ(readText(archive, members[1]), std::string(700, 'b'));
+  EXPECT_EQ(readText(archive, members[2]), "");
+}
+
+TEST(TestSourceArchive, testTarLongNames) {
+  const std::string longName =
+      std::format("{}/long.jpg", std::string(120, 'd'));
+  const std::string paxName = std::format("{}/pax.jpg", std::string(150, 'p'));
+  const auto archive =
+      tarMember("././@LongLink", longName + '\0', 'L') +
+      tarMember("truncated", "gnu") +
+      tarMember("PaxHeaders/pax.jpg",
+                paxRecord("mtime", "1.5") + paxRecord("path", paxName), 'x') +
+      tarMember("truncated", "pax") + tarMember("short.jpg", "short");
+
+  const auto members = brilliant::wp::indexArchive(bytes(archive));
+  ASSERT_EQ(members.size(), 3u);
+  EXPECT_EQ(members[0].name, longName);
+  EXPECT_EQ(readText(archive, members[0]), "gnu");
+  EXPECT_EQ(members[1].name, paxName);
+  EXPECT_EQ(readText(archive, members[1]), "pax");
+  // the long names only apply to the member after them
+  EXPECT_EQ(members[2].name, "short.jpg");
+}
+
+TEST(TestSourceArchive, testIndexZip) {
+  const auto archive = makeZip({{"a.jpg", "stored"},
+                                {"photos/", ""},
+                                {"photos/b.png", "deflated data", 8},
+                                {"secret.jpg", "hidden", 0, 1},
+                                {"bzip2.jpg", "other", 12}});
+
+  const auto members = brilliant::wp::indexArchive(bytes(archive));
+  ASSERT_EQ(members.size(), 2u);
+  EXPECT_EQ(members[0].name, "a.jpg");
+  EXPECT_EQ(members[0].location.kind, brilliant::wp::MemberKind::zipStored);
+  EXPECT_EQ(members[1].name, "photos/b.png");
+  EXPECT_EQ(members[1].location.kind,
+            brilliant::wp::MemberKind::zipDeflated);
+  EXPECT_EQ(members[1].location.size, 13u);
+  EXPECT_EQ(members[1].location.storedSize, 18u);
+
+  EXPECT_EQ(readText(archive, members[0]), "stored");
+  EXPECT_EQ(readText(archive, members[1]), "deflated data");
+}
+
+TEST(TestSourceArchive, testIndexZip64) {
+  const auto archive =
+      makeZip({{"a.jpg", "first"}, {"b.jpg", "second", 8}}, true);
+
+  const auto members = brilliant::wp::indexArchive(bytes(archive));
+  ASSERT_EQ(members.size(), 2u);
+  EXPECT_EQ(members[1].name, "b.jpg");
+  EXPECT_GT(members[1].location.offset, 0u);
+  EXPECT_EQ(readText(archive, members[0]), "first");
+  EXPECT_EQ(readText(archive, members[1]), "second");
+}
+
+TEST(TestSourceArchive, testEmptyArchives) {
+  EXPECT_TRUE(brilliant::wp::indexArchive({}).empty());
+  EXPECT_TRUE(
+      brilliant::wp::indexArchive(bytes(std::string(1024, '\0'))).empty());
+  EXPECT_TRUE(brilliant::wp::indexArchive(bytes(makeZip({}))).empty());
+}
+
+TEST(TestSourceArchive, testMalformed) {
+  // not a tar header
+  EXPECT_THROW(
+      brilliant::wp::indexArchive(bytes(std::string(512, 'x'))),
+      brilliant::wp::ArchiveError);
+
+  // a member past the end of the archive
+  const auto tar = tarMember("a.jpg", std::string(1000, 'a'));
+  EXPECT_THROW(brilliant::wp::indexArchive(bytes(tar.substr(0, 1024))),
+               brilliant::wp::ArchiveError);
+
+  // a zip without its end record
+  const auto zip = makeZip({{"a.jpg", "stored"}});
+  EXPECT_THROW(
+      brilliant::wp::indexArchive(bytes(zip.substr(0, zip.size() - 30))),
+      brilliant::wp::ArchiveError);
+
+  // a location which is not a local header, or is past the end
+  std::vector<std::byte> buffer;
+  auto location = brilliant::wp::indexArchive(bytes(zip))[0].location;
+  location.offset += 1;
+  EXPECT_THROW(brilliant::wp::readMember(bytes(zip), location, buffer),
+               brilliant::wp::ArchiveError);
+  location.offset -= 1;
+  location.storedSize = zip.size();
+  EXPECT_THROW(brilliant::wp::readMember(bytes(zip), location, buffer),
+               brilliant::wp::ArchiveError);
+
+  // deflated data which does not inflate to its size
+  const auto deflated = makeZip({{"a.jpg", "deflated", 8}});
+  location = brilliant::wp::indexArchive(bytes(deflated))[0].location;
+  location.size += 1;
+  EXPECT_THROW(brilliant::wp::readMember(bytes(deflated), location, buffer),
+               brilliant::wp::ArchiveError);
+}
+
+TEST(TestSourceArchive, testSourceFile) {
+  const auto path = std::filesystem::temp_directory_path() /
+                    "brilliant_wp_source_archive.zip";
+  const auto archive =
+      makeZip({{"a.jpg", "stored"}, {"b.jpg", "deflated", 8}});
+  std::ofstream(path, std::ios::binary) << archive;
+
+  const auto members = brilliant::wp::indexArchive(bytes(archive));
+  ASSERT_EQ(members.size(), 2u);
+  for (const auto& member : members) {
+    auto file = brilliant::wp::SourceFile(path, member.location);
+    // the data stays valid when the file is moved
+    const auto moved = std::move(file);
+    EXPECT_EQ(std::string(reinterpret_cast<const char*>(moved.data().data()),
+                          moved.data().size()),
+              readText(archive, member));
+  }
+
+  const brilliant::wp::SourceFile whole(path);
+  EXPECT_EQ(whole.data().size(), archive.size());
+  std::filesystem::remove(path);
+}
+
+TEST(TestSourceArchive, testDecodeMember) {
+  // images decode from an archive as they do from their own files
+  const brilliant::wp::MappedFile zip("files/sources.zip");
+  for (const auto& member : brilliant::wp::indexArchive(zip.data())) {
+    if (!member.name.ends_with(".png")) {
+      continue;
+    }
+    const brilliant::wp::SourceFile fromZip("files/sources.zip",
+                                            member.location);
+    const brilliant::wp::SourceFile fromFile(
+        std::filesystem::path("files") /
+        std::filesystem::path(member.name).filename());
+    const auto tags = brilliant::wp::getImageType(fromZip.data());
+    ASSERT_TRUE(tags) << member.name;
+    const auto expected = brilliant::wp::decodeImageRgb8(
+        fromFile.data(), *tags, boost::gil::rgb8_pixel_t(0, 0, 0));
+    const auto decoded = brilliant::wp::decodeImageRgb8(
+        fromZip.data(), *tags, boost::gil::rgb8_pixel_t(0, 0, 0));
+    EXPECT_TRUE(boost::gil::equal_pixels(boost::gil::const_view(expected),
+                                         boost::gil::const_view(decoded)))
+        << member.name;
+  }
+}
+
+TEST(TestSourceArchive, testReadMemberPrefix) {
+  const std::string data(1000, 'x');
+  const auto archive = makeZip({{"stored.jpg", data, 0},
+                                {"deflated.jpg", data + "end", 8}});
+  const auto members = brilliant::wp::indexArchive(bytes(archive));
+  ASSERT_EQ(members.size(), 2u);
+
+  for (const auto& member : members) {
+    std::vector<std::byte> buffer;
+    const auto prefix =
+        brilliant::wp::readMember(bytes(archive), member.location, buffer, 10);
+    EXPECT_EQ(std::string(reinterpret_cast<const char*>(prefix.data()),
+                          prefix.size()),
+              std::string(10, 'x'))
+        << member.name;
+    // only as much as was asked for is inflated
+    EXPECT_LE(buffer.size(), 10u) << member.name;
+
+    // a limit past the end reads the whole member
+    const auto whole = brilliant::wp::readMember(bytes(archive),
+                                                 member.location, buffer, 5000);
+    EXPECT_EQ(whole.size(), member.location.size) << member.name;
+  }
+}
+
+TEST(TestSourceArchive, testProbeMemberPrefix) {
+  const brilliant::wp::MappedFile zip("files/sources.zip");
+  for (const auto& member : brilliant::wp::indexArchive(zip.data())) {
+    if (!member.name.ends_with(".png")) {
+      continue;
+    }
+    // a png's size is in its first chunk
+    const brilliant::wp::SourceFile prefix("files/sources.zip",
+                                           member.location,
+                                           brilliant::wp::AccessHint::normal,
+                                           64);
+    EXPECT_TRUE(prefix.partial()) << member.name;
+    const brilliant::wp::SourceFile whole("files/sources.zip",
+                                          member.location);
+    EXPECT_FALSE(whole.partial()) << member.name;
+
+    const auto tags = brilliant::wp::getImageType(prefix.data());
+    ASSERT_TRUE(tags) << member.name;
+    const auto fromPrefix = brilliant::wp::probeImage(prefix.data(), *tags);
+    const auto fromWhole = brilliant::wp::probeImage(whole.data(), *tags);
+    EXPECT_EQ(fromPrefix.width(), fromWhole.width()) << member.name;
+    EXPECT_EQ(fromPrefix.height(), fromWhole.height()) << member.name;
+  }
+}
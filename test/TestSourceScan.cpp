@@ -0,0 +1,180 @@
+/**
+ *
+ *  @file      TestSourceScan.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Unit tests for finding source images in folders
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "SourceScan.hpp"
+
+namespace {
+  /**
+   * @brief Make a tar member for a regular file
+   * @param name The member's name
+   * @param data The member's data, under 512 bytes
+   * @return The header and padded data
+   */
+  std::string tarMember(std::string_view name, std::string_view data) {
+    std::string header(512, '\0');
+    const auto put = [&](std::size_t at, std::string_view text) {
+      header.replace(at, text.size(), text);
+    };
+    put(0, name);
+    put(124, std::format("{:011o}", data.size()));
+    header[156] = '0';
+    put(148, "        ");
+    unsigned sum = 0;
+    for (const auto c : header) {
+      sum += static_cast<unsigned char>(c);
+    }
+    put(148, std::format("{:06o}", sum));
+    std::string block(data);
+    block.resize(512);
+    return header + block;
+  }
+
+  /**
+   * @brief Creates a folder of mixed media for a test and removes it
+   * afterwards
+   */
+  class TestSourceScan : public ::testing::Test {
+  protected:
+    void SetUp() override {
+      dir = std::filesystem::temp_directory_path() / "brilliant_wp_scan";
+      std::filesystem::remove_all(dir);
+      // the same files in a tar archive beside the folder
+      archive = dir;
+      archive += ".tar";
+      std::ofstream tar(archive, std::ios::binary);
+      for (const auto* file :
+           {"a.jpg", "b.PNG", "c.cr2", "c.jpg.xmp", "clip.mp4",
+            "holiday/d.jpeg", "holiday/raw/e.jpg", "holiday/@eaDir/f.jpg",
+            "work/g.bmp", "work/deep/er/h.png"}) {
+        const auto path = dir / file;
+        std::filesystem::create_directories(path.parent_path());
+        std::ofstream(path) << "not an image";
+        tar << tarMember(file, "not an image");
+      }
+      options.extensions = {".jpg", ".jpeg", ".png", ".bmp"};
+    }
+
+    void TearDown() override {
+      std::filesystem::remove_all(dir);
+      std::filesystem::remove(archive);
+    }
+
+    /**
+     * @brief Scan the folder
+     * @return The found paths relative to the folder, sorted
+     */
+    std::vector<std::string> scan() const {
+      std::vector<std::string> found;
+      for (const auto& path : brilliant::wp::scanFolder(dir, options)) {
+        found.push_back(path.lexically_relative(dir).generic_string());
+      }
+      std::ranges::sort(found);
+      return found;
+    }
+
+    /**
+     * @brief Scan the archive
+     * @return The found paths relative to the archive, sorted
+     */
+    std::vector<std::string> scanTar() const {
+      std::vector<std::string> found;
+      for (const auto& source :
+           brilliant::wp::scanArchive(archive, options)) {
+        found.push_back(
+            source.path.lexically_relative(archive).generic_string());
+      }
+      std::ranges::sort(found);
+      return found;
+    }
+
+    //! The scratch folder
+    std::filesystem::path dir;
+
+    //! The scratch folder's files in a tar archive
+    std::filesystem::path archive;
+
+    //! The options to scan with
+    brilliant::wp::ScanOptions options;
+  };
+}  // namespace
+
+TEST(TestGlob, testMatch) {
+  using brilliant::wp::matchGlob;
+  EXPECT_TRUE(matchGlob("*.jpg", "photo.jpg"));
+  EXPECT_TRUE(matchGlob("*.JPG", "photo.jpg"));
+  EXPECT_FALSE(matchGlob("*.jpg", "photo.jpg.xmp"));
+  EXPECT_FALSE(matchGlob("*.jpg", "dir/photo.jpg"));
+  EXPECT_TRUE(matchGlob("*/*.jpg", "dir/photo.jpg"));
+  EXPECT_TRUE(matchGlob("img_????.png", "IMG_0042.png"));
+  EXPECT_FALSE(matchGlob("img_????.png", "IMG_042.png"));
+  EXPECT_FALSE(matchGlob("a?b", "a/b"));
+  EXPECT_TRUE(matchGlob("**/raw/**", "2024/june/raw/x.jpg"));
+  EXPECT_TRUE(matchGlob("holiday/**/x.jpg", "holiday/x.jpg"));
+  EXPECT_TRUE(matchGlob("holiday/**/x.jpg", "holiday/a/b/x.jpg"));
+  EXPECT_FALSE(matchGlob("holiday/**/x.jpg", "work/x.jpg"));
+  EXPECT_TRUE(matchGlob("", ""));
+  EXPECT_FALSE(matchGlob("", "a"));
+  EXPECT_TRUE(matchGlob("*", ""));
+}
+
+TEST_F(TestSourceScan, testExtensions) {
+  EXPECT_THAT(scan(), ::testing::ElementsAre(
+                          "a.jpg", "b.PNG", "holiday/@eaDir/f.jpg",
+                          "holiday/d.jpeg", "holiday/raw/e.jpg",
+                          "work/deep/er/h.png", "work/g.bmp"));
+}
+
+TEST_F(TestSourceScan, testFilters) {
+  options.exclude = {"@eaDir", "holiday/raw"};
+  options.include = {"*.jpg", "work/**"};
+  EXPECT_THAT(scan(), ::testing::ElementsAre("a.jpg", "work/deep/er/h.png",
+                                             "work/g.bmp"));
+}
+
+TEST_F(TestSourceScan, testMaxDepth) {
+  options.maxDepth = 0;
+  EXPECT_THAT(scan(), ::testing::ElementsAre("a.jpg", "b.PNG"));
+
+  options.maxDepth = 1;
+  EXPECT_THAT(scan(),
+              ::testing::ElementsAre("a.jpg", "b.PNG", "holiday/d.jpeg",
+                                     "work/g.bmp"));
+}
+
+TEST_F(TestSourceScan, testArchive) {
+  // an archive is filtered exactly as the folder it was made from
+  EXPECT_EQ(scanTar(), scan());
+
+  options.exclude = {"@eaDir", "holiday/raw"};
+  options.include = {"*.jpg", "work/**"};
+  EXPECT_EQ(scanTar(), scan());
+
+  options = {};
+  options.extensions = {".jpg", ".jpeg", ".png", ".bmp"};
+  options.maxDepth = 1;
+  EXPECT_EQ(scanTar(), scan());
+  options.maxDepth = 0;
+  EXPECT_THAT(scanTar(), ::testing::ElementsAre("a.jpg", "b.PNG"));
+
+  const auto sources = brilliant::wp::scanArchive(archive, options);
+  ASSERT_EQ(sources.size(), 2u);
+  EXPECT_EQ(sources[0].path, archive / "a.jpg");
+  EXPECT_EQ(sources[0].location.size, 12u);
+}
@@ -0,0 +1,66 @@
+/**
+ *
+ *  @file      TestStats.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Unit tests for counting transitions and missed deadlines
+ */
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+#include "Stats.hpp"
+
+namespace {
+  using namespace std::chrono_literals;
+
+  //! A deadline to count from
+  const std::chrono::steady_clock::time_point start{1h};
+}  // namespace
+
+TEST(TestStats, testOnTime) {
+  brilliant::wp::MonitorStats stats;
+  auto deadline = start;
+  EXPECT_EQ(stats.addTransition(deadline, 10s, start + 5ms, true), 0u);
+  EXPECT_EQ(deadline, start + 10s);
+  EXPECT_EQ(stats.transitions, 1u);
+  EXPECT_EQ(stats.missedDeadlines, 0u);
+  EXPECT_EQ(stats.worstLateness, 5ms);
+}
+
+TEST(TestStats, testLateWithinDelay) {
+  brilliant::wp::MonitorStats stats;
+  auto deadline = start;
+  // not ready at the deadline and set before the next
+  EXPECT_EQ(stats.addTransition(deadline, 10s, start + 2s, false), 1u);
+  EXPECT_EQ(deadline, start + 10s);
+  EXPECT_EQ(stats.missedDeadlines, 1u);
+  EXPECT_EQ(stats.worstLateness, 2s);
+}
+
+TEST(TestStats, testLatePastDeadlines) {
+  brilliant::wp::MonitorStats stats;
+  auto deadline = start;
+  // the deadline it was due at and the two which passed while waiting
+  EXPECT_EQ(stats.addTransition(deadline, 10s, start + 25s, false), 3u);
+  EXPECT_EQ(deadline, start + 30s);
+  EXPECT_EQ(stats.transitions, 1u);
+  EXPECT_EQ(stats.missedDeadlines, 3u);
+
+  // exactly on a later deadline skips it too
+  EXPECT_EQ(stats.addTransition(deadline, 10s, start + 40s, false), 2u);
+  EXPECT_EQ(deadline, start + 50s);
+  EXPECT_EQ(stats.missedDeadlines, 5u);
+  EXPECT_EQ(stats.worstLateness, 25s);
+}
+
+TEST(TestStats, testReadyButWokenLate) {
+  brilliant::wp::MonitorStats stats;
+  auto deadline = start;
+  // eg: after a suspend, the wallpaper was ready so only the deadlines
+  // after the one it was due at are missed
+  EXPECT_EQ(stats.addTransition(deadline, 10s, start + 25s, true), 2u);
+  EXPECT_EQ(deadline, start + 30s);
+  EXPECT_EQ(stats.missedDeadlines, 2u);
+}
@@ -0,0 +1,47 @@
+/**
+ *
+ *  @file      TestSystemLoad.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Tests reading and judging the system load
+ */
+#include <gtest/gtest.h>
+
+#include "SystemLoad.hpp"
+
+TEST(TestSystemLoad, testParseLoadAverage) {
+  EXPECT_DOUBLE_EQ(
+      brilliant::wp::parseLoadAverage("3.52 2.10 1.05 4/1024 31337\n")
+          .value(),
+      3.52);
+  EXPECT_FALSE(brilliant::wp::parseLoadAverage("").has_value());
+  EXPECT_FALSE(brilliant::wp::parseLoadAverage("load").has_value());
+}
+
+TEST(TestSystemLoad, testParsePressure) {
+  constexpr auto cpu =
+      "some avg10=12.50 avg60=3.00 avg300=0.75 total=123456\n"
+      "full avg10=1.00 avg60=0.00 avg300=0.00 total=1000\n";
+  EXPECT_DOUBLE_EQ(brilliant::wp::parsePressure(cpu).value(), 12.5);
+  EXPECT_FALSE(brilliant::wp::parsePressure("").has_value());
+  EXPECT_FALSE(
+      brilliant::wp::parsePressure("full avg10=1.00 avg60=0.00\n")
+          .has_value());
+  EXPECT_FALSE(
+      brilliant::wp::parsePressure("some avg60=3.00 total=1\n").has_value());
+}
+
+TEST(TestSystemLoad, testExceeds) {
+  brilliant::wp::LoadSample sample;
+  // nothing measured is never busy
+  EXPECT_FALSE(sample.exceeds(0.8, 20.0));
+
+  sample.load = 0.5;
+  sample.cpuPressure = 10.0;
+  EXPECT_FALSE(sample.exceeds(0.8, 20.0));
+  EXPECT_TRUE(sample.exceeds(0.4, 20.0));
+
+  sample.memoryPressure = 25.0;
+  EXPECT_TRUE(sample.exceeds(0.8, 20.0));
+}
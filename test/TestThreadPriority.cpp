@@ -0,0 +1,59 @@
+/**
+ *
+ *  @file      TestThreadPriority.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Tests the thread scheduling functions
+ */
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <exception>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "ThreadPriority.hpp"
+
+namespace {
+  /**
+   * @brief Run a function on a thread of its own
+   * @param f The function
+   *
+   * Keeps the test runner's thread at its normal priority, which cannot
+   * be restored on POSIX.
+   */
+  template <class F>
+  void onNewThread(F f) {
+    std::exception_ptr error;
+    std::thread([&] {
+      try {
+        f();
+      } catch (...) {
+        error = std::current_exception();
+      }
+    }).join();
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}  // namespace
+
+TEST(TestThreadPriority, testLowerThreadPriority) {
+  EXPECT_NO_THROW(onNewThread([] { brilliant::wp::lowerThreadPriority(); }));
+}
+
+TEST(TestThreadPriority, testSetThreadAffinity) {
+  // every CPU, and the first one, which always exists
+  EXPECT_NO_THROW(onNewThread([] {
+    brilliant::wp::setThreadAffinity({});
+    const std::vector<std::uint32_t> first{0};
+    brilliant::wp::setThreadAffinity(first);
+  }));
+
+  const std::vector<std::uint32_t> missing{1u << 20};
+  EXPECT_THROW(
+      onNewThread([&] { brilliant::wp::setThreadAffinity(missing); }),
+      std::system_error);
+}
@@ -0,0 +1,212 @@
+/**
+ *
+ *  @file      TestTileCache.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Unit tests for sharing scaled tiles between monitors
+ */
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+
+#include "TileCache.hpp"
+
+namespace {
+  using namespace std::chrono_literals;
+
+  /**
+   * @brief Makes tiles and counts how many it made
+   */
+  struct CountingFactory {
+    /**
+     * @brief Make a tile
+     * @return A 2x2 tile
+     */
+    boost::gil::rgb8_image_t operator()() {
+      ++*made;
+      return boost::gil::rgb8_image_t(2, 2);
+    }
+
+    //! The number of tiles made
+    int* made;
+  };
+}  // namespace
+
+TEST(TestTileCache, testMissThenHit) {
+  brilliant::wp::TileCache cache(2, 4);
+  int made = 0;
+  const auto first = cache.get(0, 7, 2, 2, CountingFactory{&made});
+  const auto second = cache.get(0, 7, 2, 2, CountingFactory{&made});
+  EXPECT_EQ(made, 1);
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(cache.hits(), 1u);
+  EXPECT_EQ(cache.size(), 1u);
+}
+
+TEST(TestTileCache, testDistinctKeys) {
+  brilliant::wp::TileCache cache(2, 4);
+  int made = 0;
+  cache.get(0, 7, 2, 2, CountingFactory{&made});
+  cache.get(0, 8, 2, 2, CountingFactory{&made});
+  cache.get(0, 7, 3, 2, CountingFactory{&made});
+  cache.get(0, 7, 2, 3, CountingFactory{&made});
+  cache.get(1, 7, 2, 2, CountingFactory{&made});
+  EXPECT_EQ(made, 5);
+  EXPECT_EQ(cache.hits(), 0u);
+  EXPECT_EQ(cache.size(), 5u);
+}
+
+TEST(TestTileCache, testFinishRoundReleases) {
+  brilliant::wp::TileCache cache(2, 4);
+  int made = 0;
+  cache.get(0, 7, 2, 2, CountingFactory{&made});
+  cache.get(1, 7, 2, 2, CountingFactory{&made});
+
+  EXPECT_FALSE(cache.finishRound(0));
+  EXPECT_EQ(cache.size(), 2u);
+  EXPECT_TRUE(cache.finishRound(0));
+  // only the finished round is released
+  EXPECT_EQ(cache.size(), 1u);
+
+  cache.get(0, 7, 2, 2, CountingFactory{&made});
+  EXPECT_EQ(made, 3);
+}
+
+TEST(TestTileCache, testSkippedRoundIsReleased) {
+  brilliant::wp::TileCache cache(2, 4);
+  int made = 0;
+  cache.get(0, 7, 2, 2, CountingFactory{&made});
+  EXPECT_FALSE(cache.finishRound(0));
+  // the other monitor showed an old wallpaper instead of drawing round 0
+  EXPECT_TRUE(cache.finishRound(0));
+  EXPECT_EQ(cache.size(), 0u);
+}
+
+TEST(TestTileCache, testExceptionReachesWaiter) {
+  brilliant::wp::TileCache cache(2, 4);
+  std::promise<void> started;
+  std::promise<void> release;
+  auto failing = std::async(std::launch::async, [&] {
+    return cache.get(0, 7, 2, 2, [&]() -> boost::gil::rgb8_image_t {
+      started.set_value();
+      release.get_future().wait();
+      throw std::runtime_error("corrupt");
+    });
+  });
+  started.get_future().wait();
+
+  int made = 0;
+  auto waiting = std::async(std::launch::async, [&] {
+    return cache.get(0, 7, 2, 2, CountingFactory{&made});
+  });
+  // give the waiter time to find the tile being made
+  while (cache.hits() == 0) {
+    std::this_thread::sleep_for(1ms);
+  }
+  release.set_value();
+
+  EXPECT_THROW(failing.get(), std::runtime_error);
+  EXPECT_THROW(waiting.get(), std::runtime_error);
+  EXPECT_EQ(made, 0);
+
+  // a failed tile is not kept, so the next caller tries again
+  EXPECT_EQ(cache.size(), 0u);
+  EXPECT_NE(cache.get(0, 7, 2, 2, CountingFactory{&made}), nullptr);
+  EXPECT_EQ(made, 1);
+}
+
+TEST(TestTileCache, testLeave) {
+  brilliant::wp::TileCache cache(3, 4);
+  int made = 0;
+  cache.get(0, 7, 2, 2, CountingFactory{&made});
+  cache.get(1, 7, 2, 2, CountingFactory{&made});
+  EXPECT_FALSE(cache.finishRound(0));
+  EXPECT_FALSE(cache.finishRound(0));
+  EXPECT_FALSE(cache.finishRound(1));
+
+  // the third monitor changes resolution before finishing round 0, the
+  // two left have finished round 0 between them
+  cache.leave(0);
+  EXPECT_EQ(cache.size(), 1u);
+  EXPECT_TRUE(cache.finishRound(1));
+  EXPECT_EQ(cache.size(), 0u);
+}
+
+TEST(TestTileCache, testLeaveAfterFinishing) {
+  brilliant::wp::TileCache cache(2, 4);
+  int made = 0;
+  cache.get(0, 7, 2, 2, CountingFactory{&made});
+  EXPECT_FALSE(cache.finishRound(0));
+  // the monitor which finished round 0 leaves, nobody else has
+  cache.leave(1);
+  EXPECT_EQ(cache.size(), 1u);
+  EXPECT_TRUE(cache.finishRound(0));
+  EXPECT_EQ(cache.size(), 0u);
+}
+
+TEST(TestTileCache, testLagIsBounded) {
+  brilliant::wp::TileCache cache(2, 3);
+  int made = 0;
+  // one monitor races ahead while the other is stuck on round 0
+  for (std::uint64_t round = 0; round < 10; ++round) {
+    cache.get(round, 7, 2, 2, CountingFactory{&made});
+    EXPECT_FALSE(cache.finishRound(round));
+    EXPECT_LE(cache.size(), 3u);
+  }
+  EXPECT_EQ(cache.oldestRound(), 7u);
+
+  // the laggard still gets its tiles, they are just not kept
+  const auto size = cache.size();
+  EXPECT_NE(cache.get(0, 7, 2, 2, CountingFactory{&made}), nullptr);
+  EXPECT_EQ(made, 11);
+  EXPECT_EQ(cache.size(), size);
+  // and finishing a released round changes nothing
+  EXPECT_FALSE(cache.finishRound(0));
+  EXPECT_EQ(cache.size(), size);
+
+  // once it catches up it shares again
+  cache.get(cache.oldestRound(), 7, 2, 2, CountingFactory{&made});
+  EXPECT_EQ(made, 11);
+  EXPECT_TRUE(cache.finishRound(cache.oldestRound()));
+}
+
+TEST(TestTileCache, testReuseKeepsMonitorsInStep) {
+  brilliant::wp::TileCache cache(2, 3);
+  int made = 0;
+  for (std::uint64_t round = 0; round < 20; ++round) {
+    cache.get(round, 7, 2, 2, CountingFactory{&made});
+    cache.finishRound(round);
+    // the other monitor is busy every other round and shows an old
+    // wallpaper again instead of drawing
+    if (round % 2 == 0) {
+      EXPECT_TRUE(cache.finishRound(round));
+    } else {
+      cache.get(round, 7, 2, 2, CountingFactory{&made});
+      EXPECT_TRUE(cache.finishRound(round));
+    }
+    EXPECT_EQ(cache.size(), 0u);
+  }
+  EXPECT_EQ(made, 20);
+  EXPECT_EQ(cache.hits(), 10u);
+}
+
+TEST(TestTileCache, testKeptTilesAreTracked) {
+  brilliant::wp::MemoryBudget budget(0);
+  brilliant::wp::TileCache cache(2, 4, &budget);
+  int made = 0;
+  auto tile = cache.get(0, 7, 2, 2, CountingFactory{&made});
+  EXPECT_EQ(budget.used(), 2u * 2 * 3);
+  cache.get(0, 8, 2, 2, CountingFactory{&made});
+  EXPECT_EQ(budget.used(), 2u * 2 * 3 * 2);
+
+  cache.finishRound(0);
+  cache.finishRound(0);
+  // the tile is counted until the last wallpaper using it lets go
+  EXPECT_EQ(budget.used(), 2u * 2 * 3);
+  tile.reset();
+  EXPECT_EQ(budget.used(), 0u);
+}
@@ -10,7 +10,12 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <filesystem>
+#include <format>
 #include <fstream>
+#include <map>
+#include <sstream>
 
 #include "TomlConfigBuilder.hpp"
 
@@ -24,6 +29,8 @@ TEST(TestTomlConfigBuilder, testBuildGoodfileIstream) {
 
   EXPECT_EQ(config->globalTransitionDelay, std::chrono::minutes{10});
   EXPECT_EQ(config->monitors.size(), 2);
+  EXPECT_EQ(config->background, 0u);
+  EXPECT_EQ(config->bandHeight, 0u);
   EXPECT_EQ(config->monitors[2].backgroundPaths.size(), 1);
   EXPECT_EQ(config->monitors[2].backgroundPaths[0].string(), "testfile.png");
   EXPECT_TRUE(config->monitors[2].index.has_value());
@@ -70,4 +77,326 @@ TEST(TestTomlConfigBuilder, testBuildNottoml) {
   }
 
   EXPECT_THROW(builder.build("files/nottoml.toml"), brilliant::wp::ConfigError);
-}
\ No newline at end of file
+}
+
+TEST(TestTomlConfigBuilder, testBuildDelayUnits) {
+  brilliant::wp::TomlConfigBuilder builder;
+  std::optional<brilliant::wp::Config> config;
+  EXPECT_NO_THROW(config.emplace(builder.build("files/delays.toml")));
+
+  EXPECT_EQ(config->globalTransitionDelay, std::chrono::milliseconds{2500});
+  EXPECT_EQ(config->prefetch, 4u);
+  EXPECT_EQ(config->background, 0x1e2a3bu);
+  EXPECT_EQ(config->maxDecodePixels, 1'000'000u);
+  EXPECT_EQ(config->maxFileSize, 64u << 20);
+  EXPECT_EQ(config->bandHeight, 64u);
+  EXPECT_EQ(config->monitors[0].transitionDelay.value(),
+            std::chrono::milliseconds{250});
+  EXPECT_EQ(config->monitors[1].transitionDelay.value(),
+            std::chrono::hours{2});
+}
+
+TEST(TestTomlConfigBuilder, testBuildBadDelay) {
+  brilliant::wp::TomlConfigBuilder builder;
+  EXPECT_THROW(builder.build("files/baddelay.toml"),
+               brilliant::wp::ConfigError);
+
+  // units the README does not list and delays too long to count
+  for (const auto* delay :
+       {"'5min'", "'1e300h'", "'infs'", "'nanms'", "'8761h'",
+        "9223372036854775807", "525601"}) {
+    std::stringstream toml;
+    toml << "transitionDelay = " << delay
+         << "\nmonitors = [{ wallpapers = ['a.jpg'] }]\n";
+    EXPECT_THROW(builder.build(toml), brilliant::wp::ConfigError) << delay;
+  }
+}
+
+TEST(TestTomlConfigBuilder, testBuildBadBackground) {
+  brilliant::wp::TomlConfigBuilder builder;
+  EXPECT_THROW(builder.build("files/badbackground.toml"),
+               brilliant::wp::ConfigError);
+}
+
+TEST(TestTomlConfigBuilder, testBuildWeights) {
+  brilliant::wp::TomlConfigBuilder builder;
+  std::optional<brilliant::wp::Config> config;
+  EXPECT_NO_THROW(config.emplace(builder.build("files/weights.toml")));
+
+  const auto& monitor = config->monitors[0];
+  ASSERT_EQ(monitor.backgroundPaths.size(), 4u);
+  EXPECT_EQ(monitor.backgroundPaths[0].string(), "new_uploads.png");
+  EXPECT_EQ(monitor.backgroundPaths[2].string(), "archive.bmp");
+  EXPECT_THAT(monitor.weights, ::testing::ElementsAre(5.0f, 1.0f, 0.2f, 1.0f));
+
+  // entries without a weight default to 1
+  EXPECT_NO_THROW(config.emplace(builder.build("files/goodfile.toml")));
+  EXPECT_THAT(config->monitors[0].weights, ::testing::ElementsAre(1.0f, 1.0f));
+}
+
+TEST(TestTomlConfigBuilder, testBuildBadWeight) {
+  brilliant::wp::TomlConfigBuilder builder;
+  EXPECT_THROW(builder.build("files/badweight.toml"),
+               brilliant::wp::ConfigError);
+
+  std::stringstream huge;
+  huge << "monitors = [{ wallpapers = [{ path = 'a.jpg', weight = 1e30 }] }]\n";
+  EXPECT_THROW(builder.build(huge), brilliant::wp::ConfigError);
+}
+
+TEST(TestTomlConfigBuilder, testBuildNestedTree) {
+  const auto dir =
+      std::filesystem::temp_directory_path() / "brilliant_wp_config_tree";
+  std::filesystem::remove_all(dir);
+  // about 20000 files at every level of a tree three folders deep
+  constexpr int outerFolders = 4;
+  constexpr int subfolders = 5;
+  constexpr int filesPerFolder = 160;
+  const auto fill = [](const std::filesystem::path& folder) {
+    std::filesystem::create_directories(folder);
+    for (int file = 0; file < filesPerFolder; ++file) {
+      std::ofstream(folder / std::format("{:03}.jpg", file));
+    }
+  };
+  for (int outer = 0; outer < outerFolders; ++outer) {
+    const auto outerDir = dir / std::format("{}", outer);
+    fill(outerDir);
+    for (int middle = 0; middle < subfolders; ++middle) {
+      const auto middleDir = outerDir / std::format("{}", middle);
+      fill(middleDir);
+      for (int inner = 0; inner < subfolders; ++inner) {
+        fill(middleDir / std::format("{}", inner));
+      }
+    }
+  }
+  constexpr int filesPerOuter =
+      (1 + subfolders + subfolders * subfolders) * filesPerFolder;
+
+  // one monitor with an index and one without, each on half of the tree
+  std::stringstream toml;
+  toml << std::format(
+      "monitors = [\n"
+      "  {{ wallpapers = ['{0}/0', '{0}/1'], index = 1 }},\n"
+      "  {{ wallpapers = ['{0}/2', '{0}/3'] }},\n"
+      "]\n",
+      dir.generic_string());
+
+  std::map<std::filesystem::path, int> walks;
+  brilliant::wp::TomlConfigBuilder builder(
+      [&walks](const std::filesystem::path& folder,
+               const brilliant::wp::ScanOptions& options) {
+        ++walks[folder];
+        return brilliant::wp::scanFolder(folder, options);
+      });
+  std::optional<brilliant::wp::Config> config;
+  EXPECT_NO_THROW(config.emplace(builder.build(toml)));
+  ASSERT_EQ(config->monitors.size(), 2u);
+
+  // indexed or not, each monitor's folders are walked once
+  EXPECT_EQ(walks.size(), static_cast<std::size_t>(outerFolders));
+  for (const auto& [folder, count] : walks) {
+    EXPECT_EQ(count, 1) << folder;
+  }
+
+  for (auto& [index, monitor] : config->monitors) {
+    auto& paths = monitor.backgroundPaths;
+    EXPECT_EQ(std::ranges::count_if(paths,
+                                    [](const auto& path) {
+                                      return path.extension() == ".jpg";
+                                    }),
+              2 * filesPerOuter)
+        << "monitor " << index;
+    EXPECT_EQ(monitor.weights.size(), paths.size());
+    std::ranges::sort(paths);
+    EXPECT_EQ(std::ranges::adjacent_find(paths), paths.end())
+        << "monitor " << index;
+  }
+
+  std::filesystem::remove_all(dir);
+}
+
+TEST(TestTomlConfigBuilder, testBuildScanOptions) {
+  const auto dir =
+      std::filesystem::temp_directory_path() / "brilliant_wp_config_scan";
+  std::filesystem::remove_all(dir);
+  for (const auto* file : {"a.png", "b.jpg", "skip/c.png", "sub/d.PNG",
+                           "sub/deeper/e.png", "sub/f.png.xmp"}) {
+    std::filesystem::create_directories((dir / file).parent_path());
+    std::ofstream(dir / file);
+  }
+
+  std::stringstream toml;
+  toml << std::format(
+      "monitors = [{{ wallpapers = ['{}'], extensions = ['png'], "
+      "exclude = ['skip'], maxDepth = 1 }}]\n",
+      dir.generic_string());
+
+  brilliant::wp::TomlConfigBuilder builder;
+  std::optional<brilliant::wp::Config> config;
+  EXPECT_NO_THROW(config.emplace(builder.build(toml)));
+  auto paths = config->monitors[0].backgroundPaths;
+  std::ranges::sort(paths);
+  EXPECT_THAT(paths, ::testing::ElementsAre(dir / "a.png", dir / "sub/d.PNG"));
+
+  std::filesystem::remove_all(dir);
+}
+
+TEST(TestTomlConfigBuilder, testBuildArchive) {
+  // an archive is filtered like a folder and its members keep their place
+  std::stringstream toml;
+  toml << "monitors = [{ wallpapers = ['files/sources.zip', 'a.jpg'], "
+          "extensions = ['png'], exclude = ['skip'] }]\n";
+
+  brilliant::wp::TomlConfigBuilder builder;
+  std::optional<brilliant::wp::Config> config;
+  EXPECT_NO_THROW(config.emplace(builder.build(toml)));
+  const auto& monitor = config->monitors[0];
+  const std::filesystem::path zip("files/sources.zip");
+  EXPECT_THAT(monitor.backgroundPaths,
+              ::testing::ElementsAre(zip / "photos/gray_alpha8.png",
+                                     zip / "photos/rgba16.png", "a.jpg"));
+  EXPECT_EQ(monitor.weights.size(), 3u);
+  EXPECT_THAT(monitor.archives, ::testing::ElementsAre(zip));
+  ASSERT_EQ(monitor.archiveMembers.size(), 2u);
+  EXPECT_EQ(monitor.archiveMembers[1].source, 1u);
+  EXPECT_EQ(monitor.archiveMembers[1].archive, 0u);
+  EXPECT_EQ(monitor.archiveMembers[1].location.kind,
+            brilliant::wp::MemberKind::zipDeflated);
+}
+
+TEST(TestTomlConfigBuilder, testBuildBadArchive) {
+  const auto path =
+      std::filesystem::temp_directory_path() / "brilliant_wp_bad.tar";
+  std::ofstream(path) << std::string(512, 'x');
+  std::stringstream toml;
+  toml << std::format("monitors = [{{ wallpapers = ['{}'] }}]\n",
+                      path.generic_string());
+
+  brilliant::wp::TomlConfigBuilder builder;
+  EXPECT_THROW(builder.build(toml), brilliant::wp::ConfigError);
+  std::filesystem::remove(path);
+}
+
+TEST(TestTomlConfigBuilder, testBuildBadScanOptions) {
+  brilliant::wp::TomlConfigBuilder builder;
+  for (const auto* option :
+       {"maxDepth = -1", "extensions = []", "include = 'a'",
+        "exclude = [1]"}) {
+    std::stringstream toml;
+    toml << std::format("monitors = [{{ wallpapers = ['a.jpg'], {} }}]\n",
+                        option);
+    EXPECT_THROW(builder.build(toml), brilliant::wp::ConfigError) << option;
+  }
+}
+
+TEST(TestTomlConfigBuilder, testBuildThreads) {
+  brilliant::wp::TomlConfigBuilder builder;
+  std::optional<brilliant::wp::Config> config;
+  EXPECT_NO_THROW(config.emplace(builder.build("files/goodfile.toml")));
+  EXPECT_EQ(config->ioThreads, 4u);
+  EXPECT_EQ(config->cpuThreads, 0u);
+  EXPECT_FALSE(config->lowPriority);
+  EXPECT_TRUE(config->cpuAffinity.empty());
+  EXPECT_FALSE(config->deferWhenBusy);
+  EXPECT_DOUBLE_EQ(config->busyLoad, 0.8);
+  EXPECT_DOUBLE_EQ(config->busyPressure, 20.0);
+
+  std::stringstream toml;
+  toml << "ioThreads = 1\ncpuThreads = 3\nlowPriority = true\n"
+          "cpuAffinity = [2, 3]\nmonitors = [{ wallpapers = ['a.jpg'] }]\n";
+  EXPECT_NO_THROW(config.emplace(builder.build(toml)));
+  EXPECT_EQ(config->ioThreads, 1u);
+  EXPECT_EQ(config->cpuThreads, 3u);
+  EXPECT_TRUE(config->lowPriority);
+  EXPECT_THAT(config->cpuAffinity, ::testing::ElementsAre(2u, 3u));
+}
+
+TEST(TestTomlConfigBuilder, testBuildBadThreads) {
+  brilliant::wp::TomlConfigBuilder builder;
+  for (const auto* option :
+       {"ioThreads = 0", "cpuThreads = -1", "lowPriority = 1",
+        "cpuAffinity = 3", "cpuAffinity = [-1]"}) {
+    std::stringstream toml;
+    toml << std::format("{}\nmonitors = [{{ wallpapers = ['a.jpg'] }}]\n",
+                        option);
+    EXPECT_THROW(builder.build(toml), brilliant::wp::ConfigError) << option;
+  }
+}
+
+TEST(TestTomlConfigBuilder, testBuildBusyThresholds) {
+  brilliant::wp::TomlConfigBuilder builder;
+  std::optional<brilliant::wp::Config> config;
+  std::stringstream toml;
+  toml << "deferWhenBusy = true\nbusyLoad = 1\nbusyPressure = 5.5\n"
+          "monitors = [{ wallpapers = ['a.jpg'] }]\n";
+  EXPECT_NO_THROW(config.emplace(builder.build(toml)));
+  EXPECT_TRUE(config->deferWhenBusy);
+  EXPECT_DOUBLE_EQ(config->busyLoad, 1.0);
+  EXPECT_DOUBLE_EQ(config->busyPressure, 5.5);
+
+  for (const auto* option :
+       {"deferWhenBusy = 'yes'", "busyLoad = 0", "busyPressure = -1"}) {
+    std::stringstream bad;
+    bad << std::format("{}\nmonitors = [{{ wallpapers = ['a.jpg'] }}]\n",
+                       option);
+    EXPECT_THROW(builder.build(bad), brilliant::wp::ConfigError) << option;
+  }
+}
+
+TEST(TestTomlConfigBuilder, testBuildMemoryBudget) {
+  brilliant::wp::TomlConfigBuilder builder;
+  std::optional<brilliant::wp::Config> config;
+  std::stringstream toml;
+  toml << "memoryBudget = '1536MB'\nmonitors = [{ wallpapers = ['a.jpg'] }]\n";
+  EXPECT_NO_THROW(config.emplace(builder.build(toml)));
+  EXPECT_EQ(config->memoryBudget, 1536ull << 20);
+
+  std::stringstream unset;
+  unset << "monitors = [{ wallpapers = ['a.jpg'] }]\n";
+  EXPECT_NO_THROW(config.emplace(builder.build(unset)));
+  EXPECT_EQ(config->memoryBudget, 0u);
+
+  std::stringstream bad;
+  bad << "memoryBudget = 'lots'\nmonitors = [{ wallpapers = ['a.jpg'] }]\n";
+  EXPECT_THROW(builder.build(bad), brilliant::wp::ConfigError);
+}
+
+TEST(TestTomlConfigBuilder, testBuildSizeOverflow) {
+  brilliant::wp::TomlConfigBuilder builder;
+  std::optional<brilliant::wp::Config> config;
+  // the largest size of each unit which fits in 64 bits
+  std::stringstream largest;
+  largest << "memoryBudget = '17179869183GB'\n"
+             "maxFileSize = '17592186044415MB'\n"
+             "monitors = [{ wallpapers = ['a.jpg'] }]\n";
+  EXPECT_NO_THROW(config.emplace(builder.build(largest)));
+  EXPECT_EQ(config->memoryBudget, 17179869183ull << 30);
+  EXPECT_EQ(config->maxFileSize, 17592186044415ull << 20);
+
+  for (const auto* option :
+       {"memoryBudget = '17179869184GB'", "memoryBudget = '17592186044416MB'",
+        "maxFileSize = '18014398509481984KB'"}) {
+    std::stringstream bad;
+    bad << std::format("{}\nmonitors = [{{ wallpapers = ['a.jpg'] }}]\n",
+                       option);
+    EXPECT_THROW(builder.build(bad), brilliant::wp::ConfigError) << option;
+  }
+}
+
+TEST(TestTomlConfigBuilder, testBuildBlurGutters) {
+  brilliant::wp::TomlConfigBuilder builder;
+  std::optional<brilliant::wp::Config> config;
+  std::stringstream unset;
+  unset << "monitors = [{ wallpapers = ['a.jpg'] }]\n";
+  EXPECT_NO_THROW(config.emplace(builder.build(unset)));
+  EXPECT_FALSE(config->blurGutters);
+
+  std::stringstream on;
+  on << "blurGutters = true\nmonitors = [{ wallpapers = ['a.jpg'] }]\n";
+  EXPECT_NO_THROW(config.emplace(builder.build(on)));
+  EXPECT_TRUE(config->blurGutters);
+
+  std::stringstream bad;
+  bad << "blurGutters = 'no'\nmonitors = [{ wallpapers = ['a.jpg'] }]\n";
+  EXPECT_THROW(builder.build(bad), brilliant::wp::ConfigError);
+}
@@ -0,0 +1,245 @@
+/**
+ *
+ *  @file      TestTransitionLoop.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Unit tests for the coroutines which schedule each monitor's transitions
+ */
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
+
+#include "MockWallpaperSetter.hpp"
+#include "TransitionLoop.hpp"
+
+using ::testing::Eq;
+using ::testing::InvokeWithoutArgs;
+
+namespace {
+  using namespace std::chrono_literals;
+
+  /**
+   * @brief Runs a monitor's transition loop on a timer context the way
+   * App::runMonitor does, setting wallpapers on a mock
+   */
+  class TestTransitionLoop : public ::testing::Test {
+  protected:
+    /**
+     * @brief Start the transition loop
+     * @param first How long until the first queued wallpaper is due
+     */
+    void start(std::chrono::steady_clock::duration first) {
+      deadline = std::chrono::steady_clock::now() + first;
+      boost::asio::co_spawn(
+          context,
+          brilliant::wp::runTransitions(
+              timer, queue, deadline, delay, stats,
+              [this](std::filesystem::path path, std::uint64_t late) {
+                missed.push_back(late);
+                setter.setWallpaper(0, path);
+              }),
+          [this](const std::exception_ptr& e) {
+            if (e) {
+              std::rethrow_exception(e);
+            }
+            finished = true;
+          });
+    }
+
+    /**
+     * @brief Stop the loop the way App::stop does
+     */
+    void stop() {
+      boost::asio::post(context, [this] {
+        timer.cancel();
+        queue.close();
+      });
+    }
+
+    /**
+     * @brief Push a wallpaper from the timer context after a while, as a
+     * producer finishing a render would
+     * @param after How long until the wallpaper is ready
+     * @param path The wallpaper
+     */
+    void pushAfter(std::chrono::steady_clock::duration after,
+                   std::filesystem::path path) {
+      producerTimer.expires_after(after);
+      producerTimer.async_wait(
+          [this, path](const boost::system::error_code&) {
+            queue.push(path);
+          });
+    }
+
+    //! The timer context
+    boost::asio::io_context context;
+
+    //! The monitor's timer
+    boost::asio::steady_timer timer{context};
+
+    //! Stands in for a producer's render
+    boost::asio::steady_timer producerTimer{context};
+
+    //! The wallpapers rendered ahead
+    brilliant::wp::AsyncQueue<std::filesystem::path> queue{
+        context.get_executor(), 4};
+
+    //! When the next wallpaper is due
+    std::chrono::steady_clock::time_point deadline;
+
+    //! The time between transitions
+    std::chrono::steady_clock::duration delay = 20ms;
+
+    //! The monitor's counters
+    brilliant::wp::MonitorStats stats;
+
+    //! The deadlines missed by each transition
+    std::vector<std::uint64_t> missed;
+
+    //! Set once the loop has returned
+    bool finished = false;
+
+    //! Stands in for the OS
+    ::testing::StrictMock<MockWallpaperSetterImpl> setter;
+  };
+}  // namespace
+
+TEST_F(TestTransitionLoop, testSetsInOrder) {
+  queue.push("a.jpg");
+  queue.push("b.jpg");
+  queue.push("c.jpg");
+  {
+    ::testing::InSequence sequence;
+    EXPECT_CALL(setter, setWallpaper(0, Eq("a.jpg")));
+    EXPECT_CALL(setter, setWallpaper(0, Eq("b.jpg")));
+    EXPECT_CALL(setter, setWallpaper(0, Eq("c.jpg")))
+        .WillOnce(InvokeWithoutArgs([this] { stop(); }));
+  }
+
+  const auto begin = std::chrono::steady_clock::now();
+  start(0ms);
+  context.run();
+
+  EXPECT_TRUE(finished);
+  EXPECT_EQ(stats.transitions, 3u);
+  EXPECT_EQ(stats.missedDeadlines, 0u);
+  EXPECT_EQ(missed, std::vector<std::uint64_t>(3, 0));
+  // each transition waits for its deadline rather than firing at once
+  EXPECT_GE(std::chrono::steady_clock::now() - begin, 2 * delay);
+}
+
+TEST_F(TestTransitionLoop, testStopCancelsDeadline) {
+  queue.push("a.jpg");
+  start(1h);
+  stop();
+
+  const auto begin = std::chrono::steady_clock::now();
+  context.run();
+
+  EXPECT_TRUE(finished);
+  EXPECT_LT(std::chrono::steady_clock::now() - begin, 1s);
+  EXPECT_EQ(stats.transitions, 0u);
+}
+
+TEST_F(TestTransitionLoop, testStopWhileWaitingForWallpaper) {
+  start(0ms);
+  producerTimer.expires_after(20ms);
+  producerTimer.async_wait([this](const boost::system::error_code&) {
+    stop();
+  });
+
+  context.run();
+
+  EXPECT_TRUE(finished);
+  EXPECT_EQ(stats.transitions, 0u);
+  EXPECT_EQ(stats.missedDeadlines, 0u);
+}
+
+TEST_F(TestTransitionLoop, testLateWallpaperIsSetWhenReady) {
+  delay = 1s;
+  pushAfter(50ms, "late.jpg");
+  EXPECT_CALL(setter, setWallpaper(0, Eq("late.jpg")))
+      .WillOnce(InvokeWithoutArgs([this] { stop(); }));
+
+  start(0ms);
+  context.run();
+
+  EXPECT_TRUE(finished);
+  EXPECT_EQ(stats.transitions, 1u);
+  EXPECT_EQ(stats.missedDeadlines, 1u);
+  EXPECT_EQ(missed, std::vector<std::uint64_t>{1});
+  EXPECT_GE(stats.worstLateness, 50ms);
+}
+
+TEST_F(TestTransitionLoop, testRendersOffTimerContext) {
+  boost::asio::thread_pool workers(1);
+  std::atomic_bool rendered = false;
+  std::thread::id renderThread;
+  std::thread::id resumeThread;
+
+  // a render which takes far longer than the delay
+  boost::asio::co_spawn(
+      context,
+      [&]() -> boost::asio::awaitable<void> {
+        auto path = co_await brilliant::wp::runOn(
+            workers.get_executor(), [&] {
+              renderThread = std::this_thread::get_id();
+              std::this_thread::sleep_for(200ms);
+              rendered = true;
+              return std::filesystem::path("rendered.jpg");
+            });
+        resumeThread = std::this_thread::get_id();
+        queue.push(std::move(path));
+      },
+      boost::asio::detached);
+
+  queue.push("ready.jpg");
+  {
+    ::testing::InSequence sequence;
+    // set on time while the render is still going
+    EXPECT_CALL(setter, setWallpaper(0, Eq("ready.jpg")))
+        .WillOnce(InvokeWithoutArgs([&] { EXPECT_FALSE(rendered); }));
+    EXPECT_CALL(setter, setWallpaper(0, Eq("rendered.jpg")))
+        .WillOnce(InvokeWithoutArgs([this] { stop(); }));
+  }
+
+  start(10ms);
+  context.run();
+  workers.join();
+
+  EXPECT_TRUE(finished);
+  EXPECT_NE(renderThread, std::this_thread::get_id());
+  EXPECT_EQ(resumeThread, std::this_thread::get_id());
+}
+
+TEST_F(TestTransitionLoop, testLateWallpaperSkipsPassedDeadlines) {
+  delay = 100ms;
+  pushAfter(250ms, "late.jpg");
+  EXPECT_CALL(setter, setWallpaper(0, Eq("late.jpg")))
+      .WillOnce(InvokeWithoutArgs([this] { stop(); }));
+
+  start(0ms);
+  const auto first = deadline;
+  context.run();
+
+  // the deadline it was due at and the two which passed while waiting are
+  // each counted once
+  EXPECT_EQ(stats.transitions, 1u);
+  EXPECT_EQ(stats.missedDeadlines, 3u);
+  EXPECT_EQ(missed, std::vector<std::uint64_t>{3});
+  EXPECT_EQ(deadline, first + 3 * delay);
+}
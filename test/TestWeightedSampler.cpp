@@ -0,0 +1,148 @@
+/**
+ *
+ *  @file      TestWeightedSampler.cpp
+ *  @author    David Brill
+ *  @copyright  David Brill, 2024. All right reserved.
+ *
+ *  Unit tests for the WeightedSampler class
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "WeightedSampler.hpp"
+
+TEST(TestWeightedSampler, testProportions) {
+  brilliant::wp::WeightedSampler sampler;
+  const std::vector<double> weights{5.0, 1.0, 0.0, 0.2, 1.0};
+  for (const auto weight : weights) {
+    sampler.push(weight);
+  }
+  EXPECT_EQ(sampler.size(), weights.size());
+  EXPECT_EQ(sampler.total(), 7 * brilliant::wp::WeightedSampler::weightScale +
+                                 205);
+
+  std::mt19937 mt(0);
+  constexpr int draws = 200000;
+  std::vector<int> counts(weights.size());
+  for (int i = 0; i < draws; ++i) {
+    ++counts.at(sampler.sample(mt));
+  }
+  EXPECT_EQ(counts[2], 0);
+  for (std::size_t i = 0; i < weights.size(); ++i) {
+    EXPECT_NEAR(counts[i] / static_cast<double>(draws), weights[i] / 7.2,
+                0.01)
+        << "index " << i;
+  }
+}
+
+TEST(TestWeightedSampler, testSet) {
+  brilliant::wp::WeightedSampler sampler;
+  for (int i = 0; i < 37; ++i) {
+    sampler.push(1.0);
+  }
+  for (std::size_t i = 0; i < sampler.size(); ++i) {
+    if (i != 20) {
+      sampler.set(i, 0.0);
+    }
+  }
+  EXPECT_EQ(sampler.total(), brilliant::wp::WeightedSampler::weightScale);
+
+  std::mt19937 mt(1);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(sampler.sample(mt), 20u);
+  }
+
+  sampler.set(20, 0.0);
+  sampler.set(36, 3.0);
+  sampler.push(0.0);
+  EXPECT_EQ(sampler.total(), 3 * brilliant::wp::WeightedSampler::weightScale);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(sampler.sample(mt), 36u);
+  }
+
+  // any positive weight can be picked
+  sampler.set(0, 1e-9);
+  EXPECT_EQ(sampler.total(),
+            3 * brilliant::wp::WeightedSampler::weightScale + 1);
+}
+
+TEST(TestWeightedSampler, testHugeWeightsClamped) {
+  brilliant::wp::WeightedSampler sampler;
+  sampler.push(1e30);
+  sampler.push(std::numeric_limits<double>::infinity());
+  sampler.push(brilliant::wp::WeightedSampler::maxWeight);
+  const auto max = static_cast<std::uint64_t>(
+      brilliant::wp::WeightedSampler::maxWeight *
+      brilliant::wp::WeightedSampler::weightScale);
+  EXPECT_EQ(sampler.weight(0), max);
+  EXPECT_EQ(sampler.weight(1), max);
+  EXPECT_EQ(sampler.total(), 3 * max);
+}
+
+TEST(TestWeightedSampler, testMillionItems) {
+  brilliant::wp::WeightedSampler sampler;
+  constexpr std::size_t count = 1'000'000;
+  for (std::size_t i = 0; i < count; ++i) {
+    // every other item is new and weighted five times the archive
+    sampler.push(i % 2 ? 0.2 : 1.0);
+  }
+
+  std::mt19937 mt(2);
+  int even = 0;
+  constexpr int draws = 100000;
+  for (int i = 0; i < draws; ++i) {
+    const auto index = sampler.sample(mt);
+    ASSERT_LT(index, count);
+    even += index % 2 ? 0 : 1;
+  }
+  EXPECT_NEAR(even / static_cast<double>(draws), 1.0 / 1.2, 0.01);
+}
+
+TEST(TestWeightedSampler, testPickDistinctProbesOnlyPicks) {
+  brilliant::wp::WeightedSampler sampler;
+  constexpr std::size_t count = 100'000;
+  for (std::size_t i = 0; i < count; ++i) {
+    sampler.push(1.0);
+  }
+
+  // stands in for probing a source on the first render
+  std::vector<std::size_t> probed;
+  std::mt19937 mt(3);
+  const auto picked = brilliant::wp::pickDistinct(
+      sampler, 64, mt, [&probed](std::size_t index) {
+        probed.push_back(index);
+        return true;
+      });
+  EXPECT_EQ(picked.size(), 64u);
+  EXPECT_EQ(probed, picked);
+}
+
+TEST(TestWeightedSampler, testPickDistinctSkipsRejected) {
+  brilliant::wp::WeightedSampler sampler;
+  for (std::size_t i = 0; i < 1000; ++i) {
+    sampler.push(1.0);
+  }
+
+  // odd items fail their probe and are taken out of the sampler
+  std::size_t probes = 0;
+  std::mt19937 mt(4);
+  const auto picked = brilliant::wp::pickDistinct(
+      sampler, 64, mt, [&](std::size_t index) {
+        ++probes;
+        if (index % 2) {
+          sampler.set(index, 0.0);
+          return false;
+        }
+        return true;
+      });
+  EXPECT_EQ(picked.size(), 64u);
+  EXPECT_THAT(picked, ::testing::Each(::testing::ResultOf(
+                          [](std::size_t index) { return index % 2; }, 0u)));
+  // each item is probed at most once
+  EXPECT_LT(probes, 64u * brilliant::wp::maxPicksPerItem);
+}